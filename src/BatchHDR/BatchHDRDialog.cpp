@@ -79,6 +79,7 @@ BatchHDRDialog::BatchHDRDialog(QWidget *p):
     connect(m_Ui->threshold_doubleSpinBox, SIGNAL(valueChanged(double)), this, SLOT(updateThresholdSpinBox(double)));
 
     //connect(m_hdrCreationManager, SIGNAL(finishedLoadingInputFiles(QStringList)), this, SLOT(align(QStringList)));
+    connect(m_hdrCreationManager, SIGNAL(duplicatesSkipped(QStringList)), this, SLOT(duplicatesSkipped(QStringList)));
     connect(m_hdrCreationManager, SIGNAL(finishedLoadingFiles()), this, SLOT(align()));
     connect(m_hdrCreationManager, SIGNAL(finishedAligning(int)), this, SLOT(create_hdr(int)));
     connect(m_hdrCreationManager, SIGNAL(errorWhileLoading(QString)), this, SLOT(error_while_loading(QString)));
@@ -328,6 +329,13 @@ void BatchHDRDialog::batch_hdr()
     }
 }
 
+void BatchHDRDialog::duplicatesSkipped(const QStringList& files)
+{
+    m_Ui->textEdit->append(tr("Warning: skipped duplicate images"));
+    foreach (const QString& file, files)
+        m_Ui->textEdit->append(file);
+}
+
 void BatchHDRDialog::align()
 {
     QStringList filesLackingExif = m_hdrCreationManager->getFilesWithoutExif();
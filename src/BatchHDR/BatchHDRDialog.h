@@ -62,6 +62,7 @@ protected slots:
     void add_output_directory(QString dir = QString());
     void on_startButton_clicked();
     void batch_hdr();
+    void duplicatesSkipped(const QStringList&);
     void align();
     void create_hdr(int);
     void error_while_loading(QString);
@@ -29,11 +29,13 @@
 
 #include <climits>
 #include <cassert>
+#include <sstream>
 
 #ifdef QT_DEBUG
 #include <QDebug>
 #endif
 
+#include <QFile>
 #include <QFileDialog>
 #include <QTextStream>
 #include <QSqlRecord>
@@ -49,6 +51,10 @@
 #include "BatchTM/BatchTMJob.h"
 #include "OsIntegration/osintegration.h"
 
+#include <Libpfs/resultcache.h>
+#include <Libpfs/utils/memorybudget.h>
+#include <Libpfs/utils/trace.h>
+
 BatchTMDialog::BatchTMDialog(QWidget *p):
     QDialog(p), m_Ui(new Ui::BatchTMDialog),
     start_left(-1), stop_left(-1), start_right(-1), stop_right(-1), m_abort(false)
@@ -98,8 +104,17 @@ BatchTMDialog::BatchTMDialog(QWidget *p):
 
     m_next_hdr_file = 0;
     m_is_batch_running  = false;
+    m_was_tracing = false;
 
     add_log_message(tr("Using %n thread(s)", "", m_max_num_threads));
+
+    // jobs wait for their memory to fit in the budget
+    pfs::utils::setMemoryBudget(m_luminance_options.getMemoryBudgetBytes());
+    add_log_message(tr("Memory budget: %1 MB").arg(pfs::utils::memoryBudget()/(1024*1024)));
+
+    // unchanged images and options are not tone mapped again
+    pfs::setSharedResultCache(QFile::encodeName(m_luminance_options.getResultCacheDir()).constData(),
+                              size_t(m_luminance_options.getResultCacheSize())*1024*1024);
     //add_log_message(tr("Saving using file format: %1").arg(m_Ui->comboBoxFormat->currentText()));
     m_Ui->overallProgressBar->hide();
 }
@@ -424,7 +439,7 @@ void BatchTMDialog::start_batch_thread()
             QString fileExtension = m_formatHelper.getFileExtension();
 
             BatchTMJob * job_thread = new BatchTMJob(t_id, HDRs_list.at(m_next_hdr_file), &m_tm_options_list, m_Ui->out_folder_widgets->text(),
-                fileExtension, m_formatHelper.getParams());
+                fileExtension, m_formatHelper.getParams(), m_luminance_options.isBatchTmNumaAffinity());
 
             // Thread deletes itself when it has done with its job
             connect(job_thread, SIGNAL(finished()),
@@ -524,6 +539,11 @@ void BatchTMDialog::init_batch_tm_ui()
     // change the label of the processing button
     m_Ui->BatchGoButton->setText(tr("Processing..."));
 
+    // the timings of every job end up in the log
+    m_was_tracing = pfs::utils::isTracing();
+    pfs::utils::resetTrace();
+    pfs::utils::setTracing(true);
+
     add_log_message(tr("Start processing..."));
 }
 
@@ -537,6 +557,8 @@ void BatchTMDialog::stop_batch_tm_ui()
 
         m_Ui->BatchGoButton->setText(tr("&Done"));
         add_log_message(tr("All tasks completed."));
+        add_log_message(tr("Peak memory of the images: %1 MB").arg(pfs::utils::frameMemoryPeak()/(1024*1024)));
+        write_trace();
         QApplication::restoreOverrideCursor();
 
         m_is_batch_running = false;
@@ -545,6 +567,23 @@ void BatchTMDialog::stop_batch_tm_ui()
     }
 }
 
+void BatchTMDialog::write_trace()
+{
+    std::ostringstream summary;
+    pfs::utils::writeTraceSummary(summary);
+    foreach (const QString& line, QString::fromStdString(summary.str()).split('\n', QString::SkipEmptyParts))
+    {
+        add_log_message(line);
+    }
+
+    const std::string traceFile = pfs::utils::traceFileFromEnvironment();
+    if ( !traceFile.empty() && !pfs::utils::writeChromeTrace(traceFile) )
+    {
+        add_log_message(tr("Could not save the trace to %1").arg(QString::fromStdString(traceFile)));
+    }
+    pfs::utils::setTracing(m_was_tracing);
+}
+
 void BatchTMDialog::closeEvent( QCloseEvent* ce )
 {
 #ifdef QT_DEBUG
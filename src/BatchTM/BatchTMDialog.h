@@ -91,6 +91,8 @@ protected:
 private:
     //Parses a TM_opts file (return NULL on error)
     TonemappingOptions* parse_tm_opt_file(QString filename);
+    //Logs the time spent in each stage of the batch
+    void write_trace();
 
     //required for the cache path
     LuminanceOptions m_luminance_options;
@@ -127,6 +129,7 @@ private:
     QMutex          m_thread_control_mutex;
     QMutex          m_class_data_mutex;
     bool            m_is_batch_running;
+    bool            m_was_tracing;
     bool        *   m_available_threads;
     bool              m_abort;
     int             m_next_hdr_file;
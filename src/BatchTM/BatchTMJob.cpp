@@ -27,27 +27,80 @@
 #include "Exif/ExifOperations.h"
 #include "Libpfs/progress.h"
 #include "Libpfs/frame.h"
+#include "Libpfs/frame_view.h"
 #include "Libpfs/manip/copy.h"
 #include "Libpfs/manip/resize.h"
 #include "Libpfs/manip/gamma.h"
 #include "Libpfs/tm/TonemapOperator.h"
+#include "Libpfs/io/framereader.h"
+#include "Libpfs/io/framereaderfactory.h"
+#include "Libpfs/resultcache.h"
+#include "Libpfs/utils/memorybudget.h"
+#include "Libpfs/utils/numa.h"
+#include "Libpfs/utils/parallel.h"
 
 #include "Core/IOWorker.h"
 #include "Common/LuminanceOptions.h"
+#include "Core/TonemappingOptions.h"
 
+#include <QFile>
 #include <QFileInfo>
 #include <QByteArray>
 #include <QDebug>
 #include <QImage>
 #include <QScopedPointer>
 
-BatchTMJob::BatchTMJob(int thread_id, const QString &filename, const QList<TonemappingOptions*>* tm_options, const QString &output_folder, const QString &format, pfs::Params params):
+namespace
+{
+//! \return false if the size of the image cannot be read
+bool readImageSize(const QString& filename, size_t& width, size_t& height)
+{
+    try
+    {
+        pfs::io::FrameReaderPtr reader = pfs::io::FrameReaderFactory::open(QFile::encodeName(filename).constData());
+        width = reader->width();
+        height = reader->height();
+        reader->close();
+        return true;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+int maxSizePercent(const QList<TonemappingOptions*>& tm_options)
+{
+    int percent = 0;
+    foreach (const TonemappingOptions* opts, tm_options)
+    {
+        percent = qMax(percent, opts->xsize_percent);
+    }
+    return percent;
+}
+
+//! \brief rough peak memory of a job on an image of \a width x \a height:
+//! the HDR, plus the working copy of the largest output (3 channels) and the
+//! temporary buffers of the operators, that need a handful of full size
+//! float planes
+size_t estimateJobMemory(size_t width, size_t height, const QList<TonemappingOptions*>& tm_options)
+{
+    const int percent = maxSizePercent(tm_options);
+
+    const size_t numPlanes = 3 + 6;
+    return pfs::utils::frameMemorySize(width, height) +
+            pfs::utils::frameMemorySize(width*percent/100, height*percent/100, numPlanes);
+}
+}
+
+BatchTMJob::BatchTMJob(int thread_id, const QString &filename, const QList<TonemappingOptions*>* tm_options, const QString &output_folder, const QString &format, pfs::Params params, bool numa_affinity):
         m_thread_id(thread_id),
         m_file_name(filename),
         m_tm_options(tm_options),
         m_output_folder(output_folder),
         m_ldr_output_format(format),
-        m_params(params)
+        m_params(params),
+        m_numa_affinity(numa_affinity)
 {
     //m_ldr_output_format = LuminanceOptions().getBatchTmLdrFormat();
 
@@ -59,13 +112,43 @@ BatchTMJob::~BatchTMJob()
 
 void BatchTMJob::run()
 {
+    // the frames are allocated and processed by the threads of one node,
+    // so their pages stay on its memory
+    QScopedPointer<pfs::utils::ScopedExecutor> node_executor;
+    if ( m_numa_affinity && pfs::utils::numaNodeCount() > 1 )
+    {
+        const size_t node = m_thread_id % pfs::utils::numaNodeCount();
+        pfs::utils::bindThreadToNumaNode(node);
+        node_executor.reset( new pfs::utils::ScopedExecutor(pfs::utils::numaNodeExecutor(node)) );
+    }
+
     pfs::Progress prog_helper;
     IOWorker io_worker;
 
+    // wait for the memory of the job to fit in the budget
+    size_t full_width = 0;
+    size_t full_height = 0;
+    const bool has_size = readImageSize(m_file_name, full_width, full_height);
+
+    pfs::utils::MemoryReservation reservation;
+    const size_t job_memory = has_size ? estimateJobMemory(full_width, full_height, *m_tm_options) : 0;
+    if ( !reservation.tryReserve(job_memory) )
+    {
+        emit add_log_message(tr("[T%1] Waiting for %2 MB of memory").arg(m_thread_id).arg(job_memory/(1024*1024)));
+        reservation.reserve(job_memory);
+    }
+
     emit add_log_message(tr("[T%1] Start processing %2").arg(m_thread_id).arg(QFileInfo(m_file_name).completeBaseName()));
 
-    // reference frame
-    QScopedPointer<pfs::Frame> reference_frame( io_worker.read_hdr_frame(m_file_name) );
+    // reference frame: OpenEXR files with reduced levels are read at the
+    // smallest one that is still as wide as the largest output
+    pfs::Params read_params;
+    const int max_percent = maxSizePercent(*m_tm_options);
+    if ( has_size && max_percent < 100 )
+    {
+        read_params.set("exr_min_width", full_width*max_percent/100);
+    }
+    QScopedPointer<pfs::Frame> reference_frame( io_worker.read_hdr_frame(m_file_name, read_params) );
 
     if ( !reference_frame.isNull() )
     {
@@ -75,34 +158,61 @@ void BatchTMJob::run()
         // update progress bar!
         emit increment_progress_bar(1);
 
+        pfs::ResultCachePtr result_cache = pfs::sharedResultCache();
         for (int idx = 0; idx < m_tm_options->size(); ++idx)
         {
             TonemappingOptions* opts = m_tm_options->at(idx);
 
             opts->tonemapSelection = false; // just to be sure!
-            opts->origxsize = reference_frame->getWidth();
 
-            opts->xsize = (int) opts->origxsize * opts->xsize_percent / 100;
+            // origxsize and the percentage are of the full image, that may
+            // not be the level read: Fattal's detail level follows
+            // xsize/origxsize, as for a full size read
+            const int read_width = reference_frame->getWidth();
+            opts->origxsize = has_size ? int(full_width) : read_width;
+            opts->xsize = qMin(opts->origxsize * opts->xsize_percent / 100, read_width);
 
+            // same key as TMWorker: the results of the GUI are reused too
+            std::string cache_key;
             QScopedPointer<pfs::Frame> temporary_frame;
-            if ( opts->origxsize == opts->xsize )
+            if ( result_cache )
             {
-                temporary_frame.reset( pfs::copy(reference_frame.data()) );
+                cache_key = pfs::ResultCache::makeKey(*reference_frame,
+                                                      opts->getCacheKey(BilinearInterp).toStdString());
+                temporary_frame.reset( result_cache->find(cache_key) );
             }
-            else
+
+            if ( !temporary_frame.isNull() )
             {
-                temporary_frame.reset( pfs::resize(reference_frame.data(), opts->xsize, BilinearInterp) );
+                emit add_log_message( tr("[T%1] Reusing the cached result of %2").arg(m_thread_id).arg(opts->getPostfix()) );
             }
-
-            if ( opts->pregamma != 1.0f )
+            else
             {
-                pfs::applyGamma(temporary_frame.data(), opts->pregamma );
+                if ( read_width == opts->xsize )
+                {
+                    temporary_frame.reset( pfs::copyWithGamma(pfs::FrameView(*reference_frame),
+                                                              opts->pregamma) );
+                }
+                else
+                {
+                    temporary_frame.reset( pfs::resize(reference_frame.data(), opts->xsize, BilinearInterp) );
+
+                    if ( opts->pregamma != 1.0f )
+                    {
+                        pfs::applyGamma(temporary_frame.data(), opts->pregamma );
+                    }
+                }
+
+                QScopedPointer<TonemapOperator> tm_operator( TonemapOperator::getTonemapOperator(opts->tmoperator) );
+
+                tm_operator->tonemapFrame(*temporary_frame, opts, prog_helper);
+
+                if ( result_cache )
+                {
+                    result_cache->insert(cache_key, *temporary_frame);
+                }
             }
 
-            QScopedPointer<TonemapOperator> tm_operator( TonemapOperator::getTonemapOperator(opts->tmoperator) );
-
-            tm_operator->tonemapFrame(*temporary_frame, opts, prog_helper);
-
             QString output_file_name = m_output_file_name_base+"_"+opts->getPostfix()+"."+m_ldr_output_format;
 
             if ( io_worker.write_ldr_frame(temporary_frame.data(),
@@ -41,8 +41,11 @@ class BatchTMJob : public QThread
 {
     Q_OBJECT
 public:
+    //! \param numa_affinity run the job on the NUMA node thread_id modulo
+    //! the number of nodes: its threads and its frames stay on one socket
     BatchTMJob(int thread_id, const QString& filename, const QList<TonemappingOptions*>* tm_options,
-               const QString& output_folder, const QString& ldr_output_format, pfs::Params params);
+               const QString& output_folder, const QString& ldr_output_format, pfs::Params params,
+               bool numa_affinity = false);
     virtual ~BatchTMJob();
 signals:
     void done(int thread_id);
@@ -60,6 +63,7 @@ private:
     QString         m_output_file_name_base;
     QString         m_ldr_output_format;
     pfs::Params        m_params;
+    bool            m_numa_affinity;
 };
 
 #endif // BATCHTMJOB_H
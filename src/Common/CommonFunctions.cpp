@@ -35,6 +35,8 @@
 #include "Exif/ExifOperations.h"
 #include <Libpfs/frame.h>
 #include <Libpfs/params.h>
+#include <Libpfs/quantizedframe.h>
+#include <Libpfs/utils/memorybudget.h>
 #include <Libpfs/utils/msec_timer.h>
 #include <Libpfs/io/tiffwriter.h>
 #include <Libpfs/io/tiffreader.h>
@@ -229,6 +231,28 @@ void ConvertToQRgb::operator()(float r, float g, float b, QRgb& rgb) const
     rgb = qRgb(r8u, g8u, b8u);
 }
 
+namespace
+{
+//! \brief thumbnail and range of the red channel of a frame read as codes,
+//! as LoadFile computes them on the float frame
+template <typename Code>
+void buildPreviewFromCodes(const Code* red, const Code* green, const Code* blue,
+                           size_t size, const std::vector<float>& values,
+                           QRgb* qimageData, float& minRed, float& maxRed)
+{
+    ConvertToQRgb convert;
+    for (size_t idx = 0; idx < size; ++idx)
+    {
+        convert(values[red[idx]], values[green[idx]], values[blue[idx]], qimageData[idx]);
+    }
+
+    std::pair<const Code*, const Code*> minmaxRed =
+            boost::minmax_element(red, red + size);
+    minRed = values[*minmaxRed.first];
+    maxRed = values[*minmaxRed.second];
+}
+}
+
 void LoadFile::operator()(HdrCreationItem& currentItem)
 {
     if (currentItem.filename().isEmpty())
@@ -245,7 +269,28 @@ void LoadFile::operator()(HdrCreationItem& currentItem)
         qDebug() << QString("LoadFile: Loading data for %1").arg(filePath.constData());
 
         FrameReaderPtr reader = FrameReaderFactory::open(filePath.constData());
-        reader->read( *currentItem.frame(), getRawSettings() );
+        // the brackets wait for their memory to fit in the budget, and keep
+        // it reserved for as long as the item holds them
+        std::shared_ptr<pfs::utils::MemoryReservation> reservation =
+                std::make_shared<pfs::utils::MemoryReservation>(
+                    pfs::utils::frameMemorySize(reader->width(), reader->height()));
+        // plain JPEG and TIFF files are kept as their codes: a quarter or a
+        // half of the memory of the float frame
+        QuantizedFramePtr codes = std::make_shared<QuantizedFrame>();
+        if ( reader->readCodes(*codes, getRawSettings()) )
+        {
+            currentItem.setCodes(codes);
+            reservation->shrink(codes->getByteSize());
+        }
+        else
+        {
+            FramePtr frame = std::make_shared<Frame>();
+            reader->read( *frame, getRawSettings() );
+            currentItem.setFrame(frame);
+            codes.reset();
+        }
+        reservation->detach();
+        currentItem.setReservation(reservation);
 
         // read Average Luminance
         pfs::exif::ExifData exifData(currentItem.filename().toStdString());
@@ -259,12 +304,34 @@ void LoadFile::operator()(HdrCreationItem& currentItem)
                     .arg(currentItem.getAverageLuminance());
 
         // build QImage
-        QImage tempImage(currentItem.frame()->getWidth(),
-                         currentItem.frame()->getHeight(),
+        QImage tempImage(currentItem.width(),
+                         currentItem.height(),
                          QImage::Format_ARGB32_Premultiplied);
 
         QRgb* qimageData = reinterpret_cast<QRgb*>(tempImage.bits());
 
+        if ( codes )
+        {
+            float minRed;
+            float maxRed;
+            if ( codes->getBitDepth() == 8 )
+            {
+                buildPreviewFromCodes(codes->codes8(0), codes->codes8(1), codes->codes8(2),
+                                      codes->size(), QuantizedFrame::codeValues(8),
+                                      qimageData, minRed, maxRed);
+            }
+            else
+            {
+                buildPreviewFromCodes(codes->codes16(0), codes->codes16(1), codes->codes16(2),
+                                      codes->size(), QuantizedFrame::codeValues(16),
+                                      qimageData, minRed, maxRed);
+            }
+            currentItem.setMin(minRed);
+            currentItem.setMax(maxRed);
+            currentItem.qimage().swap( tempImage );
+            return;
+        }
+
         Channel* red;
         Channel* green;
         Channel* blue;
@@ -314,6 +381,11 @@ void LoadFile::operator()(HdrCreationItem& currentItem)
         }
 
         currentItem.qimage().swap( tempImage );
+
+        // hashed on the loading thread: HdrCreationManager compares the
+        // content of the brackets to skip duplicates (the codes are hashed
+        // by setCodes())
+        currentItem.contentHash();
     }
     catch (std::runtime_error& err)
     {
@@ -373,12 +445,34 @@ void RefreshPreview::operator()(HdrCreationItem& currentItem)
     try
     {
         // build QImage
-        QImage tempImage(currentItem.frame()->getWidth(),
-                         currentItem.frame()->getHeight(),
+        QImage tempImage(currentItem.width(),
+                         currentItem.height(),
                          QImage::Format_ARGB32_Premultiplied);
 
         QRgb* qimageData = reinterpret_cast<QRgb*>(tempImage.bits());
 
+        if ( codes )
+        {
+            float minRed;
+            float maxRed;
+            if ( codes->getBitDepth() == 8 )
+            {
+                buildPreviewFromCodes(codes->codes8(0), codes->codes8(1), codes->codes8(2),
+                                      codes->size(), QuantizedFrame::codeValues(8),
+                                      qimageData, minRed, maxRed);
+            }
+            else
+            {
+                buildPreviewFromCodes(codes->codes16(0), codes->codes16(1), codes->codes16(2),
+                                      codes->size(), QuantizedFrame::codeValues(16),
+                                      qimageData, minRed, maxRed);
+            }
+            currentItem.setMin(minRed);
+            currentItem.setMax(maxRed);
+            currentItem.qimage().swap( tempImage );
+            return;
+        }
+
         Channel* red;
         Channel* green;
         Channel* blue;
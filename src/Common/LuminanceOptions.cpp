@@ -37,11 +37,18 @@
 #include <QFile>
 #include <QDebug>
 #include <QDir>
+#include <QThread>
 
 #include "Common/LuminanceOptions.h"
 #include "Common/config.h"
 
+#include <Libpfs/utils/memorybudget.h>
+
 #define KEY_EXPORT_FILE_PATH "Queue/FilePath"
+#define KEY_EXPORT_NUM_THREADS "Queue/NumThreads"
+#define KEY_MEMORY_BUDGET "Memory/Budget"
+#define KEY_RESIDENT_VIEWERS "Memory/ResidentViewers"
+#define KEY_RESULT_CACHE_SIZE "Memory/ResultCacheSize"
 
 #ifdef WIN32
 const QString LuminanceOptions::LUMINANCE_HDR_HOME_FOLDER = "LuminanceHDR";
@@ -685,6 +692,16 @@ void LuminanceOptions::setBatchTmNumThreads(int v)
     m_settingHolder->setValue(KEY_BATCH_TM_NUM_THREADS, v);
 }
 
+bool LuminanceOptions::isBatchTmNumaAffinity()
+{
+    return m_settingHolder->value(KEY_BATCH_TM_NUMA_AFFINITY, false).toBool();
+}
+
+void LuminanceOptions::setBatchTmNumaAffinity(bool b)
+{
+    m_settingHolder->setValue(KEY_BATCH_TM_NUMA_AFFINITY, b);
+}
+
 namespace
 {
 #ifdef QT_DEBUG
@@ -958,6 +975,16 @@ void LuminanceOptions::setPreviewPanelMode(int mode)
     m_settingHolder->setValue(KEY_PREVIEW_PANEL_MODE, mode);
 }
 
+bool LuminanceOptions::isCompactInactiveViewers()
+{
+    return m_settingHolder->value(KEY_COMPACT_INACTIVE_VIEWERS, false).toBool();
+}
+
+void LuminanceOptions::setCompactInactiveViewers(bool status)
+{
+    m_settingHolder->setValue(KEY_COMPACT_INACTIVE_VIEWERS, status);
+}
+
 void LuminanceOptions::setExportDir(QString dir)
 {
     m_settingHolder->setValue(KEY_EXPORT_FILE_PATH, dir);
@@ -981,3 +1008,61 @@ QString LuminanceOptions::getExportDir()
     return path;
 }
 
+int LuminanceOptions::getExportNumThreads()
+{
+    // leave some cores to the interactive tone mapping
+    const int defaultThreads = qMax(1, QThread::idealThreadCount()/2);
+    return qMax(1, m_settingHolder->value(KEY_EXPORT_NUM_THREADS, defaultThreads).toInt());
+}
+
+void LuminanceOptions::setExportNumThreads(int v)
+{
+    m_settingHolder->setValue(KEY_EXPORT_NUM_THREADS, v);
+}
+
+int LuminanceOptions::getMemoryBudget()
+{
+    return qMax(0, m_settingHolder->value(KEY_MEMORY_BUDGET, 0).toInt());
+}
+
+void LuminanceOptions::setMemoryBudget(int megabytes)
+{
+    m_settingHolder->setValue(KEY_MEMORY_BUDGET, megabytes);
+}
+
+qint64 LuminanceOptions::getMemoryBudgetBytes()
+{
+    const qint64 megabytes = getMemoryBudget();
+    if ( megabytes > 0 )
+    {
+        return megabytes*1024*1024;
+    }
+    return qint64(pfs::utils::physicalMemory()/4*3);
+}
+
+int LuminanceOptions::getResidentViewers()
+{
+    return qMax(0, m_settingHolder->value(KEY_RESIDENT_VIEWERS, 8).toInt());
+}
+
+void LuminanceOptions::setResidentViewers(int count)
+{
+    m_settingHolder->setValue(KEY_RESIDENT_VIEWERS, count);
+}
+
+int LuminanceOptions::getResultCacheSize()
+{
+    return qMax(0, m_settingHolder->value(KEY_RESULT_CACHE_SIZE, 1024).toInt());
+}
+
+void LuminanceOptions::setResultCacheSize(int megabytes)
+{
+    m_settingHolder->setValue(KEY_RESULT_CACHE_SIZE, megabytes);
+}
+
+QString LuminanceOptions::getResultCacheDir()
+{
+    const QString dir = getTempDir() + "/resultcache";
+    QDir().mkpath(dir);
+    return dir;
+}
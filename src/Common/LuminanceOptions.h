@@ -171,11 +171,14 @@ public Q_SLOTS:
     QString getBatchTmPathTmoSettings();
     QString getBatchTmPathLdrOutput();
     int     getBatchTmNumThreads();
+    //! \brief bind every job to one NUMA node (socket), in turn
+    bool    isBatchTmNumaAffinity();
 
     void    setBatchTmPathHdrInput(const QString&);
     void    setBatchTmPathTmoSettings(const QString&);
     void    setBatchTmPathLdrOutput(const QString&);
     void    setBatchTmNumThreads(int);
+    void    setBatchTmNumaAffinity(bool);
 
     int     getNumThreads() { return getBatchTmNumThreads(); }
     void    setNumThreads(int i) { setBatchTmNumThreads(i); }
@@ -232,9 +235,34 @@ public Q_SLOTS:
     int     getPreviewPanelMode();
     void    setPreviewPanelMode(int);
 
+    // Keep the frames of the tabs in background in half precision
+    bool    isCompactInactiveViewers();
+    void    setCompactInactiveViewers(bool);
+
     // Queue
     QString getExportDir();
     void setExportDir(QString dir);
+    //! \brief amount of exports of the queue running at the same time
+    int     getExportNumThreads();
+    void    setExportNumThreads(int);
+
+    // Memory
+    //! \brief budget (in MB) of the frames of the whole program: jobs wait
+    //! while it is exhausted. 0 means three quarters of the physical memory
+    int     getMemoryBudget();
+    void    setMemoryBudget(int megabytes);
+    //! \brief getMemoryBudget() in bytes, with the automatic value resolved
+    qint64  getMemoryBudgetBytes();
+    //! \brief tabs (the most recently used ones) whose images stay in
+    //! memory: the others are moved to scratch files in getTempDir().
+    //! 0 keeps all of them
+    int     getResidentViewers();
+    void    setResidentViewers(int count);
+    //! \brief size of the cache of tone mapped images, in MB: 0 disables it
+    int     getResultCacheSize();
+    void    setResultCacheSize(int megabytes);
+    //! \brief directory of the cache, inside getTempDir(): created if missing
+    QString getResultCacheDir();
 
 
 private:
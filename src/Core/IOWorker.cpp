@@ -45,9 +45,11 @@
 #include "Exif/ExifOperations.h"
 #include "Fileformat/pfsoutldrimage.h"
 
+#include <Libpfs/io/encodedsize.h>
 #include <Libpfs/io/exrwriter.h>            // default for HDR saving
 #include <Libpfs/io/framewriterfactory.h>
 #include <Libpfs/io/framereaderfactory.h>
+#include <Libpfs/utils/trace.h>
 
 using namespace pfs;
 using namespace pfs::io;
@@ -96,6 +98,7 @@ bool IOWorker::write_hdr_frame(pfs::Frame *hdr_frame, const QString& filename,
     QFileInfo qfi(filename);
     QString absoluteFileName = qfi.absoluteFilePath();
     QByteArray encodedName = QFile::encodeName(absoluteFileName);
+    pfs::utils::TraceSpan span("write", encodedName.constData());
 
     // add parameters for TiffWriter HDR
     pfs::Params writerParams(params);
@@ -121,6 +124,8 @@ bool IOWorker::write_hdr_frame(pfs::Frame *hdr_frame, const QString& filename,
     }
 
     if ( status ) {
+        pfs::utils::traceCount("bytes written", QFileInfo(absoluteFileName).size());
+        pfs::utils::traceCount("pixels written", hdr_frame->size());
         emit write_hdr_success(hdr_frame, filename);
     } else {
         emit write_hdr_failed(filename);
@@ -129,37 +134,6 @@ bool IOWorker::write_hdr_frame(pfs::Frame *hdr_frame, const QString& filename,
     return status;
 }
 
-bool IOWorker::write_ldr_frame(GenericViewer* ldr_viewer,
-                               const QString& filename, /*int quality,*/
-                               const QString& inputFileName,
-                               const QVector<float>& expoTimes,
-                               TonemappingOptions* tmopts,
-                               const pfs::Params& params)
-{
-    pfs::Frame* ldr_frame = ldr_viewer->getFrame();
-
-    pfs::Params p2( params );
-    p2.set( "min_luminance", ldr_viewer->getMinLuminanceValue() )
-            ( "max_luminance", ldr_viewer->getMaxLuminanceValue() )
-            ( "mapping_method", ldr_viewer->getLuminanceMappingMethod() );
-
-    bool status = write_ldr_frame(ldr_frame,
-                                  filename, /*quality,*/
-                                  inputFileName,
-                                  expoTimes,
-                                  tmopts, p2);
-
-    if ( status ) {
-        if ( !ldr_viewer->isHDR() ) {
-            ldr_viewer->setFileName(filename);
-        }
-
-        emit write_ldr_success(ldr_viewer, filename);
-    }
-    return status;
-}
-
-
 bool IOWorker::write_ldr_frame(pfs::Frame* ldr_input,
                                const QString& filename,
                                const QString& inputFileName,
@@ -178,18 +152,44 @@ bool IOWorker::write_ldr_frame(pfs::Frame* ldr_input,
     QFileInfo qfi(filename);
     QString absoluteFileName = qfi.absoluteFilePath();
     QByteArray encodedName = QFile::encodeName(absoluteFileName);
+    pfs::utils::TraceSpan span("write", encodedName.constData());
+
+    // "target_size": highest quality whose file fits the size
+    pfs::Params writerParams(params);
+    size_t targetSize = 0;
+    if ( params.get("target_size", targetSize) && targetSize > 0 )
+    {
+        std::string format;
+        if ( !params.get("format", format) )
+        {
+            format = qfi.suffix().toLower().toStdString();
+        }
+        if ( format == "jpg" || format == "jpeg" || format == "png" )
+        {
+            size_t quality = pfs::io::findQualityForSize(*ldr_input,
+                                                        pfs::Params(params)("format", format),
+                                                        targetSize);
+            if ( quality == 0 )
+            {
+                qDebug() << "IOWorker:" << filename << "does not fit in" << targetSize << "bytes";
+                quality = 1;
+            }
+            writerParams.set("quality", quality);
+        }
+    }
 
     try
     {
-        FrameWriterPtr writer = FrameWriterFactory::open(encodedName.constData(), params);
-        writer->write(*ldr_input, params);
+        FrameWriterPtr writer = FrameWriterFactory::open(encodedName.constData(), writerParams);
+        writer->write(*ldr_input, writerParams);
     }
     catch (pfs::io::UnsupportedFormat& exUnsupported) {
         qDebug() << "Exception: " << exUnsupported.what();
 
         QString format = qfi.suffix();
         // QScopedPointer will call delete when this object goes out of scope
-        QScopedPointer<QImage> image(fromLDRPFStoQImage(ldr_input, 0.f, 1.f));
+        QScopedPointer<QImage> image(fromLDRPFStoQImage(ldr_input, 0.f, 1.f, MAP_LINEAR,
+                                                        pfs::GammaLevels::fromParams(params)));
         status = image->save(filename, format.toLocal8Bit(), -1);
     }
     catch (pfs::io::InvalidFile& /*exInvalid*/) {
@@ -201,6 +201,9 @@ bool IOWorker::write_ldr_frame(pfs::Frame* ldr_input,
 
     if ( status )
     {
+        pfs::utils::traceCount("bytes written", QFileInfo(absoluteFileName).size());
+        pfs::utils::traceCount("pixels written", ldr_input->size());
+
         // copy EXIF tags from the 1st bracketed image
         if ( !inputFileName.isEmpty() )
         {
@@ -233,7 +236,7 @@ bool IOWorker::write_ldr_frame(pfs::Frame* ldr_input,
     return status;
 }
 
-pfs::Frame* IOWorker::read_hdr_frame(const QString& filename)
+pfs::Frame* IOWorker::read_hdr_frame(const QString& filename, const pfs::Params& extraParams)
 {
     emit IO_init();
 
@@ -253,11 +256,19 @@ pfs::Frame* IOWorker::read_hdr_frame(const QString& filename)
     try
     {
         QByteArray encodedFileName = QFile::encodeName(qfi.absoluteFilePath());
+        pfs::utils::TraceSpan span("read", encodedFileName.constData());
 
         pfs::Params params = getRawSettings();
+        for (pfs::Params::const_iterator it = extraParams.begin(); it != extraParams.end(); ++it)
+        {
+            params.set(it->first, it->second);
+        }
         FrameReaderPtr reader = FrameReaderFactory::open(encodedFileName.constData());
         reader->read( *hdrpfsframe, params );
         reader->close();
+
+        pfs::utils::traceCount("bytes read", qfi.size());
+        pfs::utils::traceCount("pixels read", hdrpfsframe->size());
     }
     catch (pfs::io::UnsupportedFormat& exUnsupported)
     {
@@ -72,7 +72,10 @@ public:
     ~IOWorker();
 
 public Q_SLOTS:
-    pfs::Frame* read_hdr_frame(const QString& filename);
+    //! \param params added to the RAW settings, e.g. to read a reduced
+    //! level of an OpenEXR file
+    pfs::Frame* read_hdr_frame(const QString& filename,
+                               const pfs::Params& params = pfs::Params());
 
     bool write_hdr_frame(pfs::Frame *frame, const QString& filename,
                          const pfs::Params& params = pfs::Params());
@@ -86,13 +89,6 @@ public Q_SLOTS:
                          TonemappingOptions* tmopts = NULL,
                          const pfs::Params& params = pfs::Params());
 
-    bool write_ldr_frame(GenericViewer* frame,
-                         const QString& filename,
-                         const QString& inputFileName,
-                         const QVector<float>& expoTimes,
-                         TonemappingOptions* tmopts = NULL,
-                         const pfs::Params& params = pfs::Params());
-
 signals:
     void read_hdr_failed(const QString&);
     void read_hdr_success(pfs::Frame*, const QString&);
@@ -103,7 +99,6 @@ signals:
 
     void write_ldr_failed(const QString&);
     void write_ldr_success(pfs::Frame*, const QString&);
-    void write_ldr_success(GenericViewer*, const QString&);
 
     void setMaximum(int);
     void setValue(int);
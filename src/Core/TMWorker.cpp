@@ -29,24 +29,28 @@
 #include <QDebug>
 #endif
 #include <QVector>
-#include <QDir>
+#include <QScopedPointer>
 
 #include "Core/IOWorker.h"
 
 #include "Libpfs/frame.h"
+#include "Libpfs/frame_view.h"
 #include "Libpfs/params.h"
+#include "Libpfs/resultcache.h"
 #include "Libpfs/manip/copy.h"
-#include "Libpfs/manip/cut.h"
 #include "Libpfs/manip/resize.h"
 #include "Libpfs/manip/gamma.h"
 #include "Libpfs/tm/TonemapOperator.h"
+#include "Libpfs/utils/memorybudget.h"
 
 #include "Core/TonemappingOptions.h"
 #include "Common/ProgressHelper.h"
 
 TMWorker::TMWorker(QObject* parent):
     QObject(parent),
-    m_Callback(new ProgressHelper)
+    m_Callback(new ProgressHelper),
+    m_resultCacheEnabled(false),
+    m_exportReservation(NULL)
 {
 #ifdef QT_DEBUG
     qDebug() << "TMWorker::TMWorker() ctor";
@@ -73,6 +77,14 @@ pfs::Frame* TMWorker::computeTonemap(/* const */ pfs::Frame* in_frame, Tonemappi
     qDebug() << "TMWorker::getTonemappedFrame()";
 #endif
 
+    std::string cache_key;
+    pfs::Frame* cached_frame = findCachedFrame(in_frame, tm_options, m, cache_key);
+    if (cached_frame != NULL)
+    {
+        emit tonemapSuccess(cached_frame, tm_options);
+        return cached_frame;
+    }
+
     pfs::Frame* working_frame = preprocessFrame(in_frame, tm_options, m);
     if (working_frame == NULL) return NULL;
     try {
@@ -93,55 +105,53 @@ pfs::Frame* TMWorker::computeTonemap(/* const */ pfs::Frame* in_frame, Tonemappi
     }
 
     postprocessFrame(working_frame, tm_options);
+    storeCachedFrame(cache_key, working_frame);
 
     emit tonemapSuccess(working_frame, tm_options);
     return working_frame;
 }
 
-void TMWorker::computeTonemapAndExport(/* const */ pfs::Frame* in_frame, TonemappingOptions* tm_options, pfs::Params params, QString exportDir, QString hdrName, QString inputfname, QVector<float> inputExpoTimes, InterpolationMethod m)
+void TMWorker::computeTonemapAndExport(/* const */ pfs::Frame* in_frame, TonemappingOptions* tm_options, pfs::Params params, QString outputFilename, QString inputfname, QVector<float> inputExpoTimes, InterpolationMethod m)
 {
-    pfs::Frame* working_frame = preprocessFrame(in_frame, tm_options, m);
-    if (working_frame == NULL) return;
-    try {
-        tonemapFrame(working_frame, tm_options);
-    }
-    catch(...) {
-        emit tonemapFailed("Tonemap failed!");
-        delete working_frame;
-        return;
-    }
-
-    if ( m_Callback->canceled() )
+    // the frames of the export are allocated on this thread: they are
+    // counted in the reservation of the caller
+    if ( m_exportReservation ) m_exportReservation->adopt();
+    m_exportReservation = NULL;
+
+    std::string cache_key;
+    QScopedPointer<pfs::Frame> working_frame( findCachedFrame(in_frame, tm_options, m, cache_key) );
+    if ( working_frame.isNull() )
     {
-        m_Callback->cancel(false);      // double check this
-        delete working_frame;
-        return;
+        working_frame.reset( preprocessFrame(in_frame, tm_options, m) );
+        if ( working_frame.isNull() )
+        {
+            emit exportFinished();
+            return;
+        }
+        try {
+            tonemapFrame(working_frame.data(), tm_options);
+        }
+        catch(...) {
+            emit tonemapFailed("Tonemap failed!");
+            emit exportFinished();
+            return;
+        }
+
+        if ( m_Callback->canceled() )
+        {
+            m_Callback->cancel(false);      // double check this
+            emit exportFinished();
+            return;
+        }
+
+        postprocessFrame(working_frame.data(), tm_options);
+        storeCachedFrame(cache_key, working_frame.data());
     }
 
-    postprocessFrame(working_frame, tm_options);
-
-
-    QDir dir(exportDir);
-
-    const QString firstPart = hdrName + "_" + tm_options->getPostfix();
-    QString extension;
-    if (!params.get("fileextension", extension))
-        extension = "tiff";
-    extension = "." + extension;
-
-    QString outputFilename;
-
-    int idx = 1;
-    do
-    {
-        outputFilename = firstPart + (idx > 1 ? "-" + QString::number(idx) : QString()) + extension;
-        idx++;
-    } while(dir.exists(outputFilename));
-
     IOWorker io_worker;
 
-    if ( io_worker.write_ldr_frame(working_frame,
-                                   dir.filePath(outputFilename), inputfname,
+    if ( io_worker.write_ldr_frame(working_frame.data(),
+                                   outputFilename, inputfname,
                                    inputExpoTimes, tm_options,
                                    params) )
     {
@@ -150,10 +160,7 @@ void TMWorker::computeTonemapAndExport(/* const */ pfs::Frame* in_frame, Tonemap
         //emit add_log_message( tr("[T%1] ERROR: Cannot save to file: %2").arg(m_thread_id).arg(QFileInfo(output_file_name).completeBaseName()) );
     }
 
-    delete tm_options;
-    //emit tonemapSuccess(working_frame, tm_options);
-    //return working_frame;
-    delete working_frame;
+    emit exportFinished();
 }
 
 void TMWorker::tonemapFrame(pfs::Frame* working_frame, TonemappingOptions* tm_options)
@@ -175,34 +182,54 @@ pfs::Frame* TMWorker::preprocessFrame(pfs::Frame* input_frame, TonemappingOption
 {
     pfs::Frame* working_frame = NULL;
 
-    if ( tm_options->tonemapSelection )
-    {
-        // workingframe = "crop"
-        // std::cout << "crop:[" << opts.selection_x_up_left <<", " << opts.selection_y_up_left <<"],";
-        // std::cout << "[" << opts.selection_x_bottom_right <<", " << opts.selection_y_bottom_right <<"]" << std::endl;
-        working_frame = pfs::cut(input_frame,
-                                 tm_options->selection_x_up_left,
-                                 tm_options->selection_y_up_left,
-                                 tm_options->selection_x_bottom_right,
-                                 tm_options->selection_y_bottom_right);
-    }
-    else if ( tm_options->xsize != tm_options->origxsize )
+    if ( tm_options->xsize != tm_options->origxsize && !tm_options->tonemapSelection )
     {
         // workingframe = "resize"
         working_frame = pfs::resize(input_frame, tm_options->xsize, m);
+
+        if ( tm_options->pregamma != 1.0f )
+        {
+            pfs::applyGamma( working_frame, tm_options->pregamma );
+        }
     }
     else
     {
-        // workingframe = "full res"
-        working_frame = pfs::copy(input_frame);
+        // workingframe = "crop" or "full res": the operators work in place, so
+        // the region is materialised once, applying pregamma while copying
+        pfs::FrameView view = tm_options->tonemapSelection ?
+                    pfs::FrameView(*input_frame,
+                                   tm_options->selection_x_up_left,
+                                   tm_options->selection_y_up_left,
+                                   tm_options->selection_x_bottom_right,
+                                   tm_options->selection_y_bottom_right) :
+                    pfs::FrameView(*input_frame);
+
+        working_frame = pfs::copyWithGamma(view, tm_options->pregamma);
     }
 
-    if ( tm_options->pregamma != 1.0f )
+    return working_frame;
+}
+
+pfs::Frame* TMWorker::findCachedFrame(const pfs::Frame* input_frame, TonemappingOptions* tm_options, InterpolationMethod m, std::string& key)
+{
+    key.clear();
+
+    pfs::ResultCachePtr cache = pfs::sharedResultCache();
+    if ( !m_resultCacheEnabled || !cache )
     {
-        pfs::applyGamma( working_frame, tm_options->pregamma );
+        return NULL;
     }
+    key = pfs::ResultCache::makeKey(*input_frame, tm_options->getCacheKey(m).toStdString());
+    return cache->find(key);
+}
 
-    return working_frame;
+void TMWorker::storeCachedFrame(const std::string& key, const pfs::Frame* frame)
+{
+    pfs::ResultCachePtr cache = pfs::sharedResultCache();
+    if ( !key.empty() && cache )
+    {
+        cache->insert(key, *frame);
+    }
 }
 
 void TMWorker::postprocessFrame(pfs::Frame*, TonemappingOptions*)
@@ -28,6 +28,7 @@
 
 #include <QObject>
 #include <QString>
+#include <string>
 
 #include "Common/global.h"
 #include "Libpfs/params.h"
@@ -35,6 +36,9 @@
 // Forward declaration
 namespace pfs {
     class Frame;
+    namespace utils {
+        class MemoryReservation;
+    }
 }
 
 class TonemappingOptions;
@@ -48,6 +52,16 @@ public:
     TMWorker(QObject* parent = 0);
     ~TMWorker();
 
+    //! \brief look up the results in pfs::sharedResultCache() before
+    //! running the operator, and store the new ones there (off by default)
+    void setResultCacheEnabled(bool enabled)    { m_resultCacheEnabled = enabled; }
+
+    //! \brief reservation, made by the caller, that the next
+    //! computeTonemapAndExport() adopts on the thread of the worker: set it
+    //! before queuing the call, and keep it until exportFinished()
+    void setExportReservation(pfs::utils::MemoryReservation* reservation)
+    { m_exportReservation = reservation; }
+
 public Q_SLOTS:
     //!
     //!  This function creates a copy of the input frame, tonemap the copy
@@ -55,7 +69,12 @@ public Q_SLOTS:
     //!
     pfs::Frame* computeTonemap(/* const */pfs::Frame*, TonemappingOptions*, InterpolationMethod m);
 
-    void computeTonemapAndExport(/* const */pfs::Frame*, TonemappingOptions*, pfs::Params, QString exportDir, QString hdrName, QString inputfname, QVector<float> inputExpoTimes, InterpolationMethod m);
+    //!
+    //! Tonemap a copy of the input frame and save it in \a outputFilename.
+    //! \a tm_options must stay alive until exportFinished(), that is emitted
+    //! in any case, when the job is over
+    //!
+    void computeTonemapAndExport(/* const */pfs::Frame*, TonemappingOptions*, pfs::Params, QString outputFilename, QString inputfname, QVector<float> inputExpoTimes, InterpolationMethod m);
 
     //!
     //! This function tonemap the input frame
@@ -64,6 +83,10 @@ public Q_SLOTS:
 
 private:
     pfs::Frame* preprocessFrame(pfs::Frame*, TonemappingOptions*, InterpolationMethod m);
+    //! \return the cached result for these options, NULL if there is none
+    //! (\a key is left empty when caching is disabled)
+    pfs::Frame* findCachedFrame(const pfs::Frame*, TonemappingOptions*, InterpolationMethod m, std::string& key);
+    void storeCachedFrame(const std::string& key, const pfs::Frame*);
     void postprocessFrame(pfs::Frame*, TonemappingOptions*);
 
 Q_SIGNALS:
@@ -77,8 +100,12 @@ Q_SIGNALS:
     void tonemapSetValue(int);
     void tonemapRequestTermination();
 
+    void exportFinished();
+
 private:
     ProgressHelper* m_Callback;
+    bool m_resultCacheEnabled;
+    pfs::utils::MemoryReservation* m_exportReservation;
 };
 
 #endif // TMWORKER_H
@@ -38,114 +38,6 @@
 #include "Core/TonemappingOptions.h"
 #include "TonemappingOperators/pfstmdefaultparams.h"
 
-void TonemappingOptions::setDefaultTonemapParameters()
-{
-    // Mantiuk06
-    operator_options.mantiuk06options.contrastfactor = MANTIUK06_CONTRAST_FACTOR;
-    operator_options.mantiuk06options.saturationfactor = MANTIUK06_SATURATION_FACTOR;
-    operator_options.mantiuk06options.detailfactor = MANTIUK06_DETAIL_FACTOR;
-    operator_options.mantiuk06options.contrastequalization = MANTIUK06_CONTRAST_EQUALIZATION;
-
-    // Mantiuk08
-    operator_options.mantiuk08options.colorsaturation = MANTIUK08_COLOR_SATURATION;
-    operator_options.mantiuk08options.contrastenhancement = MANTIUK08_CONTRAST_ENHANCEMENT;
-    operator_options.mantiuk08options.luminancelevel = MANTIUK08_LUMINANCE_LEVEL;
-    operator_options.mantiuk08options.setluminance = MANTIUK08_SET_LUMINANCE;
-
-    // Fattal
-    operator_options.fattaloptions.alpha = FATTAL02_ALPHA;
-    operator_options.fattaloptions.beta = FATTAL02_BETA;
-    operator_options.fattaloptions.color = FATTAL02_COLOR;
-    operator_options.fattaloptions.noiseredux = FATTAL02_NOISE_REDUX;
-    operator_options.fattaloptions.newfattal = FATTAL02_NEWFATTAL;
-    operator_options.fattaloptions.fftsolver = true;
-
-    // Ferradans
-    operator_options.ferradansoptions.rho = FERRADANS11_RHO;
-    operator_options.ferradansoptions.inv_alpha = FERRADANS11_INV_ALPHA;
-
-    // Drago
-    operator_options.dragooptions.bias = DRAGO03_BIAS;
-
-    // Durand
-    operator_options.durandoptions.spatial = DURAND02_SPATIAL;
-    operator_options.durandoptions.range = DURAND02_RANGE;
-    operator_options.durandoptions.base = DURAND02_BASE;
-
-    // Reinhard 02
-    operator_options.reinhard02options.scales = REINHARD02_SCALES;
-    operator_options.reinhard02options.key = REINHARD02_KEY;
-    operator_options.reinhard02options.phi = REINHARD02_PHI;
-    operator_options.reinhard02options.range = REINHARD02_RANGE;
-    operator_options.reinhard02options.lower = REINHARD02_LOWER;
-    operator_options.reinhard02options.upper = REINHARD02_UPPER;
-
-    // Reinhard 05
-    operator_options.reinhard05options.brightness = REINHARD05_BRIGHTNESS;
-    operator_options.reinhard05options.chromaticAdaptation = REINHARD05_CHROMATIC_ADAPTATION;
-    operator_options.reinhard05options.lightAdaptation = REINHARD05_LIGHT_ADAPTATION;
-
-    // Ashikhmin
-    operator_options.ashikhminoptions.simple = ASHIKHMIN_SIMPLE;
-    operator_options.ashikhminoptions.eq2 = ASHIKHMIN_EQ2;
-    operator_options.ashikhminoptions.lct = ASHIKHMIN_LCT;
-
-    // Pattanaik
-    operator_options.pattanaikoptions.autolum = PATTANAIK00_AUTOLUM;
-    operator_options.pattanaikoptions.local = PATTANAIK00_LOCAL;
-    operator_options.pattanaikoptions.cone = PATTANAIK00_CONE;
-    operator_options.pattanaikoptions.rod = PATTANAIK00_ROD;
-    operator_options.pattanaikoptions.multiplier = PATTANAIK00_MULTIPLIER;
-}
-
-void TonemappingOptions::setDefaultParameters()
-{
-    // TM Defaults
-    setDefaultTonemapParameters();
-
-    origxsize = INT_MAX;
-    xsize = INT_MAX;
-    xsize_percent = 100;
-    quality = 100;
-    pregamma = 1.0f;
-    tonemapSelection = false;
-    tmoperator = mantiuk06;
-
-    selection_x_up_left = 0;
-    selection_y_up_left = 0;
-    selection_x_bottom_right = INT_MAX;
-    selection_y_bottom_right = INT_MAX;
-}
-
-char TonemappingOptions::getRatingForOperator()
-{
-    switch (tmoperator) {
-    case ashikhmin:
-        return 'H';
-    case drago:
-        return 'G';
-    case durand:
-        return 'F';
-    case fattal:
-        return 'B';
-    case mantiuk06:
-        return 'A';
-    case mantiuk08:
-        return 'C';
-    case pattanaik:
-        return 'I';
-    case reinhard02:
-        return 'E';
-    case reinhard05:
-        return 'D';
-    case ferradans:
-        return 'J';
-    case mai:
-        return 'K';
-    }
-    return ' ';
-}
-
 const QString TonemappingOptions::getPostfix() {
     QString postfix=QString("pregamma_%1_").arg(pregamma);
     switch (tmoperator) {
@@ -294,6 +186,20 @@ const QString TonemappingOptions::getPostfix() {
     return postfix;
 }
 
+const QString TonemappingOptions::getCacheKey(InterpolationMethod m) {
+    QString key=getPostfix();
+    key+=QString("_fastmath_%1").arg(fastMath);
+    if (tonemapSelection) {
+        key+=QString("_selection_%1_%2_%3_%4").arg(selection_x_up_left)
+                .arg(selection_y_up_left)
+                .arg(selection_x_bottom_right)
+                .arg(selection_y_bottom_right);
+    } else if (xsize != origxsize) {
+        key+=QString("_xsize_%1_interp_%2").arg(xsize).arg(m);
+    }
+    return key;
+}
+
 const QString TonemappingOptions::getCaption(bool includePregamma, QString separator) {
     QString caption=includePregamma ? QString(QObject::tr("PreGamma=%1")).arg(pregamma) + separator : QString();
     switch (tmoperator) {
@@ -0,0 +1,195 @@
+/*
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include "engine.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+
+#include <Libpfs/frame_view.h>
+#include <Libpfs/exif/exifdata.hpp>
+#include <Libpfs/io/framereader.h>
+#include <Libpfs/io/framereaderfactory.h>
+#include <Libpfs/io/framewriter.h>
+#include <Libpfs/io/framewriterfactory.h>
+#include <Libpfs/manip/gamma.h>
+#include <Libpfs/tm/TonemapOperator.h>
+#include <Libpfs/utils/trace.h>
+#include <HdrCreation/fusionoperator.h>
+
+using namespace libhdr::fusion;
+
+namespace luminance
+{
+namespace
+{
+int64_t fileSize(const std::string& filename)
+{
+    std::ifstream file(filename.c_str(), std::ios::binary | std::ios::ate);
+    return file ? static_cast<int64_t>(file.tellg()) : 0;
+}
+
+void traceRead(const std::string& filename, size_t pixels)
+{
+    if ( pfs::utils::isTracing() )
+    {
+        pfs::utils::traceCount("bytes read", fileSize(filename));
+        pfs::utils::traceCount("pixels read", pixels);
+    }
+}
+}
+
+pfs::FramePtr readFrame(const std::string& filename, const pfs::Params& params)
+{
+    pfs::utils::TraceSpan span("read", filename);
+
+    pfs::FramePtr frame = std::make_shared<pfs::Frame>();
+
+    pfs::io::FrameReaderPtr reader = pfs::io::FrameReaderFactory::open(filename);
+    reader->read(*frame, params);
+    reader->close();
+
+    traceRead(filename, frame->size());
+    return frame;
+}
+
+void writeFrame(const pfs::Frame& frame, const std::string& filename,
+                const pfs::Params& params)
+{
+    pfs::utils::TraceSpan span("write", filename);
+
+    pfs::io::FrameWriterPtr writer = pfs::io::FrameWriterFactory::open(filename, params);
+    if ( !writer->write(frame, params) )
+    {
+        throw std::runtime_error("Cannot write " + filename);
+    }
+
+    if ( pfs::utils::isTracing() )
+    {
+        pfs::utils::traceCount("bytes written", fileSize(filename));
+        pfs::utils::traceCount("pixels written", frame.size());
+    }
+}
+
+Exposure readExposure(const std::string& filename, const pfs::Params& params)
+{
+    pfs::exif::ExifData exifData(filename);
+    if ( !exifData.isValid() )
+    {
+        throw std::runtime_error("No exposure data in " + filename);
+    }
+
+    const float ev = std::log2(exifData.getAverageSceneLuminance());
+
+    pfs::utils::TraceSpan span("read", filename);
+
+    pfs::io::FrameReaderPtr reader = pfs::io::FrameReaderFactory::open(filename);
+    pfs::QuantizedFramePtr codes = std::make_shared<pfs::QuantizedFrame>();
+    if ( reader->readCodes(*codes, params) )
+    {
+        reader->close();
+        traceRead(filename, codes->size());
+        return Exposure(codes, ev);
+    }
+
+    pfs::FramePtr frame = std::make_shared<pfs::Frame>();
+    reader->read(*frame, params);
+    reader->close();
+    traceRead(filename, frame->size());
+    return Exposure(frame, ev);
+}
+
+pfs::FramePtr fuse(const std::vector<Exposure>& exposures,
+                   const FusionOperatorConfig& config)
+{
+    if ( exposures.empty() )
+    {
+        throw std::runtime_error("No frames to merge");
+    }
+
+    ResponseCurve response(config.responseCurve);
+    if ( !config.inputResponseCurveFilename.empty() &&
+         !response.readFromFile(config.inputResponseCurveFilename) )
+    {
+        throw std::runtime_error("Cannot read the response curve " +
+                                 config.inputResponseCurveFilename);
+    }
+    WeightFunction weight(config.weightFunction);
+
+    // same reference of HdrCreationManager: the (lower) median exposure value
+    std::vector<float> evs;
+    for (size_t idx = 0; idx < exposures.size(); ++idx)
+    {
+        evs.push_back(exposures[idx].ev);
+    }
+    std::sort(evs.begin(), evs.end());
+    const float evOffset = evs[(evs.size() + 1)/2 - 1];
+
+    std::vector<FrameEnhanced> frames;
+    for (size_t idx = 0; idx < exposures.size(); ++idx)
+    {
+        const float averageLuminance = std::pow(2.f, exposures[idx].ev - evOffset);
+        if ( exposures[idx].codes )
+        {
+            frames.push_back(FrameEnhanced(exposures[idx].codes, averageLuminance));
+        }
+        else
+        {
+            frames.push_back(FrameEnhanced(exposures[idx].frame, averageLuminance));
+        }
+    }
+
+    FusionOperatorPtr fusionOperator = IFusionOperator::build(config.fusionOperator);
+    pfs::FramePtr hdr(fusionOperator->computeFusion(response, weight, frames));
+
+    if ( !config.outputResponseCurveFilename.empty() )
+    {
+        response.writeToFile(config.outputResponseCurveFilename);
+    }
+    return hdr;
+}
+
+pfs::FramePtr tonemap(const pfs::Frame& hdr, const TonemappingParameters& params,
+                      pfs::Progress* progress)
+{
+    // the operators work in place: the region is materialised once, applying
+    // pregamma while copying (as TMWorker does)
+    pfs::FrameView view = params.tonemapSelection ?
+                pfs::FrameView(hdr,
+                               params.selection_x_up_left,
+                               params.selection_y_up_left,
+                               params.selection_x_bottom_right,
+                               params.selection_y_bottom_right) :
+                pfs::FrameView(hdr);
+    pfs::FramePtr ldr(pfs::copyWithGamma(view, params.pregamma));
+
+    // the operators take non-const parameters
+    TonemappingParameters options(params);
+    pfs::Progress defaultProgress;
+    std::unique_ptr<TonemapOperator> tmo(TonemapOperator::getTonemapOperator(options.tmoperator));
+    tmo->tonemapFrame(*ldr, &options, progress ? *progress : defaultProgress);
+
+    return ldr;
+}
+
+}
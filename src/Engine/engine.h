@@ -0,0 +1,113 @@
+/*
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#ifndef LUMINANCE_ENGINE_H
+#define LUMINANCE_ENGINE_H
+
+//! \brief Entry points of the image engine (frame I/O, HDR fusion and tone
+//! mapping) for applications that embed it: no dependency on Qt, no event
+//! loop, no global state to initialise
+//!
+//! The functions are reentrant: a service can run many jobs at the same time
+//! from its own threads. The loops of the library run on the executor of
+//! Libpfs/utils/parallel.h, shared by all the jobs: a service that owns its
+//! threads installs its own with pfs::utils::setExecutor(), or sizes the
+//! default one with pfs::utils::setConcurrency(). The operator loops still
+//! on OpenMP follow omp_set_num_threads() of the calling thread.
+//! On multi-socket machines a job can be kept on one node: bind its thread
+//! with pfs::utils::bindThreadToNumaNode() and run it inside a
+//! pfs::utils::ScopedExecutor of pfs::utils::numaNodeExecutor() (see
+//! Libpfs/utils/numa.h for the placement of the frames).
+//! Frames are plain pfs::Frame objects, allocated by the caller or returned
+//! through pfs::FramePtr.
+//! \note LUMINANCE_ENGINE_API_VERSION changes only when a declaration of this
+//! header changes in a way that breaks existing callers
+
+#include <string>
+#include <vector>
+
+#include <Libpfs/frame.h>
+#include <Libpfs/params.h>
+#include <Libpfs/progress.h>
+#include <Libpfs/quantizedframe.h>
+#include <Libpfs/tm/TonemappingParameters.h>
+#include <HdrCreation/createhdr.h>
+
+#define LUMINANCE_ENGINE_API_VERSION 2
+
+namespace luminance
+{
+
+//! \brief read a frame (LDR, HDR or camera raw: the format follows the
+//! extension of \a filename)
+//! \throws pfs::io::UnsupportedFormat, std::runtime_error
+pfs::FramePtr readFrame(const std::string& filename,
+                        const pfs::Params& params = pfs::Params());
+
+//! \brief write \a frame, in the format given by the extension of \a filename
+//! \throws pfs::io::UnsupportedFormat, std::runtime_error
+void writeFrame(const pfs::Frame& frame, const std::string& filename,
+                const pfs::Params& params = pfs::Params());
+
+//! \brief one frame of a bracketed sequence, with its exposure value
+//!
+//! The frame is given either as a float frame or as the 8 or 16 bit codes of
+//! its file: exactly one of \c frame and \c codes is set
+struct Exposure
+{
+    Exposure(const pfs::FramePtr& frame_, float ev_)
+        : frame(frame_)
+        , ev(ev_)
+    {}
+
+    Exposure(const pfs::QuantizedFramePtr& codes_, float ev_)
+        : codes(codes_)
+        , ev(ev_)
+    {}
+
+    pfs::FramePtr frame;
+    pfs::QuantizedFramePtr codes;
+    //! \brief log2 of the average scene luminance
+    float ev;
+};
+
+//! \brief read a frame of a bracketed sequence: the exposure value comes from
+//! the EXIF data of the file. JPEG and TIFF files without a colour profile
+//! are kept as their codes (a quarter or a half of the memory of a float
+//! frame), which fuse() merges directly
+//! \throws std::runtime_error if the file has no exposure data
+Exposure readExposure(const std::string& filename,
+                      const pfs::Params& params = pfs::Params());
+
+//! \brief merge \a exposures in an HDR frame. A response curve is read from
+//! (and written to) the files named in \a config, when they are not empty
+//! \throws std::runtime_error if \a exposures is empty
+pfs::FramePtr fuse(const std::vector<Exposure>& exposures,
+                   const FusionOperatorConfig& config);
+
+//! \brief tone map \a hdr with the operator and the parameters in \a params:
+//! pregamma and the selection (if \c tonemapSelection is set) are applied,
+//! the size is the one of the input. \a hdr is left untouched
+pfs::FramePtr tonemap(const pfs::Frame& hdr, const TonemappingParameters& params,
+                      pfs::Progress* progress = NULL);
+
+}
+
+#endif // LUMINANCE_ENGINE_H
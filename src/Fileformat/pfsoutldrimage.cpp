@@ -43,8 +43,8 @@
 
 #include <Libpfs/frame.h>
 #include <Libpfs/utils/msec_timer.h>
-#include <Libpfs/utils/transform.h>
 #include <Libpfs/colorspace/rgbremapper.h>
+#include <Libpfs/manip/gamma_levels.h>
 #include <Libpfs/exception.h>
 
 using namespace std;
@@ -54,25 +54,11 @@ using namespace boost::assign;
 using namespace pfs;
 
 
-QRgbRemapper::QRgbRemapper(float minLuminance, float maxLuminance, RGBMappingType mappingType)
-    : m_remapper(
-          utils::chain(
-              colorspace::Normalizer(minLuminance, maxLuminance),
-              utils::CLAMP_F32,
-              Remapper<uint8_t>(mappingType)
-              )
-          )
-{}
-
-void QRgbRemapper::operator()(float r, float g, float b, QRgb& qrgb) const
-{
-    qrgb = qRgb(m_remapper(r), m_remapper(g), m_remapper(b));
-}
-
 QImage* fromLDRPFStoQImage(pfs::Frame* in_frame,
                            float min_luminance,
                            float max_luminance,
-                           RGBMappingType mapping_method)
+                           RGBMappingType mapping_method,
+                           const pfs::GammaLevels& levels)
 {
 #ifdef TIMER_PROFILING
     msec_timer stop_watch;
@@ -89,13 +75,36 @@ QImage* fromLDRPFStoQImage(pfs::Frame* in_frame,
     in_frame->getXYZChannels( Xc, Yc, Zc );
     assert( Xc != NULL && Yc != NULL && Zc != NULL );
 
-    QImage* temp_qimage = new QImage(in_frame->getWidth(), in_frame->getHeight(),
-                                     QImage::Format_RGB32);
+    const int width = in_frame->getWidth();
+    const int height = in_frame->getHeight();
+
+    QImage* temp_qimage = new QImage(width, height, QImage::Format_RGB32);
+
+    // byte offsets of the components inside a QRgb (0xAARRGGBB)
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    const int R_OFFSET = 2, G_OFFSET = 1, B_OFFSET = 0, A_OFFSET = 3;
+#else
+    const int R_OFFSET = 1, G_OFFSET = 2, B_OFFSET = 3, A_OFFSET = 0;
+#endif
 
-    QRgbRemapper remapper(min_luminance, max_luminance, mapping_method);
-    utils::transform(Xc->begin(), Xc->end(), Yc->begin(), Zc->begin(),
-                     reinterpret_cast<QRgb*>(temp_qimage->bits()),
-                     remapper);
+    const LevelsQuantizer<uint8_t> quantizer(min_luminance, max_luminance,
+                                             levels, mapping_method);
+    uchar* bits = temp_qimage->bits();
+    const int bytesPerLine = temp_qimage->bytesPerLine();
+
+#pragma omp parallel for
+    for (int row = 0; row < height; ++row)
+    {
+        uchar* line = bits + row*bytesPerLine;
+        quantizer(Xc->row_begin(row), Yc->row_begin(row), Zc->row_begin(row),
+                  width,
+                  line + R_OFFSET, line + G_OFFSET, line + B_OFFSET,
+                  4, row);
+        for (int col = 0; col < width; ++col)
+        {
+            line[4*col + A_OFFSET] = 0xFF;
+        }
+    }
 
 #ifdef TIMER_PROFILING
     stop_watch.stop_and_update();
@@ -27,7 +27,8 @@
 //! \author Giuseppe Rota <grota@users.sourceforge.net>
 //! \author Davide Anastasia <davideanastasia@users.sourceforge.net>
 
-#include <QString>
+#include <string>
+
 #include <HdrCreation/fusionoperator.h>
 
 struct FusionOperatorConfig
@@ -35,8 +36,8 @@ struct FusionOperatorConfig
     libhdr::fusion::WeightFunctionType weightFunction;
     libhdr::fusion::ResponseCurveType responseCurve;
     libhdr::fusion::FusionOperator fusionOperator;
-    QString inputResponseCurveFilename;
-    QString outputResponseCurveFilename;
+    std::string inputResponseCurveFilename;
+    std::string outputResponseCurveFilename;
 };
 
 #endif
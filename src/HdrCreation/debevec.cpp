@@ -26,14 +26,16 @@
 //! \author Davide Anastasia <davideanastasia@users.sourceforge.net>
 
 #include "HdrCreation/debevec.h"
+#include <Libpfs/quantizedframe.h>
 #include <Libpfs/utils/numeric.h>
-#include <Libpfs/utils/msec_timer.h>
 #include <Libpfs/colorspace/normalizer.h>
 
+#include <algorithm>
 #include <cmath>
 #include <cfloat>
 #include <cassert>
 #include <iostream>
+#include <limits>
 #include <functional>
 #include <vector>
 #include <boost/numeric/conversion/bounds.hpp>
@@ -61,36 +63,157 @@ using namespace colorspace;
 namespace libhdr {
 namespace fusion {
 
-void DebevecOperator::computeFusion(ResponseCurve& response, WeightFunction& weight,
-                                    const vector<FrameEnhanced> &images,
-                                    pfs::Frame &frame)
+namespace
 {
-#ifdef TIMER_PROFILING
-    msec_timer f_timer;
-    f_timer.start();
-#endif
-    assert(images.size() != 0);
+//! \brief smallest and largest code of three planes of \a size codes
+template <typename Code>
+void codeBounds(const Code* const codes[3], size_t size, int& minCode, int& maxCode)
+{
+    minCode = std::numeric_limits<Code>::max();
+    maxCode = 0;
+    for (int c = 0; c < 3; ++c)
+    {
+        const std::pair<const Code*, const Code*> bounds =
+                std::minmax_element(codes[c], codes[c] + size);
+        minCode = std::min<int>(minCode, *bounds.first);
+        maxCode = std::max<int>(maxCode, *bounds.second);
+    }
+}
 
-    std::vector<float> times;
+//! \brief per pixel weighted sum of the tabulated log-responses
+template <typename Code>
+void mergeCodes(const vector<const Code*>* inputCh, size_t numExposures,
+                const vector<float>& weightLut, const vector<float>& responseLut,
+                size_t numCodes, Array2Df* resultCh[3])
+{
+    const int size = static_cast<int>(resultCh[0]->size());
+#pragma omp parallel for
+    for (int k = 0; k < size; ++k)
+    {
+        float result[3] = {0.f, 0.f, 0.f};
+        float weightSum = 0.f;
 
-    const int W = images[0].frame()->getWidth();
-    const int H = images[0].frame()->getHeight();
+        for (size_t i = 0; i < numExposures; ++i)
+        {
+            const float* currWeight = weightLut.data() + i*numCodes;
+            const float* currResponse = responseLut.data() + i*numCodes;
 
-    for (size_t idx = 0; idx < images.size(); ++idx)
+            const Code code[3] = {
+                inputCh[0][i][k], inputCh[1][i][k], inputCh[2][i][k]
+            };
+
+            const float w = (currWeight[code[0]] + currWeight[code[1]] +
+                             currWeight[code[2]])*(1.f/3);
+            for (int c = 0; c < 3; ++c)
+            {
+                result[c] += w*currResponse[code[c]];
+            }
+            weightSum += w;
+        }
+
+        const float invWeightSum = 1.f/weightSum;
+        for (int c = 0; c < 3; ++c)
+        {
+            (*resultCh[c])(k) = expf(result[c]*invWeightSum);
+        }
+    }
+}
+
+//! \brief merge exposures given as 8 or 16 bit codes (see pfs::QuantizedFrame).
+//! Weight and log-response only depend on the code and on the exposure, so
+//! they are tabulated once per exposure: every pixel costs a few lookups, no
+//! float frame is built and no temporary image is allocated.
+//! \return false if the exposures are not all codes of the same depth, or
+//! one of them is flat (nothing is written)
+bool computeFusionFromCodes(ResponseCurve& response, WeightFunction& weight,
+                            const vector<FrameEnhanced> &images,
+                            const vector<float>& times,
+                            Array2Df* resultCh[3])
+{
+    const size_t numExposures = images.size();
+
+    int bitDepth = 0;
+    for (size_t i = 0; i < numExposures; ++i)
     {
-        times.push_back(images[idx].averageLuminance());
+        const QuantizedFramePtr& codes = images[i].codes();
+        if ( !codes ) return false;
+        if ( i > 0 && codes->getBitDepth() != bitDepth ) return false;
+        if ( codes->size() != resultCh[0]->size() ) return false;
+
+        bitDepth = codes->getBitDepth();
+    }
+
+    PRINT_DEBUG("Merging " << numExposures << " exposures of "
+                << bitDepth << " bit codes");
+
+    // the values of the float path: its normalisation and tables give the
+    // same weights and responses
+    const vector<float>& values = QuantizedFrame::codeValues(bitDepth);
+    const size_t numCodes = values.size();
+    vector<float> weightLut(numExposures*numCodes, 0.f);
+    vector<float> responseLut(numExposures*numCodes, 0.f);
+
+    vector<const uint8_t*> inputCh8[3];
+    vector<const uint16_t*> inputCh16[3];
+    for (size_t i = 0; i < numExposures; ++i)
+    {
+        const QuantizedFrame& codes = *images[i].codes();
+
+        int minCode;
+        int maxCode;
+        if ( bitDepth == 8 )
+        {
+            const uint8_t* planes[3] = { codes.codes8(0), codes.codes8(1), codes.codes8(2) };
+            codeBounds(planes, codes.size(), minCode, maxCode);
+            for (int c = 0; c < 3; ++c) inputCh8[c].push_back(planes[c]);
+        }
+        else
+        {
+            const uint16_t* planes[3] = { codes.codes16(0), codes.codes16(1), codes.codes16(2) };
+            codeBounds(planes, codes.size(), minCode, maxCode);
+            for (int c = 0; c < 3; ++c) inputCh16[c].push_back(planes[c]);
+        }
+        // a flat exposure cannot be normalised
+        if ( minCode == maxCode ) return false;
+
+        // normalised in double: the extreme codes map exactly on 0 and 1,
+        // however -ffast-math reorders the expression
+        const double minValue = values[minCode];
+        const double range = values[maxCode] - minValue;
+        const float logTime = -logf(times[i]);
+
+        float* currWeight = weightLut.data() + i*numCodes;
+        float* currResponse = responseLut.data() + i*numCodes;
+#pragma omp parallel for
+        for (int code = minCode; code <= maxCode; ++code)
+        {
+            const float sample = static_cast<float>((values[code] - minValue)/range);
+
+            currWeight[code] = weight(sample);
+            currResponse[code] = logTime + logf( response(sample) );
+        }
     }
 
+    if ( bitDepth == 8 )
+    {
+        mergeCodes(inputCh8, numExposures, weightLut, responseLut, numCodes, resultCh);
+    }
+    else
+    {
+        mergeCodes(inputCh16, numExposures, weightLut, responseLut, numCodes, resultCh);
+    }
+    return true;
+}
+
+//! \brief merge frames of any content: inputs are normalised in place
+void computeFusionFromFloats(ResponseCurve& response, WeightFunction& weight,
+                             const vector<FrameEnhanced> &images,
+                             const vector<float>& times,
+                             Array2Df* resultCh[3], int W, int H)
+{
     const int channels = 3;
     const size_t size = W*H;
 
-    vector<float> exp_values(times);
-    transform(exp_values.begin(), exp_values.end(), exp_values.begin(), logf);
-
-    frame.resize(W, H);
-    Channel *Ch[3];
-    frame.createXYZChannels(Ch[0], Ch[1], Ch[2]);
-    Array2Df *resultCh[channels] = {Ch[0], Ch[1], Ch[2]};
     #pragma omp parallel for
     for(int c = 0; c < channels; c++) {
         resultCh[c]->fill(0.f);
@@ -150,6 +273,40 @@ void DebevecOperator::computeFusion(ResponseCurve& response, WeightFunction& wei
     for(int c = 0; c < channels; c++) {
         transform(resultCh[c]->begin(), resultCh[c]->end(), resultCh[c]->begin(), expf);
     }
+}
+}
+
+void DebevecOperator::computeFusion(ResponseCurve& response, WeightFunction& weight,
+                                    const vector<FrameEnhanced> &images,
+                                    pfs::Frame &frame)
+{
+    assert(images.size() != 0);
+
+    std::vector<float> times;
+
+    const int W = images[0].getWidth();
+    const int H = images[0].getHeight();
+
+    for (size_t idx = 0; idx < images.size(); ++idx)
+    {
+        times.push_back(images[idx].averageLuminance());
+    }
+
+    const int channels = 3;
+
+    vector<float> exp_values(times);
+    transform(exp_values.begin(), exp_values.end(), exp_values.begin(), logf);
+
+    frame.resize(W, H);
+    Channel *Ch[3];
+    frame.createXYZChannels(Ch[0], Ch[1], Ch[2]);
+    Array2Df *resultCh[channels] = {Ch[0], Ch[1], Ch[2]};
+
+    if ( !computeFusionFromCodes(response, weight, images, times, resultCh) )
+    {
+        computeFusionFromFloats(response, weight, images, times, resultCh, W, H);
+    }
+
     float cmax[3];
     #pragma omp parallel for
     for(int c = 0; c < channels; c++) {
@@ -161,10 +318,6 @@ void DebevecOperator::computeFusion(ResponseCurve& response, WeightFunction& wei
         replace_if(resultCh[c]->begin(), resultCh[c]->end(), std::not1(std::ref(boost::math::isnormal<float>)), Max);
     }
 
-#ifdef TIMER_PROFILING
-    f_timer.stop_and_update();
-    std::cout << "MergeDebevec = " << f_timer.get_time() << " msec" << std::endl;
-#endif
 }
 
 /*
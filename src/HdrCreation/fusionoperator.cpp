@@ -29,6 +29,7 @@
 
 #include <Libpfs/frame.h>
 #include <Libpfs/utils/string.h>
+#include <Libpfs/utils/trace.h>
 
 using namespace pfs;
 using namespace std;
@@ -43,6 +44,13 @@ IFusionOperator::IFusionOperator()
 // TODO: fix this to return a shared_ptr
 pfs::Frame* IFusionOperator::computeFusion(ResponseCurve& response, WeightFunction& weight, const std::vector<FrameEnhanced>& frames)
 {
+    static const char* const NAMES[] = { "debevec", "robertson", "robertson-auto" };
+    pfs::utils::TraceSpan span("fuse", NAMES[getType()]);
+    if ( !frames.empty() )
+    {
+        pfs::utils::traceCount("pixels fused", frames.size()*frames[0].getWidth()*frames[0].getHeight());
+    }
+
     pfs::Frame* frame = new pfs::Frame;
     computeFusion(response, weight, frames, *frame);
     return frame;
@@ -31,6 +31,7 @@
 
 
 #include <Libpfs/frame.h>
+#include <Libpfs/quantizedframe.h>
 #include <HdrCreation/responses.h>
 #include <HdrCreation/weights.h>
 
@@ -39,6 +40,10 @@ namespace fusion {
 
 //! \brief This class contains a (shared) pointer to a frame, plus its average
 //! luminance, to be used during the fusion process
+//!
+//! An exposure read as 8 or 16 bit codes (see FrameReader::readCodes()) can
+//! be given as such: the operators that work on the codes never build its
+//! float frame, the others get it from frame(), expanded on the first call
 class FrameEnhanced
 {
 public:
@@ -47,11 +52,34 @@ public:
         , m_averageLuminance(averageLuminance)
     {}
 
-    const pfs::FramePtr& frame() const { return m_frame; }
+    FrameEnhanced(const pfs::QuantizedFramePtr& codes, float averageLuminance)
+        : m_codes(codes)
+        , m_averageLuminance(averageLuminance)
+    {}
+
+    const pfs::FramePtr& frame() const
+    {
+        if ( !m_frame && m_codes )
+        {
+            m_frame.reset(m_codes->expand());
+        }
+        return m_frame;
+    }
+
+    //! \brief the codes of the exposure, NULL if it was given as a frame
+    const pfs::QuantizedFramePtr& codes() const { return m_codes; }
+
+    //! \brief size of the exposure, without expanding its codes
+    size_t getWidth() const
+    { return m_codes ? m_codes->getWidth() : m_frame->getWidth(); }
+    size_t getHeight() const
+    { return m_codes ? m_codes->getHeight() : m_frame->getHeight(); }
+
     float averageLuminance() const { return m_averageLuminance; }
 
 private:
-    pfs::FramePtr m_frame;
+    mutable pfs::FramePtr m_frame;
+    pfs::QuantizedFramePtr m_codes;
     float m_averageLuminance;
 };
 
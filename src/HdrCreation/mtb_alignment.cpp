@@ -31,7 +31,6 @@
 #include <cmath>
 #include <iostream>
 
-#include <Common/global.h>
 #include <Libpfs/array2d.h>
 #include <Libpfs/frame.h>
 #include <Libpfs/utils/transform.h>
@@ -39,6 +38,7 @@
 #include <Libpfs/colorspace/xyz.h>
 #include <Libpfs/manip/resize.h>
 #include <Libpfs/manip/shift.h>
+#include <Libpfs/utils/trace.h>
 
 #include <Libpfs/io/jpegwriter.h>
 #include "arch/math.h"
@@ -229,6 +229,8 @@ void mtb_alignment(std::vector<pfs::FramePtr> &framePtrList)
 {
     if (framePtrList.size() <= 1) return;
 
+    pfs::utils::TraceSpan span("align", "mtb");
+
     int width   = framePtrList[0]->getWidth();
     int height  = framePtrList[0]->getHeight();
 
@@ -27,7 +27,9 @@
 
 #include <boost/bind.hpp>
 #include <boost/math/constants/constants.hpp>
+#include <algorithm>
 #include <cmath>
+#include <vector>
 #include <stdlib.h>
 #ifdef _OPENMP
 #include <omp.h>
@@ -37,8 +39,9 @@
 #include <Libpfs/frame.h>
 #include <Libpfs/colorspace/colorspace.h>
 #include <Libpfs/manip/copy.h>
+#include <Libpfs/manip/transpose.h>
 #include <Libpfs/utils/minmax.h>
-#include "Libpfs/utils/msec_timer.h"
+#include "Libpfs/utils/trace.h"
 
 #include <fftw3.h>
 
@@ -59,10 +62,13 @@ float min(const Array2Df& u)
 
 void solve_pde_dct(Array2Df &F, Array2Df &U)
 {
-#ifdef TIMER_PROFILING
-    msec_timer stop_watch;
-    stop_watch.start();
-#endif
+    Array2Df Ftr(U.getCols(), U.getRows());
+    solve_pde_dct(F, U, Ftr);
+}
+
+void solve_pde_dct(Array2Df &F, Array2Df &U, Array2Df &Ftr)
+{
+    TraceSpan span("solve_pde_dct");
   // activate parallel execution of fft routines
   fftwf_init_threads();
 #ifdef _OPENMP
@@ -74,8 +80,7 @@ void solve_pde_dct(Array2Df &F, Array2Df &U)
     const int width = U.getCols();
     const int height = U.getRows();
     assert((int)F.getCols()==width && (int)F.getRows()==height);
-
-    Array2Df Ftr(width, height);
+    assert((int)Ftr.getCols()==width && (int)Ftr.getRows()==height);
 
     fftwf_plan p = NULL; // Let's see if this blocks compiler warnings
     #pragma omp parallel for private(p) schedule(static)
@@ -85,35 +90,42 @@ void solve_pde_dct(Array2Df &F, Array2Df &U)
         fftwf_execute(p);
     }
 
+    // the tridiagonal solver runs along the columns: work on the transposed
+    // spectrum (stored inside U) so every system is contiguous in memory
+    float* Ut = U.data();
+    pfs::transpose(Ftr.data(), Ut, width, height);
+
   #pragma omp parallel
   {
     vector<float> c(height);
     #pragma omp for
     for ( int i = 0; i < width; i++ ) {
+        float* f = Ut + i*height;
         for (int j = 0; j < height; j++) {
             c[j] = 1.0f;
         }
         float b = 2.0f*(cos(boost::math::double_constants::pi*i/width) - 2.0f);
         c[0] /= b;
-        Ftr(i, 0) /= b;
+        f[0] /= b;
         for (int j = 1; j < height - 1; j++ ) {
             float m = (b - c[j-1]);
             c[j] /= m;
-            Ftr(i, j) = (Ftr(i, j) - Ftr(i, j-1))/m;
+            f[j] = (f[j] - f[j-1])/m;
         }
-        Ftr(i, height - 1) = (Ftr(i, height - 1) - Ftr(i, height - 2))/(b - c[height - 2]);
-        U(i, height - 1) = Ftr(i, height - 1);
+        f[height - 1] = (f[height - 1] - f[height - 2])/(b - c[height - 2]);
         for (int j = height - 2; j >= 0; j--) {
-            U(i, j) = Ftr(i, j) - c[j]*U(i, j+1);
+            f[j] = f[j] - c[j]*f[j+1];
         }
     }
   }
 
+    pfs::transpose(Ut, Ftr.data(), height, width);
+
     const float invDivisor = 1.0f / (2.0f*(width-1));
     #pragma omp parallel for schedule(static) lastprivate(p)
     for ( int j = 0; j < height; j++ ) {
         #pragma omp critical (make_plan)
-        p = fftwf_plan_r2r_1d(width, U.data()+width*j, U.data()+width*j, FFTW_REDFT00, FFTW_ESTIMATE);
+        p = fftwf_plan_r2r_1d(width, Ftr.data()+width*j, U.data()+width*j, FFTW_REDFT00, FFTW_ESTIMATE);
         fftwf_execute(p);
 
         for ( int i = 0; i < width; i++ ) {
@@ -122,10 +134,6 @@ void solve_pde_dct(Array2Df &F, Array2Df &U)
     }
 
     fftwf_destroy_plan(p);
-#ifdef TIMER_PROFILING
-    stop_watch.stop_and_update();
-    std::cout << "solve_pde_dct = " << stop_watch.get_time() << " msec" << std::endl;
-#endif
 }
 
 int findIndex(const float* data, int size)
@@ -375,10 +383,7 @@ bool comparePatches(const HdrCreationItem& item1,
 
 void computeIrradiance(Array2Df& irradiance, const Array2Df& in)
 {
-#ifdef TIMER_PROFILING
-    msec_timer stop_watch;
-    stop_watch.start();
-#endif
+    TraceSpan span("computeIrradiance");
 
     const int width = in.getCols();
     const int height = in.getRows();
@@ -388,18 +393,11 @@ void computeIrradiance(Array2Df& irradiance, const Array2Df& in)
         irradiance(i) = std::exp( in(i) );
     }
 
-#ifdef TIMER_PROFILING
-    stop_watch.stop_and_update();
-    std::cout << "computeIrradiance = " << stop_watch.get_time() << " msec" << std::endl;
-#endif
 }
 
 void computeLogIrradiance(Array2Df &logIrradiance, const Array2Df &u)
 {
-#ifdef TIMER_PROFILING
-    msec_timer stop_watch;
-    stop_watch.start();
-#endif
+    TraceSpan span("computeLogIrradiance");
     const int width = u.getCols();
     const int height = u.getRows();
 
@@ -415,18 +413,11 @@ void computeLogIrradiance(Array2Df &logIrradiance, const Array2Df &u)
             logIrradiance(i) = logIr;
     }
 
-#ifdef TIMER_PROFILING
-    stop_watch.stop_and_update();
-    std::cout << "computeLogIrradiance = " << stop_watch.get_time() << " msec" << std::endl;
-#endif
 }
 
 void computeGradient(Array2Df &gradientX, Array2Df &gradientY, const Array2Df& in)
 {
-#ifdef TIMER_PROFILING
-    msec_timer stop_watch;
-    stop_watch.start();
-#endif
+    TraceSpan span("computeGradient");
 
     const int width = in.getCols();
     const int height = in.getRows();
@@ -454,18 +445,11 @@ void computeGradient(Array2Df &gradientX, Array2Df &gradientY, const Array2Df& i
     }
     gradientX(0, 0) = gradientX(0, height-1) = gradientX(width-1, 0) = gradientX(width-1, height-1) = 0.0f;
     gradientY(0, 0) = gradientY(0, height-1) = gradientY(width-1, 0) = gradientY(width-1, height-1) = 0.0f;
-#ifdef TIMER_PROFILING
-    stop_watch.stop_and_update();
-    std::cout << "computeGradient = " << stop_watch.get_time() << " msec" << std::endl;
-#endif
 }
 
 void computeDivergence(Array2Df &divergence, const Array2Df& gradientX, const Array2Df& gradientY)
 {
-#ifdef TIMER_PROFILING
-    msec_timer stop_watch;
-    stop_watch.start();
-#endif
+    TraceSpan span("computeDivergence");
     const int width = gradientX.getCols();
     const int height = gradientX.getRows();
 
@@ -489,10 +473,6 @@ void computeDivergence(Array2Df &divergence, const Array2Df& gradientX, const Ar
         divergence(i, height-1) = 0.5f*(gradientX(i+1, height-1) - gradientX(i-1, height-1)) +
                                      gradientY(i, height-1) - gradientY(i, height-2);
     }
-#ifdef TIMER_PROFILING
-    stop_watch.stop_and_update();
-    std::cout << "computeDivergence = " << stop_watch.get_time() << " msec" << std::endl;
-#endif
 }
 
 void blendGradients(Array2Df &gradientXBlended, Array2Df &gradientYBlended,
@@ -500,10 +480,7 @@ void blendGradients(Array2Df &gradientXBlended, Array2Df &gradientYBlended,
                     const Array2Df &gradientXGood, const Array2Df &gradientYGood,
                     bool patches[agGridSize][agGridSize], const int gridX, const int gridY)
 {
-#ifdef TIMER_PROFILING
-    msec_timer stop_watch;
-    stop_watch.start();
-#endif
+    TraceSpan span("blendGradients");
     int width = gradientX.getCols();
     int height = gradientY.getRows();
 
@@ -543,10 +520,6 @@ void blendGradients(Array2Df &gradientXBlended, Array2Df &gradientYBlended,
             }
         }
     }
-#ifdef TIMER_PROFILING
-    stop_watch.stop_and_update();
-    std::cout << "blendGradients = " << stop_watch.get_time() << " msec" << std::endl;
-#endif
 }
 
 void blendGradients(Array2Df &gradientXBlended, Array2Df &gradientYBlended,
@@ -554,10 +527,7 @@ void blendGradients(Array2Df &gradientXBlended, Array2Df &gradientYBlended,
                     const Array2Df &gradientXGood, const Array2Df &gradientYGood,
                     const QImage& agMask)
 {
-#ifdef TIMER_PROFILING
-    msec_timer stop_watch;
-    stop_watch.start();
-#endif
+    TraceSpan span("blendGradients");
     int width = gradientX.getCols();
     int height = gradientY.getRows();
 
@@ -574,10 +544,232 @@ void blendGradients(Array2Df &gradientXBlended, Array2Df &gradientYBlended,
             }
         }
     }
-#ifdef TIMER_PROFILING
-    stop_watch.stop_and_update();
-    std::cout << "blendGradients = " << stop_watch.get_time() << " msec" << std::endl;
-#endif
+}
+
+namespace
+{
+inline
+float logIrradiance(float ir)
+{
+    return (ir == 0.0f) ? -11.09f : std::log(ir);
+}
+
+inline
+int clampIndex(int idx, int size)
+{
+    return std::max(0, std::min(idx, size - 1));
+}
+
+// seams of computeGradient: X is zero on the first and last column, Y on
+// the first and last row
+void gradientRow(float* gradientX, float* gradientY,
+                 const float* prev, const float* curr, const float* next,
+                 int j, int width, int height)
+{
+    gradientX[0] = gradientX[width-1] = 0.0f;
+    for (int i = 1; i < width-1; i++) {
+        gradientX[i] = 0.5f*(curr[i+1] - curr[i-1]);
+    }
+    if (j == 0 || j == height-1) {
+        std::fill(gradientY, gradientY + width, 0.0f);
+    } else {
+        for (int i = 0; i < width; i++) {
+            gradientY[i] = 0.5f*(next[i] - prev[i]);
+        }
+    }
+}
+
+// same stencils (and same untouched corners) of computeDivergence
+void divergenceRow(float* divergence,
+                   const float* prevX, const float* prevY,
+                   const float* currX, const float* currY,
+                   const float* nextX, const float* nextY,
+                   int j, int width, int height)
+{
+    std::fill(divergence, divergence + width, 0.0f);
+    if (j == 0) {
+        divergence[0] = currX[0] + currY[0];
+        for (int i = 1; i < width-1; i++) {
+            divergence[i] = 0.5f*(currX[i] - currX[i-1]) + currY[i];
+        }
+    } else if (j == height-1) {
+        for (int i = 1; i < width-1; i++) {
+            divergence[i] = 0.5f*(currX[i+1] - currX[i-1]) + currY[i] - prevY[i];
+        }
+    } else {
+        divergence[0] = currX[1] - currX[0] + 0.5f*(nextY[0] - prevY[0]);
+        for (int i = 1; i < width-1; i++) {
+            divergence[i] = 0.5f*(currX[i+1] - currX[i-1]) +
+                            0.5f*(nextY[i] - prevY[i]);
+        }
+        divergence[width-1] = currX[width-1] - currX[width-2] +
+                              0.5f*(currY[width-1] - prevY[width-1]);
+    }
+}
+
+//! \brief gradient rows around the row \c j of the good and of the current
+//! image, for the blending functors
+struct GradientRows
+{
+    const float* goodX;
+    const float* goodY;
+    const float* goodNextX;
+    const float* goodNextY;
+    const float* prevX;
+    const float* prevY;
+    const float* currX;
+    const float* currY;
+};
+
+class PatchBlender
+{
+public:
+    PatchBlender(bool patches[agGridSize][agGridSize], int gridX, int gridY)
+        : m_patches(patches)
+        , m_gridX(std::max(gridX, 1))
+        , m_gridY(std::max(gridY, 1))
+    {}
+
+    void operator()(float* blendedX, float* blendedY, const GradientRows& g,
+                    int j, int width) const
+    {
+        const int y = std::min(j/m_gridY, agGridSize - 1);
+        for (int i = 0; i < width; i++) {
+            const int x = std::min(i/m_gridX, agGridSize - 1);
+            if (!m_patches[x][y]) {
+                blendedX[i] = g.currX[i];
+                blendedY[i] = g.currY[i];
+                continue;
+            }
+            blendedX[i] = g.goodX[i];
+            blendedY[i] = g.goodY[i];
+            if (i % m_gridX == 0 && j >= 1) {
+                blendedX[i] = 0.5f*(g.goodNextX[i] + g.prevX[i]);
+                blendedY[i] = 0.5f*(g.goodNextY[i] + g.prevY[i]);
+            }
+            if (j % m_gridY == 0 && i >= 1) {
+                const int next = std::min(i + 1, width - 1);
+                blendedX[i] = 0.5f*(g.goodX[next] + g.currX[i-1]);
+                blendedY[i] = 0.5f*(g.goodY[next] + g.currY[i-1]);
+            }
+        }
+    }
+
+private:
+    bool (*m_patches)[agGridSize];
+    int m_gridX;
+    int m_gridY;
+};
+
+class MaskBlender
+{
+public:
+    explicit MaskBlender(const QImage& agMask)
+        : m_agMask(agMask)
+    {}
+
+    void operator()(float* blendedX, float* blendedY, const GradientRows& g,
+                    int j, int width) const
+    {
+        for (int i = 0; i < width; i++) {
+            const bool good = qAlpha(m_agMask.pixel(i, j)) != 0;
+            blendedX[i] = good ? g.goodX[i] : g.currX[i];
+            blendedY[i] = good ? g.goodY[i] : g.currY[i];
+        }
+    }
+
+private:
+    const QImage& m_agMask;
+};
+
+//! \brief rings of three rows: every stage needs the rows above and below
+//! the one it produces
+class RowRing
+{
+public:
+    explicit RowRing(int width)
+        : m_width(width)
+        , m_data(3*width)
+    {}
+
+    float* operator[](int row)
+    { return m_data.data() + (row % 3)*m_width; }
+
+private:
+    int m_width;
+    vector<float> m_data;
+};
+
+// step s reads the row s of the inputs, computes the gradients of the row
+// s-1, blends the row s-2 and writes the divergence of the row s-3
+template <typename Blender>
+void blendedDivergence(Array2Df &divergence,
+                       const Array2Df &good, const Array2Df &current,
+                       const Blender& blender)
+{
+    const int width = current.getCols();
+    const int height = current.getRows();
+    assert((int)good.getCols() == width && (int)good.getRows() == height);
+    assert((int)divergence.getCols() == width && (int)divergence.getRows() == height);
+
+    RowRing logGood(width), logCurr(width);
+    RowRing gradGoodX(width), gradGoodY(width);
+    RowRing gradCurrX(width), gradCurrY(width);
+    RowRing blendX(width), blendY(width);
+
+    for (int s = 0; s < height + 3; s++) {
+        if (s < height) {
+            std::transform(good.row_begin(s), good.row_end(s), logGood[s], logIrradiance);
+            std::transform(current.row_begin(s), current.row_end(s), logCurr[s], logIrradiance);
+        }
+
+        const int g = s - 1;
+        if (g >= 0 && g < height) {
+            const int prev = clampIndex(g - 1, height);
+            const int next = clampIndex(g + 1, height);
+            gradientRow(gradGoodX[g], gradGoodY[g],
+                        logGood[prev], logGood[g], logGood[next], g, width, height);
+            gradientRow(gradCurrX[g], gradCurrY[g],
+                        logCurr[prev], logCurr[g], logCurr[next], g, width, height);
+        }
+
+        const int b = s - 2;
+        if (b >= 0 && b < height) {
+            const int prev = clampIndex(b - 1, height);
+            const int next = clampIndex(b + 1, height);
+            GradientRows rows = {
+                gradGoodX[b], gradGoodY[b], gradGoodX[next], gradGoodY[next],
+                gradCurrX[prev], gradCurrY[prev], gradCurrX[b], gradCurrY[b]
+            };
+            blender(blendX[b], blendY[b], rows, b, width);
+        }
+
+        const int d = s - 3;
+        if (d >= 0) {
+            const int prev = clampIndex(d - 1, height);
+            const int next = clampIndex(d + 1, height);
+            divergenceRow(divergence.data() + d*width,
+                          blendX[prev], blendY[prev], blendX[d], blendY[d],
+                          blendX[next], blendY[next], d, width, height);
+        }
+    }
+}
+}
+
+void computeBlendedDivergence(Array2Df &divergence,
+                              const Array2Df &good, const Array2Df &current,
+                              bool patches[agGridSize][agGridSize], int gridX, int gridY)
+{
+    TraceSpan span("computeBlendedDivergence");
+    blendedDivergence(divergence, good, current, PatchBlender(patches, gridX, gridY));
+}
+
+void computeBlendedDivergence(Array2Df &divergence,
+                              const Array2Df &good, const Array2Df &current,
+                              const QImage& agMask)
+{
+    TraceSpan span("computeBlendedDivergence");
+    blendedDivergence(divergence, good, current, MaskBlender(agMask));
 }
 
 void colorBalance(pfs::Array2Df& U, const pfs::Array2Df& F, const int x, const int y)
@@ -33,6 +33,9 @@ using namespace pfs;
 float max(const Array2Df& u);
 float min(const Array2Df& u);
 void solve_pde_dct(Array2Df &F, Array2Df &U);
+//! \brief as above, with a caller supplied plane (same size of \a U) for the
+//! spectrum, so consecutive solutions can share it
+void solve_pde_dct(Array2Df &F, Array2Df &U, Array2Df &scratch);
 void clampToZero(Array2Df &R, Array2Df &G, Array2Df &B, float m);
 int findIndex(const float* data, int size);
 void hueSquaredMean(const HdrCreationItemContainer& data,
@@ -69,6 +72,22 @@ void blendGradients(Array2Df &gradientXBlended, Array2Df &gradientYBlended,
                     const Array2Df &gradientXGood, const Array2Df &gradientYGood,
                     const QImage& agMask);
 
+//! \brief log irradiance, gradients, blending and divergence of one channel
+//! in a single pass: same result of the chain computeLogIrradiance,
+//! computeGradient, blendGradients and computeDivergence, with a few rows of
+//! scratch memory instead of ten full planes.
+//! \a divergence can be \a current itself, it is written three rows behind
+//! the one being read
+//! \note the patch indexes and the seams at the right and bottom borders
+//! are clamped inside the image
+void computeBlendedDivergence(Array2Df &divergence,
+                              const Array2Df &good, const Array2Df &current,
+                              bool patches[agGridSize][agGridSize], int gridX, int gridY);
+
+void computeBlendedDivergence(Array2Df &divergence,
+                              const Array2Df &good, const Array2Df &current,
+                              const QImage& agMask);
+
 void colorBalance(pfs::Array2Df& U, const pfs::Array2Df& F,  int x, int y);
 qreal averageLightness(const Array2Df& R, const Array2Df& G, const Array2Df& B,
                const int i, const int j, const int gridX, const int gridY);
@@ -60,3 +60,50 @@ HdrCreationItem::~HdrCreationItem()
     // qDebug() << QString("Destroying HdrCreationItem for %1").arg(m_filename);
 }
 
+
+const pfs::FramePtr& HdrCreationItem::frame() const
+{
+    if ( m_codes )
+    {
+        m_frame.reset(m_codes->expand());
+        m_codes.reset();
+        m_reservation.reset();
+    }
+    return m_frame;
+}
+
+pfs::FramePtr& HdrCreationItem::frame()
+{
+    static_cast<const HdrCreationItem&>(*this).frame();
+    return m_frame;
+}
+
+void HdrCreationItem::setFrame(const pfs::FramePtr& frame)
+{
+    m_frame = frame;
+    m_codes.reset();
+    m_reservation.reset();
+}
+
+void HdrCreationItem::setCodes(const pfs::QuantizedFramePtr& codes)
+{
+    m_codes = codes;
+    m_codesHash = codes->getContentHash();
+    m_frame = std::make_shared<pfs::Frame>();
+    m_reservation.reset();
+}
+
+size_t HdrCreationItem::width() const
+{
+    return m_codes ? m_codes->getWidth() : m_frame->getWidth();
+}
+
+size_t HdrCreationItem::height() const
+{
+    return m_codes ? m_codes->getHeight() : m_frame->getHeight();
+}
+
+pfs::utils::Hash128 HdrCreationItem::contentHash() const
+{
+    return m_codes ? m_codesHash : m_frame->getContentHash();
+}
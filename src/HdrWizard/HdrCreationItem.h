@@ -28,6 +28,11 @@
 #include <QImage>
 #include <QString>
 #include <Libpfs/frame.h>
+#include <Libpfs/quantizedframe.h>
+#include <Libpfs/utils/hash.h>
+#include <Libpfs/utils/memorybudget.h>
+
+#include <memory>
 
 #include <cmath>
 #include "arch/math.h"
@@ -47,9 +52,30 @@ public:
     const QString& alignedFilename() const { return m_alignedFilename; }
     void setAlignedFilename(const QString& f) { m_alignedFilename = f; }
 
-    const pfs::FramePtr& frame() const  { return m_frame; }
-    pfs::FramePtr& frame()              { return m_frame; }
-    bool isValid() const                { return m_frame->isValid(); }
+    //! \brief frame of the item. When the item holds the codes of its file
+    //! (see setCodes()), they are expanded on the first call and dropped
+    const pfs::FramePtr& frame() const;
+    pfs::FramePtr& frame();
+    void setFrame(const pfs::FramePtr& frame);
+    bool isValid() const                { return m_codes || m_frame->isValid(); }
+
+    //! \brief codes of the file, NULL once the frame has been expanded
+    const pfs::QuantizedFramePtr& codes() const { return m_codes; }
+    //! \brief keep the item as the 8 or 16 bit codes of its file
+    void setCodes(const pfs::QuantizedFramePtr& codes);
+
+    //! \brief size of the item, without expanding its codes
+    size_t width() const;
+    size_t height() const;
+    //! \brief hash of the content of the item, without expanding its codes
+    pfs::utils::Hash128 contentHash() const;
+
+    //! \brief memory of the data read by LoadFile, detached from its job: it
+    //! stays in the budget until the codes are expanded (the float frame is
+    //! counted on its own) or the data is replaced. setFrame() and setCodes()
+    //! drop it
+    void setReservation(const std::shared_ptr<pfs::utils::MemoryReservation>& r)
+    { m_reservation = r; }
 
     bool hasAverageLuminance() const    { return (m_averageLuminance != -1.f); }
     void setAverageLuminance(float avl) { m_averageLuminance = avl; }
@@ -79,7 +105,11 @@ private:
     float                   m_exposureTime;
     float                   m_datamin;
     float                   m_datamax;
-    pfs::FramePtr           m_frame;
+    // declared before the data: released after it
+    mutable std::shared_ptr<pfs::utils::MemoryReservation> m_reservation;
+    mutable pfs::FramePtr   m_frame;
+    mutable pfs::QuantizedFramePtr m_codes;
+    pfs::utils::Hash128     m_codesHash;
     QSharedPointer<QImage>  m_thumbnail;
 };
 
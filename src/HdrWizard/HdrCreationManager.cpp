@@ -47,7 +47,7 @@
 
 #include "Common/CommonFunctions.h"
 #include <Libpfs/frame.h>
-#include <Libpfs/utils/msec_timer.h>
+#include <Libpfs/utils/trace.h>
 #include <Libpfs/io/tiffwriter.h>
 #include <Libpfs/io/tiffreader.h>
 #include <Libpfs/io/framereader.h>
@@ -77,12 +77,12 @@ using namespace libhdr::fusion;
 
 const FusionOperatorConfig predef_confs[6] =
 {
-    {WEIGHT_TRIANGULAR, RESPONSE_LINEAR, DEBEVEC, QString(), QString()},
-    {WEIGHT_TRIANGULAR, RESPONSE_GAMMA, DEBEVEC, QString(), QString()},
-    {WEIGHT_PLATEAU, RESPONSE_LINEAR, DEBEVEC, QString(), QString()},
-    {WEIGHT_PLATEAU, RESPONSE_GAMMA, DEBEVEC, QString(), QString()},
-    {WEIGHT_GAUSSIAN, RESPONSE_LINEAR, DEBEVEC, QString(), QString()},
-    {WEIGHT_GAUSSIAN, RESPONSE_GAMMA, DEBEVEC, QString(), QString()},
+    {WEIGHT_TRIANGULAR, RESPONSE_LINEAR, DEBEVEC, std::string(), std::string()},
+    {WEIGHT_TRIANGULAR, RESPONSE_GAMMA, DEBEVEC, std::string(), std::string()},
+    {WEIGHT_PLATEAU, RESPONSE_LINEAR, DEBEVEC, std::string(), std::string()},
+    {WEIGHT_PLATEAU, RESPONSE_GAMMA, DEBEVEC, std::string(), std::string()},
+    {WEIGHT_GAUSSIAN, RESPONSE_LINEAR, DEBEVEC, std::string(), std::string()},
+    {WEIGHT_GAUSSIAN, RESPONSE_GAMMA, DEBEVEC, std::string(), std::string()},
 };
 
 // --- NEW CODE ---
@@ -113,7 +113,7 @@ QImage* shiftQImage(const QImage *in, int dx, int dy)
 void shiftItem(HdrCreationItem& item, int dx, int dy)
 {
     FramePtr shiftedFrame( pfs::shift(*item.frame(), dx, dy) );
-    item.frame().swap(shiftedFrame);
+    item.setFrame(shiftedFrame);
     shiftedFrame.reset();       // release memory
 
     QScopedPointer<QImage> img(shiftQImage(&item.qimage(), dx, dy));
@@ -127,6 +127,11 @@ bool checkFileName(const HdrCreationItem& item, const QString& str) {
     return (item.filename().compare(str) == 0);
 }
 
+static
+bool checkContent(const HdrCreationItem& item, const HdrCreationItem& other) {
+    return (item.contentHash() == other.contentHash());
+}
+
 void HdrCreationManager::loadFiles(const QStringList &filenames)
 {
     for(const auto filename : filenames)
@@ -178,10 +183,22 @@ void HdrCreationManager::loadFilesDone()
         }
     }
     disconnect(&m_futureWatcher, SIGNAL(finished()), this, SLOT(loadFilesDone()));
+    QStringList duplicates;
     for(const auto hdrCreationItem : m_tmpdata)
     {
         if (hdrCreationItem.isValid())
         {
+            // the same image under another name (a copy, a conversion)?
+            HdrCreationItemContainer::iterator it = find_if(m_data.begin(), m_data.end(),
+                                                            boost::bind(&checkContent, _1, hdrCreationItem));
+            if (it != m_data.end())
+            {
+                qDebug() << QString("HdrCreationManager::loadFilesDone(): %1 is a duplicate of %2").arg(hdrCreationItem.filename()).arg(it->filename());
+                duplicates << tr("%1 (same image as %2)")
+                              .arg(QFileInfo(hdrCreationItem.filename()).fileName())
+                              .arg(QFileInfo(it->filename()).fileName());
+                continue;
+            }
             qDebug() << QString("HdrCreationManager::loadFilesDone(): Insert data for %1").arg(hdrCreationItem.filename());
             m_data.push_back(hdrCreationItem);
         }
@@ -197,6 +214,10 @@ void HdrCreationManager::loadFilesDone()
     }
     else
     {
+        if (!duplicates.isEmpty())
+        {
+            emit duplicatesSkipped(duplicates);
+        }
         emit finishedLoadingFiles();
     }
 }
@@ -307,10 +328,10 @@ HdrCreationManager::HdrCreationManager(bool fromCommandLine)
 
 void HdrCreationManager::setConfig(const FusionOperatorConfig &c)
 {
-    if (!c.inputResponseCurveFilename.isEmpty())
+    if (!c.inputResponseCurveFilename.empty())
     {
         setLoadResponseCurve(true);
-        setResponseCurveInputFilename(c.inputResponseCurveFilename);
+        setResponseCurveInputFilename(QString::fromStdString(c.inputResponseCurveFilename));
     }
     else
     {
@@ -332,11 +353,11 @@ QVector<float> HdrCreationManager::getExpotimes() const
 
 bool HdrCreationManager::framesHaveSameSize()
 {
-    size_t width = m_data[0].frame()->getWidth();
-    size_t height = m_data[0].frame()->getHeight();
+    size_t width = m_data[0].width();
+    size_t height = m_data[0].height();
     for ( HdrCreationItemContainer::const_iterator it = m_data.begin() + 1,
           itEnd = m_data.end(); it != itEnd; ++it) {
-        if (it->frame()->getWidth() != width || it->frame()->getHeight() != height)
+        if (it->width() != width || it->height() != height)
             return false;
     }
     return true;
@@ -391,12 +412,17 @@ pfs::Frame* HdrCreationManager::createHdr()
 
     for (size_t idx = 0; idx < m_data.size(); ++idx)
     {
-        frames.push_back(
-                    FrameEnhanced(
-                        m_data[idx].frame(),
-                        std::pow(2.f, m_data[idx].getEV() - m_evOffset)
-                        )
-                    );
+        const float averageLuminance = std::pow(2.f, m_data[idx].getEV() - m_evOffset);
+        // brackets never edited are still codes: the fusion expands them
+        // only if it needs floats
+        if ( m_data[idx].codes() )
+        {
+            frames.push_back(FrameEnhanced(m_data[idx].codes(), averageLuminance));
+        }
+        else
+        {
+            frames.push_back(FrameEnhanced(m_data[idx].frame(), averageLuminance));
+        }
     }
 
     libhdr::fusion::FusionOperatorPtr fusionOperatorPtr = IFusionOperator::build(m_fusionOperator);
@@ -449,7 +475,7 @@ void HdrCreationManager::cropItems(const QRect& ca)
                         static_cast<size_t>(x_ul), static_cast<size_t>(y_ur),
                         static_cast<size_t>(x_bl), static_cast<size_t>(y_br))
                     );
-        m_data[idx].frame().swap(cropped);
+        m_data[idx].setFrame(cropped);
         cropped.reset();
     }
 }
@@ -483,10 +509,7 @@ int HdrCreationManager::computePatches(float threshold, bool patches[][agGridSiz
 {
     qDebug() << "HdrCreationManager::computePatches";
     qDebug() << threshold;
-#ifdef TIMER_PROFILING
-    msec_timer stop_watch;
-    stop_watch.start();
-#endif
+    TraceSpan span("computePatches");
     const int width = m_data[0].frame()->getWidth();
     const int height = m_data[0].frame()->getHeight();
     const int gridX = width / agGridSize;
@@ -537,10 +560,6 @@ int HdrCreationManager::computePatches(float threshold, bool patches[][agGridSiz
 
     memcpy(patches, m_patches, agGridSize*agGridSize);
 
-#ifdef TIMER_PROFILING
-    stop_watch.stop_and_update();
-    std::cout << "computePatches = " << stop_watch.get_time() << " msec" << std::endl;
-#endif
     return m_agGoodImageIndex;
 }
 
@@ -548,10 +567,7 @@ int HdrCreationManager::computePatches(float threshold, bool patches[][agGridSiz
 pfs::Frame *HdrCreationManager::doAntiGhosting(bool patches[][agGridSize], int h0, bool manualAg, ProgressHelper *ph)
 {
     qDebug() << "HdrCreationManager::doAntiGhosting";
-#ifdef TIMER_PROFILING
-    msec_timer stop_watch;
-    stop_watch.start();
-#endif
+    TraceSpan span("doAntiGhosting");
     const int width = m_data[0].frame()->getWidth();
     const int height = m_data[0].frame()->getHeight();
     const int gridX = width / agGridSize;
@@ -566,15 +582,9 @@ pfs::Frame *HdrCreationManager::doAntiGhosting(bool patches[][agGridSize], int h
     float cmin[3];
     float Max, Min;
 
-    const Channel *Good_Rc, *Good_Gc, *Good_Bc;
     Channel *Ch_Good[3];
     m_data[h0].frame().get()->getXYZChannels(Ch_Good[0], Ch_Good[1], Ch_Good[2]);
 
-    Good_Rc = Ch_Good[0];
-    Good_Gc = Ch_Good[1];
-    Good_Bc = Ch_Good[2];
-
-    const Channel *Rc, *Gc, *Bc;
     Channel *Ch[3];
     Frame* ghosted = createHdr();
     ghosted->getXYZChannels(Ch[0], Ch[1], Ch[2]);
@@ -592,289 +602,58 @@ pfs::Frame *HdrCreationManager::doAntiGhosting(bool patches[][agGridSize], int h
         transform(Ch[c]->begin(), Ch[c]->end(), Ch[c]->begin(), Normalizer(Min, Max));
     }
 
-    Rc = Ch[0];
-    Gc = Ch[1];
-    Bc = Ch[2];
-
     ph->setValue(20);
-    if (ph->canceled()) return NULL;
-
-    Array2Df* logIrradianceGood_R = new Array2Df(width, height);
-    computeLogIrradiance(*logIrradianceGood_R, *Good_Rc);
-    ph->setValue(22);
-    if (ph->canceled()) {
-        delete logIrradianceGood_R;
-        return NULL;
-    }
-    Array2Df* logIrradianceGood_G = new Array2Df(width, height);
-    computeLogIrradiance(*logIrradianceGood_G, *Good_Gc);
-    ph->setValue(24);
-    if (ph->canceled()) {
-        delete logIrradianceGood_G;
-        return NULL;
-    }
-    Array2Df* logIrradianceGood_B = new Array2Df(width, height);
-    computeLogIrradiance(*logIrradianceGood_B, *Good_Bc);
-    ph->setValue(26);
-    if (ph->canceled()) {
-        delete logIrradianceGood_B;
-        return NULL;
-    }
-    Array2Df* logIrradiance_R = new Array2Df(width, height);
-    computeLogIrradiance(*logIrradiance_R, *Rc);
-    ph->setValue(28);
     if (ph->canceled()) {
-        delete logIrradiance_R;
-        return NULL;
-    }
-    Array2Df* logIrradiance_G = new Array2Df(width, height);
-    computeLogIrradiance(*logIrradiance_G, *Gc);
-    ph->setValue(30);
-    if (ph->canceled()) {
-        delete logIrradiance_G;
-        return NULL;
-    }
-    Array2Df* logIrradiance_B = new Array2Df(width, height);
-    computeLogIrradiance(*logIrradiance_B, *Bc);
-    ph->setValue(32);
-    if (ph->canceled()) {
-        delete logIrradiance_B;
-        return NULL;
-    }
-
-    Array2Df* gradientXGood_R = new Array2Df(width, height);
-    Array2Df* gradientYGood_R = new Array2Df(width, height);
-    Array2Df* gradientX_R = new Array2Df(width, height);
-    Array2Df* gradientY_R = new Array2Df(width, height);
-    Array2Df* gradientXBlended_R = new Array2Df(width, height);
-    Array2Df* gradientYBlended_R = new Array2Df(width, height);
-    computeGradient(*gradientXGood_R, *gradientYGood_R, *logIrradianceGood_R);
-    delete logIrradianceGood_R;
-    ph->setValue(33);
-    if (ph->canceled()) {
-        delete gradientXGood_R;
-        delete gradientYGood_R;
-        delete gradientX_R;
-        delete gradientY_R;
-        delete gradientXBlended_R;
-        delete gradientYBlended_R;
-        return NULL;
-    }
-    computeGradient(*gradientX_R, *gradientY_R, *logIrradiance_R);
-    ph->setValue(34);
-    if (ph->canceled()) {
-        delete gradientXGood_R;
-        delete gradientYGood_R;
-        delete gradientX_R;
-        delete gradientY_R;
-        delete gradientXBlended_R;
-        delete gradientYBlended_R;
-        return NULL;
-    }
-    if (manualAg)
-        blendGradients(*gradientXBlended_R, *gradientYBlended_R,
-                       *gradientX_R, *gradientY_R,
-                       *gradientXGood_R, *gradientYGood_R,
-                       *m_agMask);
-    else
-        blendGradients(*gradientXBlended_R, *gradientYBlended_R,
-                       *gradientX_R, *gradientY_R,
-                       *gradientXGood_R, *gradientYGood_R,
-                       patches, gridX, gridY);
-    delete gradientX_R;
-    delete gradientY_R;
-    delete gradientXGood_R;
-    delete gradientYGood_R;
-    ph->setValue(35);
-    if (ph->canceled()) {
-        delete gradientXBlended_R;
-        delete gradientYBlended_R;
+        delete ghosted;
         return NULL;
     }
 
-    Array2Df* gradientXGood_G = new Array2Df(width, height);
-    Array2Df* gradientYGood_G = new Array2Df(width, height);
-    Array2Df* gradientX_G = new Array2Df(width, height);
-    Array2Df* gradientY_G = new Array2Df(width, height);
-    Array2Df* gradientXBlended_G = new Array2Df(width, height);
-    Array2Df* gradientYBlended_G = new Array2Df(width, height);
-    computeGradient(*gradientXGood_G, *gradientYGood_G, *logIrradianceGood_G);
-    delete logIrradianceGood_G;
-    ph->setValue(36);
-    if (ph->canceled()) {
-        delete gradientXGood_G;
-        delete gradientYGood_G;
-        delete gradientX_G;
-        delete gradientY_G;
-        delete gradientXBlended_G;
-        delete gradientYBlended_G;
-        return NULL;
-    }
-    computeGradient(*gradientX_G, *gradientY_G, *logIrradiance_G);
-    ph->setValue(37);
-    if (ph->canceled()) {
-        delete gradientXGood_G;
-        delete gradientYGood_G;
-        delete gradientX_G;
-        delete gradientY_G;
-        delete gradientXBlended_G;
-        delete gradientYBlended_G;
-        return NULL;
-    }
-    if (manualAg)
-        blendGradients(*gradientXBlended_G, *gradientYBlended_G,
-                       *gradientX_G, *gradientY_G,
-                       *gradientXGood_G, *gradientYGood_G,
-                       *m_agMask);
-    else
-        blendGradients(*gradientXBlended_G, *gradientYBlended_G,
-                       *gradientX_G, *gradientY_G,
-                       *gradientXGood_G, *gradientYGood_G,
-                       patches, gridX, gridY);
-    delete gradientX_G;
-    delete gradientY_G;
-    delete gradientXGood_G;
-    delete gradientYGood_G;
-    ph->setValue(38);
-    if (ph->canceled()) {
-        delete gradientXBlended_G;
-        delete gradientYBlended_G;
-        return NULL;
-    }
-
-    Array2Df* gradientXGood_B = new Array2Df(width, height);
-    Array2Df* gradientYGood_B = new Array2Df(width, height);
-    Array2Df* gradientX_B = new Array2Df(width, height);
-    Array2Df* gradientY_B = new Array2Df(width, height);
-    Array2Df* gradientXBlended_B = new Array2Df(width, height);
-    Array2Df* gradientYBlended_B = new Array2Df(width, height);
-    computeGradient(*gradientXGood_B, *gradientYGood_B, *logIrradianceGood_B);
-    delete logIrradianceGood_B;
-    ph->setValue(39);
-    if (ph->canceled()) {
-        delete gradientXGood_B;
-        delete gradientYGood_B;
-        delete gradientX_B;
-        delete gradientY_B;
-        delete gradientXBlended_B;
-        delete gradientYBlended_B;
-        return NULL;
-    }
-    computeGradient(*gradientX_B, *gradientY_B, *logIrradiance_B);
-    ph->setValue(40);
-    if (ph->canceled()) {
-        delete gradientXGood_B;
-        delete gradientYGood_B;
-        delete gradientX_B;
-        delete gradientY_B;
-        delete gradientXBlended_B;
-        delete gradientYBlended_B;
-        return NULL;
-    }
-    if (manualAg)
-        blendGradients(*gradientXBlended_B, *gradientYBlended_B,
-                       *gradientX_B, *gradientY_B,
-                       *gradientXGood_B, *gradientYGood_B,
-                       *m_agMask);
-    else
-        blendGradients(*gradientXBlended_B, *gradientYBlended_B,
-                       *gradientX_B, *gradientY_B,
-                       *gradientXGood_B, *gradientYGood_B,
-                       patches, gridX, gridY);
-    delete gradientX_B;
-    delete gradientY_B;
-    delete gradientXGood_B;
-    delete gradientYGood_B;
-    ph->setValue(41);
-    if (ph->canceled()) {
-        delete gradientXBlended_B;
-        delete gradientYBlended_B;
-        return NULL;
-    }
-
-    Array2Df* divergence_R = new Array2Df(width, height);
-    computeDivergence(*divergence_R, *gradientXBlended_R, *gradientYBlended_R);
-    delete gradientXBlended_R;
-    delete gradientYBlended_R;
-    ph->setValue(42);
-    if (ph->canceled()) {
-        delete divergence_R;
-        return NULL;
-    }
-    Array2Df* divergence_G = new Array2Df(width, height);
-    computeDivergence(*divergence_G, *gradientXBlended_G, *gradientYBlended_G);
-    delete gradientXBlended_G;
-    delete gradientYBlended_G;
-    ph->setValue(43);
-    if (ph->canceled()) {
-        delete divergence_G;
-        return NULL;
+    // log irradiance, gradients, blending and divergence in one pass per
+    // channel: the divergence replaces the ghosted HDR in place, so the whole
+    // chain only needs a few rows of scratch memory
+    #pragma omp parallel for schedule(static, 1)
+    for (int c = 0; c < 3; c++) {
+        if (manualAg)
+            computeBlendedDivergence(*Ch[c], *Ch_Good[c], *Ch[c], *m_agMask);
+        else
+            computeBlendedDivergence(*Ch[c], *Ch_Good[c], *Ch[c], patches, gridX, gridY);
     }
-    Array2Df* divergence_B = new Array2Df(width, height);
-    computeDivergence(*divergence_B, *gradientXBlended_B, *gradientYBlended_B);
-    delete gradientXBlended_B;
-    delete gradientYBlended_B;
     ph->setValue(44);
     if (ph->canceled()) {
-        delete divergence_B;
-        return NULL;
-    }
-
-    qDebug() << "solve_pde";
-    solve_pde_dct(*divergence_R, *logIrradiance_R);
-    qDebug() << "residual: " << residual_pde(logIrradiance_R, divergence_R);
-    delete divergence_R;
-    ph->setValue(60);
-    if (ph->canceled()) {
-        delete logIrradiance_R;
-        return NULL;
-    }
-
-    qDebug() << "solve_pde";
-    solve_pde_dct(*divergence_G, *logIrradiance_G);
-    qDebug() << "residual: " << residual_pde(logIrradiance_G, divergence_G);
-    delete divergence_G;
-    ph->setValue(76);
-    if (ph->canceled()) {
-        delete logIrradiance_G;
-        return NULL;
-    }
-
-    qDebug() << "solve_pde";
-    solve_pde_dct(*divergence_B, *logIrradiance_B);
-    qDebug() << "residual: " << residual_pde(logIrradiance_B, divergence_B);
-    delete divergence_B;
-    ph->setValue(93);
-    if (ph->canceled()) {
-        delete logIrradiance_B;
+        delete ghosted;
         return NULL;
     }
 
     Frame* deghosted = new Frame(width, height);
-    //Channel *Urc, *Ugc, *Ubc;
     Channel *Uc[3];
     deghosted->createXYZChannels(Uc[0], Uc[1], Uc[2]);
 
-    computeIrradiance(*Uc[0], *logIrradiance_R);
-    delete logIrradiance_R;
-    ph->setValue(94);
-    if (ph->canceled()) {
-        delete deghosted;
-        return NULL;
-    }
-    computeIrradiance(*Uc[1], *logIrradiance_G);
-    delete logIrradiance_G;
-    ph->setValue(95);
-    if (ph->canceled()) {
-        delete deghosted;
-        return NULL;
+    // the log irradiance is solved straight into the output channels, the
+    // spectrum plane is shared by the three solutions
+    const int solveProgress[3] = {60, 76, 93};
+    {
+        Array2Df spectrum(width, height);
+        for (int c = 0; c < 3; c++) {
+            qDebug() << "solve_pde";
+            solve_pde_dct(*Ch[c], *Uc[c], spectrum);
+            qDebug() << "residual: " << residual_pde(Uc[c], Ch[c]);
+            ph->setValue(solveProgress[c]);
+            if (ph->canceled()) {
+                delete ghosted;
+                delete deghosted;
+                return NULL;
+            }
+        }
     }
-    computeIrradiance(*Uc[2], *logIrradiance_B);
-    delete logIrradiance_B;
-    ph->setValue(96);
-    if (ph->canceled()) {
-        delete deghosted;
-        return NULL;
+    delete ghosted;
+
+    for (int c = 0; c < 3; c++) {
+        computeIrradiance(*Uc[c], *Uc[c]);
+        ph->setValue(94 + c);
+        if (ph->canceled()) {
+            delete deghosted;
+            return NULL;
+        }
     }
     //shadesOfGrayAWB(*Uc[0], *Uc[1], *Uc[2]);
 
@@ -894,12 +673,7 @@ pfs::Frame *HdrCreationManager::doAntiGhosting(bool patches[][agGridSize], int h
     ph->setValue(100);
 
     emit progressFinished();
-    delete ghosted;
     this->reset();
-#ifdef TIMER_PROFILING
-    stop_watch.stop_and_update();
-    std::cout << "doAntiGhosting = " << stop_watch.get_time() << " msec" << std::endl;
-#endif
     return deghosted;
 }
 
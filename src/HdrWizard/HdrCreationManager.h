@@ -137,6 +137,10 @@ signals:
     void progressRangeChanged(int,int);
     void progressValueChanged(int);
     void finishedLoadingFiles();
+    //! \brief files left out by the last loadFiles() call as they hold the
+    //! same image as a file already loaded, each as "skipped (kept)";
+    //! emitted before finishedLoadingFiles()
+    void duplicatesSkipped(const QStringList& files);
 
     // legacy code
     void finishedLoadingInputFiles(const QStringList& filesLackingExif);
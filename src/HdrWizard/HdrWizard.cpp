@@ -213,6 +213,7 @@ void HdrWizard::setupConnections()
     //connect(&m_ioFutureWatcher, SIGNAL(finished()), this, SLOT(loadInputFilesDone()));
 
     connect(m_hdrCreationManager.data(), SIGNAL(finishedLoadingFiles()), this, SLOT(loadInputFilesDone()));
+    connect(m_hdrCreationManager.data(), SIGNAL(duplicatesSkipped(QStringList)), this, SLOT(duplicatesSkipped(QStringList)), Qt::QueuedConnection);
     //connect(m_hdrCreationManager.data(), SIGNAL(progressStarted()), m_Ui->progressBar, SLOT(show()), Qt::DirectConnection);
     //connect(m_hdrCreationManager.data(), SIGNAL(progressFinished()), m_Ui->progressBar, SLOT(reset()));
     //connect(m_hdrCreationManager.data(), SIGNAL(progressFinished()), m_Ui->progressBar, SLOT(hide()), Qt::DirectConnection);
@@ -570,6 +571,17 @@ void HdrWizard::loadInputFilesDone()
     QApplication::restoreOverrideCursor();
 }
 
+void HdrWizard::duplicatesSkipped(const QStringList& files)
+{
+    QString message = tr("The following images have already been loaded under another name and have been skipped:") + "<ul>";
+    foreach(const QString& file, files) {
+        message += "<li>" + file.toHtmlEscaped() + "</li>";
+    }
+    message += "</ul>";
+
+    QMessageBox::information(this, tr("Duplicate images"), message);
+}
+
 // this function should be called if we have at least a file currently in
 // memory, otherwise it will give a misleading information
 void HdrWizard::enableNextOrWarning(const QStringList& filesWithoutExif)
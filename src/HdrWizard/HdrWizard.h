@@ -95,6 +95,7 @@ signals:
 private slots:
     void loadInputFiles(const QStringList& files);
     void loadInputFilesDone();
+    void duplicatesSkipped(const QStringList& files);
 
     void loadImagesButtonClicked();
     void removeImageButtonClicked();
@@ -317,6 +317,9 @@ void whiteBalance(Frame& frame, WhiteBalanceType type)
     frame.getXYZChannels(r, g, b);
 
     whiteBalance(*r, *g, *b, type);
+
+    // a hash taken while the channels were written is stale
+    frame.invalidateContentHash();
 }
 
 void whiteBalance(pfs::Array2Df& R, pfs::Array2Df& G, pfs::Array2Df& B, WhiteBalanceType type)
@@ -23,7 +23,11 @@ enum WhiteBalanceType
     WB_SHADESOFGRAY = 2
 };
 
+//! \brief balance the RGB channels of \a frame in place, dropping its
+//! content hash when done
 void whiteBalance(pfs::Frame& frame, WhiteBalanceType type);
+//! \note the frame owning \a R, \a G and \a B keeps its content hash: call
+//! pfs::Frame::invalidateContentHash() on it
 void whiteBalance(pfs::Array2Df& R, pfs::Array2Df& G, pfs::Array2Df& B, WhiteBalanceType type);
 
 #endif // WHITEBALANCE_H
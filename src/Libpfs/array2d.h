@@ -28,6 +28,7 @@
 #include <algorithm>
 
 #include <Libpfs/strideiterator.h>
+#include <Libpfs/utils/frameallocator.h>
 
 //! \file array2d.h
 //! \brief general 2d array interface
@@ -50,7 +51,7 @@ template <typename Type>
 class Array2D
 {
 public:
-    typedef std::vector<Type>                   DataBuffer;
+    typedef std::vector<Type, utils::FrameAllocator<Type> > DataBuffer;
     typedef typename DataBuffer::value_type     value_type;
     typedef Array2D<Type>                       self;
 
@@ -58,6 +59,9 @@ public:
     Array2D();
 
     //! \brief init \c Array2D with a matrix of \a cols times \a rows
+    //! \note the samples are zeroed in parallel, with the split of the loops
+    //! of utils::parallelFor, so the pages land on the NUMA nodes that will
+    //! process them
     Array2D(size_t cols, size_t rows); // (width, height)
 
     //! \brief copy ctor
@@ -29,13 +29,69 @@
 
 #include <iostream>
 #include <cassert>
+#include <algorithm>
+#include <type_traits>
 
 #include <Libpfs/array2d.h>
 #include <Libpfs/utils/numeric.h>
+#include <Libpfs/utils/parallel.h>
 
 using namespace std;
 
 namespace pfs {
+namespace utils {
+namespace detail {
+
+//! \brief first touch of the buffers of Array2D: samples are written by
+//! the same split of the loops over the samples that will process them.
+//! Types that are not plain numbers (bool included, packed by std::vector)
+//! are initialised by the container itself
+template <typename Type,
+          bool Parallel = std::is_arithmetic<Type>::value &&
+                          !std::is_same<Type, bool>::value>
+struct FrameBuffer
+{
+    typedef typename Array2D<Type>::DataBuffer DataBuffer;
+
+    //! \brief zero the samples from \a first to the end
+    static void clear(DataBuffer& buffer, size_t first)
+    {
+        Type* data = buffer.data();
+        utils::parallelFor(first, buffer.size(), utils::PARALLEL_SAMPLES_GRAIN,
+                           [data](size_t b, size_t e)
+        {
+            std::fill(data + b, data + e, Type());
+        });
+    }
+
+    static DataBuffer copy(const DataBuffer& from)
+    {
+        DataBuffer buffer(from.size());
+        const Type* in = from.data();
+        Type* out = buffer.data();
+        utils::parallelFor(0, from.size(), utils::PARALLEL_SAMPLES_GRAIN,
+                           [in, out](size_t b, size_t e)
+        {
+            std::copy(in + b, in + e, out + b);
+        });
+        return buffer;
+    }
+};
+
+template <typename Type>
+struct FrameBuffer<Type, false>
+{
+    typedef typename Array2D<Type>::DataBuffer DataBuffer;
+
+    static void clear(DataBuffer&, size_t)
+    {}
+
+    static DataBuffer copy(const DataBuffer& from)
+    { return from; }
+};
+
+}   // detail
+}   // utils
 
 template <typename Type>
 Array2D<Type>::Array2D()
@@ -50,12 +106,13 @@ Array2D<Type>::Array2D(size_t cols, size_t rows)
     , m_cols(cols)
     , m_rows(rows)
 {
+    utils::detail::FrameBuffer<Type>::clear(m_data, 0);
     assert( m_data.size() >= m_cols*m_rows);
 }
 
 template <typename Type>
 Array2D<Type>::Array2D(const self& rhs)
-    : m_data(rhs.m_data)
+    : m_data(utils::detail::FrameBuffer<Type>::copy(rhs.m_data))
     , m_cols(rhs.m_cols)
     , m_rows(rhs.m_rows)
 {
@@ -76,7 +133,9 @@ Array2D<Type>& Array2D<Type>::operator=(const Array2D<Type>& other)
 template <typename Type>
 void Array2D<Type>::resize(size_t width, size_t height)
 {
+    const size_t previousSize = m_data.size();
     m_data.resize( width*height );
+    utils::detail::FrameBuffer<Type>::clear(m_data, previousSize);
     m_cols = width;
     m_rows = height;
 
@@ -0,0 +1,109 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#ifndef PFS_ARRAY2D_VIEW_H
+#define PFS_ARRAY2D_VIEW_H
+
+#include <cstddef>
+#include <cassert>
+
+//! \file array2d_view.h
+//! \brief non-owning rectangular view over 2d data
+
+namespace pfs
+{
+//!
+//! \brief Non-owning window over a row-major buffer
+//!
+//! An \c Array2DView points inside the memory of an \c Array2D (or any other
+//! row-major buffer) and describes a rectangle of it by means of its size and
+//! its stride (distance in elements between two consecutive rows).
+//! No data is ever copied: the view is only valid as long as the underlying
+//! buffer is alive and not resized.
+//! Use \c Array2DView<const Type> for read-only access.
+//!
+template <typename Type>
+class Array2DView
+{
+public:
+    typedef Type        value_type;
+    typedef Type*       iterator;
+    typedef Type*       const_iterator;
+
+    //! \brief empty view
+    Array2DView();
+
+    //! \brief view over a raw buffer of \a rows rows of \a cols elements,
+    //! each row starting \a stride elements after the previous one
+    Array2DView(Type* data, size_t cols, size_t rows, size_t stride);
+
+    //! \brief view over the whole content of \a array
+    template <typename ArrayType>
+    explicit Array2DView(ArrayType& array);
+
+    //! \brief view over the rectangle [x_ul, x_br) x [y_ul, y_br) of \a array
+    template <typename ArrayType>
+    Array2DView(ArrayType& array,
+                size_t x_ul, size_t y_ul, size_t x_br, size_t y_br);
+
+    size_t getCols() const      { return m_cols; }
+    size_t getRows() const      { return m_rows; }
+    size_t getStride() const    { return m_stride; }
+    size_t size() const         { return m_rows*m_cols; }
+
+    bool isValid() const        { return m_data != NULL; }
+
+    //! \brief true if the rows are adjacent in memory (no gap between them)
+    bool isContiguous() const   { return m_stride == m_cols; }
+
+    //! \brief pointer to the first element of the view
+    Type* data() const          { return m_data; }
+
+    Type& operator()(size_t col, size_t row) const
+    {
+        assert( col < m_cols && row < m_rows );
+        return m_data[row*m_stride + col];
+    }
+
+    iterator row_begin(size_t r) const
+    { return m_data + r*m_stride; }
+    iterator row_end(size_t r) const
+    { return m_data + r*m_stride + m_cols; }
+
+    //! \brief view over [x_ul, x_br) x [y_ul, y_br) of the current view
+    Array2DView subView(size_t x_ul, size_t y_ul, size_t x_br, size_t y_br) const;
+
+private:
+    Type*   m_data;
+    size_t  m_cols;
+    size_t  m_rows;
+    size_t  m_stride;
+};
+
+//! \brief read-only view on a \c Channel or an \c Array2Df
+typedef Array2DView<const float> Array2DfConstView;
+//! \brief read-write view on a \c Channel or an \c Array2Df
+typedef Array2DView<float> Array2DfView;
+
+} // namespace pfs
+
+#include <Libpfs/array2d_view.hxx>
+
+#endif // PFS_ARRAY2D_VIEW_H
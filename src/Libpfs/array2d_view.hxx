@@ -0,0 +1,94 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#ifndef PFS_ARRAY2D_VIEW_HXX
+#define PFS_ARRAY2D_VIEW_HXX
+
+//! \file array2d_view.hxx
+
+#include <Libpfs/array2d_view.h>
+
+namespace pfs {
+
+template <typename Type>
+Array2DView<Type>::Array2DView()
+    : m_data(NULL)
+    , m_cols(0)
+    , m_rows(0)
+    , m_stride(0)
+{}
+
+template <typename Type>
+Array2DView<Type>::Array2DView(Type* data, size_t cols, size_t rows, size_t stride)
+    : m_data(data)
+    , m_cols(cols)
+    , m_rows(rows)
+    , m_stride(stride)
+{
+    assert( m_stride >= m_cols );
+}
+
+template <typename Type>
+template <typename ArrayType>
+Array2DView<Type>::Array2DView(ArrayType& array)
+    : m_data(array.data())
+    , m_cols(array.getCols())
+    , m_rows(array.getRows())
+    , m_stride(array.getCols())
+{}
+
+template <typename Type>
+template <typename ArrayType>
+Array2DView<Type>::Array2DView(ArrayType& array,
+                               size_t x_ul, size_t y_ul,
+                               size_t x_br, size_t y_br)
+    : m_data(NULL)
+    , m_cols(0)
+    , m_rows(0)
+    , m_stride(array.getCols())
+{
+    if ( x_br > array.getCols() ) x_br = array.getCols();
+    if ( y_br > array.getRows() ) y_br = array.getRows();
+
+    assert( x_ul <= x_br );
+    assert( y_ul <= y_br );
+
+    m_data = array.data() + y_ul*m_stride + x_ul;
+    m_cols = x_br - x_ul;
+    m_rows = y_br - y_ul;
+}
+
+template <typename Type>
+Array2DView<Type> Array2DView<Type>::subView(size_t x_ul, size_t y_ul,
+                                             size_t x_br, size_t y_br) const
+{
+    if ( x_br > m_cols ) x_br = m_cols;
+    if ( y_br > m_rows ) y_br = m_rows;
+
+    assert( x_ul <= x_br );
+    assert( y_ul <= y_br );
+
+    return Array2DView<Type>(m_data + y_ul*m_stride + x_ul,
+                             x_br - x_ul, y_br - y_ul, m_stride);
+}
+
+} // pfs
+
+#endif // PFS_ARRAY2D_VIEW_HXX
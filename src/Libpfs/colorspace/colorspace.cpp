@@ -32,46 +32,30 @@
 
 #include <cassert>
 #include <iostream>
-#include <map>
-#include <cmath>
 
 #include "Libpfs/pfs.h"
 #include "Libpfs/array2d.h"
 #include "Libpfs/utils/msec_timer.h"
 
 #include "Libpfs/utils/transform.h"
-#include "Libpfs/colorspace/rgb.h"
+#include "Libpfs/colorspace/colortransform.h"
 #include "Libpfs/colorspace/xyz.h"
-#include "Libpfs/colorspace/yuv.h"
-
-#include <boost/assign.hpp>
 
 using namespace std;
-using namespace boost::assign;
 
 namespace pfs {
 
+using colorspace::ColorTransform;
+
 //-----------------------------------------------------------
 // sRGB conversion functions
 //-----------------------------------------------------------
 void transformSRGB2XYZ(const Array2Df *inC1, const Array2Df *inC2, const Array2Df *inC3,
                        Array2Df *outC1, Array2Df *outC2, Array2Df *outC3)
 {
-#ifdef TIMER_PROFILING
-    msec_timer f_timer;
-    f_timer.start();
-#endif
-
-    utils::transform(inC1->begin(), inC1->end(), inC2->begin(), inC3->begin(),
-                     outC1->begin(), outC2->begin(), outC3->begin(),
-                     colorspace::ConvertSRGB2XYZ());
-
-#ifdef TIMER_PROFILING
-    f_timer.stop_and_update();
-    std::cout << "transformSRGB2XYZ() = " << f_timer.get_time() << " msec" << std::endl;
-#endif
-
+    transformColorSpace(CS_SRGB, inC1, inC2, inC3, CS_XYZ, outC1, outC2, outC3);
 }
+
 void transformSRGB2Y(const Array2Df *inC1, const Array2Df *inC2, const Array2Df *inC3,
                      Array2Df *outC1)
 {
@@ -85,19 +69,7 @@ void transformSRGB2Y(const Array2Df *inC1, const Array2Df *inC2, const Array2Df
 void transformRGB2XYZ(const Array2Df *inC1, const Array2Df *inC2, const Array2Df *inC3,
                       Array2Df *outC1, Array2Df *outC2, Array2Df *outC3)
 {
-#ifdef TIMER_PROFILING
-    msec_timer f_timer;
-    f_timer.start();
-#endif
-
-    utils::transform(inC1->begin(), inC1->end(), inC2->begin(), inC3->begin(),
-                     outC1->begin(), outC2->begin(), outC3->begin(),
-                     colorspace::ConvertRGB2XYZ());
-
-#ifdef TIMER_PROFILING
-    f_timer.stop_and_update();
-    std::cout << "transformRGB2XYZ() = " << f_timer.get_time() << " msec" << std::endl;
-#endif
+    transformColorSpace(CS_RGB, inC1, inC2, inC3, CS_XYZ, outC1, outC2, outC3);
 }
 
 void transformRGB2Y(const Array2Df *inC1, const Array2Df *inC2, const Array2Df *inC3,
@@ -110,151 +82,57 @@ void transformRGB2Y(const Array2Df *inC1, const Array2Df *inC2, const Array2Df *
 void transformRGB2Yuv(const Array2Df *inC1, const Array2Df *inC2, const Array2Df *inC3,
                       Array2Df *outC1, Array2Df *outC2, Array2Df *outC3)
 {
-#ifdef TIMER_PROFILING
-    msec_timer f_timer;
-    f_timer.start();
-#endif
-
-    utils::transform(inC1->begin(), inC1->end(), inC2->begin(), inC3->begin(),
-                     outC1->begin(), outC2->begin(), outC3->begin(),
-                     colorspace::ConvertRGB2YUV());
-
-#ifdef TIMER_PROFILING
-    f_timer.stop_and_update();
-    std::cout << "transformRGB2Yuv() = " << f_timer.get_time() << " msec" << std::endl;
-#endif
+    transformColorSpace(CS_RGB, inC1, inC2, inC3, CS_YUV, outC1, outC2, outC3);
 }
 
+//-----------------------------------------------------------
+// XYZ conversion functions
+//-----------------------------------------------------------
 void transformXYZ2SRGB(const Array2Df *inC1, const Array2Df *inC2, const Array2Df *inC3,
                        Array2Df *outC1, Array2Df *outC2, Array2Df *outC3)
 {
-#ifdef TIMER_PROFILING
-    msec_timer f_timer;
-    f_timer.start();
-#endif
-
-    utils::transform(inC1->begin(), inC1->end(), inC2->begin(), inC3->begin(),
-                     outC1->begin(), outC2->begin(), outC3->begin(),
-                     colorspace::ConvertXYZ2SRGB());
-
-#ifdef TIMER_PROFILING
-    f_timer.stop_and_update();
-    std::cout << "transformXYZ2SRGB() = " << f_timer.get_time() << " msec" << std::endl;
-#endif
+    transformColorSpace(CS_XYZ, inC1, inC2, inC3, CS_SRGB, outC1, outC2, outC3);
 }
 
 void transformXYZ2RGB(const Array2Df *inC1, const Array2Df *inC2, const Array2Df *inC3,
                       Array2Df *outC1, Array2Df *outC2, Array2Df *outC3 )
 {
-#ifdef TIMER_PROFILING
-    msec_timer f_timer;
-    f_timer.start();
-#endif
-
-    utils::transform(inC1->begin(), inC1->end(), inC2->begin(), inC3->begin(),
-                     outC1->begin(), outC2->begin(), outC3->begin(),
-                     colorspace::ConvertXYZ2RGB());
-
-#ifdef TIMER_PROFILING
-    f_timer.stop_and_update();
-    std::cout << "transformXYZ2RGB() = " << f_timer.get_time() << " msec" << std::endl;
-#endif
+    transformColorSpace(CS_XYZ, inC1, inC2, inC3, CS_RGB, outC1, outC2, outC3);
 }
 
 void transformXYZ2Yuv( const Array2Df *inC1, const Array2Df *inC2, const Array2Df *inC3,
                        Array2Df *outC1, Array2Df *outC2, Array2Df *outC3 )
 {
-    const int elems = inC1->getRows()*inC1->getCols();
-    for ( int idx = 0; idx < elems; idx++ )
-    {
-        const float &X = (*inC1)(idx), Y = (*inC2)(idx), &Z = (*inC3)(idx);
-        float &outY = (*outC1)(idx), &u = (*outC2)(idx), &v = (*outC3)(idx);
-
-        float x = X/(X+Y+Z);
-        float y = Y/(X+Y+Z);
-
-        // assert((4.f*nx / (-2.f*nx + 12.f*ny + 3.f)) <= 0.62 );
-        // assert( (9.f*ny / (-2.f*nx + 12.f*ny + 3.f)) <= 0.62 );
-
-        u = 4.f*x / (-2.f*x + 12.f*y + 3.f);
-        v = 9.f*y / (-2.f*x + 12.f*y + 3.f);
-        outY = Y;
-    }
+    transformColorSpace(CS_XYZ, inC1, inC2, inC3, CS_YUV, outC1, outC2, outC3);
+}
 
+void transformXYZ2Yxy( const Array2Df *inC1, const Array2Df *inC2, const Array2Df *inC3,
+                       Array2Df *outC1, Array2Df *outC2, Array2Df *outC3 )
+{
+    transformColorSpace(CS_XYZ, inC1, inC2, inC3, CS_Yxy, outC1, outC2, outC3);
 }
 
+//-----------------------------------------------------------
+// Yuv/Yxy conversion functions
+//-----------------------------------------------------------
 void transformYuv2XYZ( const Array2Df *inC1, const Array2Df *inC2, const Array2Df *inC3,
                        Array2Df *outC1, Array2Df *outC2, Array2Df *outC3 )
 {
-    const int elems = inC1->getRows()*inC1->getCols();
-    for( int idx = 0; idx < elems ; idx++ )
-    {
-        const float Y = (*inC1)(idx), &u = (*inC2)(idx), &v = (*inC3)(idx);
-        float &X = (*outC1)(idx), &outY = (*outC2)(idx), &Z = (*outC3)(idx);
-
-        float x = 9.f*u / (6.f*u - 16.f*v + 12.f);
-        float y = 4.f*v / (6.f*u - 16.f*v + 12.f);
-
-        X = x/y * Y;
-        Z = (1.f-x-y)/y * Y;
-        outY = Y;
-    }
+    transformColorSpace(CS_YUV, inC1, inC2, inC3, CS_XYZ, outC1, outC2, outC3);
 }
 
 void transformYuv2RGB(const Array2Df *inC1, const Array2Df *inC2, const Array2Df *inC3,
                       Array2Df *outC1, Array2Df *outC2, Array2Df *outC3 )
 {
-#ifdef TIMER_PROFILING
-    msec_timer f_timer;
-    f_timer.start();
-#endif
-
-    utils::transform(inC1->begin(), inC1->end(), inC2->begin(), inC3->begin(),
-                     outC1->begin(), outC2->begin(), outC3->begin(),
-                     colorspace::ConvertYUV2RGB());
-
-#ifdef TIMER_PROFILING
-    f_timer.stop_and_update();
-    std::cout << "transformYuv2RGB() = " << f_timer.get_time() << " msec" << std::endl;
-#endif
+    transformColorSpace(CS_YUV, inC1, inC2, inC3, CS_RGB, outC1, outC2, outC3);
 }
 
 void transformYxy2XYZ( const Array2Df *inC1, const Array2Df *inC2, const Array2Df *inC3,
                        Array2Df *outC1, Array2Df *outC2, Array2Df *outC3 )
 {
-    const int elems = inC1->getRows()*inC1->getCols();
-    for( int idx = 0; idx < elems; idx++ )
-    {
-        const float Y = (*inC1)(idx), x = (*inC2)(idx), y = (*inC3)(idx);
-        float &X = (*outC1)(idx), &outY = (*outC2)(idx), &Z = (*outC3)(idx);
-
-        X = x/y * Y;
-        Z = (1.f-x-y)/y * Y;
-        outY = Y;
-    }
+    transformColorSpace(CS_Yxy, inC1, inC2, inC3, CS_XYZ, outC1, outC2, outC3);
 }
 
-void transformXYZ2Yxy( const Array2Df *inC1, const Array2Df *inC2, const Array2Df *inC3,
-                       Array2Df *outC1, Array2Df *outC2, Array2Df *outC3 )
-{
-    const int elems = inC1->getRows()*inC1->getCols();
-    for( int idx = 0; idx < elems; idx++ )
-    {
-        const float X = (*inC1)(idx), Y = (*inC2)(idx), Z = (*inC3)(idx);
-        float &outY = (*outC1)(idx), &x = (*outC2)(idx), &y = (*outC3)(idx);
-
-        x = X/(X+Y+Z);
-        y = Y/(X+Y+Z);
-
-        outY = Y;
-    }
-}
-
-typedef void (*CSTransformFunc)(const Array2Df *inC1, const Array2Df *inC2, const Array2Df *inC3,
-                                Array2Df *outC1, Array2Df *outC2, Array2Df *outC3 );
-typedef std::pair<ColorSpace, ColorSpace> CSTransformProfile;
-typedef std::map<CSTransformProfile, CSTransformFunc> CSTransformMap;
-
 void transformColorSpace(ColorSpace inCS, const Array2Df *inC1, const Array2Df *inC2, const Array2Df *inC3,
                            ColorSpace outCS, Array2Df *outC1, Array2Df *outC2, Array2Df *outC3)
 {
@@ -270,39 +148,20 @@ void transformColorSpace(ColorSpace inCS, const Array2Df *inC1, const Array2Df *
             outC1->getRows() == outC2->getRows() &&
             outC2->getRows() == outC3->getRows() );
 
-    // static dictionary... I already know in advance the subscription I want
-    // to perform, hence this approach is far easier than try to create
-    // automatic subscription to the factory
-    static CSTransformMap s_csTransformMap =
-            map_list_of
-            // XYZ -> *
-            (CSTransformProfile(CS_XYZ, CS_SRGB), transformXYZ2SRGB)
-            (CSTransformProfile(CS_XYZ, CS_RGB), transformXYZ2RGB)
-            (CSTransformProfile(CS_XYZ, CS_YUV), transformXYZ2Yuv)
-            (CSTransformProfile(CS_XYZ, CS_Yxy), transformXYZ2Yxy)
-            // sRGB -> *
-            (CSTransformProfile(CS_SRGB, CS_XYZ), transformSRGB2XYZ)
-            // RGB -> *
-            (CSTransformProfile(CS_RGB, CS_XYZ), transformRGB2XYZ)
-            (CSTransformProfile(CS_RGB, CS_YUV), transformRGB2Yuv)
-            // Yuv -> *
-            (CSTransformProfile(CS_YUV, CS_XYZ), transformYuv2XYZ)
-            (CSTransformProfile(CS_YUV, CS_RGB), transformYuv2RGB)
-            // Yxy -> *
-            (CSTransformProfile(CS_Yxy, CS_XYZ), transformYxy2XYZ)
-            ;
+#ifdef TIMER_PROFILING
+    msec_timer f_timer;
+    f_timer.start();
+#endif
 
-    CSTransformMap::const_iterator itTransform =
-            s_csTransformMap.find( CSTransformProfile(inCS, outCS) );
+    // any pair of colour spaces is a single pass: decoding curve of the
+    // input, one matrix, encoding curve of the output
+    ColorTransform::between(inCS, outCS).apply(inC1, inC2, inC3,
+                                               outC1, outC2, outC3);
 
-    if ( itTransform == s_csTransformMap.end() )
-    {
-        throw Exception( "Unsupported color tranform" );
-    }
-#ifndef NDEBUG
-    std::cerr << __FUNCTION__ << ": Found right match for colorspace conversion\n";
+#ifdef TIMER_PROFILING
+    f_timer.stop_and_update();
+    std::cout << "transformColorSpace(" << inCS << ", " << outCS << ") = "
+              << f_timer.get_time() << " msec" << std::endl;
 #endif
-    // CSTransformFunc func =
-    (itTransform->second)( inC1, inC2, inC3, outC1, outC2, outC3 );
 }
 } // namespace pfs
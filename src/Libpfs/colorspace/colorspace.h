@@ -90,6 +90,8 @@ void transformYxy2XYZ(const Array2Df*inC1, const Array2Df*inC2, const Array2Df*i
 //! \brief Transform color channels from one color space into
 //! another. Input and output channels may point to the same data
 //! for in-memory transform.
+//! Any pair of color spaces is converted in a single pass: see
+//! colorspace::ColorTransform to fuse longer chains of conversions
 //!
 //! \param inCS input color space
 //! \param inC1 first color channel of the input image
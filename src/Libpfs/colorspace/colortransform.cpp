@@ -0,0 +1,208 @@
+/*
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+//! \brief fused colour space conversions on planar data
+
+#include <Libpfs/colorspace/colortransform.h>
+
+#include <algorithm>
+#include <cassert>
+
+#include <Libpfs/array2d.h>
+#include <Libpfs/exception.h>
+#include <Libpfs/utils/kernels.h>
+#include <Libpfs/utils/parallel.h>
+#include <Libpfs/colorspace/xyz.h>
+#include <Libpfs/colorspace/yuv.h>
+
+namespace pfs {
+namespace colorspace {
+
+ColorMatrix::ColorMatrix()
+{
+    for (int r = 0; r < 3; ++r)
+        for (int c = 0; c < 3; ++c)
+            m_mat[r][c] = (r == c) ? 1.f : 0.f;
+}
+
+ColorMatrix::ColorMatrix(const float (&mat)[3][3])
+{
+    for (int r = 0; r < 3; ++r)
+        for (int c = 0; c < 3; ++c)
+            m_mat[r][c] = mat[r][c];
+}
+
+ColorMatrix ColorMatrix::operator*(const ColorMatrix& rhs) const
+{
+    float mat[3][3];
+    for (int r = 0; r < 3; ++r)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            mat[r][c] = m_mat[r][0]*rhs.m_mat[0][c] +
+                    m_mat[r][1]*rhs.m_mat[1][c] +
+                    m_mat[r][2]*rhs.m_mat[2][c];
+        }
+    }
+    return ColorMatrix(mat);
+}
+
+ColorTransform::ColorTransform()
+    : m_decode(CURVE_NONE)
+    , m_matrix()
+    , m_encode(CURVE_NONE)
+{}
+
+ColorTransform::ColorTransform(Curve decode, const ColorMatrix& matrix, Curve encode)
+    : m_decode(decode)
+    , m_matrix(matrix)
+    , m_encode(encode)
+{}
+
+namespace
+{
+//! \brief every colour space is either a curve on linear RGB or a curve on XYZ
+bool isRGBBased(ColorSpace cs)
+{
+    return (cs == CS_RGB) || (cs == CS_SRGB);
+}
+
+ColorTransform::Curve curveOf(ColorSpace cs)
+{
+    switch ( cs )
+    {
+    case CS_XYZ:
+    case CS_RGB:
+        return ColorTransform::CURVE_NONE;
+    case CS_SRGB:
+        return ColorTransform::CURVE_SRGB;
+    case CS_YUV:
+        return ColorTransform::CURVE_YUV;
+    case CS_Yxy:
+        return ColorTransform::CURVE_YXY;
+    }
+    throw Exception( "Unsupported color tranform" );
+}
+}
+
+ColorTransform ColorTransform::between(ColorSpace inCS, ColorSpace outCS)
+{
+    if ( inCS == CS_RGB && outCS == CS_YUV )
+    {
+        return ColorTransform(CURVE_NONE, ColorMatrix(rgb2yuvMat), CURVE_NONE);
+    }
+    if ( inCS == CS_YUV && outCS == CS_RGB )
+    {
+        return ColorTransform(CURVE_NONE, ColorMatrix(yuv2rgbMat), CURVE_NONE);
+    }
+
+    const Curve decode = curveOf(inCS);
+    const Curve encode = curveOf(outCS);
+    if ( inCS == outCS )
+    {
+        return ColorTransform();
+    }
+
+    ColorMatrix matrix;
+    if ( isRGBBased(inCS) && !isRGBBased(outCS) )
+    {
+        matrix = ColorMatrix(rgb2xyzD65Mat);
+    }
+    else if ( !isRGBBased(inCS) && isRGBBased(outCS) )
+    {
+        matrix = ColorMatrix(xyz2rgbD65Mat);
+    }
+    return ColorTransform(decode, matrix, encode);
+}
+
+ColorTransform ColorTransform::then(const ColorTransform& next) const
+{
+    // encoding and decoding the same curve cancel out
+    if ( m_encode != next.m_decode )
+    {
+        throw Exception( "Color transforms cannot be fused" );
+    }
+    return ColorTransform(m_decode, next.m_matrix * m_matrix, next.m_encode);
+}
+
+namespace
+{
+void applyMatrix(const ColorMatrix& mat,
+                 const float* in1, const float* in2, const float* in3,
+                 float* out1, float* out2, float* out3, size_t size)
+{
+    float m[9];
+    for (int r = 0; r < 3; ++r)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            m[3*r + c] = mat(r, c);
+        }
+    }
+
+    const utils::Kernels& k = utils::kernels();
+    const size_t numBlocks = (size + utils::KERNELS_BLOCK_SIZE - 1)/utils::KERNELS_BLOCK_SIZE;
+
+    utils::parallelFor(0, numBlocks, 1,
+                       [&](size_t first, size_t last)
+    {
+        for (size_t block = first; block < last; ++block)
+        {
+            const size_t offset = block*utils::KERNELS_BLOCK_SIZE;
+            k.matrix3(m, in1 + offset, in2 + offset, in3 + offset,
+                      out1 + offset, out2 + offset, out3 + offset,
+                      std::min(utils::KERNELS_BLOCK_SIZE, size - offset));
+        }
+    });
+}
+}
+
+void ColorTransform::apply(const float* in1, const float* in2, const float* in3,
+                           float* out1, float* out2, float* out3, size_t size) const
+{
+    if ( isLinear() )
+    {
+        applyMatrix(m_matrix, in1, in2, in3, out1, out2, out3, size);
+        return;
+    }
+
+    utils::parallelFor(0, size, utils::PARALLEL_SAMPLES_GRAIN,
+                       [&](size_t first, size_t last)
+    {
+        for (size_t idx = first; idx < last; ++idx)
+        {
+            (*this)(in1[idx], in2[idx], in3[idx], out1[idx], out2[idx], out3[idx]);
+        }
+    });
+}
+
+void ColorTransform::apply(const Array2Df* inC1, const Array2Df* inC2, const Array2Df* inC3,
+                           Array2Df* outC1, Array2Df* outC2, Array2Df* outC3) const
+{
+    assert( inC1->size() == inC2->size() && inC2->size() == inC3->size() &&
+            inC3->size() == outC1->size() && outC1->size() == outC2->size() &&
+            outC2->size() == outC3->size() );
+
+    apply(inC1->data(), inC2->data(), inC3->data(),
+          outC1->data(), outC2->data(), outC3->data(), inC1->size());
+}
+
+}   // colorspace
+}   // pfs
@@ -0,0 +1,115 @@
+/*
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+//! \brief fused colour space conversions on planar data
+
+#ifndef PFS_COLORSPACE_COLORTRANSFORM_H
+#define PFS_COLORSPACE_COLORTRANSFORM_H
+
+#include <cstddef>
+
+#include <Libpfs/array2d_fwd.h>
+#include <Libpfs/colorspace/colorspace.h>
+
+namespace pfs {
+namespace colorspace {
+
+//! \brief 3x3 matrix on colour triplets
+class ColorMatrix
+{
+public:
+    //! \brief identity
+    ColorMatrix();
+    explicit ColorMatrix(const float (&mat)[3][3]);
+
+    //! \brief the conversion of \a rhs followed by this one
+    ColorMatrix operator*(const ColorMatrix& rhs) const;
+
+    float operator()(int row, int col) const
+    { return m_mat[row][col]; }
+
+    inline
+    void operator()(float i1, float i2, float i3,
+                    float& o1, float& o2, float& o3) const;
+
+private:
+    float m_mat[3][3];
+};
+
+//! \brief conversion between two colour spaces in a single pass over the
+//! data: non linear decoding of the input, 3x3 matrix, non linear encoding
+//! of the output.
+//! Conversions can be chained with \c then: RGB -> XYZ -> Yxy, for example,
+//! becomes one matrix and one encoding, instead of two passes over the
+//! frame. Conversions without curves run on a vectorised matrix kernel
+class ColorTransform
+{
+public:
+    enum Curve
+    {
+        CURVE_NONE = 0,
+        CURVE_SRGB,     //!< sRGB <-> linear RGB
+        CURVE_YXY,      //!< Yxy <-> XYZ
+        CURVE_YUV       //!< Yu'v' <-> XYZ
+    };
+
+    //! \brief identity
+    ColorTransform();
+    ColorTransform(Curve decode, const ColorMatrix& matrix, Curve encode);
+
+    //! \brief conversion from \a inCS to \a outCS
+    //! \note RGB <-> YUV uses the YUV matrix, while all the other conversions
+    //! to and from YUV use the u'v' chromaticities of XYZ (like transformXYZ2Yuv)
+    static ColorTransform between(ColorSpace inCS, ColorSpace outCS);
+
+    //! \brief this conversion followed by \a next
+    //! \throw pfs::Exception if this conversion encodes a curve which \a next
+    //! does not decode (the two cannot run as a single matrix)
+    ColorTransform then(const ColorTransform& next) const;
+
+    bool isLinear() const
+    { return (m_decode == CURVE_NONE) && (m_encode == CURVE_NONE); }
+
+    const ColorMatrix& matrix() const
+    { return m_matrix; }
+
+    inline
+    void operator()(float i1, float i2, float i3,
+                    float& o1, float& o2, float& o3) const;
+
+    //! \brief convert \a size samples of planar data: the output can be the
+    //! input itself
+    void apply(const float* in1, const float* in2, const float* in3,
+               float* out1, float* out2, float* out3, size_t size) const;
+
+    void apply(const Array2Df* inC1, const Array2Df* inC2, const Array2Df* inC3,
+               Array2Df* outC1, Array2Df* outC2, Array2Df* outC3) const;
+
+private:
+    Curve m_decode;
+    ColorMatrix m_matrix;
+    Curve m_encode;
+};
+
+}   // colorspace
+}   // pfs
+
+#include <Libpfs/colorspace/colortransform.hxx>
+#endif // PFS_COLORSPACE_COLORTRANSFORM_H
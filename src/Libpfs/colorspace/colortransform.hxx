@@ -0,0 +1,103 @@
+/*
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+//! \brief fused colour space conversions on planar data
+
+#ifndef PFS_COLORSPACE_COLORTRANSFORM_HXX
+#define PFS_COLORSPACE_COLORTRANSFORM_HXX
+
+#include <Libpfs/colorspace/colortransform.h>
+#include <Libpfs/colorspace/rgb.h>
+
+namespace pfs {
+namespace colorspace {
+
+void ColorMatrix::operator()(float i1, float i2, float i3,
+                             float& o1, float& o2, float& o3) const
+{
+    o1 = m_mat[0][0]*i1 + m_mat[0][1]*i2 + m_mat[0][2]*i3;
+    o2 = m_mat[1][0]*i1 + m_mat[1][1]*i2 + m_mat[1][2]*i3;
+    o3 = m_mat[2][0]*i1 + m_mat[2][1]*i2 + m_mat[2][2]*i3;
+}
+
+void ColorTransform::operator()(float i1, float i2, float i3,
+                                float& o1, float& o2, float& o3) const
+{
+    switch ( m_decode )
+    {
+    case CURVE_SRGB:
+        ConvertSRGB2RGB()(i1, i2, i3, i1, i2, i3);
+        break;
+    case CURVE_YXY:
+    {
+        // Y, x, y -> X, Y, Z
+        const float Y = i1, x = i2, y = i3;
+        i1 = x/y * Y;
+        i2 = Y;
+        i3 = (1.f - x - y)/y * Y;
+    } break;
+    case CURVE_YUV:
+    {
+        // Y, u', v' -> X, Y, Z
+        const float Y = i1, u = i2, v = i3;
+        const float x = 9.f*u / (6.f*u - 16.f*v + 12.f);
+        const float y = 4.f*v / (6.f*u - 16.f*v + 12.f);
+        i1 = x/y * Y;
+        i2 = Y;
+        i3 = (1.f - x - y)/y * Y;
+    } break;
+    case CURVE_NONE:
+        break;
+    }
+
+    m_matrix(i1, i2, i3, o1, o2, o3);
+
+    switch ( m_encode )
+    {
+    case CURVE_SRGB:
+        ConvertRGB2SRGB()(o1, o2, o3, o1, o2, o3);
+        break;
+    case CURVE_YXY:
+    {
+        // X, Y, Z -> Y, x, y
+        const float X = o1, Y = o2, Z = o3;
+        o1 = Y;
+        o2 = X/(X + Y + Z);
+        o3 = Y/(X + Y + Z);
+    } break;
+    case CURVE_YUV:
+    {
+        // X, Y, Z -> Y, u', v'
+        const float X = o1, Y = o2, Z = o3;
+        const float x = X/(X + Y + Z);
+        const float y = Y/(X + Y + Z);
+        o1 = Y;
+        o2 = 4.f*x / (-2.f*x + 12.f*y + 3.f);
+        o3 = 9.f*y / (-2.f*x + 12.f*y + 3.f);
+    } break;
+    case CURVE_NONE:
+        break;
+    }
+}
+
+}   // colorspace
+}   // pfs
+
+#endif // PFS_COLORSPACE_COLORTRANSFORM_HXX
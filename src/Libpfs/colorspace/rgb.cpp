@@ -24,10 +24,11 @@
 
 namespace pfs {
 namespace colorspace {
+namespace detail {
 
 using std::pow;
 
-float ConvertSRGB2RGB::operator()(float sample) const
+float srgb2rgb(float sample)
 {
     if ( sample > 0.04045f ) {
         return pow((sample + 0.055f)*(1.f/1.055f), 2.4f);
@@ -39,7 +40,7 @@ float ConvertSRGB2RGB::operator()(float sample) const
     return -pow((0.055f - sample)*(1.f/1.055f), 2.4f);
 }
 
-float ConvertRGB2SRGB::operator ()(float sample) const
+float rgb2srgb(float sample)
 {
     if ( sample > 0.0031308f ) {
         return ((1.055f * pow(sample, 1.f/2.4f)) - 0.055f);
@@ -50,5 +51,26 @@ float ConvertRGB2SRGB::operator ()(float sample) const
     return ((0.055f - 1.f)*pow(-sample, 1.f/2.4f) - 0.055f);
 }
 
+float srgb2rgbLut[SRGB_LUT_SIZE + 2];
+float rgb2srgbLut[SRGB_LUT_SIZE + 2];
+
+namespace {
+struct SRGBLutInitializer
+{
+    SRGBLutInitializer()
+    {
+        for (int idx = 0; idx <= SRGB_LUT_SIZE + 1; ++idx)
+        {
+            const double x = static_cast<double>(idx)/SRGB_LUT_SIZE;
+            srgb2rgbLut[idx] = srgb2rgb(static_cast<float>(x));
+            rgb2srgbLut[idx] = rgb2srgb(static_cast<float>(x*x));
+        }
+    }
+};
+
+SRGBLutInitializer s_srgbLutInitializer;
 }
-}
+
+}   // detail
+}   // colorspace
+}   // pfs
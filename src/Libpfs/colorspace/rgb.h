@@ -28,6 +28,22 @@
 namespace pfs {
 namespace colorspace {
 
+namespace detail {
+//! \brief the sRGB curves are sampled in SRGB_LUT_SIZE intervals on [0, 1]:
+//! the samples in between are interpolated, outside [0, 1] the exact curve
+//! is computed with std::pow
+const int SRGB_LUT_SIZE = 4096;
+
+//! \brief SRGB -> RGB, sampled on the sRGB value
+extern float srgb2rgbLut[SRGB_LUT_SIZE + 2];
+//! \brief RGB -> SRGB, sampled on the square root of the linear value: the
+//! curve is steep close to zero, so the samples get denser there
+extern float rgb2srgbLut[SRGB_LUT_SIZE + 2];
+
+float srgb2rgb(float sample);
+float rgb2srgb(float sample);
+}
+
 //! \brief Functor SRGB -> RGB conversion
 struct ConvertSRGB2RGB {
     //! \brief single sample expanding SRGB -> RGB
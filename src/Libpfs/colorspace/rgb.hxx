@@ -27,9 +27,47 @@
 
 #include <Libpfs/colorspace/rgb.h>
 
+#include <cmath>
+
 namespace pfs {
 namespace colorspace {
 
+namespace detail {
+inline
+float interpolateSRGBLut(const float* lut, float x)
+{
+    const float pos = x*SRGB_LUT_SIZE;
+    const int idx = static_cast<int>(pos);
+    const float frac = pos - idx;
+    // the extra sample at the end makes x == 1.f safe
+    return lut[idx] + frac*(lut[idx + 1] - lut[idx]);
+}
+}
+
+inline
+float ConvertSRGB2RGB::operator()(float sample) const
+{
+    if ( sample > 0.04045f && sample <= 1.f ) {
+        return detail::interpolateSRGBLut(detail::srgb2rgbLut, sample);
+    }
+    if ( sample > 0.04045f || sample < -0.04045f ) {
+        return detail::srgb2rgb(sample);
+    }
+    return sample*(1.f/12.92f);
+}
+
+inline
+float ConvertRGB2SRGB::operator()(float sample) const
+{
+    if ( sample > 0.0031308f && sample <= 1.f ) {
+        return detail::interpolateSRGBLut(detail::rgb2srgbLut, std::sqrt(sample));
+    }
+    if ( sample > 0.0031308f || sample < -0.0031308f ) {
+        return detail::rgb2srgb(sample);
+    }
+    return sample*12.92f;
+}
+
 inline
 void ConvertSRGB2RGB::operator()(float i1, float i2, float i3,
                                  float& o1, float& o2, float& o3) const
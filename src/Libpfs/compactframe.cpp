@@ -0,0 +1,112 @@
+/*
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <Libpfs/compactframe.h>
+
+#include <cassert>
+
+#include <Libpfs/frame.h>
+#include <Libpfs/utils/half.h>
+#include <Libpfs/utils/trace.h>
+
+namespace pfs
+{
+
+CompactFrame::CompactFrame(const Frame& frame)
+    : m_width(frame.getWidth())
+    , m_height(frame.getHeight())
+    , m_tags(frame.getTags())
+{
+    utils::TraceSpan span("compact");
+
+    const ChannelContainer& channels = frame.getChannels();
+    m_channels.resize(channels.size());
+    for (size_t idx = 0; idx < channels.size(); ++idx)
+    {
+        const Channel* ch = channels[idx];
+        CompactChannel& cch = m_channels[idx];
+
+        cch.m_name = ch->getName();
+        cch.m_tags = ch->getTags();
+        cch.m_data.resize(ch->size());
+        utils::floatToHalf(ch->data(), cch.m_data.data(), ch->size());
+    }
+}
+
+size_t CompactFrame::getByteSize() const
+{
+    size_t bytes = 0;
+    for (size_t idx = 0; idx < m_channels.size(); ++idx)
+    {
+        bytes += m_channels[idx].m_data.size()*sizeof(uint16_t);
+    }
+    return bytes;
+}
+
+Frame* CompactFrame::expand() const
+{
+    utils::TraceSpan span("expand");
+
+    Frame* frame = new Frame(m_width, m_height);
+    for (size_t idx = 0; idx < m_channels.size(); ++idx)
+    {
+        const CompactChannel& cch = m_channels[idx];
+        Channel* ch = frame->createChannel(cch.m_name);
+
+        ch->getTags() = cch.m_tags;
+        utils::halfToFloat(cch.m_data.data(), ch->data(), cch.m_data.size());
+    }
+    frame->getTags() = m_tags;
+
+    return frame;
+}
+
+const CompactFrame::CompactChannel*
+CompactFrame::findChannel(const std::string& name) const
+{
+    for (size_t idx = 0; idx < m_channels.size(); ++idx)
+    {
+        if ( m_channels[idx].m_name == name ) return &m_channels[idx];
+    }
+    return NULL;
+}
+
+bool CompactFrame::expandTile(const std::string& name,
+                              size_t x_ul, size_t y_ul, size_t x_br, size_t y_br,
+                              Array2Df& out) const
+{
+    const CompactChannel* cch = findChannel(name);
+    if ( !cch ) return false;
+
+    assert( x_ul <= x_br && x_br <= m_width );
+    assert( y_ul <= y_br && y_br <= m_height );
+    assert( out.getCols() == x_br - x_ul );
+    assert( out.getRows() == y_br - y_ul );
+
+    const size_t cols = x_br - x_ul;
+    for (size_t r = 0; r < out.getRows(); ++r)
+    {
+        utils::halfToFloat(cch->m_data.data() + (y_ul + r)*m_width + x_ul,
+                           out.data() + r*cols, cols);
+    }
+    return true;
+}
+
+} // namespace pfs
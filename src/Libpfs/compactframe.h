@@ -0,0 +1,85 @@
+/*
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+//! \brief PFS library - half precision storage for inactive frames
+
+#ifndef PFS_COMPACTFRAME_H
+#define PFS_COMPACTFRAME_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include <Libpfs/array2d_fwd.h>
+#include <Libpfs/tag.h>
+
+namespace pfs
+{
+class Frame;
+
+//! \brief Copy of a \c Frame stored with 16 bits per sample
+//!
+//! Every channel is kept as IEEE 754 half, so a \c CompactFrame uses half of
+//! the memory of its source. Half has 11 bits of mantissa and a range up to
+//! 65504: frames read from half EXR files round-trip exactly, any other frame
+//! loses precision. Use it for frames that are not being processed (inactive
+//! tabs, queued items) and \c expand them before touching the pixels again.
+class CompactFrame
+{
+public:
+    //! \brief convert \a frame into half precision
+    explicit CompactFrame(const Frame& frame);
+
+    size_t getWidth() const     { return m_width; }
+    size_t getHeight() const    { return m_height; }
+
+    //! \brief number of bytes used by the pixels
+    size_t getByteSize() const;
+
+    //! \brief rebuild a full precision \c Frame (channels and tags)
+    //! \note the caller owns the returned \c Frame
+    Frame* expand() const;
+
+    //! \brief convert the rectangle [x_ul, x_br) x [y_ul, y_br) of the channel
+    //! \a name into \a out, that must be already (x_br - x_ul) x (y_br - y_ul)
+    //! \return false if the channel does not exist
+    bool expandTile(const std::string& name,
+                    size_t x_ul, size_t y_ul, size_t x_br, size_t y_br,
+                    Array2Df& out) const;
+
+private:
+    struct CompactChannel
+    {
+        std::string m_name;
+        TagContainer m_tags;
+        std::vector<uint16_t> m_data;
+    };
+
+    const CompactChannel* findChannel(const std::string& name) const;
+
+    size_t m_width;
+    size_t m_height;
+    TagContainer m_tags;
+    std::vector<CompactChannel> m_channels;
+};
+
+} // namespace pfs
+
+#endif // PFS_COMPACTFRAME_H
@@ -37,12 +37,25 @@ using namespace std;
 
 namespace pfs
 {
+namespace
+{
+// generations are drawn from a single counter, so that a frame allocated
+// where another one was freed does not take over its generations
+uint64_t nextGeneration()
+{
+    static std::atomic<uint64_t> s_generation(0);
+    return ++s_generation;
+}
+}
+
 Frame::Frame(size_t width, size_t height )
     : m_width( width )
     , m_height( height )
     , m_X(NULL)
     , m_Y(NULL)
     , m_Z(NULL)
+    , m_hashValid(false)
+    , m_generation(nextGeneration())
 {}
 
 namespace
@@ -68,6 +81,7 @@ Frame::~Frame()
 //! \brief Changes the size of the frame
 void Frame::resize(size_t width, size_t height)
 {
+    invalidateContentHash();
     for_each(m_channels.begin(), m_channels.end(),
              boost::bind(&Channel::ChannelData::resize, _1, width, height));
 
@@ -144,6 +158,8 @@ void Frame::getXYZChannels(const Channel* &X, const Channel* &Y, const Channel*
 
 void Frame::getXYZChannels( Channel* &X, Channel* &Y, Channel* &Z )
 {
+    invalidateContentHash();
+
     const Channel* X_;
     const Channel* Y_;
     const Channel* Z_;
@@ -175,11 +191,14 @@ const Channel* Frame::getChannel(const string &name) const
 
 Channel* Frame::getChannel(const string& name)
 {
+    invalidateContentHash();
     return const_cast<Channel*>(static_cast<const Frame&>(*this).getChannel(name));
 }
 
 Channel* Frame::createChannel(const string& name)
 {
+    invalidateContentHash();
+
     Channel* ch = NULL;
     ChannelContainer::iterator it = find_if(m_channels.begin(),
                                                  m_channels.end(),
@@ -210,6 +229,8 @@ Channel* Frame::createChannel(const string& name)
 
 void Frame::removeChannel(const string& channel)
 {
+    invalidateContentHash();
+
     ChannelContainer::iterator it = find_if(m_channels.begin(),
                                                  m_channels.end(),
                                                  FindChannel(channel));
@@ -231,6 +252,7 @@ void Frame::removeChannel(const string& channel)
 
 ChannelContainer& Frame::getChannels()
 {
+    invalidateContentHash();
     return this->m_channels;
 }
 
@@ -241,6 +263,7 @@ const ChannelContainer& Frame::getChannels() const
 
 TagContainer& Frame::getTags()
 {
+    invalidateContentHash();
     return m_tags;
 }
 
@@ -261,6 +284,27 @@ void Frame::swap(Frame& other)
     swap(m_X, other.m_X);
     swap(m_Y, other.m_Y);
     swap(m_Z, other.m_Z);
+
+    invalidateContentHash();
+    other.invalidateContentHash();
+}
+
+void Frame::invalidateContentHash()
+{
+    m_hashValid = false;
+    m_generation = nextGeneration();
+}
+
+utils::Hash128 Frame::getContentHash() const
+{
+    std::lock_guard<std::mutex> lock(m_hashMutex);
+    if ( !m_hashValid )
+    {
+        // set first: a change made while hashing leaves the hash invalid
+        m_hashValid = true;
+        m_hash = utils::hashFrame(*this);
+    }
+    return m_hash;
 }
 
 } // namespace pfs
@@ -30,12 +30,15 @@
 #ifndef PFS_FRAME_H
 #define PFS_FRAME_H
 
+#include <atomic>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <memory>
 
 #include <Libpfs/channel.h>
 #include <Libpfs/tag.h>
+#include <Libpfs/utils/hash.h>
 
 namespace pfs
 {
@@ -46,6 +49,16 @@ typedef std::vector< Channel* > ChannelContainer;
 //! or more channels (e.g. color XYZ, depth channel, alpha
 //! channnel). All the channels are of the same size. Frame can
 //! also contain additional information in tags (see getTags).
+//!
+//! The hash of the content (see getContentHash) is kept on the frame. Every
+//! non-const accessor drops it, as the caller may be about to change the
+//! frame, but the channels do not know their frame: a hash taken between
+//! that call and the last write through the channel is kept. The functions
+//! changing a frame in place (applyGamma, gammaAndLevels, whiteBalance,
+//! TonemapOperator::tonemapFrame) drop it again when done; any other code
+//! writing through channels obtained earlier must call
+//! invalidateContentHash() after its last write. getGeneration() changes
+//! along with the hash.
 class Frame
 {
 public:
@@ -129,6 +142,20 @@ public:
 
     void swap(Frame& other);
 
+    //! \brief hash of the size, tags and channels of the frame (see
+    //! utils::hashFrame), computed on the first call and kept until the
+    //! frame is changed
+    utils::Hash128 getContentHash() const;
+
+    //! \brief drop the hash kept by getContentHash() and move the frame to a
+    //! new generation
+    void invalidateContentHash();
+
+    //! \brief number changed along with the content hash, and never shared
+    //! by two frames: tells whether a frame may have been changed since an
+    //! earlier call, without hashing it
+    uint64_t getGeneration() const  { return m_generation; }
+
 private:
     size_t m_width;
     size_t m_height;
@@ -140,6 +167,12 @@ private:
     Channel* m_X;
     Channel* m_Y;
     Channel* m_Z;
+
+    // cache for getContentHash()
+    mutable std::mutex m_hashMutex;
+    mutable std::atomic<bool> m_hashValid;
+    mutable utils::Hash128 m_hash;
+    std::atomic<uint64_t> m_generation;
 };
 
 typedef std::shared_ptr< pfs::Frame > FramePtr;
@@ -0,0 +1,102 @@
+/*
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include "frame_view.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace pfs
+{
+
+FrameView::FrameView(const Frame& frame)
+    : m_frame(&frame)
+    , m_x(0)
+    , m_y(0)
+    , m_width(frame.getWidth())
+    , m_height(frame.getHeight())
+{}
+
+FrameView::FrameView(const Frame& frame,
+                     size_t x_ul, size_t y_ul, size_t x_br, size_t y_br)
+    : m_frame(&frame)
+    , m_x(x_ul)
+    , m_y(y_ul)
+    , m_width(0)
+    , m_height(0)
+{
+    x_br = std::min(x_br, frame.getWidth());
+    y_br = std::min(y_br, frame.getHeight());
+
+    assert( x_ul <= x_br );
+    assert( y_ul <= y_br );
+
+    m_width = x_br - x_ul;
+    m_height = y_br - y_ul;
+}
+
+bool FrameView::isWholeFrame() const
+{
+    return (m_x == 0 && m_y == 0 &&
+            m_width == m_frame->getWidth() &&
+            m_height == m_frame->getHeight());
+}
+
+Array2DfConstView FrameView::getChannel(const Channel& channel) const
+{
+    assert( channel.getWidth() == m_frame->getWidth() );
+    assert( channel.getHeight() == m_frame->getHeight() );
+
+    return Array2DfConstView(channel,
+                             m_x, m_y, m_x + m_width, m_y + m_height);
+}
+
+Array2DfConstView FrameView::getChannel(const std::string& name) const
+{
+    const Channel* channel = m_frame->getChannel(name);
+    if ( channel == NULL )
+    {
+        return Array2DfConstView();
+    }
+    return getChannel(*channel);
+}
+
+bool FrameView::getXYZChannels(Array2DfConstView& X,
+                               Array2DfConstView& Y,
+                               Array2DfConstView& Z) const
+{
+    const Channel* X_;
+    const Channel* Y_;
+    const Channel* Z_;
+    m_frame->getXYZChannels(X_, Y_, Z_);
+
+    if ( X_ == NULL || Y_ == NULL || Z_ == NULL )
+    {
+        X = Y = Z = Array2DfConstView();
+        return false;
+    }
+
+    X = getChannel(*X_);
+    Y = getChannel(*Y_);
+    Z = getChannel(*Z_);
+    return true;
+}
+
+} // namespace pfs
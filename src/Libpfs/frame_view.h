@@ -0,0 +1,101 @@
+/*
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+//! \brief PFS library - read-only region of a Frame
+
+#ifndef PFS_FRAME_VIEW_H
+#define PFS_FRAME_VIEW_H
+
+#include <string>
+
+#include <Libpfs/array2d_view.h>
+#include <Libpfs/frame.h>
+
+namespace pfs
+{
+
+//! \brief Read-only window over a rectangle of a \c Frame
+//!
+//! A \c FrameView does not own any pixel: its channels are \c Array2DView
+//! pointing inside the channels of the source \c Frame. Consumers that only
+//! read their input (writers, previews, the first stage of a tone mapping)
+//! can work on a crop of a big frame without materialising it.
+//! The view must not outlive the source \c Frame.
+class FrameView
+{
+public:
+    //! \brief view over the whole \a frame
+    explicit FrameView(const Frame& frame);
+
+    //! \brief view over the rectangle [x_ul, x_br) x [y_ul, y_br) of \a frame
+    //! \note the bottom right corner is clamped to the size of \a frame
+    FrameView(const Frame& frame,
+              size_t x_ul, size_t y_ul, size_t x_br, size_t y_br);
+
+    bool isValid() const
+    { return (getWidth() > 0 && getHeight() > 0); }
+
+    //! \return width of the view (in pixels)
+    size_t getWidth() const     { return m_width; }
+    //! \return height of the view (in pixels)
+    size_t getHeight() const    { return m_height; }
+    //! \return height * width
+    size_t size() const         { return m_width*m_height; }
+
+    //! \return true if the view covers the entire source frame
+    bool isWholeFrame() const;
+
+    //! \return the frame this view refers to
+    const Frame& getFrame() const   { return *m_frame; }
+
+    //! \return the channels of the source frame
+    const ChannelContainer& getChannels() const
+    { return m_frame->getChannels(); }
+
+    //! \return the tags of the source frame
+    const TagContainer& getTags() const
+    { return m_frame->getTags(); }
+
+    //! \brief view on the region of \a channel covered by this \c FrameView
+    //! \note \a channel must belong to the source frame
+    Array2DfConstView getChannel(const Channel& channel) const;
+
+    //! \brief view on the named channel
+    //! \return an invalid view if the channel does not exist
+    Array2DfConstView getChannel(const std::string& name) const;
+
+    //! \brief get the views on the X, Y, Z channels
+    //! \return false if the source frame does not hold all of them
+    bool getXYZChannels(Array2DfConstView& X,
+                        Array2DfConstView& Y,
+                        Array2DfConstView& Z) const;
+
+private:
+    const Frame* m_frame;
+
+    size_t m_x;
+    size_t m_y;
+    size_t m_width;
+    size_t m_height;
+};
+
+} // namespace pfs
+
+#endif // PFS_FRAME_VIEW_H
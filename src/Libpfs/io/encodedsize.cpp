@@ -0,0 +1,225 @@
+/*
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <Libpfs/io/encodedsize.h>
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <Libpfs/frame.h>
+#include <Libpfs/io/ioexception.h>
+#include <Libpfs/io/jpegwriter.h>
+#include <Libpfs/io/pngwriter.h>
+#include <Libpfs/utils/parallel.h>
+#include <Libpfs/utils/trace.h>
+
+namespace pfs {
+namespace io {
+
+namespace {
+//! \brief bands of the sample: a multiple of the 16 rows of a JPEG MCU, so
+//! that the bands encode like they do inside the frame
+const size_t SAMPLE_BANDS = 16;
+const size_t SAMPLE_BAND_HEIGHT = 16;
+
+//! \brief rows of the frame copied in the sample of estimateEncodedSize()
+struct Sample
+{
+    explicit Sample(const Frame& frame);
+
+    //! \brief NULL when the frame is small enough to be encoded whole
+    std::unique_ptr<Frame> rows_;
+    //! \brief one pixel, for the size of the headers (tables, profile)
+    Frame pixel_;
+    //! \brief rows of the frame / rows of the sample
+    double scale_;
+};
+
+Sample::Sample(const Frame& frame)
+    : pixel_(1, 1)
+    , scale_(1.0)
+{
+    Channel* X;
+    Channel* Y;
+    Channel* Z;
+    pixel_.createXYZChannels(X, Y, Z);
+
+    const size_t width = frame.getWidth();
+    const size_t height = frame.getHeight();
+    const size_t bandHeight = SAMPLE_BAND_HEIGHT;
+    if ( height < 4*SAMPLE_BANDS*bandHeight ) return;
+
+    const Channel* srcX;
+    const Channel* srcY;
+    const Channel* srcZ;
+    frame.getXYZChannels(srcX, srcY, srcZ);
+    (*X)(0) = (*srcX)(0);
+    (*Y)(0) = (*srcY)(0);
+    (*Z)(0) = (*srcZ)(0);
+
+    rows_.reset(new Frame(width, SAMPLE_BANDS*bandHeight));
+    rows_->createXYZChannels(X, Y, Z);
+
+    // bands at the centre of SAMPLE_BANDS equal slices, aligned on MCUs
+    const Channel* src[] = { srcX, srcY, srcZ };
+    Channel* dst[] = { X, Y, Z };
+    for (size_t b = 0; b < SAMPLE_BANDS; ++b)
+    {
+        const size_t center = (2*b + 1)*height/(2*SAMPLE_BANDS);
+        const size_t first = std::min(center/bandHeight*bandHeight, height - bandHeight);
+        for (int c = 0; c < 3; ++c)
+        {
+            std::copy(src[c]->row_begin(first), src[c]->row_end(first + bandHeight - 1),
+                      dst[c]->row_begin(b*bandHeight));
+        }
+    }
+    scale_ = double(height)/rows_->getHeight();
+}
+
+size_t estimate(const Frame& frame, const Sample& sample, const Params& params)
+{
+    if ( !sample.rows_ )
+    {
+        return encodedSize(frame, params);
+    }
+
+    // the headers are written once, the data grows with the rows
+    const size_t header = encodedSize(sample.pixel_, params);
+    const size_t rows = encodedSize(*sample.rows_, params);
+    const double data = std::max(double(rows) - double(header), 0.0);
+    return header + static_cast<size_t>(data*sample.scale_ + 0.5);
+}
+
+typedef std::function<size_t (size_t)> SizeOfQuality;
+
+//! \brief highest quality in [\a lo, \a hi] whose size fits \a targetSize,
+//! assuming the size grows with the quality: each round probes as many
+//! qualities as the threads, evenly spread over the remaining range
+//! \return 0 if none fits
+size_t searchQuality(size_t lo, size_t hi, size_t targetSize,
+                     const SizeOfQuality& sizeOf)
+{
+    size_t found = 0;
+    const size_t maxProbes = std::max(utils::concurrency(), size_t(1));
+    while ( lo <= hi )
+    {
+        const size_t numProbes = std::min(maxProbes, hi - lo + 1);
+        std::vector<size_t> qualities(numProbes);
+        for (size_t p = 0; p < numProbes; ++p)
+        {
+            qualities[p] = lo + (p + 1)*(hi - lo + 1)/(numProbes + 1);
+        }
+        qualities.erase(std::unique(qualities.begin(), qualities.end()), qualities.end());
+
+        std::vector<char> fits(qualities.size());
+        utils::parallelFor(0, qualities.size(), 1, [&](size_t b, size_t e)
+        {
+            for (size_t p = b; p < e; ++p)
+            {
+                fits[p] = sizeOf(qualities[p]) <= targetSize;
+            }
+        });
+
+        // the answer is between the last probe that fits and the first
+        // one that does not
+        size_t next = 0;
+        while ( next < qualities.size() && fits[next] ) ++next;
+        if ( next > 0 )
+        {
+            found = qualities[next - 1];
+            lo = found + 1;
+        }
+        if ( next < qualities.size() )
+        {
+            hi = qualities[next] - 1;
+        }
+    }
+    return found;
+}
+}
+
+size_t encodedSize(const Frame& frame, const Params& params)
+{
+    std::string format;
+    params.get("format", format);
+
+    if ( format == "jpg" || format == "jpeg" )
+    {
+        JpegWriter writer;
+        writer.write(frame, params);
+        return writer.getFileSize();
+    }
+    if ( format == "png" )
+    {
+        PngWriter writer;
+        writer.write(frame, params);
+        return writer.getFileSize();
+    }
+    throw UnsupportedFormat("No size estimation for format: " + format);
+}
+
+size_t estimateEncodedSize(const Frame& frame, const Params& params)
+{
+    utils::TraceSpan span("size estimation");
+
+    return estimate(frame, Sample(frame), params);
+}
+
+size_t findQualityForSize(const Frame& frame, const Params& params,
+                          size_t targetSize, bool exact)
+{
+    utils::TraceSpan span("quality search");
+
+    const Sample sample(frame);
+    const size_t estimated = searchQuality(1, 100, targetSize, [&](size_t quality)
+    {
+        return estimate(frame, sample, Params(params)("quality", quality));
+    });
+    if ( !exact || !sample.rows_ )
+    {
+        return estimated;
+    }
+
+    // the estimate is off by a few qualities at most: search around it,
+    // and go further only if the whole window fits (or does not)
+    const SizeOfQuality encoded = [&](size_t quality)
+    {
+        return encodedSize(frame, Params(params)("quality", quality));
+    };
+    const size_t window = 4;
+    const size_t lo = std::max(estimated, window + 1) - window;
+    const size_t hi = std::min(estimated + window, size_t(100));
+
+    size_t found = searchQuality(lo, hi, targetSize, encoded);
+    if ( found == 0 && lo > 1 )
+    {
+        found = searchQuality(1, lo - 1, targetSize, encoded);
+    }
+    else if ( found == hi && hi < 100 )
+    {
+        found = std::max(found, searchQuality(hi + 1, 100, targetSize, encoded));
+    }
+    return found;
+}
+
+}   // io
+}   // pfs
@@ -0,0 +1,59 @@
+/*
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+//! \brief Size of LDR files (JPEG, PNG) before writing them, and search of
+//! the quality that fits a size
+
+#ifndef PFS_IO_ENCODEDSIZE_H
+#define PFS_IO_ENCODEDSIZE_H
+
+#include <cstddef>
+
+#include <Libpfs/params.h>
+
+namespace pfs {
+class Frame;
+
+namespace io {
+
+//! \brief size in bytes of \a frame encoded with \a params, whose "format"
+//! ("jpg" or "png") picks the writer
+//! \throws pfs::io::UnsupportedFormat for the other formats
+size_t encodedSize(const Frame& frame, const Params& params);
+
+//! \brief prediction of encodedSize() from the encoding of a few bands of
+//! rows spread over the frame: within a few percent for photographs, at a
+//! fraction of the cost. Small frames are encoded whole
+size_t estimateEncodedSize(const Frame& frame, const Params& params);
+
+//! \brief highest "quality" in [1, 100] for which \a frame encoded with
+//! \a params fits in \a targetSize bytes
+//!
+//! The qualities are probed on the estimated sizes first, several at a time
+//! on the threads of the executor. With \a exact, the result is then
+//! confirmed by encoding the whole frame around the estimated quality.
+//! \return 0 if the frame does not fit even at quality 1
+size_t findQualityForSize(const Frame& frame, const Params& params,
+                          size_t targetSize, bool exact = true);
+
+}   // io
+}   // pfs
+
+#endif // PFS_IO_ENCODEDSIZE_H
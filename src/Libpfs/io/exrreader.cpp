@@ -28,14 +28,19 @@
 #include <ImfHeader.h>
 #include <ImfChannelList.h>
 #include <ImfInputFile.h>
+#include <ImfTiledInputFile.h>
 #include <ImfRgbaFile.h>
 #include <ImfStringAttribute.h>
 #include <ImfStandardAttributes.h>
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdio>
 #include <cstdlib>
 #include <iostream>
+#include <limits>
 #include <string>
+#include <vector>
 
 #include <Libpfs/frame.h>
 #include <Libpfs/io/ioexception.h>
@@ -59,6 +64,72 @@ static string escapeString( const string &src )
     }
     return ret;
 }
+
+//! \brief level of a tiled file requested by \a params: "exr_level" picks
+//! it directly, "exr_min_width" picks the smallest one that is at least that
+//! wide (and tall in proportion)
+void selectLevel(const TiledInputFile& file, const pfs::Params& params,
+                 int& lx, int& ly)
+{
+    lx = 0;
+    ly = 0;
+    if ( file.levelMode() == ONE_LEVEL ) return;
+
+    int level = 0;
+    size_t minWidth = 0;
+    if ( params.get("exr_level", level) )
+    {
+        lx = std::max(level, 0);
+        ly = std::max(level, 0);
+    }
+    else if ( params.get("exr_min_width", minWidth) )
+    {
+        const size_t width = file.levelWidth(0);
+        const size_t height = file.levelHeight(0);
+        const size_t minHeight = (minWidth*height + width - 1)/width;
+
+        while ( lx + 1 < file.numXLevels() &&
+                size_t(file.levelWidth(lx + 1)) >= minWidth ) ++lx;
+        while ( ly + 1 < file.numYLevels() &&
+                size_t(file.levelHeight(ly + 1)) >= minHeight ) ++ly;
+    }
+
+    if ( file.levelMode() == MIPMAP_LEVELS )
+    {
+        lx = std::min(lx, ly);
+        ly = lx;
+    }
+    lx = std::min(lx, file.numXLevels() - 1);
+    ly = std::min(ly, file.numYLevels() - 1);
+}
+
+//! \brief part of \a window requested by "exr_region_x", "exr_region_y",
+//! "exr_region_width" and "exr_region_height", in pixels from its top left
+//! corner: the whole window by default
+Box2i selectRegion(const Box2i& window, const pfs::Params& params)
+{
+    const size_t windowWidth = window.max.x - window.min.x + 1;
+    const size_t windowHeight = window.max.y - window.min.y + 1;
+
+    size_t x = 0;
+    size_t y = 0;
+    size_t width = std::numeric_limits<size_t>::max();
+    size_t height = std::numeric_limits<size_t>::max();
+    params.get("exr_region_x", x);
+    params.get("exr_region_y", y);
+    params.get("exr_region_width", width);
+    params.get("exr_region_height", height);
+
+    if ( x >= windowWidth || y >= windowHeight || width == 0 || height == 0 )
+    {
+        throw pfs::io::ReadException("Empty region of OpenEXR file requested");
+    }
+    width = std::min(width, windowWidth - x);
+    height = std::min(height, windowHeight - y);
+
+    return Box2i(V2i(window.min.x + x, window.min.y + y),
+                 V2i(window.min.x + x + width - 1, window.min.y + y + height - 1));
+}
 }
 
 namespace pfs {
@@ -141,44 +212,74 @@ void EXRReader::close()
     setHeight(0);
 }
 
-void EXRReader::read(Frame & frame, const Params &/*params*/)
+void EXRReader::read(Frame & frame, const Params &params)
 {
     if ( !isOpen() ) open();
 
     // helpers...
     InputFile& file = m_data->file_;
-    Box2i& dtw = m_data->dtw_;
 
-    pfs::Frame tempFrame( width(), height() );
+    // level and region to read: tiled files decode only the tiles that
+    // overlap it, scanline files only its lines
+    int lx = 0;
+    int ly = 0;
+    Box2i levelWindow = m_data->dtw_;
+    std::unique_ptr<TiledInputFile> tiledFile;
+    if ( file.header().hasTileDescription() )
+    {
+        tiledFile.reset( new TiledInputFile(filename().c_str()) );
+        selectLevel(*tiledFile, params, lx, ly);
+        levelWindow = tiledFile->dataWindowForLevel(lx, ly);
+    }
+    const Box2i region = selectRegion(levelWindow, params);
+    const size_t regionWidth = region.max.x - region.min.x + 1;
+    const size_t regionHeight = region.max.y - region.min.y + 1;
+
+    int tx0 = 0, tx1 = 0, ty0 = 0, ty1 = 0;
+    Box2i decoded(V2i(levelWindow.min.x, region.min.y),
+                  V2i(levelWindow.max.x, region.max.y));
+    if ( tiledFile )
+    {
+        const TileDescription& tiles = tiledFile->tileDescription();
+        tx0 = (region.min.x - levelWindow.min.x)/tiles.xSize;
+        tx1 = (region.max.x - levelWindow.min.x)/tiles.xSize;
+        ty0 = (region.min.y - levelWindow.min.y)/tiles.ySize;
+        ty1 = (region.max.y - levelWindow.min.y)/tiles.ySize;
+
+        decoded = Box2i(tiledFile->dataWindowForTile(tx0, ty0, lx, ly).min,
+                        tiledFile->dataWindowForTile(tx1, ty1, lx, ly).max);
+    }
+    const size_t decodedWidth = decoded.max.x - decoded.min.x + 1;
+    const size_t decodedHeight = decoded.max.y - decoded.min.y + 1;
+
+    pfs::Frame tempFrame( regionWidth, regionHeight );
     pfs::Channel *X, *Y, *Z;
     tempFrame.createXYZChannels( X, Y, Z );
 
-    FrameBuffer frameBuffer;
-    frameBuffer.insert( "R",                                    // name
-                        Slice( FLOAT,                           // type
-                               (char*)(X->data() - dtw.min.x - dtw.min.y * width()),
-                               sizeof(float),                   // xStride
-                               sizeof(float) * width(),         // yStride
-                               1, 1,                            // x/y sampling
-                               0.0));                           // fillValue
-
-    frameBuffer.insert( "G",                                    // name
-                        Slice( FLOAT,                           // type
-                               (char*)(Y->data() - dtw.min.x - dtw.min.y * width()),
-                               sizeof(float),                   // xStride
-                               sizeof(float) * width(),         // yStride
-                               1, 1,                            // x/y sampling
-                               0.0));                           // fillValue
-
-    frameBuffer.insert( "B",                                    // name
-                        Slice( FLOAT,                           // type
-                               (char*)(Z->data() - dtw.min.x - dtw.min.y * width()),
-                               sizeof(float),                   // xStride
-                               sizeof(float) * width(),         // yStride
-                               1, 1,                            // x/y sampling
-                               0.0));                           // fillValue
-
+    // the pixels are decoded in the frame when they are exactly the region,
+    // otherwise in a buffer that the region is copied from
+    float* base[] = { X->data(), Y->data(), Z->data() };
+    size_t stride = regionWidth;
+    std::vector<float> buffer;
+    if ( decoded != region )
+    {
+        buffer.resize(3*decodedWidth*decodedHeight);
+        for (int c = 0; c < 3; ++c) base[c] = buffer.data() + c*decodedWidth*decodedHeight;
+        stride = decodedWidth;
+    }
 
+    FrameBuffer frameBuffer;
+    const char* names[] = { "R", "G", "B" };
+    for (int c = 0; c < 3; ++c)
+    {
+        frameBuffer.insert( names[c],                               // name
+                            Slice( FLOAT,                           // type
+                                   (char*)(base[c] - decoded.min.x - ptrdiff_t(decoded.min.y) * ptrdiff_t(stride)),
+                                   sizeof(float),                   // xStride
+                                   sizeof(float) * stride,          // yStride
+                                   1, 1,                            // x/y sampling
+                                   0.0));                           // fillValue
+    }
 
     // I know I have the channels I need because I have checked that I have the
     // RGB channels. Hence, I don't load any further that that...
@@ -237,8 +338,30 @@ void EXRReader::read(Frame & frame, const Params &/*params*/)
         }
     }
 
-    file.setFrameBuffer( frameBuffer );
-    file.readPixels( dtw.min.y, dtw.max.y );
+    if ( tiledFile )
+    {
+        tiledFile->setFrameBuffer( frameBuffer );
+        tiledFile->readTiles( tx0, tx1, ty0, ty1, lx, ly );
+    }
+    else
+    {
+        file.setFrameBuffer( frameBuffer );
+        file.readPixels( region.min.y, region.max.y );
+    }
+
+    if ( !buffer.empty() )
+    {
+        pfs::Channel* channels[] = { X, Y, Z };
+        for (int c = 0; c < 3; ++c)
+        {
+            for (size_t y = 0; y < regionHeight; ++y)
+            {
+                const float* src = base[c] + (region.min.y - decoded.min.y + y)*stride +
+                        (region.min.x - decoded.min.x);
+                std::copy(src, src + regionWidth, channels[c]->data() + y*regionWidth);
+            }
+        }
+    }
 
     // Rescale values if WhiteLuminance is present
     if ( hasWhiteLuminance( file.header() ) )
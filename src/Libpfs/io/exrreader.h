@@ -27,6 +27,15 @@
 namespace pfs {
 namespace io {
 
+//! \brief OpenEXR reader
+//!
+//! By default \c read() returns the full resolution image. With tiled files
+//! written with MIPMAP or RIPMAP levels, "exr_level" (int) reads a reduced
+//! level and "exr_min_width" (size_t) the smallest level at least that wide.
+//! "exr_region_x", "exr_region_y", "exr_region_width" and
+//! "exr_region_height" (size_t, in pixels of the level) restrict the read
+//! to a region: only the tiles (or scanlines) that overlap it are decoded.
+//! \note width() and height() are the ones of the full resolution image
 class EXRReader : public FrameReader {
 public:
     EXRReader(const std::string& filename);
@@ -23,15 +23,20 @@
 #include <ImfHeader.h>
 #include <ImfChannelList.h>
 #include <ImfOutputFile.h>
+#include <ImfTiledOutputFile.h>
 #include <ImfRgbaFile.h>
 #include <ImfStringAttribute.h>
 #include <ImfStandardAttributes.h>
 
 #include <string>
 #include <cmath>
+#include <algorithm>
+#include <vector>
 
 #include <Libpfs/frame.h>
 #include <Libpfs/io/exrwriter.h>
+#include <Libpfs/io/ioexception.h>
+#include <Libpfs/utils/parallel.h>
 
 // #define min(x,y) ( (x)<(y) ? (x) : (y) )
 
@@ -39,6 +44,179 @@ using namespace Imf;
 using namespace Imath;
 using namespace std;
 
+namespace {
+//! \brief one level of a tiled file: the three channels, stored row by row
+struct TileLevel
+{
+    TileLevel(size_t width, size_t height)
+        : width_(width)
+        , height_(height)
+    {
+        for (int c = 0; c < 3; ++c) data_[c].resize(width*height);
+    }
+
+    size_t width_;
+    size_t height_;
+    std::vector<float> data_[3];
+};
+
+//! \brief box filter \a src (of \a srcWidth x \a srcHeight) down to
+//! \a dstWidth x \a dstHeight, each one the same or half (rounded down) of
+//! the source size, as OpenEXR's ROUND_DOWN levels
+void reduce(const float* src, size_t srcWidth, size_t srcHeight,
+            float* dst, size_t dstWidth, size_t dstHeight)
+{
+    const size_t fx = (dstWidth < srcWidth) ? 2 : 1;
+    const size_t fy = (dstHeight < srcHeight) ? 2 : 1;
+    const float norm = 1.f/(fx*fy);
+
+    pfs::utils::parallelFor(0, dstHeight, 16, [&](size_t begin, size_t end)
+    {
+        for (size_t y = begin; y < end; ++y)
+        {
+            for (size_t x = 0; x < dstWidth; ++x)
+            {
+                float sum = 0.f;
+                for (size_t j = 0; j < fy; ++j)
+                {
+                    const float* row = src + (y*fy + j)*srcWidth + x*fx;
+                    for (size_t i = 0; i < fx; ++i) sum += row[i];
+                }
+                dst[y*dstWidth + x] = sum*norm;
+            }
+        }
+    });
+}
+
+//! \brief reduce the channels \a src, of \a srcWidth x \a srcHeight, to \a dst
+void reduce(const float* const src[3], size_t srcWidth, size_t srcHeight, TileLevel& dst)
+{
+    for (int c = 0; c < 3; ++c)
+    {
+        reduce(src[c], srcWidth, srcHeight,
+               dst.data_[c].data(), dst.width_, dst.height_);
+    }
+}
+
+FrameBuffer levelFrameBuffer(const float* const channels[3], size_t width)
+{
+    FrameBuffer frameBuffer;
+    const char* names[] = { "R", "G", "B" };
+    for (int c = 0; c < 3; ++c)
+    {
+        frameBuffer.insert(names[c],                            // name
+                           Slice( FLOAT,                        // type
+                                  (char*)channels[c],           // base
+                                  sizeof(float) * 1,            // xStride
+                                  sizeof(float) * width) );     // yStride
+    }
+    return frameBuffer;
+}
+
+//! \brief write the levels of \a file, reducing each one from the previous:
+//! only two levels are in memory at any time, besides the frame
+void writeTiled(TiledOutputFile& file,
+                const pfs::Channel* R, const pfs::Channel* G, const pfs::Channel* B)
+{
+    const float* frameData[] = { R->data(), G->data(), B->data() };
+    const size_t width = R->getWidth();
+    const size_t height = R->getHeight();
+
+    // the full resolution level is written straight from the frame
+    file.setFrameBuffer(levelFrameBuffer(frameData, width));
+
+    switch ( file.levelMode() )
+    {
+    case ONE_LEVEL:
+        file.writeTiles(0, file.numXTiles() - 1, 0, file.numYTiles() - 1);
+        break;
+    case MIPMAP_LEVELS:
+    {
+        file.writeTiles(0, file.numXTiles(0) - 1, 0, file.numYTiles(0) - 1, 0);
+
+        TileLevel previous(0, 0);
+        for (int l = 1; l < file.numLevels(); ++l)
+        {
+            TileLevel current(file.levelWidth(l), file.levelHeight(l));
+            if ( l == 1 ) {
+                reduce(frameData, width, height, current);
+            } else {
+                const float* src[] = { previous.data_[0].data(),
+                                       previous.data_[1].data(),
+                                       previous.data_[2].data() };
+                reduce(src, previous.width_, previous.height_, current);
+            }
+            std::swap(previous, current);
+
+            const float* data[] = { previous.data_[0].data(),
+                                    previous.data_[1].data(),
+                                    previous.data_[2].data() };
+            file.setFrameBuffer(levelFrameBuffer(data, previous.width_));
+            file.writeTiles(0, file.numXTiles(l) - 1, 0, file.numYTiles(l) - 1, l);
+        }
+    }
+        break;
+    case RIPMAP_LEVELS:
+    {
+        // (0, ly) is reduced from (0, ly - 1), (lx, ly) from (lx - 1, ly)
+        TileLevel column(0, 0);
+        for (int ly = 0; ly < file.numYLevels(); ++ly)
+        {
+            const float* columnData[3] = { frameData[0], frameData[1], frameData[2] };
+            size_t columnHeight = height;
+            if ( ly > 0 )
+            {
+                TileLevel current(width, file.levelHeight(ly));
+                if ( ly == 1 ) {
+                    reduce(frameData, width, height, current);
+                } else {
+                    const float* src[] = { column.data_[0].data(),
+                                           column.data_[1].data(),
+                                           column.data_[2].data() };
+                    reduce(src, width, column.height_, current);
+                }
+                std::swap(column, current);
+
+                for (int c = 0; c < 3; ++c) columnData[c] = column.data_[c].data();
+                columnHeight = column.height_;
+
+                file.setFrameBuffer(levelFrameBuffer(columnData, width));
+                file.writeTiles(0, file.numXTiles(0) - 1, 0, file.numYTiles(ly) - 1, 0, ly);
+            }
+            else
+            {
+                file.writeTiles(0, file.numXTiles(0) - 1, 0, file.numYTiles(0) - 1, 0, 0);
+            }
+
+            TileLevel previous(0, 0);
+            for (int lx = 1; lx < file.numXLevels(); ++lx)
+            {
+                TileLevel current(file.levelWidth(lx), columnHeight);
+                if ( lx == 1 ) {
+                    reduce(columnData, width, columnHeight, current);
+                } else {
+                    const float* src[] = { previous.data_[0].data(),
+                                           previous.data_[1].data(),
+                                           previous.data_[2].data() };
+                    reduce(src, previous.width_, previous.height_, current);
+                }
+                std::swap(previous, current);
+
+                const float* data[] = { previous.data_[0].data(),
+                                        previous.data_[1].data(),
+                                        previous.data_[2].data() };
+                file.setFrameBuffer(levelFrameBuffer(data, previous.width_));
+                file.writeTiles(0, file.numXTiles(lx) - 1, 0, file.numYTiles(ly) - 1, lx, ly);
+            }
+        }
+    }
+        break;
+    default:
+        break;
+    }
+}
+}
+
 namespace pfs {
 namespace io {
 
@@ -46,8 +224,25 @@ EXRWriter::EXRWriter(const string &filename)
     : FrameWriter(filename)
 {}
 
-bool EXRWriter::write(const Frame &frame, const Params &/*params*/)
+bool EXRWriter::write(const Frame &frame, const Params &params)
 {
+    // scanlines, unless "exr_tiles" asks for tiles with one|mipmap|ripmap levels
+    std::string tiles;
+    params.get("exr_tiles", tiles);
+    int tileSize = 64;
+    params.get("exr_tile_size", tileSize);
+
+    LevelMode levelMode = NUM_LEVELMODES;
+    if ( tiles == "one" ) levelMode = ONE_LEVEL;
+    else if ( tiles == "mipmap" ) levelMode = MIPMAP_LEVELS;
+    else if ( tiles == "ripmap" ) levelMode = RIPMAP_LEVELS;
+    else if ( !tiles.empty() ) {
+        throw pfs::io::WriteException("Unknown EXR tiles mode: " + tiles);
+    }
+    if ( tileSize <= 0 ) {
+        throw pfs::io::WriteException("Invalid EXR tile size");
+    }
+
     // Channels are named (X Y Z) but contain (R G B) data
     const pfs::Channel *R, *G, *B;
     frame.getXYZChannels(R, G, B);
@@ -110,6 +305,16 @@ bool EXRWriter::write(const Frame &frame, const Params &/*params*/)
                               sizeof(float) * 1,                    // xStride
                               sizeof(float) * frame.getWidth()) );    // yStride
 
+    if ( levelMode != NUM_LEVELMODES )
+    {
+        header.setTileDescription(TileDescription(tileSize, tileSize,
+                                                  levelMode, ROUND_DOWN));
+
+        TiledOutputFile file(filename().c_str(), header);
+        writeTiled(file, R, G, B);
+        return true;
+    }
+
     OutputFile file(filename().c_str(), header);
     file.setFrameBuffer(frameBuffer);
     file.writePixels(frame.getHeight());
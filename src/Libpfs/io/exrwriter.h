@@ -35,6 +35,10 @@
 namespace pfs {
 namespace io {
 
+//! \brief OpenEXR writer: scanlines by default. "exr_tiles" (std::string)
+//! writes tiles instead, with a single level ("one") or with the reduced
+//! levels of "mipmap" or "ripmap", that \c EXRReader can read without
+//! decoding the full image. "exr_tile_size" (int) defaults to 64
 class EXRWriter : public FrameWriter {
 public:
     EXRWriter(const std::string& filename);
@@ -22,6 +22,7 @@
 #include <Libpfs/io/framereader.h>
 
 #include <Libpfs/frame.h>
+#include <Libpfs/quantizedframe.h>
 #include <Libpfs/exif/exifdata.hpp>
 #include <Libpfs/manip/rotate.h>
 
@@ -56,5 +57,25 @@ void FrameReader::read(pfs::Frame& frame, const pfs::Params& params)
     }
 }
 
+bool FrameReader::readCodes(pfs::QuantizedFrame& /*frame*/, const pfs::Params& /*params*/)
+{
+    return false;
+}
+
+void FrameReader::orientCodes(pfs::QuantizedFrame& frame) const
+{
+    pfs::exif::ExifData exifData(m_filename);
+    int rotation = exifData.getOrientationDegree();
+
+    if (rotation == 270 || rotation == 90 || rotation == 180)
+    {
+        frame.rotate(rotation != 270);
+    }
+    if (rotation == 180)
+    {
+        frame.rotate(true);
+    }
+}
+
 }   // io
 }   // pfs
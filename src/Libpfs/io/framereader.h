@@ -32,6 +32,7 @@
 
 namespace pfs {
 class Frame;
+class QuantizedFrame;
 
 namespace io {
 
@@ -54,7 +55,17 @@ public:
     virtual void close() = 0;
     virtual void read(pfs::Frame& frame, const pfs::Params& params);
 
+    //! \brief read the 8 or 16 bit codes of the file into \a frame, without
+    //! expanding them to float (see QuantizedFrame)
+    //! \return false, and nothing is read, if the file does not hold plain RGB
+    //! codes (float data, an embedded colour profile, CMYK...): use read()
+    virtual bool readCodes(pfs::QuantizedFrame& frame, const pfs::Params& params);
+
 protected:
+    //! \brief turn \a frame as given by the EXIF orientation of the file, as
+    //! read() does
+    void orientCodes(pfs::QuantizedFrame& frame) const;
+
     void setWidth(size_t width)     { m_width = width; }
     void setHeight(size_t height)   { m_height = height; }
 
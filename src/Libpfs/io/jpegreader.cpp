@@ -23,6 +23,7 @@
 #include <Libpfs/io/jpegreader.h>
 
 #include <Libpfs/frame.h>
+#include <Libpfs/quantizedframe.h>
 #include <Libpfs/fixedstrideiterator.h>
 #include <Libpfs/colorspace/copy.h>
 #include <Libpfs/colorspace/cmyk.h>
@@ -33,6 +34,8 @@
 
 #include <cassert>
 #include <iostream>
+#include <utility>
+#include <vector>
 #include <jpeglib.h>
 
 using namespace pfs;
@@ -467,5 +470,65 @@ void JpegReader::read(Frame &frame, const Params &params)
     }
 }
 
+bool JpegReader::readCodes(QuantizedFrame &frame, const Params &/*params*/)
+{
+    switch (m_data->cinfo()->jpeg_color_space)
+    {
+    case JCS_RGB:
+    case JCS_YCbCr:
+        break;
+    default:
+        // CMYK is converted
+        return false;
+    }
+
+    try
+    {
+        {
+            // a profile converts the samples: they are not codes any more
+            utils::ScopedCmsTransform xform( getColorSpaceTransform(m_data->cinfo()) );
+            if ( xform ) return false;
+        }
+
+        QuantizedFrame codes(width(), height(), 8);
+        uint8_t* red = codes.codes8(0);
+        uint8_t* green = codes.codes8(1);
+        uint8_t* blue = codes.codes8(2);
+
+        jpeg_start_decompress(m_data->cinfo());
+
+        assert( m_data->cinfo()->output_width == width() );
+        assert( m_data->cinfo()->output_components == 3 );
+
+        std::vector<JSAMPLE> scanLineBuffer(width()*3);
+        JSAMPROW scanLineBufferArray[1] = { scanLineBuffer.data() };
+
+        for (size_t i = 0; m_data->cinfo()->output_scanline < m_data->cinfo()->output_height; ++i)
+        {
+            jpeg_read_scanlines(m_data->cinfo(), scanLineBufferArray, 1);
+
+            const size_t offset = i*width();
+            for (size_t x = 0; x < width(); ++x)
+            {
+                red[offset + x] = scanLineBuffer[3*x];
+                green[offset + x] = scanLineBuffer[3*x + 1];
+                blue[offset + x] = scanLineBuffer[3*x + 2];
+            }
+        }
+
+        jpeg_finish_decompress(m_data->cinfo());
+        jpeg_destroy_decompress(m_data->cinfo());
+
+        orientCodes(codes);
+        std::swap(frame, codes);
+        return true;
+    }
+    catch (...)
+    {
+        close();
+        throw;
+    }
+}
+
 }   // io
 }   // pfs
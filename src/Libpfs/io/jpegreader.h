@@ -45,6 +45,7 @@ public:
     bool isOpen() const;
     void close();
     void read(Frame &frame, const Params &params);
+    bool readCodes(QuantizedFrame &frame, const Params &params);
 
 private:
     struct JpegReaderData;
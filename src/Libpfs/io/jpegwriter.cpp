@@ -36,6 +36,7 @@
 #include <Libpfs/frame.h>
 #include <Libpfs/colorspace/rgbremapper.h>
 #include <Libpfs/colorspace/normalizer.h>
+#include <Libpfs/manip/gamma_levels.h>
 #include <Libpfs/utils/resourcehandlerstdio.h>
 #include <Libpfs/utils/resourcehandlerlcms.h>
 #include <Libpfs/utils/transform.h>
@@ -158,10 +159,12 @@ struct JpegWriterParams
         , minLuminance_(0.f)
         , maxLuminance_(1.f)
         , luminanceMapping_(MAP_LINEAR)
+        , dither_(false)
     {}
 
     void parse(const Params& params)
     {
+        levels_ = GammaLevels::fromParams(params);
         for ( Params::const_iterator it = params.begin(), itEnd = params.end();
               it != itEnd; ++it )
         {
@@ -181,6 +184,10 @@ struct JpegWriterParams
                 luminanceMapping_ = it->second.as<RGBMappingType>(luminanceMapping_);
                 continue;
             }
+            if ( it->first == "dither" ) {
+                dither_ = it->second.as<bool>(dither_);
+                continue;
+            }
         }
     }
 
@@ -188,6 +195,8 @@ struct JpegWriterParams
     float minLuminance_;
     float maxLuminance_;
     RGBMappingType luminanceMapping_;
+    GammaLevels levels_;
+    bool dither_;
 };
 
 ostream& operator<<(ostream& out, const JpegWriterParams& params)
@@ -270,23 +279,21 @@ public:
             std::vector<JSAMPLE> scanLineOut(cinfo.image_width * cinfo.num_components);
             JSAMPROW scanLineOutArray[1] = { scanLineOut.data() };
 
+            LevelsQuantizer<JSAMPLE> quantizer(params.minLuminance_, params.maxLuminance_,
+                                               params.levels_, params.luminanceMapping_,
+                                               params.dither_);
+
             while (cinfo.next_scanline < cinfo.image_height)
             {
                 // copy line from Frame into scanLineOut
-                utils::transform(
-                            rChannel->row_begin(cinfo.next_scanline),
-                            rChannel->row_end(cinfo.next_scanline),
-                            gChannel->row_begin(cinfo.next_scanline),
-                            bChannel->row_begin(cinfo.next_scanline),
-                            FixedStrideIterator<JSAMPLE*, 3>(scanLineOut.data()),
-                            FixedStrideIterator<JSAMPLE*, 3>(scanLineOut.data() + 1),
-                            FixedStrideIterator<JSAMPLE*, 3>(scanLineOut.data() + 2),
-                            utils::chain(
-                                colorspace::Normalizer(params.minLuminance_, params.maxLuminance_),
-                                utils::CLAMP_F32,
-                                Remapper<JSAMPLE>(params.luminanceMapping_)
-                                )
-                            );
+                quantizer(rChannel->row_begin(cinfo.next_scanline),
+                          gChannel->row_begin(cinfo.next_scanline),
+                          bChannel->row_begin(cinfo.next_scanline),
+                          cinfo.image_width,
+                          scanLineOut.data(),
+                          scanLineOut.data() + 1,
+                          scanLineOut.data() + 2,
+                          3, cinfo.next_scanline);
                 jpeg_write_scanlines(&cinfo, scanLineOutArray, 1);
             }
         }
@@ -34,6 +34,7 @@
 #include <Libpfs/frame.h>
 #include <Libpfs/colorspace/rgbremapper.h>
 #include <Libpfs/colorspace/normalizer.h>
+#include <Libpfs/manip/gamma_levels.h>
 #include <Libpfs/utils/resourcehandlerlcms.h>
 #include <Libpfs/utils/resourcehandlerstdio.h>
 #include <Libpfs/utils/transform.h>
@@ -54,10 +55,12 @@ struct PngWriterParams
         , minLuminance_(0.f)
         , maxLuminance_(1.f)
         , luminanceMapping_(MAP_LINEAR)
+        , dither_(false)
     {}
 
     void parse(const Params& params)
     {
+        levels_ = GammaLevels::fromParams(params);
         for ( Params::const_iterator it = params.begin(), itEnd = params.end();
               it != itEnd; ++it )
         {
@@ -77,6 +80,10 @@ struct PngWriterParams
                 luminanceMapping_ = it->second.as<RGBMappingType>(luminanceMapping_);
                 continue;
             }
+            if ( it->first == "dither" ) {
+                dither_ = it->second.as<bool>(dither_);
+                continue;
+            }
         }
     }
 
@@ -93,6 +100,8 @@ struct PngWriterParams
     float minLuminance_;
     float maxLuminance_;
     RGBMappingType luminanceMapping_;
+    GammaLevels levels_;
+    bool dither_;
 };
 
 ostream& operator<<(ostream& out, const PngWriterParams& params)
@@ -196,23 +205,22 @@ public:
         const Channel* bChannel;
         frame.getXYZChannels(rChannel, gChannel, bChannel);
 
+        LevelsQuantizer<png_byte> quantizer(params.minLuminance_, params.maxLuminance_,
+                                            params.levels_, params.luminanceMapping_,
+                                            params.dither_);
+
         std::vector<png_byte> scanLineOut( width * 3 );
         for (png_uint_32 row = 0; row < height; ++row)
         {
-            utils::transform(
-                        rChannel->row_begin(row),
-                        rChannel->row_end(row),
-                        gChannel->row_begin(row),
-                        bChannel->row_begin(row),
-                        FixedStrideIterator<png_byte*, 3>(scanLineOut.data() + 2),
-                        FixedStrideIterator<png_byte*, 3>(scanLineOut.data() + 1),
-                        FixedStrideIterator<png_byte*, 3>(scanLineOut.data()),
-                        utils::chain(
-                            colorspace::Normalizer(params.minLuminance_, params.maxLuminance_),
-                            utils::CLAMP_F32,
-                            Remapper<png_byte>(params.luminanceMapping_)
-                            )
-                        );
+            // BGR, see png_set_bgr()
+            quantizer(rChannel->row_begin(row),
+                      gChannel->row_begin(row),
+                      bChannel->row_begin(row),
+                      width,
+                      scanLineOut.data() + 2,
+                      scanLineOut.data() + 1,
+                      scanLineOut.data(),
+                      3, row);
             png_write_row(png_ptr, scanLineOut.data());
         }
 
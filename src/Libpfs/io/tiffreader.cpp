@@ -23,6 +23,7 @@
 #include <Libpfs/io/tiffcommon.h>
 
 #include <Libpfs/frame.h>
+#include <Libpfs/quantizedframe.h>
 #include <Libpfs/fixedstrideiterator.h>
 #include <Libpfs/strideiterator.h>
 
@@ -191,6 +192,30 @@ struct TiffReaderData
         currentCallback_(this, frame, TiffReaderParams());
     }
 
+    //! \return false if the samples are not plain RGB codes
+    bool readCodes(QuantizedFrame& frame)
+    {
+        if ( photometricType_ != PHOTOMETRIC_RGB ) return false;
+        if ( bitsPerSample_ != 8 && bitsPerSample_ != 16 ) return false;
+        {
+            // a profile converts the samples: they are not codes any more
+            ScopedCmsTransform xform( getColorSpaceTransform() );
+            if ( xform ) return false;
+        }
+
+        QuantizedFrame codes(width_, height_, bitsPerSample_);
+        if ( bitsPerSample_ == 8 )
+        {
+            readCodes(codes.codes8(0), codes.codes8(1), codes.codes8(2));
+        }
+        else
+        {
+            readCodes(codes.codes16(0), codes.codes16(1), codes.codes16(2));
+        }
+        std::swap(frame, codes);
+        return true;
+    }
+
     void initReader()
     {
         typedef std::pair<uint16, uint16> RegistryKey;
@@ -281,6 +306,26 @@ private:
 
     void doNothing(Frame &/*frame*/, const TiffReaderParams& /*params*/) {}
 
+    template <typename InputDataType>
+    void readCodes(InputDataType* red, InputDataType* green, InputDataType* blue)
+    {
+        assert(samplesPerPixel_ >= 3);
+
+        std::vector<InputDataType> tempBuffer(width_*samplesPerPixel_);
+        for (uint32 row = 0; row < height_; row++)
+        {
+            TIFFReadScanline(handle(), tempBuffer.data(), row);
+
+            const size_t offset = size_t(row)*width_;
+            for (uint32 x = 0; x < width_; ++x)
+            {
+                red[offset + x] = tempBuffer[x*samplesPerPixel_];
+                green[offset + x] = tempBuffer[x*samplesPerPixel_ + 1];
+                blue[offset + x] = tempBuffer[x*samplesPerPixel_ + 2];
+            }
+        }
+    }
+
     template <typename InputDataType, typename Converter>
     void read3Components(Frame& frame, const TiffReaderParams& /*params*/,
                          const Converter& conv)
@@ -521,5 +566,16 @@ void TiffReader::read(Frame &frame, const Params &params)
     FrameReader::read(frame, params);
 }
 
+bool TiffReader::readCodes(QuantizedFrame &frame, const Params &/*params*/)
+{
+    if ( !isOpen() ) {
+        open();
+    }
+
+    if ( !m_data->readCodes(frame) ) return false;
+    orientCodes(frame);
+    return true;
+}
+
 }   // io
 }   // pfs
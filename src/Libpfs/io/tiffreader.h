@@ -45,6 +45,7 @@ public:
     void close();
 
     void read(Frame &frame, const Params &params);
+    bool readCodes(QuantizedFrame &frame, const Params &params);
 
 private:
     std::unique_ptr<TiffReaderData> m_data;
@@ -54,6 +54,7 @@
 #include <Libpfs/colorspace/rgbremapper.h>
 #include <Libpfs/colorspace/xyz.h>
 #include <Libpfs/colorspace/normalizer.h>
+#include <Libpfs/manip/gamma_levels.h>
 #include <Libpfs/utils/chain.h>
 #include <Libpfs/utils/clamp.h>
 #include <Libpfs/frame.h>
@@ -82,10 +83,12 @@ struct TiffWriterParams
         , luminanceMapping_(MAP_LINEAR)
         , tiffWriterMode_(0)        // 8bit uint by default
         , deflateCompression_(true)
+        , dither_(false)
     {}
 
     void parse(const Params& params)
     {
+        levels_ = GammaLevels::fromParams(params);
         for ( Params::const_iterator it = params.begin(), itEnd = params.end();
               it != itEnd; ++it )
         {
@@ -111,6 +114,10 @@ struct TiffWriterParams
             }
             if ( it->first == "deflateCompression" ) {
                 deflateCompression_ = it->second.as<bool>(deflateCompression_);
+                continue;
+            }
+            if ( it->first == "dither" ) {
+                dither_ = it->second.as<bool>(dither_);
                 //continue;
             }
         }
@@ -122,6 +129,8 @@ struct TiffWriterParams
     RGBMappingType luminanceMapping_;
     int tiffWriterMode_;
     bool deflateCompression_;
+    GammaLevels levels_;
+    bool dither_;
 };
 
 ostream& operator<<(ostream& out, const TiffWriterParams& params)
@@ -197,23 +206,21 @@ bool writeUint8(TIFF* tif, const Frame& frame, const TiffWriterParams& params)
     const Channel* bChannel;
     frame.getXYZChannels(rChannel, gChannel, bChannel);
 
+    LevelsQuantizer<uint8_t> quantizer(params.minLuminance_, params.maxLuminance_,
+                                       params.levels_, params.luminanceMapping_,
+                                       params.dither_);
+
     std::vector<uint8_t> stripBuffer( stripSize );
     for (tstrip_t s = 0; s < stripsNum; s++)
     {
-        utils::transform(
-                    rChannel->row_begin(s),
-                    rChannel->row_end(s),
-                    gChannel->row_begin(s),
-                    bChannel->row_begin(s),
-                    FixedStrideIterator<uint8_t*, 3>(stripBuffer.data()),
-                    FixedStrideIterator<uint8_t*, 3>(stripBuffer.data() + 1),
-                    FixedStrideIterator<uint8_t*, 3>(stripBuffer.data() + 2),
-                    utils::chain(
-                        colorspace::Normalizer(params.minLuminance_, params.maxLuminance_),
-                        utils::CLAMP_F32,
-                        Remapper<uint8_t>(params.luminanceMapping_)
-                        )
-                    );
+        quantizer(rChannel->row_begin(s),
+                  gChannel->row_begin(s),
+                  bChannel->row_begin(s),
+                  width,
+                  stripBuffer.data(),
+                  stripBuffer.data() + 1,
+                  stripBuffer.data() + 2,
+                  3, s);
 
         if (TIFFWriteEncodedStrip(tif, s, stripBuffer.data(), stripSize) != stripSize)
         {
@@ -258,28 +265,19 @@ bool writeUint16(TIFF* tif, const Frame& frame, const TiffWriterParams& params)
 
     std::vector<uint16_t> stripBuffer( width*3 );
 
-    typedef utils::Chain<
-            colorspace::Normalizer,
-            utils::Chain<
-                utils::Clamp<float>,
-                Remapper<uint16_t>
-            >> TiffRemapper;
-
-    TiffRemapper remapper(
-                colorspace::Normalizer(params.minLuminance_, params.maxLuminance_),
-                utils::Chain<
-                    utils::Clamp<float>,
-                    Remapper<uint16_t>
-                >(utils::Clamp<float>(0.f, 1.f), Remapper<uint16_t>(params.luminanceMapping_)));
+    LevelsQuantizer<uint16_t> quantizer(params.minLuminance_, params.maxLuminance_,
+                                        params.levels_, params.luminanceMapping_,
+                                        params.dither_);
     for (tstrip_t s = 0; s < stripsNum; s++)
     {
-        utils::transform(rChannel->row_begin(s), rChannel->row_end(s),
-                         gChannel->row_begin(s),
-                         bChannel->row_begin(s),
-                         FixedStrideIterator<uint16_t*, 3>(stripBuffer.data()),
-                         FixedStrideIterator<uint16_t*, 3>(stripBuffer.data() + 1),
-                         FixedStrideIterator<uint16_t*, 3>(stripBuffer.data() + 2),
-                         remapper);
+        quantizer(rChannel->row_begin(s),
+                  gChannel->row_begin(s),
+                  bChannel->row_begin(s),
+                  width,
+                  stripBuffer.data(),
+                  stripBuffer.data() + 1,
+                  stripBuffer.data() + 2,
+                  3, s);
         if (TIFFWriteEncodedStrip(tif, s, stripBuffer.data(), stripSize) != stripSize)
         {
             throw pfs::io::WriteException("TiffWriter: Error writing strip " +
@@ -329,12 +327,13 @@ bool writeFloat32(TIFF* tif, const Frame& frame, const TiffWriterParams& params)
     std::vector<float> stripBuffer( width*3 );
     typedef utils::Chain<
             colorspace::Normalizer,
-            utils::Clamp<float>
+            GammaLevels
             > TiffRemapper;
     // Mapping is linear, so I avoid to call the Remapper class
+    // (GammaLevels also clamps the samples in [0, 1])
     TiffRemapper remapper(
                 colorspace::Normalizer(params.minLuminance_, params.maxLuminance_),
-                utils::Clamp<float>(0.f, 1.f));
+                params.levels_);
     for (tstrip_t s = 0; s < stripsNum; s++)
     {
         utils::transform(rChannel->row_begin(s), rChannel->row_end(s),
@@ -393,16 +392,16 @@ bool writeLogLuv(TIFF* tif, const Frame& frame, const TiffWriterParams& params)
     typedef utils::Chain<
             colorspace::Normalizer,
             utils::Chain<
-                utils::Clamp<float>,
+                GammaLevels,
                 colorspace::ConvertRGB2XYZ
             >> TiffRemapper;
 
     TiffRemapper remapper(
                 colorspace::Normalizer(params.minLuminance_, params.maxLuminance_),
                 utils::Chain<
-                    utils::Clamp<float>,
+                    GammaLevels,
                     colorspace::ConvertRGB2XYZ
-                >(utils::Clamp<float>(0.f, 1.f), colorspace::ConvertRGB2XYZ()));
+                >(params.levels_, colorspace::ConvertRGB2XYZ()));
 
     for (tstrip_t s = 0; s < stripsNum; s++)
     {
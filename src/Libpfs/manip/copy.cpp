@@ -25,6 +25,7 @@
 #include "copy.h"
 
 #include "Libpfs/frame.h"
+#include "Libpfs/frame_view.h"
 #include "Libpfs/utils/msec_timer.h"
 
 #include <algorithm>
@@ -68,4 +69,34 @@ pfs::Frame *copy(const pfs::Frame *inFrame)
     return outFrame;
 }
 
+pfs::Frame* copy(const pfs::FrameView& view)
+{
+#ifdef TIMER_PROFILING
+    msec_timer f_timer;
+    f_timer.start();
+#endif
+
+    pfs::Frame *outFrame = new pfs::Frame(view.getWidth(), view.getHeight());
+
+    const ChannelContainer& channels = view.getChannels();
+
+    for ( ChannelContainer::const_iterator it = channels.begin();
+          it != channels.end();
+          ++it)
+    {
+        pfs::Channel *outCh = outFrame->createChannel((*it)->getName());
+
+        copy(view.getChannel(**it), outCh);
+    }
+
+    pfs::copyTags(&view.getFrame(), outFrame);
+
+#ifdef TIMER_PROFILING
+    f_timer.stop_and_update();
+    std::cout << "pfscopy(view) = " << f_timer.get_time() << " msec" << std::endl;
+#endif
+
+    return outFrame;
+}
+
 }
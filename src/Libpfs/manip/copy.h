@@ -26,13 +26,19 @@
 #define PFS_COPY_H
 
 #include "Libpfs/array2d_fwd.h"
+#include "Libpfs/array2d_view.h"
 
 namespace pfs
 {
 class Frame;
+class FrameView;
 
 pfs::Frame* copy(const pfs::Frame *inFrame);
 
+//! \brief materialise the region described by \c view into a new \c Frame
+//! (channels and tags are copied)
+pfs::Frame* copy(const pfs::FrameView& view);
+
 //! \brief Copy data from one Array2D to another.
 //! Dimensions of the arrays must be the same.
 //!
@@ -41,6 +47,11 @@ pfs::Frame* copy(const pfs::Frame *inFrame);
 template<typename Type>
 void copy(const Array2D<Type> *from, Array2D<Type> *to);
 
+//! \brief Copy the content of a (strided) view inside \c to.
+//! Dimensions of \c from and \c to must be the same.
+template<typename Type>
+void copy(const Array2DView<const Type>& from, Array2D<Type> *to);
+
 } // pfs
 
 #include "copy.hxx"
@@ -30,6 +30,9 @@
 #include <cassert>
 #include <algorithm>
 
+#include "Libpfs/array2d.h"
+#include "Libpfs/utils/parallel.h"
+
 namespace pfs
 {
 
@@ -41,6 +44,29 @@ void copy(const Array2D<Type> *from, Array2D<Type> *to)
 
     std::copy(from->begin(), from->end(), to->begin());
 }
+
+template <typename Type>
+void copy(const Array2DView<const Type>& from, Array2D<Type> *to)
+{
+    assert( from.getRows() == to->getRows() );
+    assert( from.getCols() == to->getCols() );
+
+    if ( from.isContiguous() )
+    {
+        std::copy(from.data(), from.data() + from.size(), to->begin());
+        return;
+    }
+
+    const size_t rowGrain = utils::PARALLEL_SAMPLES_GRAIN/std::max<size_t>(from.getCols(), 1);
+    utils::parallelFor(0, from.getRows(), rowGrain,
+                       [&](size_t first, size_t last)
+    {
+        for (size_t r = first; r < last; r++)
+        {
+            std::copy(from.row_begin(r), from.row_end(r), to->row_begin(r));
+        }
+    });
+}
 }
 
 #endif // #ifndef PFS_COPY_HXX
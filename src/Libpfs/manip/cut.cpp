@@ -37,6 +37,8 @@
 
 #include "Libpfs/utils/msec_timer.h"
 #include "Libpfs/frame.h"
+#include "Libpfs/frame_view.h"
+#include "copy.h"
 
 namespace pfs
 {
@@ -51,30 +53,7 @@ pfs::Frame *cut(const pfs::Frame *inFrame,
     f_timer.start();
 #endif
 
-    // ----  Boundary Check!
-    // if (x_ul < 0) x_ul = 0;
-    // if (y_ul < 0) y_ul = 0;
-    if (x_br > inFrame->getWidth()) x_br = inFrame->getWidth();
-    if (y_br > inFrame->getHeight()) y_br = inFrame->getHeight();
-    // -----
-
-    pfs::Frame *outFrame = new pfs::Frame((x_br-x_ul), (y_br-y_ul));
-
-    const ChannelContainer& channels = inFrame->getChannels();
-
-    for ( ChannelContainer::const_iterator it = channels.begin();
-          it != channels.end();
-          ++it)
-    {
-        const pfs::Channel* inCh = *it;
-
-        pfs::Channel *outCh = outFrame->createChannel(inCh->getName());
-
-        cut(inCh, outCh,
-            x_ul, y_ul, x_br, y_br);
-    }
-
-    pfs::copyTags(inFrame, outFrame);
+    pfs::Frame *outFrame = copy(FrameView(*inFrame, x_ul, y_ul, x_br, y_br));
 
 #ifdef TIMER_PROFILING
     f_timer.stop_and_update();
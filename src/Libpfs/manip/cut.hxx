@@ -26,10 +26,13 @@
 //! \author Davide Anastasia <davideanastasia@users.sourceforge.net>
 
 #include "cut.h"
+#include "copy.h"
 
 #include <cassert>
 #include <algorithm>
 
+#include <Libpfs/array2d_view.h>
+
 namespace pfs
 {
 
@@ -46,19 +49,7 @@ void cut(const Array2D<Type> *from, Array2D<Type> *to,
 
     // if ( x_ul < 0 ) x_ul = 0; // unsigned
     // if ( y_ul < 0 ) y_ul = 0; // unsigned
-    if ( x_br > from->getCols() ) x_br = from->getCols();
-    if ( y_br > from->getRows() ) y_br = from->getRows();
-
-    // update right border
-    x_br = from->getCols() - x_br;
-    int rEnd = (int)to->getRows();
-#pragma omp parallel for shared(rEnd)
-    for (int r = 0; r < rEnd; r++)
-    {
-        std::copy(from->row_begin(r + y_ul) + x_ul,
-                  from->row_end(r + y_ul) - x_br,
-                  to->row_begin(r));
-    }
+    copy(Array2DView<const Type>(*from, x_ul, y_ul, x_br, y_br), to);
 }
 
 }   // pfs
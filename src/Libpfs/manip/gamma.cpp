@@ -26,14 +26,18 @@
 
 #include "gamma.h"
 
+#include <algorithm>
 #include <iostream>
 #include <cmath>
 #include <cassert>
 
 #include "Libpfs/array2d.h"
 #include "Libpfs/frame.h"
+#include "Libpfs/frame_view.h"
+#include "Libpfs/manip/copy.h"
 #include "Libpfs/colorspace/colorspace.h"
 #include "Libpfs/utils/msec_timer.h"
+#include "Libpfs/utils/parallel.h"
 
 namespace pfs
 {
@@ -50,31 +54,51 @@ void applyGamma(pfs::Frame* frame, float gamma)
     applyGamma(X, 1.0f/gamma, multiplier);
     applyGamma(Y, 1.0f/gamma, multiplier);
     applyGamma(Z, 1.0f/gamma, multiplier);
+
+    // a hash taken while the channels were written is stale
+    frame->invalidateContentHash();
 }
 
 
 void applyGamma(pfs::Array2Df *array, const float exponent, const float multiplier)
+{
+    applyGamma(Array2DfConstView(*array), array, exponent, multiplier);
+}
+
+void applyGamma(const pfs::Array2DfConstView& in, pfs::Array2Df *out,
+                const float exponent, const float multiplier)
 {
 #ifdef TIMER_PROFILING
     msec_timer f_timer;
     f_timer.start();
 #endif
 
-    float* Vin  = array->data();
+    assert( in.getCols() == out->getCols() );
+    assert( in.getRows() == out->getRows() );
 
-    int V_ELEMS = array->getRows()*array->getCols();
-#pragma omp parallel for
-    for (int idx = 0; idx < V_ELEMS; idx++)
+    const int V_COLS = in.getCols();
+    const int V_ROWS = in.getRows();
+    utils::parallelFor(0, V_ROWS, utils::PARALLEL_SAMPLES_GRAIN/std::max(V_COLS, 1),
+                       [&](size_t first, size_t last)
     {
-        if (Vin[idx] > 0.0f)
-        {
-            Vin[idx] = powf(Vin[idx]*multiplier, exponent);
-        }
-        else
+        for (size_t r = first; r < last; r++)
         {
-            Vin[idx] = 0.0f;
+            const float* Vin = in.row_begin(r);
+            float* Vout = out->data() + r*V_COLS;
+
+            for (int c = 0; c < V_COLS; c++)
+            {
+                if (Vin[c] > 0.0f)
+                {
+                    Vout[c] = powf(Vin[c]*multiplier, exponent);
+                }
+                else
+                {
+                    Vout[c] = 0.0f;
+                }
+            }
         }
-    }
+    });
 
 #ifdef TIMER_PROFILING
     f_timer.stop_and_update();
@@ -82,5 +106,36 @@ void applyGamma(pfs::Array2Df *array, const float exponent, const float multipli
 #endif
 }
 
+pfs::Frame* copyWithGamma(const pfs::FrameView& view, float gamma)
+{
+    if ( gamma == 1.0f ) return copy(view);
+
+    pfs::Frame *outFrame = new pfs::Frame(view.getWidth(), view.getHeight());
+
+    const Channel *X, *Y, *Z;
+    view.getFrame().getXYZChannels( X, Y, Z );
+
+    const ChannelContainer& channels = view.getChannels();
+    for ( ChannelContainer::const_iterator it = channels.begin();
+          it != channels.end();
+          ++it)
+    {
+        pfs::Channel *outCh = outFrame->createChannel((*it)->getName());
+
+        if ( *it == X || *it == Y || *it == Z )
+        {
+            applyGamma(view.getChannel(**it), outCh, 1.0f/gamma, 1.0f);
+        }
+        else
+        {
+            copy(view.getChannel(**it), outCh);
+        }
+    }
+
+    pfs::copyTags(&view.getFrame(), outFrame);
+
+    return outFrame;
+}
+
 }
 
@@ -24,6 +24,7 @@
 #define PFS_GAMMA_H
 
 #include "Libpfs/array2d_fwd.h"
+#include "Libpfs/array2d_view.h"
 
 //! \brief Apply gamma correction the the pfs stream
 //! \author Rafal Mantiuk <mantiuk@mpi-sb.mpg.de>
@@ -32,13 +33,25 @@
 namespace pfs
 {
 class Frame;
+class FrameView;
 
 //! \brief Apply \c gamma on the input \c frame
+//! \note the content hash of \c frame is dropped when done
 void applyGamma(pfs::Frame* frame, float gamma);
 
 //! \brief Apply gamma on the input \c array
 void applyGamma(pfs::Array2Df *array, float exponent, float multiplier = 1.0f);
 
+//! \brief Apply gamma on \c in and store the result inside \c out
+//! \note \c out must have the same size of \c in
+void applyGamma(const pfs::Array2DfConstView& in, pfs::Array2Df *out,
+                float exponent, float multiplier = 1.0f);
+
+//! \brief Materialise \c view inside a new frame, applying \c gamma on its
+//! X, Y, Z channels while copying them.
+//! \note equivalent to pfs::copy() followed by applyGamma(), in one pass
+pfs::Frame* copyWithGamma(const pfs::FrameView& view, float gamma);
+
 }
 
 #endif // PFSGAMMA_H
@@ -22,80 +22,83 @@
 //! \brief apply gamma and black/white point to the input frame
 //! \author Davide Anastasia <davideanastasia@users.sourceforge.net>
 
+#include "Libpfs/manip/gamma_levels.h"
+
 #include <cmath>
 #include <iostream>
 
 #include "Libpfs/frame.h"
 #include "Libpfs/channel.h"
-#include "Libpfs/utils/msec_timer.h"
+#include "Libpfs/params.h"
+#include "Libpfs/utils/parallel.h"
+#include "Libpfs/utils/trace.h"
 
-namespace
+namespace pfs
 {
 
-template <typename T>
-inline T clamp(const T& v, const T& lower_bound, const T& upper_bound)
+GammaLevels::GammaLevels()
+    : m_blackIn(0.f)
+    , m_whiteIn(1.f)
+    , m_blackOut(0.f)
+    , m_whiteOut(1.f)
+    , m_gamma(1.f)
+    , m_identity(true)
+{}
+
+GammaLevels::GammaLevels(float black_in, float white_in,
+                         float black_out, float white_out,
+                         float gamma)
+    : m_blackIn(black_in)
+    , m_whiteIn(white_in)
+    , m_blackOut(black_out)
+    , m_whiteOut(white_out)
+    , m_gamma(gamma)
+    , m_identity(black_in == 0.f && white_in == 1.f &&
+                 black_out == 0.f && white_out == 1.f &&
+                 gamma == 1.f)
 {
-    if ( v <= lower_bound ) return lower_bound;
-    if ( v >= upper_bound ) return upper_bound;
-    return v;
+    assert( white_in != black_in );
 }
 
-////! \note I assume that *in* contains only value between [0,1]
-//void gamma_levels_array(const pfs::Array2D* in, pfs::Array2D* out,
-//                        float black_in, float white_in,
-//                        float black_out, float white_out, float gamma)
-//{
-//    // same formula used inside GammaAndLevels::refreshLUT()
-//    //float value = powf( ( ((float)(i)/255.0f) - bin ) / (win-bin), expgamma);
-//    //LUT[i] = clamp(blackout+value*(whiteout-blackout),0,255);
-
-//    const float* in_vector = in->getRawData();
-//    float* out_vector = out->getRawData();
-
-//    const int ELEMS = in->getCols()*in->getRows();
-
-//    if (gamma != 1.0f)
-//    {
-//#pragma omp parallel for
-//        for (int idx = 0; idx < ELEMS; ++idx)
-//        {
-//            float tmp = (in_vector[idx] - black_in)/(white_in - black_in);
-//            tmp = powf(tmp, gamma);
-
-//            tmp = black_out + tmp*(white_out-black_out);
-
-//            out_vector[idx] = clamp(tmp, 0.0f, 1.0f);
-//        }
-//    }
-//    else
-//    {
-//#pragma omp parallel for
-//        for (int idx = 0; idx < ELEMS; ++idx)
-//        {
-//            float tmp = (in_vector[idx] - black_in)/(white_in - black_in);
-//            //tmp = powf(tmp, gamma);
-
-//            tmp = black_out + tmp*(white_out-black_out);
-
-//            out_vector[idx] = clamp(tmp, 0.0f, 1.0f);
-//        }
-//    }
-//}
+GammaLevels GammaLevels::fromParams(const Params& params)
+{
+    float black_in = 0.f;
+    float white_in = 1.f;
+    float black_out = 0.f;
+    float white_out = 1.f;
+    float gamma = 1.f;
+
+    params.get("levels_black_in", black_in);
+    params.get("levels_white_in", white_in);
+    params.get("levels_black_out", black_out);
+    params.get("levels_white_out", white_out);
+    params.get("levels_gamma", gamma);
+
+    if ( white_in == black_in ) return GammaLevels();
 
+    return GammaLevels(black_in, white_in, black_out, white_out, gamma);
 }
 
-namespace pfs
+void GammaLevels::toParams(Params& params) const
 {
+    params.set("levels_black_in", m_blackIn)
+            ("levels_white_in", m_whiteIn)
+            ("levels_black_out", m_blackOut)
+            ("levels_white_out", m_whiteOut)
+            ("levels_gamma", m_gamma);
+}
+
+bool GammaLevels::isIdentity() const
+{
+    return m_identity;
+}
 
 void gammaAndLevels(pfs::Frame* inFrame,
                     float black_in, float white_in,
                     float black_out, float white_out,
                     float gamma)
 {
-#ifdef TIMER_PROFILING
-    msec_timer f_timer;
-    f_timer.start();
-#endif
+    utils::TraceSpan span("gamma levels");
 
 #ifndef NDEBUG
     std::cerr << "Black in = " << black_in << ", Black out = " << black_out
@@ -111,46 +114,23 @@ void gammaAndLevels(pfs::Frame* inFrame,
     inFrame->getXYZChannels( Xc, Yc, Zc );
     assert( Xc != NULL && Yc != NULL && Zc != NULL );
 
-    const float* R_i = Xc->data();
-    const float* G_i = Yc->data();
-    const float* B_i = Zc->data();
+    float* R = Xc->data();
+    float* G = Yc->data();
+    float* B = Zc->data();
 
-    float* R_o = Xc->data();
-    float* G_o = Yc->data();
-    float* B_o = Zc->data();
+    const GammaLevels levels(black_in, white_in, black_out, white_out, gamma);
 
-    // float exp_gamma = 1.f/gamma;
-#pragma omp parallel for
-    for (int idx = 0; idx < outWidth*outHeight; ++idx)
+    utils::parallelFor(0, outWidth*outHeight, utils::PARALLEL_SAMPLES_GRAIN,
+                       [&](size_t first, size_t last)
     {
-        float red = R_i[idx];
-        float green = G_i[idx];
-        float blue = B_i[idx];
-
-        float L = 0.2126f * red
-                + 0.7152f * green
-                + 0.0722f * blue; // number between [0..1]
-
-        float c = powf(L, gamma - 1.0f);
-
-        red = (red - black_in) / (white_in - black_in);
-        red *= c;
-
-        green = (green - black_in) / (white_in - black_in);
-        green *= c;
-
-        blue = (blue - black_in) / (white_in - black_in);
-        blue *= c;
-
-        R_o[idx] = clamp(black_out + red * (white_out - black_out), 0.f, 1.f);
-        G_o[idx] = clamp(black_out + green * (white_out - black_out), 0.f, 1.f);
-        B_o[idx] = clamp(black_out + blue * (white_out - black_out), 0.f, 1.f);
-    }
-
-#ifdef TIMER_PROFILING
-    f_timer.stop_and_update();
-    std::cout << "gamma_levels() = " << f_timer.get_time() << " msec" << std::endl;
-#endif
+        for (size_t idx = first; idx < last; ++idx)
+        {
+            levels(R[idx], G[idx], B[idx], R[idx], G[idx], B[idx]);
+        }
+    });
+
+    // a hash taken while the channels were written is stale
+    inFrame->invalidateContentHash();
 }
 
 }
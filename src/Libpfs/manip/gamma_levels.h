@@ -22,13 +22,91 @@
 //! \brief apply gamma and black/white point to the input frame
 //! \author Davide Anastasia <davideanastasia@users.sourceforge.net>
 
+#ifndef PFS_GAMMA_LEVELS_H
+#define PFS_GAMMA_LEVELS_H
+
+#include <cstddef>
+
+#include <Libpfs/colorspace/normalizer.h>
+#include <Libpfs/colorspace/rgbremapper.h>
+
 namespace pfs
 {
 class Frame;
+class Params;
+
+//! \brief black/white points and gamma of the levels tool, as a functor on
+//! RGB triplets (it can be chained with the other colorspace functors).
+//! Results are clamped in [0, 1]: the default object only clamps
+class GammaLevels
+{
+public:
+    GammaLevels();
+    GammaLevels(float black_in, float white_in,
+                float black_out, float white_out,
+                float gamma = 1.0f);
+
+    //! \brief levels stored in \a params by \c toParams, or the default
+    //! object if there are none
+    static GammaLevels fromParams(const Params& params);
+    //! \brief store the levels in \a params, so the writers apply them while
+    //! they quantise the frame
+    void toParams(Params& params) const;
+
+    bool isIdentity() const;
+
+    inline
+    void operator()(float i1, float i2, float i3,
+                    float& o1, float& o2, float& o3) const;
 
+private:
+    float m_blackIn;
+    float m_whiteIn;
+    float m_blackOut;
+    float m_whiteOut;
+    float m_gamma;
+    bool m_identity;
+};
+
+//! \brief apply gamma and levels on the RGB channels of \a in (in place)
+//! \note the content hash of \a in is dropped when done
 void gammaAndLevels(pfs::Frame* in,
                     float black_in, float white_in,
                     float black_out, float white_out,
                     float gamma = 1.0f);
 
+//! \brief single pass from float planes to 8/16 bit integer samples:
+//! normalisation between min and max luminance, levels, gamma, clamp, RGB
+//! mapping and quantisation, with an optional ordered dither. It writes
+//! straight into the scanline buffer of the writers (or of a QImage)
+template <typename TypeOut>
+class LevelsQuantizer
+{
+public:
+    LevelsQuantizer(float minLuminance, float maxLuminance,
+                    const GammaLevels& levels = GammaLevels(),
+                    RGBMappingType mapping = MAP_LINEAR,
+                    bool dither = false);
+
+    //! \brief convert \a size pixels of the row \a row: the red sample of
+    //! pixel \c i goes in \c out1[i*stride], green and blue likewise
+    //! \note the dither only applies to the linear mapping
+    template <typename InputIterator>
+    void operator()(InputIterator R, InputIterator G, InputIterator B,
+                    size_t size,
+                    TypeOut* out1, TypeOut* out2, TypeOut* out3,
+                    size_t stride, size_t row = 0) const;
+
+private:
+    colorspace::Normalizer m_normalizer;
+    GammaLevels m_levels;
+    Remapper<TypeOut> m_remapper;
+    bool m_linear;
+    bool m_dither;
+};
+
 }
+
+#include "gamma_levels.hxx"
+
+#endif // PFS_GAMMA_LEVELS_H
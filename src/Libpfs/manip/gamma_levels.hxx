@@ -0,0 +1,132 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2011-2012 Davide Anastasia
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#ifndef PFS_GAMMA_LEVELS_HXX
+#define PFS_GAMMA_LEVELS_HXX
+
+#include "gamma_levels.h"
+
+#include <cmath>
+#include <limits>
+
+namespace pfs
+{
+namespace detail
+{
+inline
+float clampUnit(float v)
+{
+    if ( v <= 0.f ) return 0.f;
+    if ( v >= 1.f ) return 1.f;
+    return v;
+}
+
+//! \brief threshold of the 4x4 Bayer matrix for the pixel (\a col, \a row):
+//! it replaces the 0.5 of the rounding, so the mean of a flat area keeps
+//! the fraction lost by the quantisation
+inline
+float orderedDither(size_t col, size_t row)
+{
+    static const float BAYER_4X4[4][4] =
+    {
+        {  0.5f/16.f,  8.5f/16.f,  2.5f/16.f, 10.5f/16.f },
+        { 12.5f/16.f,  4.5f/16.f, 14.5f/16.f,  6.5f/16.f },
+        {  3.5f/16.f, 11.5f/16.f,  1.5f/16.f,  9.5f/16.f },
+        { 15.5f/16.f,  7.5f/16.f, 13.5f/16.f,  5.5f/16.f }
+    };
+    return BAYER_4X4[row & 3][col & 3];
+}
+}
+
+void GammaLevels::operator()(float i1, float i2, float i3,
+                             float& o1, float& o2, float& o3) const
+{
+    if ( m_identity )
+    {
+        o1 = detail::clampUnit(i1);
+        o2 = detail::clampUnit(i2);
+        o3 = detail::clampUnit(i3);
+        return;
+    }
+
+    // same formula of the levels tool: gamma is applied on the luminance,
+    // so hue and saturation are preserved
+    float c = 1.f;
+    if ( m_gamma != 1.f )
+    {
+        const float L = 0.2126f*i1 + 0.7152f*i2 + 0.0722f*i3;
+        c = (L > 0.f) ? std::pow(L, m_gamma - 1.0f) : 0.f;
+    }
+
+    const float scaleIn = c/(m_whiteIn - m_blackIn);
+    const float rangeOut = m_whiteOut - m_blackOut;
+
+    o1 = detail::clampUnit(m_blackOut + (i1 - m_blackIn)*scaleIn*rangeOut);
+    o2 = detail::clampUnit(m_blackOut + (i2 - m_blackIn)*scaleIn*rangeOut);
+    o3 = detail::clampUnit(m_blackOut + (i3 - m_blackIn)*scaleIn*rangeOut);
+}
+
+template <typename TypeOut>
+LevelsQuantizer<TypeOut>::LevelsQuantizer(float minLuminance, float maxLuminance,
+                                          const GammaLevels& levels,
+                                          RGBMappingType mapping,
+                                          bool dither)
+    : m_normalizer(minLuminance, maxLuminance)
+    , m_levels(levels)
+    , m_remapper(mapping)
+    , m_linear(mapping == MAP_LINEAR)
+    , m_dither(dither)
+{}
+
+template <typename TypeOut>
+template <typename InputIterator>
+void LevelsQuantizer<TypeOut>::operator()(InputIterator R, InputIterator G, InputIterator B,
+                                          size_t size,
+                                          TypeOut* out1, TypeOut* out2, TypeOut* out3,
+                                          size_t stride, size_t row) const
+{
+    const float maxCode = static_cast<float>(std::numeric_limits<TypeOut>::max());
+
+    for (size_t idx = 0; idx < size; ++idx)
+    {
+        float r, g, b;
+        m_normalizer(R[idx], G[idx], B[idx], r, g, b);
+        m_levels(r, g, b, r, g, b);
+
+        if ( m_linear )
+        {
+            // the offset is below 1, so a sample at 1.f never wraps around
+            const float offset = m_dither ? detail::orderedDither(idx, row) : 0.5f;
+
+            out1[idx*stride] = static_cast<TypeOut>(r*maxCode + offset);
+            out2[idx*stride] = static_cast<TypeOut>(g*maxCode + offset);
+            out3[idx*stride] = static_cast<TypeOut>(b*maxCode + offset);
+        }
+        else
+        {
+            m_remapper(r, g, b, out1[idx*stride], out2[idx*stride], out3[idx*stride]);
+        }
+    }
+}
+
+}
+
+#endif // PFS_GAMMA_LEVELS_HXX
@@ -28,8 +28,9 @@
 #include <cassert>
 #include <iostream>
 #include <algorithm>
-#include <numeric>
-#include <cmath>
+#include <map>
+
+#include <boost/thread/mutex.hpp>
 
 #include "resize.h"
 
@@ -39,9 +40,167 @@
 
 namespace pfs
 {
+namespace detail
+{
+
+FilterBank::FilterBank(size_t srcSize, size_t dstSize, InterpolationMethod m)
+    : m_support(1)
+    , m_start(dstSize)
+    , m_size(dstSize)
+{
+    const int W = static_cast<int>(srcSize);
+    const int W2 = static_cast<int>(dstSize);
+
+    switch ( m )
+    {
+    case LanczosInterp:
+    {
+        const float scale = static_cast<float>(W2)/static_cast<float>(W);
+        const float delta = 1.0f / scale;
+        const float a = 3.0f;
+        const float sc = std::min(scale, 1.0f);
+
+        m_support = static_cast<int>(2.0f * a / sc) + 1;
+        m_weights.assign(m_support*W2, 0.f);
+
+        for (int j = 0; j < W2; j++)
+        {
+            // x coord of the center of pixel on src image
+            const float x0 = (static_cast<float>(j) + 0.5f) * delta - 0.5f;
+
+            const int j0 = std::max(0, static_cast<int>(floorf(x0 - a / sc)) + 1);
+            const int j1 = std::min(W, static_cast<int>(floorf(x0 + a / sc)) + 1);
+
+            float* w = &m_weights[j*m_support];
+            float ws = 0.0f;
+            for (int jj = j0; jj < j1; jj++)
+            {
+                w[jj - j0] = Lanc(sc * (x0 - static_cast<float>(jj)), a);
+                ws += w[jj - j0];
+            }
+            for (int k = 0; k < j1 - j0; k++)
+            {
+                w[k] /= ws;
+            }
+
+            m_start[j] = j0;
+            m_size[j] = j1 - j0;
+        }
+    } break;
+    case BilinearInterp:
+    {
+        // same sampling of the original bilinear scaler: the last source
+        // sample maps beyond the last destination one
+        const float ratio = static_cast<float>(W - 1)/W2;
+
+        m_support = 2;
+        m_weights.assign(m_support*W2, 0.f);
+
+        for (int j = 0; j < W2; j++)
+        {
+            const int x = static_cast<int>(ratio * j);
+            const float diff = (ratio * j) - x;
+
+            m_start[j] = x;
+            if ( x + 1 < W )
+            {
+                m_size[j] = 2;
+                m_weights[j*m_support] = 1.f - diff;
+                m_weights[j*m_support + 1] = diff;
+            }
+            else
+            {
+                m_size[j] = 1;
+                m_weights[j*m_support] = 1.f;
+            }
+        }
+    } break;
+    case AreaInterp:
+    {
+        // every destination sample is the mean of the source interval
+        // [j*delta, (j + 1)*delta)
+        const double delta = static_cast<double>(W)/W2;
+
+        m_support = static_cast<int>(std::ceil(delta)) + 1;
+        m_weights.assign(m_support*W2, 0.f);
+
+        for (int j = 0; j < W2; j++)
+        {
+            const double a = j*delta;
+            const double b = std::min(static_cast<double>(W), (j + 1)*delta);
+            const int j0 = static_cast<int>(std::floor(a));
+            const int j1 = std::min(W, static_cast<int>(std::ceil(b)));
+
+            float* w = &m_weights[j*m_support];
+            for (int jj = j0; jj < j1; jj++)
+            {
+                const double overlap = std::min(b, jj + 1.) - std::max(a, static_cast<double>(jj));
+                w[jj - j0] = static_cast<float>(overlap/(b - a));
+            }
+
+            m_start[j] = j0;
+            m_size[j] = j1 - j0;
+        }
+    } break;
+    }
+}
+
+namespace
+{
+struct FilterBankKey
+{
+    size_t m_srcSize;
+    size_t m_dstSize;
+    InterpolationMethod m_method;
+
+    bool operator<(const FilterBankKey& rhs) const
+    {
+        if ( m_srcSize != rhs.m_srcSize ) return m_srcSize < rhs.m_srcSize;
+        if ( m_dstSize != rhs.m_dstSize ) return m_dstSize < rhs.m_dstSize;
+        return m_method < rhs.m_method;
+    }
+};
+
+typedef std::map<FilterBankKey, FilterBankPtr> FilterBankCache;
+
+//! \brief a few dozen banks cover the previews and the size presets: the
+//! cache starts over when it is full
+const size_t MAX_CACHED_BANKS = 32;
+
+boost::mutex s_filterBankMutex;
+}
+
+FilterBankPtr getFilterBank(size_t srcSize, size_t dstSize, InterpolationMethod m)
+{
+    static FilterBankCache s_filterBanks;
 
+    const FilterBankKey key = { srcSize, dstSize, m };
+    {
+        boost::mutex::scoped_lock lock(s_filterBankMutex);
+        FilterBankCache::const_iterator it = s_filterBanks.find(key);
+        if ( it != s_filterBanks.end() )
+        {
+            return it->second;
+        }
+    }
+
+    // built outside the lock: two threads may build the same bank, which is
+    // harmless
+    FilterBankPtr bank = std::make_shared<const FilterBank>(srcSize, dstSize, m);
+
+    boost::mutex::scoped_lock lock(s_filterBankMutex);
+    if ( s_filterBanks.size() >= MAX_CACHED_BANKS )
+    {
+        s_filterBanks.clear();
+    }
+    s_filterBanks[key] = bank;
 
-Frame* resize(Frame* frame, int xSize, InterpolationMethod m)
+    return bank;
+}
+
+} // detail
+
+Frame* resize(const Frame* frame, int xSize, InterpolationMethod m)
 {
 #ifdef TIMER_PROFILING
     msec_timer f_timer;
@@ -53,15 +212,20 @@ Frame* resize(Frame* frame, int xSize, InterpolationMethod m)
 
     pfs::Frame *resizedFrame = new pfs::Frame( new_x, new_y );
 
+    // all the channels in one pass
+    std::vector<const Array2Df*> from;
+    std::vector<Array2Df*> to;
+
     const ChannelContainer& channels = frame->getChannels();
     for ( ChannelContainer::const_iterator it = channels.begin();
           it != channels.end();
           ++it)
     {
-        pfs::Channel* newCh = resizedFrame->createChannel( (*it)->getName() );
-
-        resize(*it, newCh, m);
+        from.push_back( *it );
+        to.push_back( resizedFrame->createChannel( (*it)->getName() ) );
     }
+    resize(from, to, m);
+
     pfs::copyTags( frame, resizedFrame );
 
 #ifdef TIMER_PROFILING
@@ -28,19 +28,56 @@
 //! \author Davide Anastasia <davideanastasia@users.sourceforge.net>
 
 //#include "Libpfs/array2d_fwd.h"
-#include "Common/global.h"
+#include <cstddef>
+#include <memory>
+#include <vector>
+
 #include "Libpfs/array2d.h"
+#include "Libpfs/manip/interpolation.h"
 
 namespace pfs
 {
 // forward declaration
 class Frame;
 
-Frame* resize(Frame* frame, int xSize, InterpolationMethod m);
+namespace detail
+{
+//! \brief weights of a separable resampling filter along one axis: the
+//! destination sample \c i is the weighted sum of the source samples
+//! [m_start[i], m_start[i] + m_size[i]), with the weights stored from
+//! \c m_weights[i*m_support]
+struct FilterBank
+{
+    FilterBank(size_t srcSize, size_t dstSize, InterpolationMethod m);
+
+    size_t m_support;
+    std::vector<int> m_start;
+    std::vector<int> m_size;
+    std::vector<float> m_weights;
+};
+
+typedef std::shared_ptr<const FilterBank> FilterBankPtr;
+
+//! \brief filter bank for the resampling of \a srcSize samples into
+//! \a dstSize, from a process-wide cache: previews and size presets resize
+//! to the same few sizes over and over
+FilterBankPtr getFilterBank(size_t srcSize, size_t dstSize, InterpolationMethod m);
+}
+
+//! \brief resize all the channels of \a frame to \a xSize columns (the
+//! aspect ratio is preserved)
+Frame* resize(const Frame* frame, int xSize, InterpolationMethod m);
 
 template <typename Type>
 void resize(const Array2D<Type> *from, Array2D<Type> *to, InterpolationMethod m);
 
+//! \brief resize planes of the same size into planes of the same size in a
+//! single pass, sharing the filter banks and the temporary rows
+template <typename Type>
+void resize(const std::vector<const Array2D<Type>*>& from,
+            const std::vector<Array2D<Type>*>& to,
+            InterpolationMethod m);
+
 template <typename Type>
 void resize(const Array2D<Type>& from, Array2D<Type>& to, InterpolationMethod m) {
     resize(&from, &to, m);
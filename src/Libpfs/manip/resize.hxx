@@ -22,9 +22,17 @@
 #ifndef PFS_RESIZE_HXX
 #define PFS_RESIZE_HXX
 
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
 #include <boost/math/constants/constants.hpp>
+#include <boost/numeric/conversion/bounds.hpp>
+
 #include "resize.h"
 #include "copy.h"
+#include <Libpfs/utils/kernels.h>
+#include <Libpfs/utils/parallel.h>
 
 #define PI4_Af 0.78515625f
 #define PI4_Bf 0.00024127960205078125f
@@ -82,226 +90,121 @@ static inline float Lanc (float x, float a)
     }
 }
 
+//! \brief acc[j] += w*src[j]: the rows are contiguous, so the vertical pass
+//! of the resampling runs on whole rows
 template <typename Type>
-void Lanczos (const Type* src, Type* dst,
-                        int W, int H, int W2, int H2)
-
+inline
+void accumulateRow(float w, const Type* src, float* acc, int size)
 {
-
-    const float scale = static_cast<float>(W2)/static_cast<float>(W);
-    const float delta = 1.0f / scale;
-    const float a = 3.0f;
-    const float sc = std::min (scale, 1.0f);
-    const int support = static_cast<int> (2.0f * a / sc) + 1;
-
-    const Type zero = static_cast<Type> (0);
-
-    #pragma omp parallel
+    for (int j = 0; j < size; ++j)
     {
-        // storage for precomputed parameters for horisontal interpolation
-        float * wwh = new float[support * W2];
-        int * jj0 = new int[W2];
-        int * jj1 = new int[W2];
-
-        // temporal storage for vertically-interpolated row of pixels
-        float * l = new float[W];
-
-        // Phase 1: precompute coefficients for horisontal interpolation
-
-        for (int j = 0; j < W2; j++) {
-
-            // x coord of the center of pixel on src image
-            float x0 = (static_cast<float> (j) + 0.5f) * delta - 0.5f;
-
-            // weights for interpolation in horisontal direction
-            float * w = wwh + j * support;
-
-            // sum of weights used for normalization
-            float ws =  0.0f;
-
-            jj0[j] = std::max (0, static_cast<int> (floorf (x0 - a / sc)) + 1);
-            jj1[j] = std::min (W, static_cast<int> (floorf (x0 + a / sc)) + 1);
-
-            // calculate weights
-            for (int jj = jj0[j]; jj < jj1[j]; jj++) {
-                int k = jj - jj0[j];
-                float z = sc * (x0 - static_cast<float> (jj));
-                w[k] = Lanc (z, a);
-                ws += w[k];
-            }
-
-            // normalize weights
-            for (int k = 0; k < support; k++) {
-                w[k] /= ws;
-            }
-        }
-
-        // Phase 2: do actual interpolation
-        // weights for interpolation in y direction
-        float *w = new float[support];
-        #pragma omp for
-        for (int i = 0; i < H2; i++) {
-
-            // y coord of the center of pixel on src image
-            float y0 = (static_cast<float> (i) + 0.5f) * delta - 0.5f;
-
-            // sum of weights used for normalization
-            float ws = 0.0f;
-
-            int ii0 = std::max (0, static_cast<int> (floorf (y0 - a / sc)) + 1);
-            int ii1 = std::min (H, static_cast<int> (floorf (y0 + a / sc)) + 1);
-
-            // calculate weights for vertical interpolation
-            for (int ii = ii0; ii < ii1; ii++) {
-                int k = ii - ii0;
-                float z = sc * (y0 - static_cast<float> (ii));
-                w[k] = Lanc (z, a);
-                ws += w[k];
-            }
-
-            // normalize weights
-            for (int k = 0; k < support; k++) {
-                w[k] /= ws;
-            }
-
-            // Do vertical interpolation. Store results.
-            for (int j = 0; j < W; j++) {
-
-                float o = 0.0f;
-
-                for (int ii = ii0; ii < ii1; ii++) {
-                    int k = ii - ii0;
-
-                    o += w[k] * static_cast<float>(src[ii*W + j]);
-                }
-
-                l[j] = o;
-            }
-
-            // Do horizontal interpolation
-            for (int j = 0; j < W2; j++) {
-
-                float * wh = wwh + support * j;
-
-                float o = 0.0f;
-
-                for (int jj = jj0[j]; jj < jj1[j]; jj++) {
-                    int k = jj - jj0[j];
-
-                    o += wh[k] * l[jj];
-                }
-
-                dst[i*W2 + j] = max(zero, min(static_cast<Type>(o), boost::numeric::bounds<Type>::highest()));
-            }
-        }
-
-        delete[] w;
-        delete[] wwh;
-        delete[] jj0;
-        delete[] jj1;
-        delete[] l;
+        acc[j] += w*static_cast<float>(src[j]);
     }
 }
 
-const size_t BLOCK_FACTOR = 96;
+inline
+void accumulateRow(float w, const float* src, float* acc, int size)
+{
+    utils::kernels().vadds(acc, w, src, acc, size);
+}
 
-//! \author Davide Anastasia <davideanastasia@users.sourceforge.net>
-//! \note Code derived from
-//! http://tech-algorithm.com/articles/bilinear-image-scaling/
-//! with added OpenMP support and block based resampling
 template <typename Type>
-void resizeBilinearGray(const Type* pixels, Type* output,
-                        size_t w, size_t h, size_t w2, size_t h2)
+inline
+Type storeSample(float o, bool clamp)
 {
-    const float x_ratio = static_cast<float>(w - 1)/w2;
-    const float y_ratio = static_cast<float>(h - 1)/h2;
-
-    Type A, B, C, D;
-    Type outputPixel;
-    size_t x = 0;
-    size_t y = 0;
-    size_t index = 0;
-
-    float x_diff = 0.0f;
-    float y_diff = 0.0f;
+    // the negative lobes of Lanczos can overshoot
+    if ( clamp )
+    {
+        o = std::max(0.f,
+                     std::min(o, static_cast<float>(boost::numeric::bounds<Type>::highest())));
+    }
+    return static_cast<Type>(o);
+}
 
-#pragma omp parallel \
-    shared(pixels, output, w, h, w2, h2) \
-    private(x_diff, y_diff, x, y, index, outputPixel, A, B, C, D)
+template <typename Type>
+void resample(const std::vector<const Array2D<Type>*>& in,
+              const std::vector<Array2D<Type>*>& out,
+              InterpolationMethod m)
+{
+    const int W = in[0]->getCols();
+    const int H = in[0]->getRows();
+    const int W2 = out[0]->getCols();
+    const int H2 = out[0]->getRows();
+    const int numPlanes = static_cast<int>(in.size());
+    const bool clamp = (m == LanczosInterp);
+
+    const FilterBankPtr hBank = getFilterBank(W, W2, m);
+    const FilterBankPtr vBank = getFilterBank(H, H2, m);
+
+    utils::parallelFor(0, H2, utils::PARALLEL_SAMPLES_GRAIN/std::max(W2*numPlanes, 1),
+                       [&](size_t first, size_t last)
     {
-#pragma omp for schedule(static, 1)
-        for ( int iO = 0; iO < static_cast<int>(h2); iO += BLOCK_FACTOR )
-        {
-            for ( int jO = 0; jO < static_cast<int>(w2); jO += BLOCK_FACTOR )
-            {
-                for (size_t i = iO, iEnd = std::min(iO + BLOCK_FACTOR, h2);
-                     i < iEnd;
-                     i++)
-                {
-                    y = static_cast<size_t>(y_ratio * i);
-                    y_diff = (y_ratio * i) - y;
+        // vertically interpolated row of the source
+        std::vector<float> line(W);
 
-                    for (size_t j = jO, jEnd = std::min(jO + BLOCK_FACTOR, w2);
-                         j < jEnd;
-                         j++)
-                    {
-                        x = static_cast<size_t>(x_ratio * j);
-                        x_diff = (x_ratio * j) - x;
+        for (int i = static_cast<int>(first); i < static_cast<int>(last); i++)
+        {
+            const float* wv = &vBank->m_weights[i*vBank->m_support];
+            const int i0 = vBank->m_start[i];
+            const int iSize = vBank->m_size[i];
 
-                        index = y*w + x;
+            for (int p = 0; p < numPlanes; ++p)
+            {
+                const Type* src = in[p]->data();
+                Type* dst = out[p]->data() + i*W2;
 
-                        A = pixels[index];
-                        B = pixels[index + 1];
-                        C = pixels[index + w];
-                        D = pixels[index + w + 1];
+                std::fill(line.begin(), line.end(), 0.f);
+                for (int k = 0; k < iSize; ++k)
+                {
+                    accumulateRow(wv[k], src + (i0 + k)*W, line.data(), W);
+                }
 
-                        // Y = A(1-w)(1-h) + B(w)(1-h) + C(h)(1-w) + D(w)(h)
-                        outputPixel =
-                                static_cast<Type>(
-                                    A*(1-x_diff)*(1-y_diff) +
-                                    B*(x_diff)*(1-y_diff) +
-                                    C*(y_diff)*(1-x_diff) +
-                                    D*(x_diff*y_diff) );
+                for (int j = 0; j < W2; j++)
+                {
+                    const float* wh = &hBank->m_weights[j*hBank->m_support];
+                    const float* l = line.data() + hBank->m_start[j];
+                    const int jSize = hBank->m_size[j];
 
-                        output[i*w2 + j] = outputPixel;
+                    float o = 0.0f;
+                    for (int k = 0; k < jSize; ++k)
+                    {
+                        o += wh[k]*l[k];
                     }
+                    dst[j] = storeSample<Type>(o, clamp);
                 }
             }
         }
-    } // end parallel region
+    });
 }
 
+} // detail
+
 template <typename Type>
-void resample(const ::pfs::Array2D<Type> *in, ::pfs::Array2D<Type> *out, InterpolationMethod m)
+void resize(const std::vector<const Array2D<Type>*>& in,
+            const std::vector<Array2D<Type>*>& out,
+            InterpolationMethod m)
 {
-    switch ( m )
+    assert( in.size() == out.size() );
+    if ( in.empty() ) return;
+
+    if ( in[0]->getCols() == out[0]->getCols() && in[0]->getRows() == out[0]->getRows() )
+    {
+        for (size_t p = 0; p < in.size(); ++p)
+        {
+            pfs::copy(in[p], out[p]);
+        }
+    }
+    else if ( out[0]->size() > 0 && in[0]->size() > 0 )
     {
-        case LanczosInterp:
-            Lanczos(in->data(), out->data(),
-                       in->getCols(), in->getRows(),
-                       out->getCols(), out->getRows());
-            break;
-        case BilinearInterp:
-                resizeBilinearGray(in->data(), out->data(),
-                       in->getCols(), in->getRows(),
-                       out->getCols(), out->getRows());
-            break;
+        detail::resample(in, out, m);
     }
 }
 
-} // anonymous
-
 template <typename Type>
 void resize(const Array2D<Type> *in, Array2D<Type> *out, InterpolationMethod m)
 {
-    if ( in->getCols() == out->getCols() && in->getRows() == out->getRows() )
-    {
-        pfs::copy(in, out);
-    }
-    else
-    {
-        detail::resample(in, out, m);
-    }
+    resize(std::vector<const Array2D<Type>*>(1, in),
+           std::vector<Array2D<Type>*>(1, out), m);
 }
 
 } // pfs
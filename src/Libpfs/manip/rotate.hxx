@@ -23,6 +23,11 @@
 #define PFS_ROTATE_HXX
 
 #include "rotate.h"
+#include "transpose.h"
+
+#include <cassert>
+
+#include <Libpfs/array2d.h>
 
 namespace pfs
 {
@@ -30,36 +35,20 @@ namespace pfs
 template <typename Type>
 void rotate(const pfs::Array2D<Type> *in, pfs::Array2D<Type> *out, bool clockwise)
 {
-    const Type* Vin  = in->data();
-    Type* Vout       = out->data();
-
-    const int I_ROWS  = in->getRows();
-    const int I_COLS  = in->getCols();
-
-    //const int O_ROWS = out->getRows();
-    const int O_COLS = out->getCols();
+    assert( in->getCols() == out->getRows() );
+    assert( in->getRows() == out->getCols() );
 
+    // a rotation is a transpose followed by a mirror: clockwise mirrors the
+    // columns of the output, counter clockwise mirrors its rows
     if (clockwise)
     {
-#pragma omp parallel for
-        for (int j = 0; j < I_ROWS; j++)
-        {
-            for (int i = 0; i < I_COLS; i++)
-            {
-                Vout[(i+1)*O_COLS - 1 - j] = Vin[j*I_COLS + i];
-            }
-        }
+        detail::transposeBlocked<Type, false, true>(in->data(), out->data(),
+                                                    in->getCols(), in->getRows());
     }
     else
     {
-#pragma omp parallel for
-        for (int j = 0; j < I_ROWS; j++)
-        {
-            for (int i = 0; i < I_COLS; i++)
-            {
-                Vout[(I_COLS - i - 1)*O_COLS + j] = Vin[j*I_COLS + i];
-            }
-        }
+        detail::transposeBlocked<Type, true, false>(in->data(), out->data(),
+                                                    in->getCols(), in->getRows());
     }
 }
 
@@ -0,0 +1,57 @@
+/*
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+//! \brief Cache-blocked transpose of 2D buffers
+
+#ifndef PFS_TRANSPOSE_H
+#define PFS_TRANSPOSE_H
+
+#include <cstddef>
+#include <Libpfs/array2d_fwd.h>
+
+namespace pfs
+{
+//! \brief transpose the row-major buffer \c in (\a cols x \a rows) into
+//! \c out (\a rows x \a cols)
+//! \note work is done in square tiles, so both the reads and the writes stay
+//! inside a few cache lines at a time. \c in and \c out must not overlap
+template <typename Type>
+void transpose(const Type* in, Type* out, size_t cols, size_t rows);
+
+//! \brief transpose \c in inside \c out
+//! \note \c out must be already allocated as in->getRows() x in->getCols()
+template <typename Type>
+void transpose(const Array2D<Type>* in, Array2D<Type>* out);
+
+namespace detail
+{
+//! \brief blocked kernel shared by \c transpose and \c rotate: element
+//! (col \a i, row \a j) of \c in lands in row \a i and column \a j of \c out,
+//! possibly mirrored by \a FlipRows (output rows reversed) and \a FlipCols
+//! (output columns reversed)
+template <typename Type, bool FlipRows, bool FlipCols>
+void transposeBlocked(const Type* in, Type* out, size_t cols, size_t rows);
+}
+
+}
+
+#include "transpose.hxx"
+
+#endif // PFS_TRANSPOSE_H
@@ -0,0 +1,171 @@
+/*
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#ifndef PFS_TRANSPOSE_HXX
+#define PFS_TRANSPOSE_HXX
+
+#include "transpose.h"
+
+#include <cassert>
+#include <algorithm>
+
+#include <Libpfs/array2d.h>
+#include <Libpfs/utils/parallel.h>
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+namespace pfs
+{
+namespace detail
+{
+//! \brief side of the square tile: 32x32 floats is 4KB, so the source tile
+//! and the destination tile sit comfortably in L1
+static const size_t TRANSPOSE_BLOCK_SIZE = 32;
+
+//! \brief moves the sub-block [i0, i1) x [j0, j1) of \c in into \c out
+template <typename Type, bool FlipRows, bool FlipCols>
+inline
+void transposeTileScalar(const Type* in, Type* out, size_t cols, size_t rows,
+                         size_t i0, size_t i1, size_t j0, size_t j1)
+{
+    for (size_t i = i0; i < i1; ++i)
+    {
+        Type* outRow = out + (FlipRows ? (cols - 1 - i) : i)*rows;
+        for (size_t j = j0; j < j1; ++j)
+        {
+            outRow[FlipCols ? (rows - 1 - j) : j] = in[j*cols + i];
+        }
+    }
+}
+
+template <typename Type, bool FlipRows, bool FlipCols>
+struct TransposeTile
+{
+    static inline
+    void apply(const Type* in, Type* out, size_t cols, size_t rows,
+               size_t i0, size_t i1, size_t j0, size_t j1)
+    {
+        transposeTileScalar<Type, FlipRows, FlipCols>(in, out, cols, rows,
+                                                      i0, i1, j0, j1);
+    }
+};
+
+#ifdef __SSE__
+//! \brief float tiles are moved in 4x4 sub-blocks transposed in register
+template <bool FlipRows, bool FlipCols>
+struct TransposeTile<float, FlipRows, FlipCols>
+{
+    static inline
+    void apply(const float* in, float* out, size_t cols, size_t rows,
+               size_t i0, size_t i1, size_t j0, size_t j1)
+    {
+        size_t i = i0;
+        for (; i + 4 <= i1; i += 4)
+        {
+            float* o0 = out + (FlipRows ? (cols - 1 - i) : i)*rows;
+            float* o1 = out + (FlipRows ? (cols - 2 - i) : i + 1)*rows;
+            float* o2 = out + (FlipRows ? (cols - 3 - i) : i + 2)*rows;
+            float* o3 = out + (FlipRows ? (cols - 4 - i) : i + 3)*rows;
+
+            size_t j = j0;
+            for (; j + 4 <= j1; j += 4)
+            {
+                __m128 r0 = _mm_loadu_ps(in + j*cols + i);
+                __m128 r1 = _mm_loadu_ps(in + (j + 1)*cols + i);
+                __m128 r2 = _mm_loadu_ps(in + (j + 2)*cols + i);
+                __m128 r3 = _mm_loadu_ps(in + (j + 3)*cols + i);
+
+                _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+                size_t outCol = j;
+                if (FlipCols)
+                {
+                    outCol = rows - 4 - j;
+                    r0 = _mm_shuffle_ps(r0, r0, _MM_SHUFFLE(0, 1, 2, 3));
+                    r1 = _mm_shuffle_ps(r1, r1, _MM_SHUFFLE(0, 1, 2, 3));
+                    r2 = _mm_shuffle_ps(r2, r2, _MM_SHUFFLE(0, 1, 2, 3));
+                    r3 = _mm_shuffle_ps(r3, r3, _MM_SHUFFLE(0, 1, 2, 3));
+                }
+
+                _mm_storeu_ps(o0 + outCol, r0);
+                _mm_storeu_ps(o1 + outCol, r1);
+                _mm_storeu_ps(o2 + outCol, r2);
+                _mm_storeu_ps(o3 + outCol, r3);
+            }
+            // leftover rows of the tile
+            transposeTileScalar<float, FlipRows, FlipCols>(in, out, cols, rows,
+                                                           i, i + 4, j, j1);
+        }
+        // leftover columns of the tile
+        transposeTileScalar<float, FlipRows, FlipCols>(in, out, cols, rows,
+                                                       i, i1, j0, j1);
+    }
+};
+#endif
+
+template <typename Type, bool FlipRows, bool FlipCols>
+void transposeBlocked(const Type* in, Type* out, size_t cols, size_t rows)
+{
+    assert( in != out );
+
+    const size_t numBlocks = (cols + TRANSPOSE_BLOCK_SIZE - 1)/TRANSPOSE_BLOCK_SIZE;
+
+    // every block of input columns maps onto a separate block of output rows,
+    // so threads never share an output row
+    utils::parallelFor(0, numBlocks, 1,
+                       [&](size_t first, size_t last)
+    {
+        for (size_t bi = first; bi < last; ++bi)
+        {
+            const size_t i0 = bi*TRANSPOSE_BLOCK_SIZE;
+            const size_t i1 = std::min(i0 + TRANSPOSE_BLOCK_SIZE, cols);
+
+            for (size_t j0 = 0; j0 < rows; j0 += TRANSPOSE_BLOCK_SIZE)
+            {
+                TransposeTile<Type, FlipRows, FlipCols>::apply(
+                            in, out, cols, rows,
+                            i0, i1, j0, std::min(j0 + TRANSPOSE_BLOCK_SIZE, rows));
+            }
+        }
+    });
+}
+
+} // detail
+
+template <typename Type>
+void transpose(const Type* in, Type* out, size_t cols, size_t rows)
+{
+    detail::transposeBlocked<Type, false, false>(in, out, cols, rows);
+}
+
+template <typename Type>
+void transpose(const Array2D<Type>* in, Array2D<Type>* out)
+{
+    assert( in->getCols() == out->getRows() );
+    assert( in->getRows() == out->getCols() );
+
+    transpose(in->data(), out->data(), in->getCols(), in->getRows());
+}
+
+}
+
+#endif // PFS_TRANSPOSE_HXX
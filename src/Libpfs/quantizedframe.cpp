@@ -0,0 +1,173 @@
+/*
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <Libpfs/quantizedframe.h>
+
+#include <cassert>
+
+#include <Libpfs/frame.h>
+#include <Libpfs/colorspace/convert.h>
+#include <Libpfs/manip/transpose.h>
+#include <Libpfs/utils/parallel.h>
+
+namespace pfs
+{
+namespace
+{
+template <typename Code>
+std::vector<float> buildCodeValues()
+{
+    std::vector<float> values(size_t(1) << (8*sizeof(Code)));
+    for (size_t code = 0; code < values.size(); ++code)
+    {
+        values[code] = colorspace::convertSample<float>(static_cast<Code>(code));
+    }
+    return values;
+}
+
+template <typename Code>
+void rotatePlane(std::vector<Code>& plane, size_t width, size_t height, bool clockwise)
+{
+    std::vector<Code> rotated(plane.size());
+    if ( clockwise )
+    {
+        detail::transposeBlocked<Code, false, true>(plane.data(), rotated.data(),
+                                                    width, height);
+    }
+    else
+    {
+        detail::transposeBlocked<Code, true, false>(plane.data(), rotated.data(),
+                                                    width, height);
+    }
+    plane.swap(rotated);
+}
+
+template <typename Code>
+void expandPlane(const Code* codes, const float* values, Channel& out)
+{
+    float* data = out.data();
+    utils::parallelFor(0, out.size(), utils::PARALLEL_SAMPLES_GRAIN,
+                       [=](size_t b, size_t e)
+    {
+        for (size_t idx = b; idx < e; ++idx)
+        {
+            data[idx] = values[codes[idx]];
+        }
+    });
+}
+}
+
+QuantizedFrame::QuantizedFrame()
+    : m_width(0)
+    , m_height(0)
+    , m_bitDepth(8)
+{}
+
+QuantizedFrame::QuantizedFrame(size_t width, size_t height, int bitDepth)
+    : m_width(width)
+    , m_height(height)
+    , m_bitDepth(bitDepth)
+{
+    assert( bitDepth == 8 || bitDepth == 16 );
+
+    for (int c = 0; c < 3; ++c)
+    {
+        if ( m_bitDepth == 8 )
+        {
+            m_codes8[c].resize(width*height);
+        }
+        else
+        {
+            m_codes16[c].resize(width*height);
+        }
+    }
+}
+
+size_t QuantizedFrame::getByteSize() const
+{
+    return 3*size()*(m_bitDepth/8);
+}
+
+utils::Hash128 QuantizedFrame::getContentHash() const
+{
+    utils::Hasher hasher;
+    hasher.update(static_cast<uint64_t>(m_width));
+    hasher.update(static_cast<uint64_t>(m_height));
+    hasher.update(static_cast<uint64_t>(m_bitDepth));
+    for (int c = 0; c < 3; ++c)
+    {
+        if ( m_bitDepth == 8 )
+        {
+            hasher.update(m_codes8[c].data(), m_codes8[c].size());
+        }
+        else
+        {
+            hasher.update(m_codes16[c].data(), 2*m_codes16[c].size());
+        }
+    }
+    return hasher.digest();
+}
+
+const std::vector<float>& QuantizedFrame::codeValues(int bitDepth)
+{
+    static const std::vector<float> s_values8 = buildCodeValues<uint8_t>();
+    static const std::vector<float> s_values16 = buildCodeValues<uint16_t>();
+
+    return (bitDepth == 8) ? s_values8 : s_values16;
+}
+
+void QuantizedFrame::rotate(bool clockwise)
+{
+    for (int c = 0; c < 3; ++c)
+    {
+        if ( m_bitDepth == 8 )
+        {
+            rotatePlane(m_codes8[c], m_width, m_height, clockwise);
+        }
+        else
+        {
+            rotatePlane(m_codes16[c], m_width, m_height, clockwise);
+        }
+    }
+    std::swap(m_width, m_height);
+}
+
+Frame* QuantizedFrame::expand() const
+{
+    const float* values = codeValues(m_bitDepth).data();
+
+    Frame* frame = new Frame(m_width, m_height);
+    Channel* ch[3];
+    frame->createXYZChannels(ch[0], ch[1], ch[2]);
+    for (int c = 0; c < 3; ++c)
+    {
+        if ( m_bitDepth == 8 )
+        {
+            expandPlane(m_codes8[c].data(), values, *ch[c]);
+        }
+        else
+        {
+            expandPlane(m_codes16[c].data(), values, *ch[c]);
+        }
+    }
+    return frame;
+}
+
+} // namespace pfs
@@ -0,0 +1,103 @@
+/*
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+//! \brief PFS library - RGB frames kept as the 8 or 16 bit codes of their file
+
+#ifndef PFS_QUANTIZEDFRAME_H
+#define PFS_QUANTIZEDFRAME_H
+
+#include <memory>
+#include <vector>
+#include <stdint.h>
+
+#include <Libpfs/utils/hash.h>
+
+namespace pfs
+{
+class Frame;
+
+//! \brief RGB frame holding the integer codes read from a JPEG or TIFF file
+//!
+//! The readers turn every code \c c of an n bit file into c/(2^n - 1). Kept
+//! as codes, a frame uses a quarter (8 bit) or a half (16 bit) of the memory
+//! of the float channels, and the fusion operators can index their lookup
+//! tables with the codes. \c expand builds the float frame that
+//! FrameReader::read() would have returned.
+class QuantizedFrame
+{
+public:
+    //! \brief empty frame
+    QuantizedFrame();
+    //! \param bitDepth 8 or 16
+    QuantizedFrame(size_t width, size_t height, int bitDepth);
+
+    size_t getWidth() const     { return m_width; }
+    size_t getHeight() const    { return m_height; }
+    size_t size() const         { return m_width*m_height; }
+
+    //! \brief 8 or 16
+    int getBitDepth() const     { return m_bitDepth; }
+    //! \brief largest code: 255 or 65535
+    int getMaxCode() const      { return (1 << m_bitDepth) - 1; }
+
+    //! \brief number of bytes used by the codes
+    size_t getByteSize() const;
+
+    //! \brief codes of the channel \a c (0 red, 1 green, 2 blue) of an 8 bit
+    //! frame, row by row
+    uint8_t* codes8(int c)                  { return m_codes8[c].data(); }
+    const uint8_t* codes8(int c) const      { return m_codes8[c].data(); }
+    //! \brief codes of the channel \a c of a 16 bit frame
+    uint16_t* codes16(int c)                { return m_codes16[c].data(); }
+    const uint16_t* codes16(int c) const    { return m_codes16[c].data(); }
+
+    //! \brief code of the sample \a idx of the channel \a c, at any depth
+    int code(int c, size_t idx) const
+    { return (m_bitDepth == 8) ? m_codes8[c][idx] : m_codes16[c][idx]; }
+
+    //! \brief hash of the size, depth and codes of the frame, computed on
+    //! every call
+    utils::Hash128 getContentHash() const;
+
+    //! \brief value of every code of a \a bitDepth frame, exactly as the
+    //! readers and \c expand produce it
+    static const std::vector<float>& codeValues(int bitDepth);
+
+    //! \brief turn the frame by 90 degrees, as pfs::rotate()
+    void rotate(bool clockwise);
+
+    //! \brief float frame with the X, Y and Z channels of the codes
+    //! \note the caller owns the returned \c Frame
+    Frame* expand() const;
+
+private:
+    size_t m_width;
+    size_t m_height;
+    int m_bitDepth;
+    // only the planes of m_bitDepth are allocated
+    std::vector<uint8_t> m_codes8[3];
+    std::vector<uint16_t> m_codes16[3];
+};
+
+typedef std::shared_ptr<QuantizedFrame> QuantizedFramePtr;
+
+} // namespace pfs
+
+#endif // PFS_QUANTIZEDFRAME_H
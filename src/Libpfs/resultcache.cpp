@@ -0,0 +1,519 @@
+/*
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <Libpfs/resultcache.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+#include <Libpfs/exception.h>
+#include <Libpfs/frame.h>
+#include <Libpfs/spilledframe.h>
+#include <Libpfs/utils/hash.h>
+#include <Libpfs/utils/trace.h>
+
+namespace pfs
+{
+namespace
+{
+const char INDEX_HEADER[] = "LuminanceHDR result cache 1";
+
+std::string joinPath(const std::string& directory, const std::string& name)
+{
+    if ( directory.empty() ||
+         directory[directory.size() - 1] == '/' ||
+         directory[directory.size() - 1] == '\\' )
+    {
+        return directory + name;
+    }
+    return directory + '/' + name;
+}
+
+bool fileExists(const std::string& filename)
+{
+    std::FILE* f = std::fopen(filename.c_str(), "rb");
+    if ( f ) std::fclose(f);
+    return f != NULL;
+}
+
+size_t fileSize(const std::string& filename)
+{
+    std::FILE* f = std::fopen(filename.c_str(), "rb");
+    if ( !f ) return 0;
+    std::fseek(f, 0, SEEK_END);
+    const long size = std::ftell(f);
+    std::fclose(f);
+    return size > 0 ? static_cast<size_t>(size) : 0;
+}
+
+//! \brief rename() does not replace an existing file on Windows
+bool replaceFile(const std::string& from, const std::string& to)
+{
+    std::remove(to.c_str());
+    return std::rename(from.c_str(), to.c_str()) == 0;
+}
+
+std::string temporaryFilename(const std::string& filename)
+{
+    static std::atomic<unsigned> s_counter(0);
+
+    std::ostringstream name;
+    name << filename << '.' << s_counter++ << ".tmp";
+    return name.str();
+}
+
+//! \brief names of the files of \a directory ending in \a suffix
+std::vector<std::string> listFiles(const std::string& directory, const std::string& suffix)
+{
+    std::vector<std::string> names;
+#if defined(_WIN32)
+    WIN32_FIND_DATAA data;
+    HANDLE find = FindFirstFileA(joinPath(directory, "*" + suffix).c_str(), &data);
+    if ( find == INVALID_HANDLE_VALUE ) return names;
+    do
+    {
+        names.push_back(data.cFileName);
+    }
+    while ( FindNextFileA(find, &data) );
+    FindClose(find);
+#else
+    DIR* dir = opendir(directory.c_str());
+    if ( dir == NULL ) return names;
+    while ( dirent* entry = readdir(dir) )
+    {
+        const std::string name(entry->d_name);
+        if ( name.size() > suffix.size() &&
+             name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0 )
+        {
+            names.push_back(name);
+        }
+    }
+    closedir(dir);
+#endif
+    return names;
+}
+
+//! \brief lock shared by the processes using the same directory, held while
+//! the index is read, changed and written back
+//!
+//! The lock is taken on a file that is never removed: the system releases
+//! it when its holder closes the file or dies, so there are no stale locks
+//! to guess about. If the file cannot be opened (the directory is missing
+//! or read only) the lock is not held, and the cache is not used.
+class IndexLock
+{
+public:
+    explicit IndexLock(const std::string& filename)
+#if defined(_WIN32)
+        : m_file(INVALID_HANDLE_VALUE)
+#else
+        : m_fd(-1)
+#endif
+    {
+#if defined(_WIN32)
+        HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ | GENERIC_WRITE,
+                                  FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                                  OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+        if ( file == INVALID_HANDLE_VALUE ) return;
+        OVERLAPPED overlapped = OVERLAPPED();
+        if ( !LockFileEx(file, LOCKFILE_EXCLUSIVE_LOCK, 0, 1, 0, &overlapped) )
+        {
+            CloseHandle(file);
+            return;
+        }
+        m_file = file;
+#else
+        // flock() locks belong to the open file: two instances of the
+        // cache in the same process exclude each other too
+        const int fd = open(filename.c_str(), O_RDWR | O_CREAT, 0644);
+        if ( fd < 0 ) return;
+        while ( flock(fd, LOCK_EX) != 0 )
+        {
+            if ( errno != EINTR )
+            {
+                close(fd);
+                return;
+            }
+        }
+        m_fd = fd;
+#endif
+    }
+
+    ~IndexLock()
+    {
+#if defined(_WIN32)
+        if ( m_file == INVALID_HANDLE_VALUE ) return;
+        OVERLAPPED overlapped = OVERLAPPED();
+        UnlockFileEx(m_file, 0, 1, 0, &overlapped);
+        CloseHandle(m_file);
+#else
+        if ( m_fd < 0 ) return;
+        flock(m_fd, LOCK_UN);
+        close(m_fd);
+#endif
+    }
+
+    bool locked() const
+    {
+#if defined(_WIN32)
+        return m_file != INVALID_HANDLE_VALUE;
+#else
+        return m_fd >= 0;
+#endif
+    }
+
+private:
+    IndexLock(const IndexLock&);
+    IndexLock& operator=(const IndexLock&);
+
+#if defined(_WIN32)
+    HANDLE m_file;
+#else
+    int m_fd;
+#endif
+};
+}
+
+ResultCache::ResultCache(const std::string& directory, size_t maxBytes)
+    : m_directory(directory)
+    , m_maxBytes(maxBytes)
+    , m_bytes(0)
+    , m_clock(0)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    IndexLock indexLock(lockFilename());
+    if ( !indexLock.locked() ) return;
+    loadIndex();
+    removeOrphans();
+    // the limit may be lower than the one of the last run
+    const size_t count = m_entries.size();
+    evict(m_maxBytes);
+    if ( count != m_entries.size() )
+    {
+        saveIndex();
+    }
+}
+
+std::string ResultCache::makeKey(const Frame& input, const std::string& options)
+{
+    utils::Hasher hasher;
+    hasher.update(input.getContentHash());
+    hasher.update(options);
+    return hasher.digest().toString();
+}
+
+Frame* ResultCache::find(const std::string& key)
+{
+    utils::TraceSpan span("cache lookup");
+    const std::string filename = entryFilename(key);
+    {
+        // the index in memory is enough: a lookup only changes the last
+        // use, written back with the next insertion or eviction
+        std::lock_guard<std::mutex> lock(m_mutex);
+        EntryMap::iterator it = m_entries.find(key);
+        if ( it != m_entries.end() )
+        {
+            it->second.lastUse = ++m_clock;
+        }
+        else if ( !fileExists(filename) )
+        {
+            utils::traceCount("cache misses", 1);
+            return NULL;
+        }
+    }
+
+    try
+    {
+        Frame* frame = readScratchFrame(filename);
+
+        // stored by another process since the index was read
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if ( m_entries.find(key) == m_entries.end() )
+        {
+            Entry& entry = m_entries[key];
+            entry.bytes = fileSize(filename);
+            entry.lastUse = ++m_clock;
+            m_bytes += entry.bytes;
+        }
+        utils::traceCount("cache hits", 1);
+        return frame;
+    }
+    catch (const pfs::Exception&)
+    {
+        // evicted by another process, or damaged
+        std::lock_guard<std::mutex> lock(m_mutex);
+        IndexLock indexLock(lockFilename());
+        if ( indexLock.locked() )
+        {
+            loadIndex();
+        }
+        EntryMap::iterator it = m_entries.find(key);
+        if ( it != m_entries.end() )
+        {
+            removeEntry(it);
+            if ( indexLock.locked() )
+            {
+                saveIndex();
+            }
+        }
+        utils::traceCount("cache misses", 1);
+        return NULL;
+    }
+}
+
+void ResultCache::insert(const std::string& key, const Frame& result)
+{
+    utils::TraceSpan span("cache store");
+
+    // written aside, so that a reader never sees a partial file
+    const std::string filename = entryFilename(key);
+    const std::string temporary = temporaryFilename(filename);
+    try
+    {
+        writeScratchFrame(result, temporary);
+    }
+    catch (const pfs::Exception&)
+    {
+        return;
+    }
+    const size_t bytes = fileSize(temporary);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if ( bytes == 0 || bytes > m_maxBytes )
+    {
+        std::remove(temporary.c_str());
+        return;
+    }
+
+    // the file is moved in place under the lock, so that a result is on
+    // disk only while the index lists it
+    IndexLock indexLock(lockFilename());
+    if ( !indexLock.locked() || !replaceFile(temporary, filename) )
+    {
+        std::remove(temporary.c_str());
+        return;
+    }
+
+    loadIndex();
+    EntryMap::iterator it = m_entries.find(key);
+    if ( it != m_entries.end() )
+    {
+        m_bytes -= it->second.bytes;
+    }
+    Entry& entry = m_entries[key];
+    entry.bytes = bytes;
+    entry.lastUse = ++m_clock;
+    m_bytes += bytes;
+
+    evict(m_maxBytes);
+    saveIndex();
+
+    utils::traceCount("bytes cached", bytes);
+}
+
+void ResultCache::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    IndexLock indexLock(lockFilename());
+    if ( !indexLock.locked() ) return;
+    loadIndex();
+    evict(0);
+    saveIndex();
+}
+
+size_t ResultCache::getMaxByteSize() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_maxBytes;
+}
+
+void ResultCache::setMaxByteSize(size_t maxBytes)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_maxBytes = maxBytes;
+    IndexLock indexLock(lockFilename());
+    if ( !indexLock.locked() ) return;
+    loadIndex();
+    evict(m_maxBytes);
+    saveIndex();
+}
+
+size_t ResultCache::getByteSize() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_bytes;
+}
+
+size_t ResultCache::size() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.size();
+}
+
+std::string ResultCache::entryFilename(const std::string& key) const
+{
+    return joinPath(m_directory, key + ".lhc");
+}
+
+std::string ResultCache::indexFilename() const
+{
+    return joinPath(m_directory, "index");
+}
+
+std::string ResultCache::lockFilename() const
+{
+    return joinPath(m_directory, "index.lock");
+}
+
+void ResultCache::loadIndex()
+{
+    EntryMap entries;
+    size_t bytes = 0;
+
+    std::ifstream in(indexFilename().c_str());
+    std::string line;
+    if ( std::getline(in, line) && line == INDEX_HEADER )
+    {
+        std::string key;
+        Entry entry;
+        while ( in >> key >> entry.bytes >> entry.lastUse )
+        {
+            m_clock = std::max(m_clock, entry.lastUse);
+            if ( !fileExists(entryFilename(key)) ) continue;
+
+            // the lookups of this instance since the last write
+            EntryMap::const_iterator current = m_entries.find(key);
+            if ( current != m_entries.end() )
+            {
+                entry.lastUse = std::max(entry.lastUse, current->second.lastUse);
+            }
+            entries[key] = entry;
+            bytes += entry.bytes;
+        }
+    }
+
+    m_entries.swap(entries);
+    m_bytes = bytes;
+}
+
+void ResultCache::removeOrphans()
+{
+    const std::vector<std::string> names = listFiles(m_directory, ".lhc");
+    for (size_t idx = 0; idx < names.size(); ++idx)
+    {
+        const std::string key = names[idx].substr(0, names[idx].size() - 4);
+        if ( m_entries.find(key) == m_entries.end() )
+        {
+            std::remove(joinPath(m_directory, names[idx]).c_str());
+        }
+    }
+}
+
+void ResultCache::saveIndex() const
+{
+    const std::string filename = indexFilename();
+    const std::string temporary = temporaryFilename(filename);
+    {
+        std::ofstream out(temporary.c_str());
+        out << INDEX_HEADER << '\n';
+        for (EntryMap::const_iterator it = m_entries.begin(); it != m_entries.end(); ++it)
+        {
+            out << it->first << ' ' << it->second.bytes << ' ' << it->second.lastUse << '\n';
+        }
+        if ( !out )
+        {
+            out.close();
+            std::remove(temporary.c_str());
+            return;
+        }
+    }
+    if ( !replaceFile(temporary, filename) )
+    {
+        std::remove(temporary.c_str());
+    }
+}
+
+void ResultCache::removeEntry(EntryMap::iterator it)
+{
+    std::remove(entryFilename(it->first).c_str());
+    m_bytes -= it->second.bytes;
+    m_entries.erase(it);
+}
+
+void ResultCache::evict(size_t maxBytes)
+{
+    while ( m_bytes > maxBytes && !m_entries.empty() )
+    {
+        EntryMap::iterator oldest = m_entries.begin();
+        for (EntryMap::iterator it = m_entries.begin(); it != m_entries.end(); ++it)
+        {
+            if ( it->second.lastUse < oldest->second.lastUse )
+            {
+                oldest = it;
+            }
+        }
+        removeEntry(oldest);
+    }
+}
+
+namespace
+{
+std::mutex s_sharedMutex;
+ResultCachePtr s_sharedCache;
+}
+
+ResultCachePtr sharedResultCache()
+{
+    std::lock_guard<std::mutex> lock(s_sharedMutex);
+    return s_sharedCache;
+}
+
+void setSharedResultCache(const std::string& directory, size_t maxBytes)
+{
+    std::lock_guard<std::mutex> lock(s_sharedMutex);
+    if ( maxBytes == 0 )
+    {
+        s_sharedCache.reset();
+    }
+    else if ( s_sharedCache && s_sharedCache->getDirectory() == directory )
+    {
+        s_sharedCache->setMaxByteSize(maxBytes);
+    }
+    else
+    {
+        s_sharedCache.reset(new ResultCache(directory, maxBytes));
+    }
+}
+
+} // namespace pfs
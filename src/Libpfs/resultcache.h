@@ -0,0 +1,129 @@
+/*
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+//! \brief PFS library - on-disk cache of tone mapped frames
+
+#ifndef PFS_RESULTCACHE_H
+#define PFS_RESULTCACHE_H
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <stdint.h>
+
+namespace pfs
+{
+class Frame;
+
+//! \brief Frames computed from an input frame and a set of options, kept in
+//! a directory and looked up by the content of both
+//!
+//! The key of a result combines the content hash of the input frame (see
+//! Frame::getContentHash()) and a hash of the serialised options. Every result is stored
+//! losslessly in its own file, in the format of \c SpilledFrame. The
+//! directory holds an index with the size and the last use of the entries:
+//! when the results exceed the size limit, the least recently used ones are
+//! removed.
+//! All the functions can be called from several threads. Processes can share
+//! the directory: lookups use the index in memory (and the files stored by
+//! the others since), insertions and evictions read, change and write back
+//! the index under a file lock, and the results missing from the index are
+//! removed when a cache is opened. When the directory is missing or read
+//! only, nothing is stored and every lookup is a miss.
+class ResultCache
+{
+public:
+    //! \brief open the cache in \a directory (that must exist), holding at
+    //! most \a maxBytes on disk
+    ResultCache(const std::string& directory, size_t maxBytes);
+
+    //! \brief key of the result of \a options applied to \a input
+    static std::string makeKey(const Frame& input, const std::string& options);
+
+    //! \return the result stored under \a key, NULL if there is none
+    //! \note the caller owns the returned \c Frame
+    Frame* find(const std::string& key);
+
+    //! \brief store \a result under \a key, evicting the least recently
+    //! used entries to stay within the size limit. Results larger than the
+    //! limit are not stored. Errors of the disk are ignored: the result is
+    //! simply not cached
+    void insert(const std::string& key, const Frame& result);
+
+    //! \brief remove all the results
+    void clear();
+
+    const std::string& getDirectory() const { return m_directory; }
+
+    size_t getMaxByteSize() const;
+    void setMaxByteSize(size_t maxBytes);
+
+    //! \brief bytes used on disk by the results
+    size_t getByteSize() const;
+    //! \brief number of results
+    size_t size() const;
+
+private:
+    ResultCache(const ResultCache&);
+    ResultCache& operator=(const ResultCache&);
+
+    struct Entry
+    {
+        size_t bytes;
+        uint64_t lastUse;
+    };
+    typedef std::map<std::string, Entry> EntryMap;
+
+    std::string entryFilename(const std::string& key) const;
+    std::string indexFilename() const;
+    std::string lockFilename() const;
+
+    //! \brief replace m_entries with the index on disk, keeping the last
+    //! uses recorded in memory
+    //! \note called with the lock file held, as saveIndex()
+    void loadIndex();
+    void saveIndex() const;
+    //! \brief remove the results that the index does not list
+    void removeOrphans();
+    void removeEntry(EntryMap::iterator it);
+    void evict(size_t maxBytes);
+
+    std::string m_directory;
+    size_t m_maxBytes;
+    size_t m_bytes;
+    uint64_t m_clock;
+    EntryMap m_entries;
+    mutable std::mutex m_mutex;
+};
+
+typedef std::shared_ptr<ResultCache> ResultCachePtr;
+
+//! \brief cache shared by the jobs of the process: NULL (the default) when
+//! caching is disabled
+ResultCachePtr sharedResultCache();
+//! \brief use the cache in \a directory for the whole process: a
+//! \a maxBytes of 0 disables caching. Jobs already holding the previous
+//! cache keep using it until they finish
+void setSharedResultCache(const std::string& directory, size_t maxBytes);
+
+} // namespace pfs
+
+#endif // PFS_RESULTCACHE_H
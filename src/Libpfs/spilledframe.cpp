@@ -0,0 +1,373 @@
+/*
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <Libpfs/spilledframe.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <vector>
+#include <stdint.h>
+
+#include <zlib.h>
+
+#include <Libpfs/exception.h>
+#include <Libpfs/frame.h>
+#include <Libpfs/utils/parallel.h>
+#include <Libpfs/utils/trace.h>
+
+namespace pfs
+{
+namespace
+{
+const char SPILL_MAGIC[4] = { 'L', 'H', 'S', '1' };
+//! \brief rows compressed together: small enough to spread a channel over
+//! all the threads, large enough to keep deflate efficient
+const size_t BLOCK_ROWS = 32;
+
+typedef std::vector<unsigned char> Buffer;
+
+struct FileCloser
+{
+    void operator()(std::FILE* f) const { std::fclose(f); }
+};
+typedef std::unique_ptr<std::FILE, FileCloser> FilePtr;
+
+std::string spillFilename(const std::string& directory)
+{
+    static std::atomic<unsigned> s_counter(0);
+
+    std::ostringstream name;
+    name << directory;
+    if ( !directory.empty() &&
+         directory[directory.size() - 1] != '/' &&
+         directory[directory.size() - 1] != '\\' )
+    {
+        name << '/';
+    }
+    // the clock keeps apart the files of two processes sharing the directory
+    name << "luminance_spill_"
+         << std::chrono::steady_clock::now().time_since_epoch().count() << '_'
+         << s_counter++ << ".lhs";
+    return name.str();
+}
+
+void writeBytes(std::FILE* f, const void* data, size_t size)
+{
+    if ( size && std::fwrite(data, 1, size, f) != size )
+    {
+        throw pfs::Exception("SpilledFrame: cannot write the scratch file");
+    }
+}
+
+void readBytes(std::FILE* f, void* data, size_t size)
+{
+    if ( size && std::fread(data, 1, size, f) != size )
+    {
+        throw pfs::Exception("SpilledFrame: scratch file is truncated");
+    }
+}
+
+template <typename Type>
+void writeValue(std::FILE* f, Type value)
+{
+    writeBytes(f, &value, sizeof(Type));
+}
+
+template <typename Type>
+Type readValue(std::FILE* f)
+{
+    Type value;
+    readBytes(f, &value, sizeof(Type));
+    return value;
+}
+
+void writeString(std::FILE* f, const std::string& str)
+{
+    writeValue<uint32_t>(f, static_cast<uint32_t>(str.size()));
+    writeBytes(f, str.data(), str.size());
+}
+
+std::string readString(std::FILE* f)
+{
+    std::string str(readValue<uint32_t>(f), '\0');
+    if ( !str.empty() ) readBytes(f, &str[0], str.size());
+    return str;
+}
+
+void writeTags(std::FILE* f, const TagContainer& tags)
+{
+    uint32_t count = 0;
+    for (TagContainer::const_iterator it = tags.begin(); it != tags.end(); ++it)
+    {
+        ++count;
+    }
+    writeValue<uint32_t>(f, count);
+    for (TagContainer::const_iterator it = tags.begin(); it != tags.end(); ++it)
+    {
+        writeString(f, it->first);
+        writeString(f, it->second);
+    }
+}
+
+void readTags(std::FILE* f, TagContainer& tags)
+{
+    const uint32_t count = readValue<uint32_t>(f);
+    for (uint32_t idx = 0; idx < count; ++idx)
+    {
+        const std::string name = readString(f);
+        tags.setTag(name, readString(f));
+    }
+}
+
+//! \brief byte k of every sample goes in the k-th quarter of \a out
+void shuffle(const float* in, size_t size, unsigned char* out)
+{
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(in);
+    for (size_t idx = 0; idx < size; ++idx)
+    {
+        for (size_t k = 0; k < sizeof(float); ++k)
+        {
+            out[k*size + idx] = bytes[idx*sizeof(float) + k];
+        }
+    }
+}
+
+void unshuffle(const unsigned char* in, size_t size, float* out)
+{
+    unsigned char* bytes = reinterpret_cast<unsigned char*>(out);
+    for (size_t idx = 0; idx < size; ++idx)
+    {
+        for (size_t k = 0; k < sizeof(float); ++k)
+        {
+            bytes[idx*sizeof(float) + k] = in[k*size + idx];
+        }
+    }
+}
+
+void writeFrame(std::FILE* f, const Frame& frame)
+{
+    const size_t width = frame.getWidth();
+    const size_t height = frame.getHeight();
+
+    writeBytes(f, SPILL_MAGIC, sizeof(SPILL_MAGIC));
+    writeValue<uint64_t>(f, width);
+    writeValue<uint64_t>(f, height);
+    writeTags(f, frame.getTags());
+
+    const ChannelContainer& channels = frame.getChannels();
+    writeValue<uint32_t>(f, static_cast<uint32_t>(channels.size()));
+
+    const size_t numBlocks = (height + BLOCK_ROWS - 1)/BLOCK_ROWS;
+    std::vector<Buffer> blocks(numBlocks);
+    for (size_t c = 0; c < channels.size(); ++c)
+    {
+        const Channel* ch = channels[c];
+        writeString(f, ch->getName());
+        writeTags(f, ch->getTags());
+
+        utils::parallelFor(0, numBlocks, 1,
+                           [&](size_t b_begin, size_t b_end)
+        {
+            Buffer shuffled;
+            for (size_t b = b_begin; b < b_end; ++b)
+            {
+                const size_t row = b*BLOCK_ROWS;
+                const size_t size = std::min(BLOCK_ROWS, height - row)*width;
+
+                shuffled.resize(size*sizeof(float));
+                shuffle(ch->data() + row*width, size, shuffled.data());
+
+                uLongf destSize = compressBound(shuffled.size());
+                blocks[b].resize(destSize);
+                if ( compress2(blocks[b].data(), &destSize,
+                               shuffled.data(), shuffled.size(),
+                               Z_BEST_SPEED) != Z_OK )
+                {
+                    destSize = 0;
+                }
+                blocks[b].resize(destSize);
+            }
+        });
+
+        for (size_t b = 0; b < numBlocks; ++b)
+        {
+            // deflate never produces an empty stream
+            if ( blocks[b].empty() )
+            {
+                throw pfs::Exception("pfs: compression of the scratch file failed");
+            }
+            writeValue<uint64_t>(f, blocks[b].size());
+            writeBytes(f, blocks[b].data(), blocks[b].size());
+        }
+    }
+
+    if ( std::fflush(f) != 0 )
+    {
+        throw pfs::Exception("pfs: cannot write the scratch file");
+    }
+}
+
+Frame* readFrame(std::FILE* f, const std::string& filename)
+{
+    char magic[sizeof(SPILL_MAGIC)];
+    readBytes(f, magic, sizeof(magic));
+    if ( std::memcmp(magic, SPILL_MAGIC, sizeof(magic)) != 0 )
+    {
+        throw pfs::Exception("pfs: " + filename + " is not a scratch file");
+    }
+    const size_t width = readValue<uint64_t>(f);
+    const size_t height = readValue<uint64_t>(f);
+
+    std::unique_ptr<Frame> frame(new Frame(width, height));
+    readTags(f, frame->getTags());
+
+    const uint32_t numChannels = readValue<uint32_t>(f);
+    const size_t numBlocks = (height + BLOCK_ROWS - 1)/BLOCK_ROWS;
+    std::vector<Buffer> blocks(numBlocks);
+    for (uint32_t c = 0; c < numChannels; ++c)
+    {
+        Channel* ch = frame->createChannel(readString(f));
+        readTags(f, ch->getTags());
+
+        for (size_t b = 0; b < numBlocks; ++b)
+        {
+            blocks[b].resize(readValue<uint64_t>(f));
+            readBytes(f, blocks[b].data(), blocks[b].size());
+        }
+
+        std::atomic<bool> damaged(false);
+        utils::parallelFor(0, numBlocks, 1,
+                           [&](size_t b_begin, size_t b_end)
+        {
+            Buffer shuffled;
+            for (size_t b = b_begin; b < b_end; ++b)
+            {
+                const size_t row = b*BLOCK_ROWS;
+                const size_t size = std::min(BLOCK_ROWS, height - row)*width;
+
+                shuffled.resize(size*sizeof(float));
+                uLongf destSize = shuffled.size();
+                if ( uncompress(shuffled.data(), &destSize,
+                                blocks[b].data(), blocks[b].size()) != Z_OK ||
+                     destSize != shuffled.size() )
+                {
+                    damaged = true;
+                    continue;
+                }
+                unshuffle(shuffled.data(), size, ch->data() + row*width);
+            }
+        });
+        if ( damaged )
+        {
+            throw pfs::Exception("pfs: " + filename + " is damaged");
+        }
+    }
+    return frame.release();
+}
+}
+
+void writeScratchFrame(const Frame& frame, const std::string& filename)
+{
+    FilePtr f(std::fopen(filename.c_str(), "wb"));
+    if ( !f )
+    {
+        throw pfs::Exception("pfs: cannot create " + filename);
+    }
+    try
+    {
+        writeFrame(f.get(), frame);
+    }
+    catch (...)
+    {
+        f.reset();
+        std::remove(filename.c_str());
+        throw;
+    }
+}
+
+Frame* readScratchFrame(const std::string& filename)
+{
+    FilePtr f(std::fopen(filename.c_str(), "rb"));
+    if ( !f )
+    {
+        throw pfs::Exception("pfs: cannot open " + filename);
+    }
+    return readFrame(f.get(), filename);
+}
+
+SpilledFrame::SpilledFrame(const Frame& frame, const std::string& directory)
+    : m_width(frame.getWidth())
+    , m_height(frame.getHeight())
+    , m_byteSize(0)
+{
+    utils::TraceSpan span("spill");
+
+    FilePtr f;
+    for (int attempt = 0; attempt < 16 && !f; ++attempt)
+    {
+        m_filename = spillFilename(directory);
+        // "x": never reuse an existing file
+        f.reset(std::fopen(m_filename.c_str(), "wbx"));
+    }
+    if ( !f )
+    {
+        throw pfs::Exception("SpilledFrame: cannot create a scratch file in " + directory);
+    }
+
+    try
+    {
+        writeFrame(f.get(), frame);
+        m_byteSize = static_cast<size_t>(std::ftell(f.get()));
+    }
+    catch (...)
+    {
+        f.reset();
+        std::remove(m_filename.c_str());
+        throw;
+    }
+
+    utils::traceCount("bytes spilled", m_byteSize);
+}
+
+SpilledFrame::~SpilledFrame()
+{
+    std::remove(m_filename.c_str());
+}
+
+Frame* SpilledFrame::expand() const
+{
+    utils::TraceSpan span("reload");
+
+    std::unique_ptr<Frame> frame(readScratchFrame(m_filename));
+    if ( frame->getWidth() != m_width || frame->getHeight() != m_height )
+    {
+        throw pfs::Exception("SpilledFrame: " + m_filename + " is not a scratch file of this frame");
+    }
+
+    utils::traceCount("bytes reloaded", m_byteSize);
+    return frame.release();
+}
+
+} // namespace pfs
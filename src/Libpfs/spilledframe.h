@@ -0,0 +1,84 @@
+/*
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+//! \brief PFS library - scratch file storage for inactive frames
+
+#ifndef PFS_SPILLEDFRAME_H
+#define PFS_SPILLEDFRAME_H
+
+#include <string>
+
+namespace pfs
+{
+class Frame;
+
+//! \brief write \a frame (channels and tags) in the scratch format of
+//! \c SpilledFrame, that is also used by \c ResultCache. The files can only
+//! be read on machines with the same byte order
+//! \throw pfs::Exception if the file cannot be written
+void writeScratchFrame(const Frame& frame, const std::string& filename);
+
+//! \brief read a file written by writeScratchFrame()
+//! \note the caller owns the returned \c Frame
+//! \throw pfs::Exception if the file is missing or damaged
+Frame* readScratchFrame(const std::string& filename);
+
+//! \brief Copy of a \c Frame moved to a scratch file on disk
+//!
+//! The samples are stored losslessly: every block of rows is byte shuffled
+//! (the exponents of neighbouring pixels end up next to each other) and
+//! deflated at the fastest level, with the blocks compressed and inflated in
+//! parallel. The file is only meant to be read back by the same process:
+//! it is written in the byte order of the machine, and removed by the
+//! destructor.
+class SpilledFrame
+{
+public:
+    //! \brief write \a frame in a new file inside \a directory
+    //! \throw pfs::Exception if the file cannot be written
+    SpilledFrame(const Frame& frame, const std::string& directory);
+    ~SpilledFrame();
+
+    size_t getWidth() const     { return m_width; }
+    size_t getHeight() const    { return m_height; }
+
+    const std::string& getFilename() const { return m_filename; }
+
+    //! \brief number of bytes used on disk
+    size_t getByteSize() const  { return m_byteSize; }
+
+    //! \brief read back the \c Frame (channels and tags)
+    //! \note the caller owns the returned \c Frame
+    //! \throw pfs::Exception if the file is missing or damaged
+    Frame* expand() const;
+
+private:
+    SpilledFrame(const SpilledFrame&);
+    SpilledFrame& operator=(const SpilledFrame&);
+
+    size_t m_width;
+    size_t m_height;
+    size_t m_byteSize;
+    std::string m_filename;
+};
+
+} // namespace pfs
+
+#endif // PFS_SPILLEDFRAME_H
@@ -39,7 +39,10 @@
 #include "Libpfs/channel.h"
 #include "Libpfs/colorspace/colorspace.h"
 #include "Libpfs/progress.h"
+#include "Libpfs/utils/fastmath.h"
+#include "Libpfs/utils/trace.h"
 #include "Libpfs/tm/TonemapOperator.h"
+#include "Libpfs/tm/TonemapStageCache.h"
 
 using namespace boost::assign;
 
@@ -61,7 +64,18 @@ class TonemapOperatorMantiuk06
         : public TonemapOperatorRegister<mantiuk06, TonemapOperatorMantiuk06>
 {
 public:
-    void tonemapFrame(pfs::Frame& workingFrame, TonemappingOptions* opts, pfs::Progress& ph)
+    std::vector<Stage> getStages() const
+    {
+        Stage luminance;
+        luminance.name = "luminance";
+        luminance.parameters.push_back("contrastfactor");
+        luminance.parameters.push_back("detailfactor");
+        luminance.parameters.push_back("contrastequalization");
+        return std::vector<Stage>(1, luminance);
+    }
+
+    void doTonemapFrame(pfs::Frame& workingFrame, TonemappingParameters* opts,
+                        const pfs::TonemapStages& stages, pfs::Progress& ph)
     {
         ph.setMaximum(100);
 
@@ -72,7 +86,7 @@ public:
                              opts->operator_options.mantiuk06options.saturationfactor,
                              opts->operator_options.mantiuk06options.detailfactor,
                              opts->operator_options.mantiuk06options.contrastequalization,
-                             ph);
+                             ph, stages);
         }
         catch (...)
         {
@@ -85,7 +99,8 @@ public:
 struct TonemapOperatorMantiuk08
         : public TonemapOperatorRegister<mantiuk08, TonemapOperatorMantiuk08>
 {
-    void tonemapFrame(pfs::Frame& workingframe, TonemappingOptions* opts, pfs::Progress& ph)
+    void doTonemapFrame(pfs::Frame& workingframe, TonemappingParameters* opts,
+                        const pfs::TonemapStages&, pfs::Progress& ph)
     {
         ph.setMaximum(100);
 
@@ -110,7 +125,21 @@ struct TonemapOperatorMantiuk08
 struct TonemapOperatorFattal02
         : public TonemapOperatorRegister<fattal, TonemapOperatorFattal02>
 {
-    void tonemapFrame(pfs::Frame& workingframe, TonemappingOptions* opts, pfs::Progress& ph)
+    std::vector<Stage> getStages() const
+    {
+        // the detail level follows xsize/origxsize
+        Stage luminance;
+        luminance.name = "luminance";
+        luminance.parameters.push_back("alpha");
+        luminance.parameters.push_back("beta");
+        luminance.parameters.push_back("noiseredux");
+        luminance.parameters.push_back("newfattal");
+        luminance.parameters.push_back("fftsolver");
+        return std::vector<Stage>(1, luminance);
+    }
+
+    void doTonemapFrame(pfs::Frame& workingframe, TonemappingParameters* opts,
+                        const pfs::TonemapStages& stages, pfs::Progress& ph)
     {
         ph.setMaximum(100);
 
@@ -137,14 +166,15 @@ struct TonemapOperatorFattal02
                         opts->operator_options.fattaloptions.newfattal,
                         opts->operator_options.fattaloptions.fftsolver,
                         detail_level,
-                        ph);
+                        ph, stages);
     }
 };
 
 struct TonemapOperatorFerradans11
         : public TonemapOperatorRegister<ferradans, TonemapOperatorFerradans11>
 {
-    void tonemapFrame(pfs::Frame& workingframe, TonemappingOptions* opts, pfs::Progress& ph)
+    void doTonemapFrame(pfs::Frame& workingframe, TonemappingParameters* opts,
+                        const pfs::TonemapStages&, pfs::Progress& ph)
     {
         ph.setMaximum(100);
 
@@ -165,7 +195,8 @@ boost::mutex TonemapOperatorFerradans11::m_mutex;
 struct TonemapOperatorMai11
         : public TonemapOperatorRegister<mai, TonemapOperatorMai11>
 {
-    void tonemapFrame(pfs::Frame& workingframe, TonemappingOptions* opts, pfs::Progress& ph)
+    void doTonemapFrame(pfs::Frame& workingframe, TonemappingParameters* opts,
+                        const pfs::TonemapStages&, pfs::Progress& ph)
     {
         ph.setMaximum(100);
 
@@ -176,7 +207,8 @@ struct TonemapOperatorMai11
 struct TonemapOperatorDrago03
         : public TonemapOperatorRegister<drago, TonemapOperatorDrago03>
 {
-    void tonemapFrame(pfs::Frame& workingframe, TonemappingOptions* opts, pfs::Progress& ph)
+    void doTonemapFrame(pfs::Frame& workingframe, TonemappingParameters* opts,
+                        const pfs::TonemapStages&, pfs::Progress& ph)
     {
         ph.setMaximum(100);         // this guy should not be here!
 
@@ -189,7 +221,17 @@ struct TonemapOperatorDrago03
 class TonemapOperatorDurand02
         : public TonemapOperatorRegister<durand, TonemapOperatorDurand02>
 {
-    void tonemapFrame(pfs::Frame& workingframe, TonemappingOptions* opts, pfs::Progress& ph)
+    std::vector<Stage> getStages() const
+    {
+        Stage base;
+        base.name = "base";
+        base.parameters.push_back("spatial");
+        base.parameters.push_back("range");
+        return std::vector<Stage>(1, base);
+    }
+
+    void doTonemapFrame(pfs::Frame& workingframe, TonemappingParameters* opts,
+                        const pfs::TonemapStages& stages, pfs::Progress& ph)
     {
         ph.setMaximum(100);
 
@@ -201,7 +243,7 @@ class TonemapOperatorDurand02
                             opts->operator_options.durandoptions.spatial,
                             opts->operator_options.durandoptions.range,
                             opts->operator_options.durandoptions.base,
-                            ph);
+                            ph, stages);
         }
         catch (...)
         {
@@ -221,7 +263,8 @@ boost::mutex TonemapOperatorDurand02::m_mutex;
 struct TonemapOperatorReinhard02
         : public TonemapOperatorRegister<reinhard02, TonemapOperatorReinhard02>
 {
-    void tonemapFrame(pfs::Frame& workingframe, TonemappingOptions* opts, pfs::Progress& ph)
+    void doTonemapFrame(pfs::Frame& workingframe, TonemappingParameters* opts,
+                        const pfs::TonemapStages&, pfs::Progress& ph)
     {
         ph.setMaximum(100);
 
@@ -261,7 +304,8 @@ boost::mutex TonemapOperatorReinhard02::m_mutex;
 struct TonemapOperatorReinhard05
         : public TonemapOperatorRegister<reinhard05, TonemapOperatorReinhard05>
 {
-    void tonemapFrame(pfs::Frame& workingframe, TonemappingOptions* opts, pfs::Progress& ph)
+    void doTonemapFrame(pfs::Frame& workingframe, TonemappingParameters* opts,
+                        const pfs::TonemapStages&, pfs::Progress& ph)
     {
         ph.setMaximum(100);
 
@@ -276,7 +320,8 @@ struct TonemapOperatorReinhard05
 struct TonemapOperatorAshikhmin02
         : public TonemapOperatorRegister<ashikhmin, TonemapOperatorAshikhmin02>
 {
-    void tonemapFrame(pfs::Frame& workingframe, TonemappingOptions* opts, pfs::Progress& ph)
+    void doTonemapFrame(pfs::Frame& workingframe, TonemappingParameters* opts,
+                        const pfs::TonemapStages&, pfs::Progress& ph)
     {
         ph.setMaximum(100);
 
@@ -291,7 +336,8 @@ struct TonemapOperatorAshikhmin02
 struct TonemapOperatorPattanaik00
         : public TonemapOperatorRegister<pattanaik, TonemapOperatorPattanaik00>
 {
-    void tonemapFrame(pfs::Frame& workingframe, TonemappingOptions* opts, pfs::Progress& ph)
+    void doTonemapFrame(pfs::Frame& workingframe, TonemappingParameters* opts,
+                        const pfs::TonemapStages&, pfs::Progress& ph)
     {
         ph.setMaximum(100);
 
@@ -345,6 +391,35 @@ TonemapOperator::TonemapOperator()
 TonemapOperator::~TonemapOperator()
 {}
 
+std::vector<TonemapOperator::Stage> TonemapOperator::getStages() const
+{
+    return std::vector<Stage>();
+}
+
+void TonemapOperator::tonemapFrame(pfs::Frame& workingFrame, TonemappingParameters* opts,
+                                   pfs::Progress& ph)
+{
+    pfs::utils::TraceSpan span("tonemap", opts->getOperatorName());
+    pfs::utils::traceCount("pixels tonemapped", workingFrame.size());
+
+    pfs::utils::ScopedMathPrecision precision(opts->fastMath ?
+                                                  pfs::utils::MATH_FAST :
+                                                  pfs::utils::MATH_ACCURATE);
+
+    // the key of the stages is the frame as the operator receives it
+    pfs::TonemapStages stages;
+    pfs::TonemapStageCache& stage_cache = pfs::tonemapStageCache();
+    if ( !getStages().empty() && stage_cache.getMaxByteSize() > 0 )
+    {
+        stages = pfs::TonemapStages(&stage_cache, workingFrame.getContentHash());
+    }
+
+    doTonemapFrame(workingFrame, opts, stages, ph);
+
+    // the operators work in place
+    workingFrame.invalidateContentHash();
+}
+
 TonemapOperator* TonemapOperator::getTonemapOperator(const TMOperator tmo)
 {
     TonemapOperatorCreatorMap::const_iterator it = registry().find(tmo);
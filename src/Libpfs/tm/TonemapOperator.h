@@ -32,14 +32,17 @@
 #define TONEMAPOPERATOR_H
 
 #include <stdexcept>
+#include <string>
+#include <vector>
 
-#include "Core/TonemappingOptions.h"
+#include "Libpfs/tm/TonemappingParameters.h"
 
 // Forward declaration
 namespace pfs
 {
 class Progress;
 class Frame;
+class TonemapStages;
 }
 
 class TonemapOperator
@@ -53,15 +56,39 @@ public:
     //!
     virtual TMOperator getType() const = 0;
 
+    //! \brief intermediate result of the operator and the parameters (names
+    //! of the fields of the operator options) it depends on
+    struct Stage
+    {
+        std::string name;
+        std::vector<std::string> parameters;
+    };
+
+    //!
+    //! \return the stages the operator keeps in pfs::tonemapStageCache():
+    //! a new run on the same frame that only changes the other parameters
+    //! skips them. Empty by default
+    //!
+    virtual std::vector<Stage> getStages() const;
+
     //!
     //! Get a Frame in RGB and processes it.
     //! \note input frame is MODIFIED
     //! If you want to keep the original frame, make a copy before
+    //! \note the operator runs with the math precision selected by
+    //! TonemappingParameters::fastMath
+    //! \note the stages listed by getStages() are looked up by the content
+    //! of the frame
     //!
-    virtual void tonemapFrame(pfs::Frame&, TonemappingOptions*, pfs::Progress& ph) = 0;
+    void tonemapFrame(pfs::Frame&, TonemappingParameters*, pfs::Progress& ph);
 
 protected:
     TonemapOperator();
+
+    //! \brief the actual tone mapping, implemented by each operator
+    //! \param stages where the operator finds and keeps its stages
+    virtual void doTonemapFrame(pfs::Frame&, TonemappingParameters*,
+                                const pfs::TonemapStages& stages, pfs::Progress& ph) = 0;
 };
 
 #endif // TONEMAPOPERATOR_H
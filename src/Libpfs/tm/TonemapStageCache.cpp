@@ -0,0 +1,196 @@
+/**
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include "Libpfs/tm/TonemapStageCache.h"
+
+#include <string>
+
+#include "Libpfs/array2d.h"
+#include "Libpfs/utils/fastmath.h"
+#include "Libpfs/utils/memorybudget.h"
+#include "Libpfs/utils/trace.h"
+
+namespace pfs
+{
+namespace
+{
+const size_t DEFAULT_MAX_BYTES = 512*1024*1024;
+
+size_t resultBytes(const TonemapStageCache::ResultPtr& result)
+{
+    return result->size()*sizeof(float);
+}
+}
+
+TonemapStageCache::TonemapStageCache(size_t maxBytes)
+    : m_maxBytes(maxBytes)
+    , m_bytes(0)
+{
+    // the results are Array2D, counted in the memory of the frames: a job
+    // waiting for memory can have them back
+    m_pressureHandler = utils::addMemoryPressureHandler(
+                [this](size_t bytes) { return release(bytes); });
+}
+
+TonemapStageCache::~TonemapStageCache()
+{
+    utils::removeMemoryPressureHandler(m_pressureHandler);
+}
+
+TonemapStageCache::ResultPtr TonemapStageCache::find(const utils::Hash128& key)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    EntryIndex::iterator it = m_index.find(key);
+    if ( it == m_index.end() )
+    {
+        utils::traceCount("stage cache misses", 1);
+        return ResultPtr();
+    }
+
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    utils::traceCount("stage cache hits", 1);
+    return it->second->second;
+}
+
+void TonemapStageCache::insert(const utils::Hash128& key, const ResultPtr& result)
+{
+    if ( !result ) return;
+
+    const size_t bytes = resultBytes(result);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if ( bytes > m_maxBytes ) return;
+
+    EntryIndex::iterator it = m_index.find(key);
+    if ( it != m_index.end() )
+    {
+        m_bytes -= resultBytes(it->second->second);
+        m_entries.erase(it->second);
+        m_index.erase(it);
+    }
+
+    m_entries.push_front(std::make_pair(key, result));
+    m_index[key] = m_entries.begin();
+    m_bytes += bytes;
+
+    evict(m_maxBytes);
+}
+
+size_t TonemapStageCache::release(size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return evict(bytes < m_bytes ? m_bytes - bytes : 0);
+}
+
+void TonemapStageCache::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    evict(0);
+}
+
+size_t TonemapStageCache::getMaxByteSize() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_maxBytes;
+}
+
+void TonemapStageCache::setMaxByteSize(size_t maxBytes)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_maxBytes = maxBytes;
+    evict(m_maxBytes);
+}
+
+size_t TonemapStageCache::getByteSize() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_bytes;
+}
+
+size_t TonemapStageCache::size() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.size();
+}
+
+size_t TonemapStageCache::evict(size_t maxBytes)
+{
+    // a result still used by a running operator is only freed by it
+    size_t freed = 0;
+    while ( m_bytes > maxBytes && !m_entries.empty() )
+    {
+        const size_t bytes = resultBytes(m_entries.back().second);
+        m_index.erase(m_entries.back().first);
+        m_entries.pop_back();
+        m_bytes -= bytes;
+        freed += bytes;
+    }
+    return freed;
+}
+
+TonemapStageCache& tonemapStageCache()
+{
+    static TonemapStageCache s_cache(DEFAULT_MAX_BYTES);
+    return s_cache;
+}
+
+TonemapStages::TonemapStages()
+    : m_cache(NULL)
+{}
+
+TonemapStages::TonemapStages(TonemapStageCache* cache, const utils::Hash128& input)
+    : m_cache(cache)
+    , m_input(input)
+{}
+
+TonemapStageCache::ResultPtr TonemapStages::find(const char* stage,
+                                                 std::initializer_list<float> parameters) const
+{
+    if ( !m_cache ) return TonemapStageCache::ResultPtr();
+
+    return m_cache->find(key(stage, parameters));
+}
+
+void TonemapStages::insert(const char* stage, std::initializer_list<float> parameters,
+                           const TonemapStageCache::ResultPtr& result) const
+{
+    if ( !m_cache ) return;
+
+    m_cache->insert(key(stage, parameters), result);
+}
+
+utils::Hash128 TonemapStages::key(const char* stage,
+                                  std::initializer_list<float> parameters) const
+{
+    utils::Hasher hasher;
+    hasher.update(m_input);
+    hasher.update(std::string(stage));
+    // the fast log/exp/pow give (slightly) different intermediate results
+    hasher.update(static_cast<uint64_t>(utils::mathPrecision()));
+    for (std::initializer_list<float>::const_iterator it = parameters.begin();
+         it != parameters.end(); ++it)
+    {
+        const float value = *it;
+        hasher.update(&value, sizeof(value));
+    }
+    return hasher.digest();
+}
+
+}
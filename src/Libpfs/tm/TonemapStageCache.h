@@ -0,0 +1,129 @@
+/**
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ *
+ * Intermediate results of the tone mapping operators, kept between runs
+ *
+ */
+
+#ifndef TONEMAPSTAGECACHE_H
+#define TONEMAPSTAGECACHE_H
+
+#include <cstddef>
+#include <initializer_list>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include "Libpfs/array2d_fwd.h"
+#include "Libpfs/utils/hash.h"
+
+namespace pfs
+{
+
+//! \brief expensive intermediate results of the tone mapping operators (the
+//! base layer of Durand, the luminance solved by Fattal and Mantiuk06), kept
+//! in memory between runs
+//!
+//! A result is identified by the content of the frame given to the operator,
+//! the stage and the values of the parameters the stage depends on (see
+//! TonemapOperator::getStages()): moving a slider that only changes the tail
+//! of an operator finds the expensive stages already computed.
+//! The least recently used results are dropped beyond the size limit, and
+//! when a job waits for memory (see utils::addMemoryPressureHandler()).
+//! All the functions can be called from several threads.
+class TonemapStageCache
+{
+public:
+    typedef std::shared_ptr<const Array2Df> ResultPtr;
+
+    explicit TonemapStageCache(size_t maxBytes);
+    ~TonemapStageCache();
+
+    //! \return the result stored under \a key, NULL if there is none
+    ResultPtr find(const utils::Hash128& key);
+    //! \brief store \a result under \a key, dropping the least recently used
+    //! results to stay within the size limit. Results larger than the limit
+    //! are not stored
+    void insert(const utils::Hash128& key, const ResultPtr& result);
+
+    //! \brief drop the least recently used results until \a bytes are freed
+    //! \return bytes freed
+    size_t release(size_t bytes);
+    void clear();
+
+    //! \brief 0 disables the cache
+    size_t getMaxByteSize() const;
+    void setMaxByteSize(size_t maxBytes);
+
+    size_t getByteSize() const;
+    size_t size() const;
+
+private:
+    TonemapStageCache(const TonemapStageCache&);
+    TonemapStageCache& operator=(const TonemapStageCache&);
+
+    // most recently used first
+    typedef std::list< std::pair<utils::Hash128, ResultPtr> > EntryList;
+    typedef std::map<utils::Hash128, EntryList::iterator> EntryIndex;
+
+    //! \pre m_mutex is held
+    size_t evict(size_t maxBytes);
+
+    EntryList m_entries;
+    EntryIndex m_index;
+    size_t m_maxBytes;
+    size_t m_bytes;
+    mutable std::mutex m_mutex;
+    int m_pressureHandler;
+};
+
+//! \brief cache used by TonemapOperator::tonemapFrame(), 512 MB by default
+TonemapStageCache& tonemapStageCache();
+
+//! \brief the stages of one run of an operator: the cache and the content of
+//! the frame the operator received. A default constructed object keeps
+//! nothing, and every stage is computed
+class TonemapStages
+{
+public:
+    TonemapStages();
+    TonemapStages(TonemapStageCache* cache, const utils::Hash128& input);
+
+    bool isEnabled() const  { return m_cache != NULL; }
+
+    //! \return the result of \a stage computed with the same \a parameters,
+    //! at the current math precision (see utils::mathPrecision()). NULL if
+    //! there is none
+    TonemapStageCache::ResultPtr find(const char* stage,
+                                      std::initializer_list<float> parameters) const;
+    void insert(const char* stage, std::initializer_list<float> parameters,
+                const TonemapStageCache::ResultPtr& result) const;
+
+private:
+    utils::Hash128 key(const char* stage, std::initializer_list<float> parameters) const;
+
+    TonemapStageCache* m_cache;
+    utils::Hash128 m_input;
+};
+
+}
+
+#endif // TONEMAPSTAGECACHE_H
@@ -0,0 +1,370 @@
+/**
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include "Libpfs/tm/TonemapSweep.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Libpfs/frame.h"
+#include "Libpfs/frame_view.h"
+#include "Libpfs/progress.h"
+#include "Libpfs/manip/copy.h"
+#include "Libpfs/manip/gamma.h"
+#include "Libpfs/manip/resize.h"
+#include "Libpfs/tm/TonemapOperator.h"
+#include "Libpfs/utils/memorybudget.h"
+#include "Libpfs/utils/parallel.h"
+#include "Libpfs/utils/trace.h"
+
+namespace pfs
+{
+namespace
+{
+//! \brief space around the cells of the contact sheet, in pixels
+const size_t SHEET_GUTTER = 4;
+const float SHEET_BACKGROUND = 0.2f;
+
+//! \brief a variant waiting for memory checks the budget again at this
+//! interval, for the memory released outside of the sweep
+const std::chrono::milliseconds MEMORY_POLL(50);
+
+//! \brief the frame every variant starts from, as TMWorker::preprocessFrame()
+//! makes it for a single run
+Frame* prepareInput(const Frame& input, const TonemappingParameters& params)
+{
+    if ( params.xsize > 0 && static_cast<size_t>(params.xsize) < input.getWidth() )
+    {
+        Frame* resized = resize(&input, params.xsize, BilinearInterp);
+        if ( params.pregamma != 1.0f )
+        {
+            applyGamma(resized, params.pregamma);
+        }
+        return resized;
+    }
+    return copyWithGamma(FrameView(input), params.pregamma);
+}
+
+Frame* createSheet(size_t columns, size_t rows, size_t cellWidth, size_t cellHeight)
+{
+    Frame* sheet = new Frame(columns*cellWidth + (columns + 1)*SHEET_GUTTER,
+                             rows*cellHeight + (rows + 1)*SHEET_GUTTER);
+    Channel* R;
+    Channel* G;
+    Channel* B;
+    sheet->createXYZChannels(R, G, B);
+    std::fill(R->begin(), R->end(), SHEET_BACKGROUND);
+    std::fill(G->begin(), G->end(), SHEET_BACKGROUND);
+    std::fill(B->begin(), B->end(), SHEET_BACKGROUND);
+    return sheet;
+}
+
+//! \brief copy the downscaled \a result in its cell: the cells do not
+//! overlap, so the variants fill them at the same time
+void placeInSheet(Frame& sheet, size_t column, size_t row,
+                  size_t cellWidth, size_t cellHeight, const Frame& result)
+{
+    std::unique_ptr<Frame> thumbnail(resize(&result, static_cast<int>(cellWidth), AreaInterp));
+
+    const size_t x0 = SHEET_GUTTER + column*(cellWidth + SHEET_GUTTER);
+    const size_t y0 = SHEET_GUTTER + row*(cellHeight + SHEET_GUTTER);
+    const size_t width = std::min(cellWidth, thumbnail->getWidth());
+    const size_t height = std::min(cellHeight, thumbnail->getHeight());
+
+    const Channel* from[3];
+    thumbnail->getXYZChannels(from[0], from[1], from[2]);
+    Channel* to[3];
+    sheet.getXYZChannels(to[0], to[1], to[2]);
+    for (int c = 0; c < 3; ++c)
+    {
+        if ( from[c] == NULL ) continue;
+
+        for (size_t y = 0; y < height; ++y)
+        {
+            std::copy(from[c]->row_begin(y), from[c]->row_begin(y) + width,
+                      to[c]->row_begin(y0 + y) + x0);
+        }
+    }
+}
+}
+
+SweepAxis::SweepAxis()
+    : first(0.f)
+    , last(0.f)
+    , steps(1)
+{}
+
+SweepAxis::SweepAxis(const std::string& option_, float first_, float last_, size_t steps_)
+    : option(option_)
+    , first(first_)
+    , last(last_)
+    , steps(steps_)
+{}
+
+float SweepAxis::value(size_t i) const
+{
+    if ( steps <= 1 ) return first;
+
+    return first + (last - first)*static_cast<float>(i)/static_cast<float>(steps - 1);
+}
+
+TonemapSweep::TonemapSweep(const TonemappingParameters& params,
+                           const SweepAxis& columns, const SweepAxis& rows)
+    : m_params(params)
+    , m_columns(columns)
+    , m_rows(rows)
+    , m_cellWidth(0)
+{
+    const SweepAxis* axes[] = { &m_columns, &m_rows };
+    for (int a = 0; a < 2; ++a)
+    {
+        if ( axes[a]->steps == 0 )
+        {
+            throw std::runtime_error("TonemapSweep: an axis has no steps");
+        }
+        TonemappingParameters check(m_params);
+        if ( !axes[a]->option.empty() && !check.setOperatorOption(axes[a]->option, 0.f) )
+        {
+            throw std::runtime_error("TonemapSweep: unknown option " + axes[a]->option +
+                                     " for " + m_params.getOperatorName());
+        }
+    }
+}
+
+TonemappingParameters TonemapSweep::getParameters(size_t column, size_t row) const
+{
+    TonemappingParameters params(m_params);
+    if ( !m_columns.option.empty() )
+    {
+        params.setOperatorOption(m_columns.option, m_columns.value(column));
+    }
+    if ( !m_rows.option.empty() )
+    {
+        params.setOperatorOption(m_rows.option, m_rows.value(row));
+    }
+    return params;
+}
+
+Frame* TonemapSweep::run(const Frame& input, const ResultHandler& handler, Progress& ph) const
+{
+    utils::TraceSpan span("sweep", m_params.getOperatorName());
+
+    const size_t numVariants = getColumns()*getRows();
+    ph.setMaximum(static_cast<int>(numVariants));
+    ph.setValue(0);
+
+    std::unique_ptr<Frame> prepared(prepareInput(input, m_params));
+    const size_t width = prepared->getWidth();
+    const size_t height = prepared->getHeight();
+
+    // variants differing only in the options of the tail share their stages
+    std::set<std::string> stageOptions;
+    {
+        std::unique_ptr<TonemapOperator> tmo(TonemapOperator::getTonemapOperator(m_params.tmoperator));
+        const std::vector<TonemapOperator::Stage> stages = tmo->getStages();
+        for (size_t s = 0; s < stages.size(); ++s)
+        {
+            stageOptions.insert(stages[s].parameters.begin(), stages[s].parameters.end());
+        }
+    }
+    const bool columnsInStages = stageOptions.count(m_columns.option) > 0;
+    const bool rowsInStages = stageOptions.count(m_rows.option) > 0;
+
+    std::map< std::pair<size_t, size_t>, std::vector<size_t> > groupMap;
+    for (size_t idx = 0; idx < numVariants; ++idx)
+    {
+        const size_t column = idx % getColumns();
+        const size_t row = idx / getColumns();
+        groupMap[std::make_pair(columnsInStages ? column : 0,
+                                rowsInStages ? row : 0)].push_back(idx);
+    }
+    std::vector< std::vector<size_t> > groups;
+    for (std::map< std::pair<size_t, size_t>, std::vector<size_t> >::const_iterator it = groupMap.begin();
+         it != groupMap.end(); ++it)
+    {
+        groups.push_back(it->second);
+    }
+
+    const size_t cellWidth = m_cellWidth;
+    const size_t cellHeight = std::max<size_t>(1, (cellWidth*height + width/2)/std::max<size_t>(1, width));
+    std::unique_ptr<Frame> sheet;
+    if ( cellWidth > 0 )
+    {
+        sheet.reset(createSheet(getColumns(), getRows(), cellWidth, cellHeight));
+    }
+
+    // the variants run on threads of their own, not as tasks of the
+    // executor: a thread waiting for a loop runs the tasks queued by the
+    // others, and a variant picked up there would run on top of the one
+    // waiting, inside its locks (Durand is not reentrant) and its memory
+    // reservation. The first variant of a group is queued before the others,
+    // that wait for it to compute the stages
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque< std::pair<size_t, size_t> > ready;  // group, position
+    for (size_t g = 0; g < groups.size(); ++g)
+    {
+        ready.push_back(std::make_pair(g, size_t(0)));
+    }
+    size_t remaining = numVariants;
+    size_t admitted = 0;
+    std::exception_ptr error;
+    std::mutex handlerMutex;
+    int done = 0;
+
+    auto runVariant = [&](size_t idx)
+    {
+        if ( ph.canceled() ) return;
+
+        const size_t column = idx % getColumns();
+        const size_t row = idx / getColumns();
+        TonemappingParameters params = getParameters(column, row);
+        params.origxsize = static_cast<int>(input.getWidth());
+        params.xsize = static_cast<int>(width);
+        params.tonemapSelection = false;
+
+        // the working copy, and about as much for the operator. The caller
+        // may hold what is left of the budget: a variant waits for the
+        // others of the sweep to finish, and runs anyway when none is running
+        utils::MemoryReservation reservation;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            while ( !reservation.tryReserve(utils::frameMemorySize(width, height)*2) &&
+                    admitted > 0 )
+            {
+                changed.wait_for(lock, MEMORY_POLL);
+            }
+            ++admitted;
+        }
+        struct Admitted
+        {
+            std::mutex& mutex_;
+            std::condition_variable& changed_;
+            size_t& admitted_;
+            utils::MemoryReservation& reservation_;
+            ~Admitted()
+            {
+                reservation_.release();
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    --admitted_;
+                }
+                changed_.notify_all();
+            }
+        } admittedGuard = { mutex, changed, admitted, reservation };
+
+        std::unique_ptr<Frame> working(copy(prepared.get()));
+        Progress variantProgress;
+        std::unique_ptr<TonemapOperator> tmo(TonemapOperator::getTonemapOperator(params.tmoperator));
+        tmo->tonemapFrame(*working, &params, variantProgress);
+
+        if ( sheet )
+        {
+            placeInSheet(*sheet, column, row, cellWidth, cellHeight, *working);
+        }
+
+        std::lock_guard<std::mutex> lock(handlerMutex);
+        if ( handler )
+        {
+            handler(column, row, params, *working);
+        }
+        ph.setValue(++done);
+    };
+
+    auto worker = [&]()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;)
+        {
+            changed.wait(lock, [&]() { return !ready.empty() || remaining == 0 || error; });
+            if ( remaining == 0 || error ) return;
+
+            const std::pair<size_t, size_t> next = ready.front();
+            ready.pop_front();
+            lock.unlock();
+
+            std::exception_ptr failure;
+            try
+            {
+                runVariant(groups[next.first][next.second]);
+            }
+            catch (...)
+            {
+                failure = std::current_exception();
+            }
+
+            lock.lock();
+            if ( failure && !error )
+            {
+                error = failure;
+            }
+            if ( next.second == 0 )
+            {
+                for (size_t v = 1; v < groups[next.first].size(); ++v)
+                {
+                    ready.push_back(std::make_pair(next.first, v));
+                }
+            }
+            --remaining;
+            changed.notify_all();
+        }
+    };
+
+    // the loops of the operators go to the executor of the caller
+    const utils::ExecutorPtr executor = utils::executor();
+    const size_t numThreads = std::min(std::max<size_t>(utils::concurrency(), 1), numVariants);
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < numThreads; ++t)
+    {
+        threads.push_back(std::thread([&]()
+        {
+            utils::ScopedExecutor scoped(executor);
+            worker();
+        }));
+    }
+    worker();
+    for (size_t t = 0; t < threads.size(); ++t)
+    {
+        threads[t].join();
+    }
+
+    if ( error )
+    {
+        std::rethrow_exception(error);
+    }
+    if ( ph.canceled() )
+    {
+        return NULL;
+    }
+    return sheet.release();
+}
+
+}
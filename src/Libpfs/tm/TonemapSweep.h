@@ -0,0 +1,112 @@
+/**
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ *
+ * Tone mapping of a grid of parameter values, with a contact sheet
+ *
+ */
+
+#ifndef TONEMAPSWEEP_H
+#define TONEMAPSWEEP_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+#include "Libpfs/tm/TonemappingParameters.h"
+
+namespace pfs
+{
+class Frame;
+class Progress;
+
+//! \brief values taken by one option of the operator in a sweep
+struct SweepAxis
+{
+    //! \brief no option: a single step, with the value of the parameters
+    SweepAxis();
+    //! \brief \a steps values evenly spaced from \a first to \a last
+    SweepAxis(const std::string& option, float first, float last, size_t steps);
+
+    //! \brief value of the step \a i
+    float value(size_t i) const;
+
+    std::string option;     //!< see TonemappingParameters::setOperatorOption()
+    float first;
+    float last;
+    size_t steps;
+};
+
+//! \brief tone maps an HDR with every combination of the values of one or
+//! two options of an operator
+//!
+//! The HDR is resized and gamma corrected once, as TMWorker does for a
+//! single run. The variants run in parallel, grouped by the values of the
+//! options the stages of the operator depend on (TonemapOperator::getStages()):
+//! the first variant of a group computes the stages, the others find them
+//! in tonemapStageCache(). The results are handed out as soon as they are
+//! ready and are not kept, so a large sweep never holds more than a frame
+//! for each thread; a contact sheet with the variants downscaled in a grid
+//! can be built along the way.
+class TonemapSweep
+{
+public:
+    //! \brief called with every variant, one call at a time, on the threads
+    //! of the sweep. \a result is freed (and can be changed) after the call
+    typedef std::function<void (size_t column, size_t row,
+                                const TonemappingParameters& params,
+                                Frame& result)> ResultHandler;
+
+    //! \param params operator, options not swept, pregamma, xsize and fastMath
+    //! \param columns option changing from a column of the grid to the next
+    //! \param rows option changing from a row of the grid to the next
+    //! \throw std::runtime_error if the operator has no option of an axis,
+    //! or an axis has no steps
+    TonemapSweep(const TonemappingParameters& params,
+                 const SweepAxis& columns, const SweepAxis& rows = SweepAxis());
+
+    size_t getColumns() const               { return m_columns.steps; }
+    size_t getRows() const                  { return m_rows.steps; }
+    const SweepAxis& getColumnAxis() const  { return m_columns; }
+    const SweepAxis& getRowAxis() const     { return m_rows; }
+
+    //! \brief parameters of the variant in \a column, \a row
+    TonemappingParameters getParameters(size_t column, size_t row) const;
+
+    //! \brief width of the cells of the contact sheet: 0 (the default) for
+    //! no sheet
+    void setSheetCellWidth(size_t width)    { m_cellWidth = width; }
+    size_t getSheetCellWidth() const        { return m_cellWidth; }
+
+    //! \brief tone map all the variants of \a input
+    //! \param ph its maximum is the number of variants, and its value the
+    //! variants done. Canceling it skips the variants not started yet
+    //! \return the contact sheet, owned by the caller: NULL without cells,
+    //! or when \a ph is canceled
+    Frame* run(const Frame& input, const ResultHandler& handler, Progress& ph) const;
+
+private:
+    TonemappingParameters m_params;
+    SweepAxis m_columns;
+    SweepAxis m_rows;
+    size_t m_cellWidth;
+};
+
+}
+
+#endif // TONEMAPSWEEP_H
@@ -0,0 +1,259 @@
+/**
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2011 Davide Anastasia
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ *
+ * Tone mapping parameters, split from TonemappingOptions
+ *
+ */
+
+#include <climits>
+#include <cmath>
+
+#include "Libpfs/tm/TonemappingParameters.h"
+#include "TonemappingOperators/pfstmdefaultparams.h"
+
+void TonemappingParameters::setDefaultTonemapParameters()
+{
+    // Mantiuk06
+    operator_options.mantiuk06options.contrastfactor = MANTIUK06_CONTRAST_FACTOR;
+    operator_options.mantiuk06options.saturationfactor = MANTIUK06_SATURATION_FACTOR;
+    operator_options.mantiuk06options.detailfactor = MANTIUK06_DETAIL_FACTOR;
+    operator_options.mantiuk06options.contrastequalization = MANTIUK06_CONTRAST_EQUALIZATION;
+
+    // Mantiuk08
+    operator_options.mantiuk08options.colorsaturation = MANTIUK08_COLOR_SATURATION;
+    operator_options.mantiuk08options.contrastenhancement = MANTIUK08_CONTRAST_ENHANCEMENT;
+    operator_options.mantiuk08options.luminancelevel = MANTIUK08_LUMINANCE_LEVEL;
+    operator_options.mantiuk08options.setluminance = MANTIUK08_SET_LUMINANCE;
+
+    // Fattal
+    operator_options.fattaloptions.alpha = FATTAL02_ALPHA;
+    operator_options.fattaloptions.beta = FATTAL02_BETA;
+    operator_options.fattaloptions.color = FATTAL02_COLOR;
+    operator_options.fattaloptions.noiseredux = FATTAL02_NOISE_REDUX;
+    operator_options.fattaloptions.newfattal = FATTAL02_NEWFATTAL;
+    operator_options.fattaloptions.fftsolver = true;
+
+    // Ferradans
+    operator_options.ferradansoptions.rho = FERRADANS11_RHO;
+    operator_options.ferradansoptions.inv_alpha = FERRADANS11_INV_ALPHA;
+
+    // Drago
+    operator_options.dragooptions.bias = DRAGO03_BIAS;
+
+    // Durand
+    operator_options.durandoptions.spatial = DURAND02_SPATIAL;
+    operator_options.durandoptions.range = DURAND02_RANGE;
+    operator_options.durandoptions.base = DURAND02_BASE;
+
+    // Reinhard 02
+    operator_options.reinhard02options.scales = REINHARD02_SCALES;
+    operator_options.reinhard02options.key = REINHARD02_KEY;
+    operator_options.reinhard02options.phi = REINHARD02_PHI;
+    operator_options.reinhard02options.range = REINHARD02_RANGE;
+    operator_options.reinhard02options.lower = REINHARD02_LOWER;
+    operator_options.reinhard02options.upper = REINHARD02_UPPER;
+
+    // Reinhard 05
+    operator_options.reinhard05options.brightness = REINHARD05_BRIGHTNESS;
+    operator_options.reinhard05options.chromaticAdaptation = REINHARD05_CHROMATIC_ADAPTATION;
+    operator_options.reinhard05options.lightAdaptation = REINHARD05_LIGHT_ADAPTATION;
+
+    // Ashikhmin
+    operator_options.ashikhminoptions.simple = ASHIKHMIN_SIMPLE;
+    operator_options.ashikhminoptions.eq2 = ASHIKHMIN_EQ2;
+    operator_options.ashikhminoptions.lct = ASHIKHMIN_LCT;
+
+    // Pattanaik
+    operator_options.pattanaikoptions.autolum = PATTANAIK00_AUTOLUM;
+    operator_options.pattanaikoptions.local = PATTANAIK00_LOCAL;
+    operator_options.pattanaikoptions.cone = PATTANAIK00_CONE;
+    operator_options.pattanaikoptions.rod = PATTANAIK00_ROD;
+    operator_options.pattanaikoptions.multiplier = PATTANAIK00_MULTIPLIER;
+}
+
+void TonemappingParameters::setDefaultParameters()
+{
+    // TM Defaults
+    setDefaultTonemapParameters();
+
+    origxsize = INT_MAX;
+    xsize = INT_MAX;
+    xsize_percent = 100;
+    quality = 100;
+    pregamma = 1.0f;
+    tonemapSelection = false;
+    fastMath = false;
+    tmoperator = mantiuk06;
+
+    selection_x_up_left = 0;
+    selection_y_up_left = 0;
+    selection_x_bottom_right = INT_MAX;
+    selection_y_bottom_right = INT_MAX;
+}
+
+char TonemappingParameters::getRatingForOperator()
+{
+    switch (tmoperator) {
+    case ashikhmin:
+        return 'H';
+    case drago:
+        return 'G';
+    case durand:
+        return 'F';
+    case fattal:
+        return 'B';
+    case mantiuk06:
+        return 'A';
+    case mantiuk08:
+        return 'C';
+    case pattanaik:
+        return 'I';
+    case reinhard02:
+        return 'E';
+    case reinhard05:
+        return 'D';
+    case ferradans:
+        return 'J';
+    case mai:
+        return 'K';
+    }
+    return ' ';
+}
+
+const char* TonemappingParameters::getOperatorName() const
+{
+    switch (tmoperator) {
+    case ashikhmin:
+        return "ashikhmin";
+    case drago:
+        return "drago";
+    case durand:
+        return "durand";
+    case fattal:
+        return "fattal";
+    case mantiuk06:
+        return "mantiuk06";
+    case mantiuk08:
+        return "mantiuk08";
+    case pattanaik:
+        return "pattanaik";
+    case reinhard02:
+        return "reinhard02";
+    case reinhard05:
+        return "reinhard05";
+    case ferradans:
+        return "ferradans";
+    case mai:
+        return "mai";
+    }
+    return "";
+}
+
+namespace
+{
+bool setOption(float& option, float value)
+{
+    option = value;
+    return true;
+}
+
+bool setOption(int& option, float value)
+{
+    option = static_cast<int>(std::floor(value + 0.5f));
+    return true;
+}
+
+bool setOption(bool& option, float value)
+{
+    option = (value != 0.f);
+    return true;
+}
+}
+
+bool TonemappingParameters::setOperatorOption(const std::string& name, float value)
+{
+#define TM_OPTION(options, field) \
+    if ( name == #field ) return setOption(operator_options.options.field, value)
+
+    switch (tmoperator) {
+    case ashikhmin:
+        TM_OPTION(ashikhminoptions, simple);
+        TM_OPTION(ashikhminoptions, eq2);
+        TM_OPTION(ashikhminoptions, lct);
+        break;
+    case drago:
+        TM_OPTION(dragooptions, bias);
+        break;
+    case durand:
+        TM_OPTION(durandoptions, spatial);
+        TM_OPTION(durandoptions, range);
+        TM_OPTION(durandoptions, base);
+        break;
+    case fattal:
+        TM_OPTION(fattaloptions, alpha);
+        TM_OPTION(fattaloptions, beta);
+        TM_OPTION(fattaloptions, color);
+        TM_OPTION(fattaloptions, noiseredux);
+        TM_OPTION(fattaloptions, newfattal);
+        TM_OPTION(fattaloptions, fftsolver);
+        break;
+    case ferradans:
+        TM_OPTION(ferradansoptions, rho);
+        TM_OPTION(ferradansoptions, inv_alpha);
+        break;
+    case mantiuk06:
+        TM_OPTION(mantiuk06options, contrastfactor);
+        TM_OPTION(mantiuk06options, saturationfactor);
+        TM_OPTION(mantiuk06options, detailfactor);
+        TM_OPTION(mantiuk06options, contrastequalization);
+        break;
+    case mantiuk08:
+        TM_OPTION(mantiuk08options, colorsaturation);
+        TM_OPTION(mantiuk08options, contrastenhancement);
+        TM_OPTION(mantiuk08options, luminancelevel);
+        TM_OPTION(mantiuk08options, setluminance);
+        break;
+    case pattanaik:
+        TM_OPTION(pattanaikoptions, autolum);
+        TM_OPTION(pattanaikoptions, local);
+        TM_OPTION(pattanaikoptions, cone);
+        TM_OPTION(pattanaikoptions, rod);
+        TM_OPTION(pattanaikoptions, multiplier);
+        break;
+    case reinhard02:
+        TM_OPTION(reinhard02options, scales);
+        TM_OPTION(reinhard02options, key);
+        TM_OPTION(reinhard02options, phi);
+        TM_OPTION(reinhard02options, range);
+        TM_OPTION(reinhard02options, lower);
+        TM_OPTION(reinhard02options, upper);
+        break;
+    case reinhard05:
+        TM_OPTION(reinhard05options, brightness);
+        TM_OPTION(reinhard05options, chromaticAdaptation);
+        TM_OPTION(reinhard05options, lightAdaptation);
+        break;
+    case mai:
+        break;
+    }
+    return false;
+
+#undef TM_OPTION
+}
@@ -0,0 +1,159 @@
+/*
+* This file is a part of Luminance HDR package.
+* ----------------------------------------------------------------------
+*
+*  This library is free software; you can redistribute it and/or
+*  modify it under the terms of the GNU Lesser General Public
+*  License as published by the Free Software Foundation; either
+*  version 2.1 of the License, or (at your option) any later version.
+*
+*  This library is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*  Lesser General Public License for more details.
+*
+*  You should have received a copy of the GNU Lesser General Public
+*  License along with this library; if not, write to the Free Software
+*  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+* ----------------------------------------------------------------------
+*/
+
+
+//! \brief Instruction set detection for the dispatched kernels
+
+#include <Libpfs/utils/cpu.h>
+
+#include <cctype>
+#include <cstdlib>
+#include <iostream>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <immintrin.h>
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#endif
+
+namespace pfs {
+namespace utils {
+
+namespace
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+CpuLevel detect()
+{
+    int info[4];
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+
+    __cpuid(info, 1);
+    if ( !(info[3] & (1 << 26)) ) return CPU_GENERIC;     // SSE2
+
+    // AVX registers must be saved by the OS (OSXSAVE and XCR0)
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool fma = (info[2] & (1 << 12)) != 0;
+    const bool f16c = (info[2] & (1 << 29)) != 0;
+    if ( !osxsave || maxLeaf < 7 ) return CPU_SSE2;
+
+    const unsigned long long xcr0 = _xgetbv(0);
+    if ( (xcr0 & 0x6) != 0x6 ) return CPU_SSE2;
+
+    __cpuidex(info, 7, 0);
+    const bool avx2 = (info[1] & (1 << 5)) != 0;
+    const bool avx512f = (info[1] & (1 << 16)) != 0;
+    if ( !avx2 || !fma || !f16c ) return CPU_SSE2;
+
+    if ( avx512f && (xcr0 & 0xe6) == 0xe6 ) return CPU_AVX512;
+    return CPU_AVX2;
+}
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+CpuLevel detect()
+{
+    // the builtins check the OS support of the AVX registers as well
+    __builtin_cpu_init();
+    if ( !__builtin_cpu_supports("sse2") ) return CPU_GENERIC;
+    if ( !__builtin_cpu_supports("avx2") || !__builtin_cpu_supports("fma") ) return CPU_SSE2;
+
+    // every AVX2 processor has F16C: older compilers cannot ask the builtin
+    unsigned int eax, ebx, ecx, edx;
+    if ( !__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_F16C) ) return CPU_SSE2;
+    if ( !__builtin_cpu_supports("avx512f") ) return CPU_AVX2;
+    return CPU_AVX512;
+}
+#else
+CpuLevel detect()
+{
+    return CPU_GENERIC;
+}
+#endif
+
+CpuLevel selectCpuLevel()
+{
+    CpuLevel level = detectCpuLevel();
+
+    const char* env = std::getenv("LUMINANCE_CPU_LEVEL");
+    if ( env == NULL ) return level;
+
+    CpuLevel requested;
+    if ( !parseCpuLevel(env, requested) )
+    {
+        std::cerr << "LUMINANCE_CPU_LEVEL: unknown level \"" << env << "\"" << std::endl;
+        return level;
+    }
+    if ( requested > level )
+    {
+        std::cerr << "LUMINANCE_CPU_LEVEL: " << env
+                  << " is not supported by this processor, using "
+                  << cpuLevelName(level) << std::endl;
+        return level;
+    }
+    return requested;
+}
+}
+
+CpuLevel detectCpuLevel()
+{
+    static const CpuLevel s_detected = detect();
+    return s_detected;
+}
+
+CpuLevel cpuLevel()
+{
+    static const CpuLevel s_level = selectCpuLevel();
+    return s_level;
+}
+
+const char* cpuLevelName(CpuLevel level)
+{
+    switch (level)
+    {
+    case CPU_SSE2: return "sse2";
+    case CPU_AVX2: return "avx2";
+    case CPU_AVX512: return "avx512";
+    case CPU_GENERIC:
+    default: return "generic";
+    }
+}
+
+bool parseCpuLevel(const std::string& name, CpuLevel& level)
+{
+    std::string lower(name);
+    for (std::string::iterator it = lower.begin(); it != lower.end(); ++it)
+    {
+        *it = static_cast<char>(std::tolower(static_cast<unsigned char>(*it)));
+    }
+
+    const CpuLevel levels[] = { CPU_GENERIC, CPU_SSE2, CPU_AVX2, CPU_AVX512 };
+    for (size_t idx = 0; idx < sizeof(levels)/sizeof(levels[0]); ++idx)
+    {
+        if ( lower == cpuLevelName(levels[idx]) )
+        {
+            level = levels[idx];
+            return true;
+        }
+    }
+    return false;
+}
+
+}   // utils
+}   // pfs
@@ -0,0 +1,63 @@
+/*
+* This file is a part of Luminance HDR package.
+* ----------------------------------------------------------------------
+*
+*  This library is free software; you can redistribute it and/or
+*  modify it under the terms of the GNU Lesser General Public
+*  License as published by the Free Software Foundation; either
+*  version 2.1 of the License, or (at your option) any later version.
+*
+*  This library is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*  Lesser General Public License for more details.
+*
+*  You should have received a copy of the GNU Lesser General Public
+*  License along with this library; if not, write to the Free Software
+*  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+* ----------------------------------------------------------------------
+*/
+
+
+#ifndef PFS_UTILS_CPU_H
+#define PFS_UTILS_CPU_H
+
+//! \brief Instruction set detection for the dispatched kernels
+//!
+//! The level is detected once, with cpuid, the first time it is needed. The
+//! environment variable LUMINANCE_CPU_LEVEL (generic, sse2, avx2, avx512)
+//! lowers it, so every path can be tested on the same machine: a level
+//! above the one supported by the processor is ignored
+
+#include <string>
+
+namespace pfs {
+namespace utils {
+
+enum CpuLevel
+{
+    CPU_GENERIC = 0,
+    CPU_SSE2 = 1,
+    //! \brief AVX2, FMA and F16C
+    CPU_AVX2 = 2,
+    //! \brief AVX-512 Foundation
+    CPU_AVX512 = 3
+};
+
+//! \brief highest level supported by the processor and enabled by the OS
+CpuLevel detectCpuLevel();
+
+//! \brief level of the dispatched kernels: the detected one, unless
+//! LUMINANCE_CPU_LEVEL asks for a lower one
+CpuLevel cpuLevel();
+
+//! \brief name of \a level, as accepted by LUMINANCE_CPU_LEVEL
+const char* cpuLevelName(CpuLevel level);
+
+//! \brief \c true if \a name is a valid level (case insensitive)
+bool parseCpuLevel(const std::string& name, CpuLevel& level);
+
+}   // utils
+}   // pfs
+
+#endif // PFS_UTILS_CPU_H
@@ -0,0 +1,65 @@
+/*
+* This file is a part of Luminance HDR package.
+* ----------------------------------------------------------------------
+*
+*  This library is free software; you can redistribute it and/or
+*  modify it under the terms of the GNU Lesser General Public
+*  License as published by the Free Software Foundation; either
+*  version 2.1 of the License, or (at your option) any later version.
+*
+*  This library is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*  Lesser General Public License for more details.
+*
+*  You should have received a copy of the GNU Lesser General Public
+*  License along with this library; if not, write to the Free Software
+*  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+* ----------------------------------------------------------------------
+*/
+
+
+#include <Libpfs/utils/dotproduct.h>
+
+#include <algorithm>
+
+#include <Libpfs/utils/kernels.h>
+#include <Libpfs/utils/parallel.h>
+
+namespace pfs {
+namespace utils {
+
+template <>
+float dotProduct<float>(const float* v1, const float* v2, size_t N)
+{
+    const Kernels& k = kernels();
+    const size_t numBlocks = (N + KERNELS_BLOCK_SIZE - 1)/KERNELS_BLOCK_SIZE;
+
+    const double dotProd = parallelSum<double>(numBlocks,
+                                               [&](size_t block)
+    {
+        const size_t offset = block*KERNELS_BLOCK_SIZE;
+        return k.dotProduct(v1 + offset, v2 + offset,
+                            std::min(KERNELS_BLOCK_SIZE, N - offset));
+    });
+    return static_cast<float>(dotProd);
+}
+
+template <>
+float dotProduct<float>(const float* v1, size_t N)
+{
+    const Kernels& k = kernels();
+    const size_t numBlocks = (N + KERNELS_BLOCK_SIZE - 1)/KERNELS_BLOCK_SIZE;
+
+    const double dotProd = parallelSum<double>(numBlocks,
+                                               [&](size_t block)
+    {
+        const size_t offset = block*KERNELS_BLOCK_SIZE;
+        return k.sumOfSquares(v1 + offset,
+                              std::min(KERNELS_BLOCK_SIZE, N - offset));
+    });
+    return static_cast<float>(dotProd);
+}
+
+}   // utils
+}   // pfs
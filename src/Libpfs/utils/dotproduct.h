@@ -46,6 +46,13 @@ _Type dotProduct(const _Type* v1, const _Type* v2, size_t N);
 template <typename _Type>
 _Type dotProduct(const _Type* v1, size_t N);
 
+//! \brief float versions run the vector kernel of the processor (still
+//! accumulated in double precision)
+template <>
+float dotProduct<float>(const float* v1, const float* v2, size_t N);
+template <>
+float dotProduct<float>(const float* v1, size_t N);
+
 }   // utils
 }   // pfs
 
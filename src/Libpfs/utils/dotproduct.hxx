@@ -26,30 +26,48 @@
 
 #include <Libpfs/utils/dotproduct.h>
 
+#include <algorithm>
+
+#include <Libpfs/utils/parallel.h>
+
 namespace pfs {
 namespace utils {
 
 template <typename _Type>
 _Type dotProduct(const _Type* v1, const _Type* v2, size_t N)
 {
-    double dotProd = _Type();
-#pragma omp parallel for reduction(+:dotProd)
-    for (int idx = 0; idx < static_cast<int>(N); idx++)
+    const size_t numBlocks = (N + PARALLEL_SAMPLES_GRAIN - 1)/PARALLEL_SAMPLES_GRAIN;
+
+    const double dotProd = parallelSum<double>(numBlocks,
+                                               [&](size_t block)
     {
-        dotProd = dotProd + (v1[idx] * v2[idx]);
-    }
+        const size_t last = std::min(N, (block + 1)*PARALLEL_SAMPLES_GRAIN);
+        double partial = _Type();
+        for (size_t idx = block*PARALLEL_SAMPLES_GRAIN; idx < last; idx++)
+        {
+            partial = partial + (v1[idx] * v2[idx]);
+        }
+        return partial;
+    });
     return static_cast<_Type>(dotProd);
 }
 
 template <typename _Type>
 _Type dotProduct(const _Type* v1, size_t N)
 {
-    double dotProd = _Type();
-#pragma omp parallel for reduction(+:dotProd)
-    for (int idx = 0; idx < static_cast<int>(N); idx++)
+    const size_t numBlocks = (N + PARALLEL_SAMPLES_GRAIN - 1)/PARALLEL_SAMPLES_GRAIN;
+
+    const double dotProd = parallelSum<double>(numBlocks,
+                                               [&](size_t block)
     {
-        dotProd = dotProd + (v1[idx] * v1[idx]);
-    }
+        const size_t last = std::min(N, (block + 1)*PARALLEL_SAMPLES_GRAIN);
+        double partial = _Type();
+        for (size_t idx = block*PARALLEL_SAMPLES_GRAIN; idx < last; idx++)
+        {
+            partial = partial + (v1[idx] * v1[idx]);
+        }
+        return partial;
+    });
     return static_cast<_Type>(dotProd);
 }
 
@@ -0,0 +1,142 @@
+/*
+* This file is a part of Luminance HDR package.
+* ----------------------------------------------------------------------
+*
+*  This library is free software; you can redistribute it and/or
+*  modify it under the terms of the GNU Lesser General Public
+*  License as published by the Free Software Foundation; either
+*  version 2.1 of the License, or (at your option) any later version.
+*
+*  This library is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*  Lesser General Public License for more details.
+*
+*  You should have received a copy of the GNU Lesser General Public
+*  License along with this library; if not, write to the Free Software
+*  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+* ----------------------------------------------------------------------
+*/
+
+
+//! \brief Fast approximations of the transcendental functions
+
+#include <Libpfs/utils/fastmath.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include <Libpfs/utils/kernels.h>
+#include <Libpfs/utils/parallel.h>
+
+namespace pfs {
+namespace utils {
+
+namespace
+{
+thread_local MathPrecision s_mathPrecision = MATH_ACCURATE;
+}
+
+MathPrecision mathPrecision()
+{
+    return s_mathPrecision;
+}
+
+void setMathPrecision(MathPrecision precision)
+{
+    s_mathPrecision = precision;
+}
+
+ScopedMathPrecision::ScopedMathPrecision(MathPrecision precision)
+    : m_previous(mathPrecision())
+{
+    setMathPrecision(precision);
+}
+
+ScopedMathPrecision::~ScopedMathPrecision()
+{
+    setMathPrecision(m_previous);
+}
+
+namespace
+{
+//! \brief the fast tier runs the kernel of the processor on blocks of the
+//! input, split among the threads
+typedef void (*FastKernel)(const float* in, float* out, size_t size, float param);
+
+void fastTransform(const float* in, float* out, size_t size,
+                   FastKernel kernel, float param)
+{
+    const size_t numBlocks = (size + KERNELS_BLOCK_SIZE - 1)/KERNELS_BLOCK_SIZE;
+
+    parallelFor(0, numBlocks, 1,
+                [&](size_t first, size_t last)
+    {
+        for (size_t block = first; block < last; ++block)
+        {
+            const size_t offset = block*KERNELS_BLOCK_SIZE;
+            const size_t length = std::min(KERNELS_BLOCK_SIZE, size - offset);
+
+            kernel(in + offset, out + offset, length, param);
+        }
+    });
+}
+
+template <typename Func>
+void accurateTransform(const float* in, float* out, size_t size, Func func)
+{
+    parallelFor(0, size, PARALLEL_SAMPLES_GRAIN,
+                [&](size_t first, size_t last)
+    {
+        for (size_t idx = first; idx < last; ++idx)
+        {
+            out[idx] = func(in[idx]);
+        }
+    });
+}
+
+struct StdPow
+{
+    explicit StdPow(float exponent) : m_exponent(exponent) {}
+    float operator()(float x) const { return std::pow(x, m_exponent); }
+    float m_exponent;
+};
+
+float stdLog(float x) { return std::log(x); }
+float stdLog10(float x) { return std::log10(x); }
+float stdExp(float x) { return std::exp(x); }
+float stdExp10(float x) { return std::pow(10.f, x); }
+}
+
+void vlog(const float* in, float* out, size_t size, MathPrecision p)
+{
+    if ( p == MATH_FAST ) fastTransform(in, out, size, kernels().log2, fastmath::detail::LN2);
+    else accurateTransform(in, out, size, stdLog);
+}
+
+void vlog10(const float* in, float* out, size_t size, MathPrecision p)
+{
+    if ( p == MATH_FAST ) fastTransform(in, out, size, kernels().log2, fastmath::detail::LOG10_2);
+    else accurateTransform(in, out, size, stdLog10);
+}
+
+void vexp(const float* in, float* out, size_t size, MathPrecision p)
+{
+    if ( p == MATH_FAST ) fastTransform(in, out, size, kernels().exp2, fastmath::detail::LOG2_E);
+    else accurateTransform(in, out, size, stdExp);
+}
+
+void vexp10(const float* in, float* out, size_t size, MathPrecision p)
+{
+    if ( p == MATH_FAST ) fastTransform(in, out, size, kernels().exp2, fastmath::detail::LOG2_10);
+    else accurateTransform(in, out, size, stdExp10);
+}
+
+void vpow(const float* in, float exponent, float* out, size_t size, MathPrecision p)
+{
+    if ( p == MATH_FAST ) fastTransform(in, out, size, kernels().pow, exponent);
+    else accurateTransform(in, out, size, StdPow(exponent));
+}
+
+}   // utils
+}   // pfs
@@ -0,0 +1,108 @@
+/*
+* This file is a part of Luminance HDR package.
+* ----------------------------------------------------------------------
+*
+*  This library is free software; you can redistribute it and/or
+*  modify it under the terms of the GNU Lesser General Public
+*  License as published by the Free Software Foundation; either
+*  version 2.1 of the License, or (at your option) any later version.
+*
+*  This library is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*  Lesser General Public License for more details.
+*
+*  You should have received a copy of the GNU Lesser General Public
+*  License along with this library; if not, write to the Free Software
+*  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+* ----------------------------------------------------------------------
+*/
+
+
+#ifndef PFS_UTILS_FASTMATH_H
+#define PFS_UTILS_FASTMATH_H
+
+//! \brief Fast approximations of the transcendental functions used by the
+//! tone mapping operators, with a per-thread accuracy switch
+//!
+//! Two accuracy tiers are available:
+//! \li MATH_ACCURATE: the functions of the standard library
+//! \li MATH_FAST: series and polynomials on the IEEE 754 representation.
+//! Maximum errors, for normal inputs:
+//! log2 1.2e-7 absolute, plus the rounding of the result (half ULP);
+//! log and log10 likewise; log1p 3e-7 relative;
+//! exp2 1.6e-7 relative (2 ULP); exp and exp10 add the rounding of the
+//! scaled argument (1e-5 relative at |x| = 80);
+//! pow(x, y) the error of exp2, plus the one of log2 times |y|.
+//! Zero, denormals and negative inputs are not handled by the fast log
+//! (log2(0) gives -127 instead of -inf); the fast pow returns 0 for x <= 0
+//!
+//! The operators read the tier of the calling thread once, outside their
+//! OpenMP regions, and pass it down to the inner loops
+
+#include <cstddef>
+
+namespace pfs {
+namespace utils {
+
+enum MathPrecision
+{
+    MATH_ACCURATE = 0,
+    MATH_FAST = 1
+};
+
+//! \brief accuracy tier of the calling thread (MATH_ACCURATE by default)
+MathPrecision mathPrecision();
+void setMathPrecision(MathPrecision precision);
+
+//! \brief set the accuracy tier of the calling thread for the lifetime of
+//! the object
+class ScopedMathPrecision
+{
+public:
+    explicit ScopedMathPrecision(MathPrecision precision);
+    ~ScopedMathPrecision();
+
+private:
+    ScopedMathPrecision(const ScopedMathPrecision&);
+    ScopedMathPrecision& operator=(const ScopedMathPrecision&);
+
+    MathPrecision m_previous;
+};
+
+namespace fastmath {
+inline float log2(float x);
+inline float exp2(float x);
+inline float log(float x);
+inline float exp(float x);
+inline float log10(float x);
+//! \brief 10^x
+inline float exp10(float x);
+inline float log1p(float x);
+inline float pow(float x, float y);
+}
+
+//! \brief scalar functions for the tier \a p: the branch is the same for
+//! all the pixels of a loop, so it is almost free
+inline float log(float x, MathPrecision p);
+inline float exp(float x, MathPrecision p);
+inline float log10(float x, MathPrecision p);
+inline float exp10(float x, MathPrecision p);
+inline float log1p(float x, MathPrecision p);
+inline float pow(float x, float y, MathPrecision p);
+
+//! \brief vectorised (and multithreaded) versions, the output can be the
+//! input itself
+void vlog(const float* in, float* out, size_t size, MathPrecision p);
+void vlog10(const float* in, float* out, size_t size, MathPrecision p);
+void vexp(const float* in, float* out, size_t size, MathPrecision p);
+void vexp10(const float* in, float* out, size_t size, MathPrecision p);
+//! \brief out[i] = in[i]^exponent
+void vpow(const float* in, float exponent, float* out, size_t size, MathPrecision p);
+
+}   // utils
+}   // pfs
+
+#include <Libpfs/utils/fastmath.hxx>
+
+#endif // PFS_UTILS_FASTMATH_H
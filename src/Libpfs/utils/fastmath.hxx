@@ -0,0 +1,179 @@
+/*
+* This file is a part of Luminance HDR package.
+* ----------------------------------------------------------------------
+*
+*  This library is free software; you can redistribute it and/or
+*  modify it under the terms of the GNU Lesser General Public
+*  License as published by the Free Software Foundation; either
+*  version 2.1 of the License, or (at your option) any later version.
+*
+*  This library is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*  Lesser General Public License for more details.
+*
+*  You should have received a copy of the GNU Lesser General Public
+*  License along with this library; if not, write to the Free Software
+*  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+* ----------------------------------------------------------------------
+*/
+
+
+#ifndef PFS_UTILS_FASTMATH_HXX
+#define PFS_UTILS_FASTMATH_HXX
+
+#include <Libpfs/utils/fastmath.h>
+
+#include <cmath>
+#include <cstring>
+#include <stdint.h>
+
+namespace pfs {
+namespace utils {
+namespace fastmath {
+
+namespace detail {
+// ln(2), log10(2), log2(e), log2(10)
+const float LN2 = 0.69314718f;
+const float LOG10_2 = 0.30103f;
+const float LOG2_E = 1.44269504f;
+const float LOG2_10 = 3.32192809f;
+
+inline
+uint32_t floatBits(float x)
+{
+    uint32_t i;
+    std::memcpy(&i, &x, sizeof(float));
+    return i;
+}
+
+inline
+float bitsFloat(uint32_t i)
+{
+    float x;
+    std::memcpy(&x, &i, sizeof(float));
+    return x;
+}
+
+//! \brief ln((1 + s)/(1 - s)) = 2*atanh(s): for m in [sqrt(1/2), sqrt(2)),
+//! s = (m - 1)/(m + 1) is below 0.172 and five terms are enough
+inline
+float atanhSeries(float s)
+{
+    const float s2 = s*s;
+    return 2.f*s*(1.f + s2*(1.f/3.f + s2*(1.f/5.f + s2*(1.f/7.f + s2*(1.f/9.f)))));
+}
+
+//! \brief minimax fit of 2^f on [0, 1)
+inline
+float exp2Poly(float f)
+{
+    return ((((1.8775767e-3f*f
+               + 8.9893397e-3f)*f
+              + 5.5826318e-2f)*f
+             + 2.4015361e-1f)*f
+            + 6.9315308e-1f)*f
+            + 9.9999994e-1f;
+}
+}
+
+float log2(float x)
+{
+    const uint32_t i = detail::floatBits(x);
+    float e = static_cast<float>(static_cast<int>((i >> 23) & 0xFF) - 127);
+    float m = detail::bitsFloat((i & 0x007FFFFF) | 0x3F800000);
+
+    // mantissa in [sqrt(1/2), sqrt(2)): log2(1) is exactly 0
+    if ( m > 1.41421356f )
+    {
+        m *= 0.5f;
+        e += 1.f;
+    }
+    return detail::atanhSeries((m - 1.f)/(m + 1.f))*detail::LOG2_E + e;
+}
+
+float exp2(float x)
+{
+    // beyond these bounds the result is not a normal number anymore
+    if ( x < -126.99999f ) x = -126.99999f;
+    if ( x > 128.f ) x = 128.f;
+
+    int ipart = static_cast<int>(x);
+    if ( x < 0.f && static_cast<float>(ipart) != x ) --ipart;   // floor
+    const float fpart = x - static_cast<float>(ipart);
+
+    return detail::bitsFloat(static_cast<uint32_t>(ipart + 127) << 23)*detail::exp2Poly(fpart);
+}
+
+float log(float x)
+{
+    return log2(x)*detail::LN2;
+}
+
+float exp(float x)
+{
+    return exp2(x*detail::LOG2_E);
+}
+
+float log10(float x)
+{
+    return log2(x)*detail::LOG10_2;
+}
+
+float exp10(float x)
+{
+    return exp2(x*detail::LOG2_10);
+}
+
+float log1p(float x)
+{
+    // (u - 1)/(u + 1) with u = 1 + x, without rounding 1 + x
+    if ( x > -0.29289f && x < 0.41421f )
+    {
+        return detail::atanhSeries(x/(2.f + x));
+    }
+    return log(1.f + x);
+}
+
+float pow(float x, float y)
+{
+    if ( x <= 0.f ) return 0.f;
+    return exp2(y*log2(x));
+}
+
+}   // fastmath
+
+float log(float x, MathPrecision p)
+{
+    return (p == MATH_FAST) ? fastmath::log(x) : std::log(x);
+}
+
+float exp(float x, MathPrecision p)
+{
+    return (p == MATH_FAST) ? fastmath::exp(x) : std::exp(x);
+}
+
+float log10(float x, MathPrecision p)
+{
+    return (p == MATH_FAST) ? fastmath::log10(x) : std::log10(x);
+}
+
+float exp10(float x, MathPrecision p)
+{
+    return (p == MATH_FAST) ? fastmath::exp10(x) : std::pow(10.f, x);
+}
+
+float log1p(float x, MathPrecision p)
+{
+    return (p == MATH_FAST) ? fastmath::log1p(x) : std::log1p(x);
+}
+
+float pow(float x, float y, MathPrecision p)
+{
+    return (p == MATH_FAST) ? fastmath::pow(x, y) : std::pow(x, y);
+}
+
+}   // utils
+}   // pfs
+
+#endif // PFS_UTILS_FASTMATH_HXX
@@ -0,0 +1,86 @@
+/*
+* This file is a part of Luminance HDR package.
+* ----------------------------------------------------------------------
+*
+*  This library is free software; you can redistribute it and/or
+*  modify it under the terms of the GNU Lesser General Public
+*  License as published by the Free Software Foundation; either
+*  version 2.1 of the License, or (at your option) any later version.
+*
+*  This library is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*  Lesser General Public License for more details.
+*
+*  You should have received a copy of the GNU Lesser General Public
+*  License along with this library; if not, write to the Free Software
+*  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+* ----------------------------------------------------------------------
+*/
+
+#ifndef PFS_UTILS_FRAMEALLOCATOR_H
+#define PFS_UTILS_FRAMEALLOCATOR_H
+
+//! \brief Allocator of the frame buffers
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include <Libpfs/utils/numa.h>
+
+namespace pfs {
+namespace utils {
+
+//! \brief allocator for the buffers of Array2D: memory comes from
+//! allocateFrameMemory(), so it follows memoryPlacement(), and the samples
+//! of arithmetic type are left uninitialised by the container. The owner
+//! writes them in parallel, so every page is first touched by the thread
+//! that will work on it
+template <typename Type>
+class FrameAllocator
+{
+public:
+    typedef Type value_type;
+
+    FrameAllocator() {}
+    template <typename Other>
+    FrameAllocator(const FrameAllocator<Other>&) {}
+
+    Type* allocate(size_t n)
+    { return static_cast<Type*>(allocateFrameMemory(n*sizeof(Type))); }
+
+    void deallocate(Type* ptr, size_t n)
+    { freeFrameMemory(ptr, n*sizeof(Type)); }
+
+    template <typename Other>
+    void construct(Other* ptr)
+    { defaultConstruct(ptr, std::is_arithmetic<Other>()); }
+
+    template <typename Other, typename... Args>
+    void construct(Other* ptr, Args&&... args)
+    { ::new(static_cast<void*>(ptr)) Other(std::forward<Args>(args)...); }
+
+private:
+    template <typename Other>
+    static void defaultConstruct(Other* ptr, std::true_type)
+    { ::new(static_cast<void*>(ptr)) Other; }
+
+    template <typename Other>
+    static void defaultConstruct(Other* ptr, std::false_type)
+    { ::new(static_cast<void*>(ptr)) Other(); }
+};
+
+template <typename Type, typename Other>
+bool operator==(const FrameAllocator<Type>&, const FrameAllocator<Other>&)
+{ return true; }
+
+template <typename Type, typename Other>
+bool operator!=(const FrameAllocator<Type>&, const FrameAllocator<Other>&)
+{ return false; }
+
+}   // utils
+}   // pfs
+
+#endif // PFS_UTILS_FRAMEALLOCATOR_H
@@ -0,0 +1,156 @@
+/*
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <Libpfs/utils/half.h>
+
+#include <cstring>
+
+#include <Libpfs/utils/kernels.h>
+#include <Libpfs/utils/parallel.h>
+
+namespace pfs {
+namespace utils {
+
+namespace
+{
+inline
+uint32_t floatBits(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+inline
+float bitsFloat(uint32_t bits)
+{
+    float value;
+    std::memcpy(&value, &bits, sizeof(bits));
+    return value;
+}
+}
+
+uint16_t floatToHalf(float value)
+{
+    const uint32_t bits = floatBits(value);
+    const uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+    const uint32_t absBits = bits & 0x7fffffff;
+
+    // Inf or NaN (keep NaN quiet)
+    if ( absBits >= 0x7f800000 )
+    {
+        return sign | 0x7c00 |
+                (absBits > 0x7f800000 ? (0x200 | ((absBits >> 13) & 0x3ff)) : 0);
+    }
+    // rounds to a value bigger than HALF_MAX
+    if ( absBits >= 0x477ff000 )
+    {
+        return sign | 0x7c00;
+    }
+    // normal half
+    if ( absBits >= 0x38800000 )
+    {
+        uint32_t h = (absBits - 0x38000000) >> 13;
+        const uint32_t rem = absBits & 0x1fff;
+        if ( rem > 0x1000 || (rem == 0x1000 && (h & 1)) ) ++h;
+        return sign | static_cast<uint16_t>(h);
+    }
+    // below half of the smallest subnormal
+    if ( absBits <= 0x33000000 )
+    {
+        return sign;
+    }
+    // subnormal half
+    const uint32_t exponent = absBits >> 23;
+    const uint32_t mantissa = (absBits & 0x7fffff) | 0x800000;
+    const uint32_t shift = 126 - exponent;
+
+    uint32_t h = mantissa >> shift;
+    const uint32_t rem = mantissa & ((1u << shift) - 1);
+    const uint32_t halfway = 1u << (shift - 1);
+    if ( rem > halfway || (rem == halfway && (h & 1)) ) ++h;
+
+    return sign | static_cast<uint16_t>(h);
+}
+
+uint16_t floatToHalfSaturate(float value)
+{
+    // on the bits: with -ffast-math the comparisons of floats may not keep
+    // NaN apart
+    const uint32_t bits = floatBits(value);
+    const uint32_t absBits = bits & 0x7fffffff;
+    if ( absBits > 0x477fe000 && absBits <= 0x7f800000 )
+    {
+        return static_cast<uint16_t>((bits >> 16) & 0x8000) | 0x7bff;
+    }
+    return floatToHalf(value);
+}
+
+float halfToFloat(uint16_t value)
+{
+    const uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+    uint32_t exponent = (value >> 10) & 0x1f;
+    uint32_t mantissa = value & 0x3ff;
+
+    if ( exponent == 0 )
+    {
+        if ( mantissa == 0 )
+        {
+            return bitsFloat(sign);
+        }
+        // subnormal: normalise it
+        exponent = 113;
+        while ( !(mantissa & 0x400) )
+        {
+            mantissa <<= 1;
+            --exponent;
+        }
+        mantissa &= 0x3ff;
+        return bitsFloat(sign | (exponent << 23) | (mantissa << 13));
+    }
+    if ( exponent == 31 )
+    {
+        return bitsFloat(sign | 0x7f800000 | (mantissa << 13));
+    }
+    return bitsFloat(sign | ((exponent + 112) << 23) | (mantissa << 13));
+}
+
+void floatToHalf(const float* in, uint16_t* out, size_t size)
+{
+    const Kernels& k = kernels();
+    parallelFor(0, size, PARALLEL_SAMPLES_GRAIN,
+                [&](size_t first, size_t last)
+    {
+        k.floatToHalf(in + first, out + first, last - first);
+    });
+}
+
+void halfToFloat(const uint16_t* in, float* out, size_t size)
+{
+    const Kernels& k = kernels();
+    parallelFor(0, size, PARALLEL_SAMPLES_GRAIN,
+                [&](size_t first, size_t last)
+    {
+        k.halfToFloat(in + first, out + first, last - first);
+    });
+}
+
+}   // utils
+}   // pfs
@@ -0,0 +1,58 @@
+/*
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#ifndef PFS_UTILS_HALF_H
+#define PFS_UTILS_HALF_H
+
+//! \brief Conversion between 32 bit floats and IEEE 754 binary16 (half)
+
+#include <cstddef>
+#include <stdint.h>
+
+namespace pfs {
+namespace utils {
+
+//! \brief largest finite value representable by a half
+const float HALF_MAX = 65504.f;
+
+//! \brief convert \a value to half, rounding to nearest even
+//! \note values outside of the half range become infinity
+uint16_t floatToHalf(float value);
+
+//! \brief convert \a value to half, rounding to nearest even: values
+//! outside [-HALF_MAX, HALF_MAX] are saturated, NaN stays NaN
+uint16_t floatToHalfSaturate(float value);
+
+//! \brief convert the half \a value to float (exact)
+float halfToFloat(uint16_t value);
+
+//! \brief convert \a size floats into halves, as floatToHalfSaturate(), so
+//! that no finite pixel is turned into an infinity.
+//! \note runs the F16C instructions of the dispatched kernels (see
+//! kernels.h) when the processor has them
+void floatToHalf(const float* in, uint16_t* out, size_t size);
+
+//! \brief convert \a size halves into floats (exact)
+void halfToFloat(const uint16_t* in, float* out, size_t size);
+
+}   // utils
+}   // pfs
+
+#endif // PFS_UTILS_HALF_H
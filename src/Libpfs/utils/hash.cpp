@@ -0,0 +1,243 @@
+/*
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <Libpfs/utils/hash.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <Libpfs/frame.h>
+#include <Libpfs/utils/parallel.h>
+#include <Libpfs/utils/trace.h>
+
+namespace pfs {
+namespace utils {
+
+namespace
+{
+const uint64_t PRIME1 = 0x9E3779B185EBCA87ULL;
+const uint64_t PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+const uint64_t PRIME3 = 0x165667B19E3779F9ULL;
+const uint64_t PRIME4 = 0x85EBCA77C2B2AE63ULL;
+
+const size_t STRIPE = 32;
+//! \brief bytes hashed by a task: large enough to hide the cost of the task
+const size_t BLOCK_BYTES = 256*1024;
+
+inline uint64_t rotl(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+inline uint64_t hashRound(uint64_t acc, uint64_t value)
+{
+    return rotl(acc + value*PRIME2, 31)*PRIME1;
+}
+
+inline uint64_t merge(uint64_t acc, uint64_t lane)
+{
+    return (acc ^ hashRound(0, lane))*PRIME1 + PRIME4;
+}
+
+inline uint64_t avalanche(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= PRIME2;
+    h ^= h >> 29;
+    h *= PRIME3;
+    return h ^ (h >> 32);
+}
+
+inline uint64_t load64(const unsigned char* p)
+{
+    uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+}
+
+std::string Hash128::toString() const
+{
+    char str[33];
+    std::snprintf(str, sizeof(str), "%016llx%016llx",
+                  static_cast<unsigned long long>(high),
+                  static_cast<unsigned long long>(low));
+    return str;
+}
+
+Hasher::Hasher(uint64_t seed)
+    : m_length(0)
+{
+    m_lanes[0] = seed + PRIME1 + PRIME2;
+    m_lanes[1] = seed + PRIME2;
+    m_lanes[2] = seed;
+    m_lanes[3] = seed - PRIME1;
+}
+
+void Hasher::update(const void* data, size_t size)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    const size_t stripes = size/STRIPE;
+
+    // the lanes in locals: the compiler keeps them in registers
+    uint64_t l0 = m_lanes[0];
+    uint64_t l1 = m_lanes[1];
+    uint64_t l2 = m_lanes[2];
+    uint64_t l3 = m_lanes[3];
+    for (size_t s = 0; s < stripes; ++s)
+    {
+        const unsigned char* p = bytes + s*STRIPE;
+        l0 = hashRound(l0, load64(p));
+        l1 = hashRound(l1, load64(p + 8));
+        l2 = hashRound(l2, load64(p + 16));
+        l3 = hashRound(l3, load64(p + 24));
+    }
+
+    // the tail, padded with zeros, and the size close the buffer
+    const size_t tail = size - stripes*STRIPE;
+    if ( tail )
+    {
+        unsigned char last[STRIPE] = { 0 };
+        std::memcpy(last, bytes + stripes*STRIPE, tail);
+        l0 = hashRound(l0, load64(last));
+        l1 = hashRound(l1, load64(last + 8));
+        l2 = hashRound(l2, load64(last + 16));
+        l3 = hashRound(l3, load64(last + 24));
+    }
+    l0 = hashRound(l0, size);
+
+    m_lanes[0] = l0;
+    m_lanes[1] = l1;
+    m_lanes[2] = l2;
+    m_lanes[3] = l3;
+    m_length += size;
+}
+
+void Hasher::update(uint64_t value)
+{
+    m_lanes[m_length % 4] = hashRound(m_lanes[m_length % 4], value);
+    m_length += sizeof(value);
+}
+
+void Hasher::update(const Hash128& value)
+{
+    update(value.low);
+    update(value.high);
+}
+
+void Hasher::update(const std::string& str)
+{
+    update(str.data(), str.size());
+}
+
+Hash128 Hasher::digest() const
+{
+    uint64_t h = rotl(m_lanes[0], 1) + rotl(m_lanes[1], 7) +
+            rotl(m_lanes[2], 12) + rotl(m_lanes[3], 18);
+    for (int i = 0; i < 4; ++i)
+    {
+        h = merge(h, m_lanes[i]);
+    }
+    h += m_length;
+
+    // the second half mixes the lanes in another order
+    uint64_t g = rotl(m_lanes[3], 3) ^ rotl(m_lanes[2], 17) ^
+            rotl(m_lanes[1], 29) ^ rotl(m_lanes[0], 41);
+    for (int i = 3; i >= 0; --i)
+    {
+        g = merge(g, m_lanes[i] ^ h);
+    }
+
+    return Hash128(avalanche(h), avalanche(g ^ PRIME3));
+}
+
+Hash128 hashBytes(const void* data, size_t size, uint64_t seed)
+{
+    Hasher hasher(seed);
+    hasher.update(data, size);
+    return hasher.digest();
+}
+
+namespace
+{
+//! \brief where the frame was read from is not part of its content
+const char FILE_NAME_TAG[] = "FILE_NAME";
+
+void hashTags(Hasher& hasher, const TagContainer& tags)
+{
+    for (TagContainer::const_iterator it = tags.begin(); it != tags.end(); ++it)
+    {
+        if ( it->first == FILE_NAME_TAG ) continue;
+
+        hasher.update(it->first);
+        hasher.update(it->second);
+    }
+}
+}
+
+Hash128 hashFrame(const Frame& frame)
+{
+    TraceSpan span("hash");
+
+    const size_t width = frame.getWidth();
+    const size_t height = frame.getHeight();
+    const ChannelContainer& channels = frame.getChannels();
+
+    // the blocks only depend on the size of the frame, never on the threads
+    const size_t blockRows = std::max<size_t>(1, BLOCK_BYTES/(std::max<size_t>(1, width)*sizeof(float)));
+    const size_t numBlocks = (height + blockRows - 1)/blockRows;
+
+    std::vector<Hash128> blocks(channels.size()*numBlocks);
+    parallelFor(0, blocks.size(), 1,
+                [&](size_t begin, size_t end)
+    {
+        for (size_t idx = begin; idx < end; ++idx)
+        {
+            const Channel* ch = channels[idx/numBlocks];
+            const size_t row = (idx % numBlocks)*blockRows;
+            const size_t rows = std::min(blockRows, height - row);
+
+            blocks[idx] = hashBytes(ch->data() + row*width,
+                                    rows*width*sizeof(float), idx % numBlocks);
+        }
+    });
+
+    Hasher hasher;
+    hasher.update(width);
+    hasher.update(height);
+    hashTags(hasher, frame.getTags());
+    for (size_t c = 0; c < channels.size(); ++c)
+    {
+        hasher.update(channels[c]->getName());
+        hashTags(hasher, channels[c]->getTags());
+        for (size_t b = 0; b < numBlocks; ++b)
+        {
+            hasher.update(blocks[c*numBlocks + b]);
+        }
+    }
+
+    traceCount("bytes hashed", width*height*channels.size()*sizeof(float));
+    return hasher.digest();
+}
+
+}   // utils
+}   // pfs
@@ -0,0 +1,100 @@
+/*
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#ifndef PFS_UTILS_HASH_H
+#define PFS_UTILS_HASH_H
+
+//! \brief Fast 128 bit hash of buffers and frames, to identify their content
+//! (cache keys, duplicate detection)
+//!
+//! The hash runs four independent lanes over stripes of 32 bytes (the
+//! rounds of xxHash64), so that the compiler keeps them in vector registers
+//! or in parallel in the pipeline. It is not a cryptographic hash.
+
+#include <cstddef>
+#include <string>
+#include <stdint.h>
+
+namespace pfs {
+class Frame;
+
+namespace utils {
+
+struct Hash128
+{
+    Hash128()
+        : low(0)
+        , high(0)
+    {}
+
+    Hash128(uint64_t l, uint64_t h)
+        : low(l)
+        , high(h)
+    {}
+
+    bool operator==(const Hash128& other) const
+    { return low == other.low && high == other.high; }
+    bool operator!=(const Hash128& other) const
+    { return !(*this == other); }
+    bool operator<(const Hash128& other) const
+    { return high < other.high || (high == other.high && low < other.low); }
+
+    //! \brief 32 hexadecimal digits
+    std::string toString() const;
+
+    uint64_t low;
+    uint64_t high;
+};
+
+//! \brief Hash of a sequence of values and buffers
+//! \note the result depends on how the data is split among the calls to
+//! update(): two buffers hashed one after the other do not give the hash of
+//! their concatenation
+class Hasher
+{
+public:
+    explicit Hasher(uint64_t seed = 0);
+
+    void update(const void* data, size_t size);
+    void update(uint64_t value);
+    void update(const Hash128& value);
+    void update(const std::string& str);
+
+    Hash128 digest() const;
+
+private:
+    uint64_t m_lanes[4];
+    uint64_t m_length;
+};
+
+//! \brief hash of \a size bytes
+Hash128 hashBytes(const void* data, size_t size, uint64_t seed = 0);
+
+//! \brief hash of the size, tags and channels (names, tags and samples) of
+//! \a frame, computed in parallel over blocks of rows. The result does not
+//! depend on the number of threads. The FILE_NAME tag is left out: the
+//! same image read from two files has the same hash
+//! \note Frame::getContentHash() keeps the result on the frame
+Hash128 hashFrame(const Frame& frame);
+
+}   // utils
+}   // pfs
+
+#endif // PFS_UTILS_HASH_H
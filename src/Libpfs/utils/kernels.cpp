@@ -0,0 +1,167 @@
+/*
+* This file is a part of Luminance HDR package.
+* ----------------------------------------------------------------------
+*
+*  This library is free software; you can redistribute it and/or
+*  modify it under the terms of the GNU Lesser General Public
+*  License as published by the Free Software Foundation; either
+*  version 2.1 of the License, or (at your option) any later version.
+*
+*  This library is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*  Lesser General Public License for more details.
+*
+*  You should have received a copy of the GNU Lesser General Public
+*  License along with this library; if not, write to the Free Software
+*  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+* ----------------------------------------------------------------------
+*/
+
+
+//! \brief Generic build of the dispatched kernels, and selection of the
+//! table for the running processor
+
+#include <Libpfs/utils/kernels.h>
+#include <Libpfs/utils/fastmath.h>
+#include <Libpfs/utils/half.h>
+
+namespace pfs {
+namespace utils {
+
+namespace
+{
+double genericDotProduct(const float* v1, const float* v2, size_t size)
+{
+    double dotProd = 0.;
+    for (size_t idx = 0; idx < size; ++idx)
+    {
+        dotProd += static_cast<double>(v1[idx])*v2[idx];
+    }
+    return dotProd;
+}
+
+double genericSumOfSquares(const float* v, size_t size)
+{
+    return genericDotProduct(v, v, size);
+}
+
+void genericVadds(const float* A, float s, const float* B, float* C, size_t size)
+{
+    for (size_t idx = 0; idx < size; ++idx)
+    {
+        C[idx] = A[idx] + s*B[idx];
+    }
+}
+
+void genericMatrix3(const float* m,
+                    const float* in1, const float* in2, const float* in3,
+                    float* out1, float* out2, float* out3, size_t size)
+{
+    for (size_t idx = 0; idx < size; ++idx)
+    {
+        const float i1 = in1[idx];
+        const float i2 = in2[idx];
+        const float i3 = in3[idx];
+
+        out1[idx] = m[0]*i1 + m[1]*i2 + m[2]*i3;
+        out2[idx] = m[3]*i1 + m[4]*i2 + m[5]*i3;
+        out3[idx] = m[6]*i1 + m[7]*i2 + m[8]*i3;
+    }
+}
+
+void genericLog2(const float* in, float* out, size_t size, float scale)
+{
+    for (size_t idx = 0; idx < size; ++idx)
+    {
+        out[idx] = fastmath::log2(in[idx])*scale;
+    }
+}
+
+void genericExp2(const float* in, float* out, size_t size, float scale)
+{
+    for (size_t idx = 0; idx < size; ++idx)
+    {
+        out[idx] = fastmath::exp2(in[idx]*scale);
+    }
+}
+
+void genericPow(const float* in, float* out, size_t size, float exponent)
+{
+    for (size_t idx = 0; idx < size; ++idx)
+    {
+        out[idx] = fastmath::pow(in[idx], exponent);
+    }
+}
+
+void genericFloatToHalf(const float* in, uint16_t* out, size_t size)
+{
+    for (size_t idx = 0; idx < size; ++idx)
+    {
+        out[idx] = floatToHalfSaturate(in[idx]);
+    }
+}
+
+void genericHalfToFloat(const uint16_t* in, float* out, size_t size)
+{
+    for (size_t idx = 0; idx < size; ++idx)
+    {
+        out[idx] = halfToFloat(in[idx]);
+    }
+}
+
+const Kernels* selectKernels()
+{
+    for (int level = cpuLevel(); level > CPU_GENERIC; --level)
+    {
+        const Kernels* k = kernels(static_cast<CpuLevel>(level));
+        if ( k != NULL ) return k;
+    }
+    return detail::genericKernels();
+}
+}
+
+namespace detail
+{
+const Kernels* genericKernels()
+{
+    static const Kernels s_kernels =
+    {
+        CPU_GENERIC,
+        &genericDotProduct,
+        &genericSumOfSquares,
+        &genericVadds,
+        &genericMatrix3,
+        &genericLog2,
+        &genericExp2,
+        &genericPow,
+        &genericFloatToHalf,
+        &genericHalfToFloat
+    };
+    return &s_kernels;
+}
+}
+
+const Kernels* kernels(CpuLevel level)
+{
+    // never touch the code of an instruction set the processor lacks
+    if ( level > detectCpuLevel() ) return NULL;
+
+    switch (level)
+    {
+    case CPU_SSE2: return detail::sse2Kernels();
+    case CPU_AVX2: return detail::avx2Kernels();
+    case CPU_AVX512: return detail::avx512Kernels();
+    case CPU_GENERIC:
+    default: return detail::genericKernels();
+    }
+}
+
+const Kernels& kernels()
+{
+    static const Kernels* s_kernels = selectKernels();
+    return *s_kernels;
+}
+
+}   // utils
+}   // pfs
@@ -0,0 +1,94 @@
+/*
+* This file is a part of Luminance HDR package.
+* ----------------------------------------------------------------------
+*
+*  This library is free software; you can redistribute it and/or
+*  modify it under the terms of the GNU Lesser General Public
+*  License as published by the Free Software Foundation; either
+*  version 2.1 of the License, or (at your option) any later version.
+*
+*  This library is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*  Lesser General Public License for more details.
+*
+*  You should have received a copy of the GNU Lesser General Public
+*  License along with this library; if not, write to the Free Software
+*  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+* ----------------------------------------------------------------------
+*/
+
+
+#ifndef PFS_UTILS_KERNELS_H
+#define PFS_UTILS_KERNELS_H
+
+//! \brief Vector kernels built for several instruction sets, selected at
+//! run time
+//!
+//! Each level lives in its own translation unit (kernels_sse2.cpp,
+//! kernels_avx2.cpp, kernels_avx512.cpp), compiled with the flags of that
+//! instruction set; kernels.cpp holds the generic one and picks the table
+//! for cpuLevel(). The kernels are single threaded: the callers split the
+//! work among the OpenMP threads
+
+#include <cstddef>
+#include <stdint.h>
+
+#include <Libpfs/utils/cpu.h>
+
+namespace pfs {
+namespace utils {
+
+//! \brief samples given to a kernel call by the multithreaded callers:
+//! big enough to hide the call, small enough to balance the threads
+const size_t KERNELS_BLOCK_SIZE = 16384;
+
+struct Kernels
+{
+    CpuLevel level;
+
+    //! \brief sum of v1[i]*v2[i], accumulated in double precision
+    double (*dotProduct)(const float* v1, const float* v2, size_t size);
+    //! \brief sum of v[i]*v[i], accumulated in double precision
+    double (*sumOfSquares)(const float* v, size_t size);
+
+    //! \brief C[i] = A[i] + s*B[i] (C can be A or B)
+    void (*vadds)(const float* A, float s, const float* B, float* C, size_t size);
+
+    //! \brief 3x3 matrix on three planes, row major: the output can be
+    //! the input
+    void (*matrix3)(const float* m,
+                    const float* in1, const float* in2, const float* in3,
+                    float* out1, float* out2, float* out3, size_t size);
+
+    //! \brief out[i] = scale*log2(in[i]), fast math tier
+    void (*log2)(const float* in, float* out, size_t size, float scale);
+    //! \brief out[i] = 2^(scale*in[i]), fast math tier
+    void (*exp2)(const float* in, float* out, size_t size, float scale);
+    //! \brief out[i] = in[i]^exponent (0 for in[i] <= 0), fast math tier
+    void (*pow)(const float* in, float* out, size_t size, float exponent);
+
+    //! \brief out[i] = floatToHalfSaturate(in[i]) (see half.h)
+    void (*floatToHalf)(const float* in, uint16_t* out, size_t size);
+    //! \brief out[i] = halfToFloat(in[i])
+    void (*halfToFloat)(const uint16_t* in, float* out, size_t size);
+};
+
+//! \brief kernels of the level returned by cpuLevel()
+const Kernels& kernels();
+
+//! \brief kernels of \a level, NULL if the compiler could not build them
+const Kernels* kernels(CpuLevel level);
+
+namespace detail
+{
+const Kernels* genericKernels();
+const Kernels* sse2Kernels();
+const Kernels* avx2Kernels();
+const Kernels* avx512Kernels();
+}
+
+}   // utils
+}   // pfs
+
+#endif // PFS_UTILS_KERNELS_H
@@ -0,0 +1,518 @@
+/*
+* This file is a part of Luminance HDR package.
+* ----------------------------------------------------------------------
+*
+*  This library is free software; you can redistribute it and/or
+*  modify it under the terms of the GNU Lesser General Public
+*  License as published by the Free Software Foundation; either
+*  version 2.1 of the License, or (at your option) any later version.
+*
+*  This library is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*  Lesser General Public License for more details.
+*
+*  You should have received a copy of the GNU Lesser General Public
+*  License along with this library; if not, write to the Free Software
+*  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+* ----------------------------------------------------------------------
+*/
+
+
+//! \brief Body of the vector kernels, shared by the instruction sets
+//!
+//! \note this file is only included by kernels_sse2.cpp, kernels_avx2.cpp
+//! and kernels_avx512.cpp, each one compiled with its own flags. Everything
+//! here has internal linkage and no other Libpfs header with inline code is
+//! included: an inline function emitted by one of these translation units
+//! could otherwise be picked by the linker for the whole program, and run
+//! AVX instructions on a processor without them. half.h only declares
+//! functions, so the scalar conversions are safe to call
+
+#ifndef PFS_UTILS_KERNELS_HXX
+#define PFS_UTILS_KERNELS_HXX
+
+#include <Libpfs/utils/kernels.h>
+#include <Libpfs/utils/half.h>
+
+#if defined(__GNUC__) && !defined(__clang__)
+// the AVX-512 header of some GCC releases initialises its "undefined"
+// registers with themselves, and -Wall reports every use
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#include <immintrin.h>
+#pragma GCC diagnostic pop
+#else
+#include <immintrin.h>
+#endif
+
+namespace pfs {
+namespace utils {
+namespace {
+
+const float LOG2_E = 1.44269504088896341f;
+//! \brief bits of HALF_MAX as a float
+const int HALF_MAX_BITS = 0x477fe000;
+
+#if defined(__AVX512F__)
+typedef __m512 vfloat;
+typedef __m512i vint;
+const int VSIZE = 16;
+
+inline vfloat vload(const float* p) { return _mm512_loadu_ps(p); }
+inline void vstore(float* p, vfloat v) { _mm512_storeu_ps(p, v); }
+inline vfloat vset(float v) { return _mm512_set1_ps(v); }
+inline vfloat vadd(vfloat a, vfloat b) { return _mm512_add_ps(a, b); }
+inline vfloat vsub(vfloat a, vfloat b) { return _mm512_sub_ps(a, b); }
+inline vfloat vmul(vfloat a, vfloat b) { return _mm512_mul_ps(a, b); }
+inline vfloat vdiv(vfloat a, vfloat b) { return _mm512_div_ps(a, b); }
+inline vfloat vmin(vfloat a, vfloat b) { return _mm512_min_ps(a, b); }
+inline vfloat vmax(vfloat a, vfloat b) { return _mm512_max_ps(a, b); }
+inline vfloat vfloor(vfloat x) { return _mm512_roundscale_ps(x, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+
+inline vint vbits(vfloat x) { return _mm512_castps_si512(x); }
+inline vfloat vfromBits(vint i) { return _mm512_castsi512_ps(i); }
+inline vint viset(int v) { return _mm512_set1_epi32(v); }
+inline vint viand(vint a, vint b) { return _mm512_and_si512(a, b); }
+inline vint vior(vint a, vint b) { return _mm512_or_si512(a, b); }
+inline vint viadd(vint a, vint b) { return _mm512_add_epi32(a, b); }
+inline vint visub(vint a, vint b) { return _mm512_sub_epi32(a, b); }
+inline vint vexponentBits(vint i) { return _mm512_srli_epi32(i, 23); }
+inline vint vtoExponent(vint i) { return _mm512_slli_epi32(i, 23); }
+inline vfloat vitof(vint i) { return _mm512_cvtepi32_ps(i); }
+inline vint vftoi(vfloat x) { return _mm512_cvttps_epi32(x); }
+
+//! \brief x > t ? a : b
+inline vfloat vselectGreater(vfloat x, vfloat t, vfloat a, vfloat b)
+{ return _mm512_mask_blend_ps(_mm512_cmp_ps_mask(x, t, _CMP_GT_OQ), b, a); }
+//! \brief x > t ? v : 0
+inline vfloat vmaskGreater(vfloat x, vfloat t, vfloat v)
+{ return _mm512_maskz_mov_ps(_mm512_cmp_ps_mask(x, t, _CMP_GT_OQ), v); }
+
+inline double vdotProduct(const float* v1, const float* v2, size_t size, size_t& done)
+{
+    __m512d acc0 = _mm512_setzero_pd();
+    __m512d acc1 = _mm512_setzero_pd();
+    size_t idx = 0;
+    for (; idx + 16 <= size; idx += 16)
+    {
+        acc0 = _mm512_fmadd_pd(_mm512_cvtps_pd(_mm256_loadu_ps(v1 + idx)),
+                               _mm512_cvtps_pd(_mm256_loadu_ps(v2 + idx)), acc0);
+        acc1 = _mm512_fmadd_pd(_mm512_cvtps_pd(_mm256_loadu_ps(v1 + idx + 8)),
+                               _mm512_cvtps_pd(_mm256_loadu_ps(v2 + idx + 8)), acc1);
+    }
+    done = idx;
+    return _mm512_reduce_add_pd(_mm512_add_pd(acc0, acc1));
+}
+
+inline void vfloatToHalf(const float* in, uint16_t* out, size_t size, size_t& done)
+{
+    const __m512i absMask = _mm512_set1_epi32(0x7fffffff);
+    const __m512i infBits = _mm512_set1_epi32(0x7f800000);
+    const __m512i maxBits = _mm512_set1_epi32(HALF_MAX_BITS);
+    size_t idx = 0;
+    for (; idx + 16 <= size; idx += 16)
+    {
+        // saturated on the bits, so NaN (above the bits of infinity) is kept
+        const __m512i bits = _mm512_castps_si512(_mm512_loadu_ps(in + idx));
+        const __m512i absBits = _mm512_and_si512(bits, absMask);
+        const __m512i saturated = _mm512_or_si512(_mm512_andnot_si512(absMask, bits),
+                                                  _mm512_min_epi32(absBits, maxBits));
+        const __m512i value = _mm512_mask_blend_epi32(_mm512_cmpgt_epi32_mask(absBits, infBits),
+                                                      saturated, bits);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + idx),
+                            _mm512_cvtps_ph(_mm512_castsi512_ps(value),
+                                            _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+    }
+    done = idx;
+}
+
+inline void vhalfToFloat(const uint16_t* in, float* out, size_t size, size_t& done)
+{
+    size_t idx = 0;
+    for (; idx + 16 <= size; idx += 16)
+    {
+        const __m256i h = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + idx));
+        _mm512_storeu_ps(out + idx, _mm512_cvtph_ps(h));
+    }
+    done = idx;
+}
+
+#elif defined(__AVX2__)
+typedef __m256 vfloat;
+typedef __m256i vint;
+const int VSIZE = 8;
+
+inline vfloat vload(const float* p) { return _mm256_loadu_ps(p); }
+inline void vstore(float* p, vfloat v) { _mm256_storeu_ps(p, v); }
+inline vfloat vset(float v) { return _mm256_set1_ps(v); }
+inline vfloat vadd(vfloat a, vfloat b) { return _mm256_add_ps(a, b); }
+inline vfloat vsub(vfloat a, vfloat b) { return _mm256_sub_ps(a, b); }
+inline vfloat vmul(vfloat a, vfloat b) { return _mm256_mul_ps(a, b); }
+inline vfloat vdiv(vfloat a, vfloat b) { return _mm256_div_ps(a, b); }
+inline vfloat vmin(vfloat a, vfloat b) { return _mm256_min_ps(a, b); }
+inline vfloat vmax(vfloat a, vfloat b) { return _mm256_max_ps(a, b); }
+inline vfloat vfloor(vfloat x) { return _mm256_floor_ps(x); }
+
+inline vint vbits(vfloat x) { return _mm256_castps_si256(x); }
+inline vfloat vfromBits(vint i) { return _mm256_castsi256_ps(i); }
+inline vint viset(int v) { return _mm256_set1_epi32(v); }
+inline vint viand(vint a, vint b) { return _mm256_and_si256(a, b); }
+inline vint vior(vint a, vint b) { return _mm256_or_si256(a, b); }
+inline vint viadd(vint a, vint b) { return _mm256_add_epi32(a, b); }
+inline vint visub(vint a, vint b) { return _mm256_sub_epi32(a, b); }
+inline vint vexponentBits(vint i) { return _mm256_srli_epi32(i, 23); }
+inline vint vtoExponent(vint i) { return _mm256_slli_epi32(i, 23); }
+inline vfloat vitof(vint i) { return _mm256_cvtepi32_ps(i); }
+inline vint vftoi(vfloat x) { return _mm256_cvttps_epi32(x); }
+
+inline vfloat vselectGreater(vfloat x, vfloat t, vfloat a, vfloat b)
+{ return _mm256_blendv_ps(b, a, _mm256_cmp_ps(x, t, _CMP_GT_OQ)); }
+inline vfloat vmaskGreater(vfloat x, vfloat t, vfloat v)
+{ return _mm256_and_ps(v, _mm256_cmp_ps(x, t, _CMP_GT_OQ)); }
+
+inline double vdotProduct(const float* v1, const float* v2, size_t size, size_t& done)
+{
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    size_t idx = 0;
+    for (; idx + 8 <= size; idx += 8)
+    {
+        acc0 = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm_loadu_ps(v1 + idx)),
+                               _mm256_cvtps_pd(_mm_loadu_ps(v2 + idx)), acc0);
+        acc1 = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm_loadu_ps(v1 + idx + 4)),
+                               _mm256_cvtps_pd(_mm_loadu_ps(v2 + idx + 4)), acc1);
+    }
+    done = idx;
+
+    double partial[4];
+    _mm256_storeu_pd(partial, _mm256_add_pd(acc0, acc1));
+    return (partial[0] + partial[1]) + (partial[2] + partial[3]);
+}
+
+// F16C comes with the AVX2 level (see cpu.h)
+inline void vfloatToHalf(const float* in, uint16_t* out, size_t size, size_t& done)
+{
+    const __m256i absMask = _mm256_set1_epi32(0x7fffffff);
+    const __m256i infBits = _mm256_set1_epi32(0x7f800000);
+    const __m256i maxBits = _mm256_set1_epi32(HALF_MAX_BITS);
+    size_t idx = 0;
+    for (; idx + 8 <= size; idx += 8)
+    {
+        // saturated on the bits, so NaN (above the bits of infinity) is kept
+        const __m256i bits = _mm256_castps_si256(_mm256_loadu_ps(in + idx));
+        const __m256i absBits = _mm256_and_si256(bits, absMask);
+        const __m256i saturated = _mm256_or_si256(_mm256_andnot_si256(absMask, bits),
+                                                  _mm256_min_epi32(absBits, maxBits));
+        const __m256i value = _mm256_blendv_epi8(saturated, bits,
+                                                 _mm256_cmpgt_epi32(absBits, infBits));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + idx),
+                         _mm256_cvtps_ph(_mm256_castsi256_ps(value), _MM_FROUND_TO_NEAREST_INT));
+    }
+    done = idx;
+}
+
+inline void vhalfToFloat(const uint16_t* in, float* out, size_t size, size_t& done)
+{
+    size_t idx = 0;
+    for (; idx + 8 <= size; idx += 8)
+    {
+        const __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + idx));
+        _mm256_storeu_ps(out + idx, _mm256_cvtph_ps(h));
+    }
+    done = idx;
+}
+
+#else
+// SSE2: the baseline of x86-64, and of the 32 bits builds of kernels_sse2.cpp
+typedef __m128 vfloat;
+typedef __m128i vint;
+const int VSIZE = 4;
+
+inline vfloat vload(const float* p) { return _mm_loadu_ps(p); }
+inline void vstore(float* p, vfloat v) { _mm_storeu_ps(p, v); }
+inline vfloat vset(float v) { return _mm_set1_ps(v); }
+inline vfloat vadd(vfloat a, vfloat b) { return _mm_add_ps(a, b); }
+inline vfloat vsub(vfloat a, vfloat b) { return _mm_sub_ps(a, b); }
+inline vfloat vmul(vfloat a, vfloat b) { return _mm_mul_ps(a, b); }
+inline vfloat vdiv(vfloat a, vfloat b) { return _mm_div_ps(a, b); }
+inline vfloat vmin(vfloat a, vfloat b) { return _mm_min_ps(a, b); }
+inline vfloat vmax(vfloat a, vfloat b) { return _mm_max_ps(a, b); }
+
+inline vint vbits(vfloat x) { return _mm_castps_si128(x); }
+inline vfloat vfromBits(vint i) { return _mm_castsi128_ps(i); }
+inline vint viset(int v) { return _mm_set1_epi32(v); }
+inline vint viand(vint a, vint b) { return _mm_and_si128(a, b); }
+inline vint vior(vint a, vint b) { return _mm_or_si128(a, b); }
+inline vint viadd(vint a, vint b) { return _mm_add_epi32(a, b); }
+inline vint visub(vint a, vint b) { return _mm_sub_epi32(a, b); }
+inline vint vexponentBits(vint i) { return _mm_srli_epi32(i, 23); }
+inline vint vtoExponent(vint i) { return _mm_slli_epi32(i, 23); }
+inline vfloat vitof(vint i) { return _mm_cvtepi32_ps(i); }
+inline vint vftoi(vfloat x) { return _mm_cvttps_epi32(x); }
+
+//! \brief floor without SSE4.1: truncate, then step down the negative
+//! values that were not integral
+inline vfloat vfloor(vfloat x)
+{
+    const vfloat truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+    return _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, x), _mm_set1_ps(1.f)));
+}
+
+inline vfloat vselectGreater(vfloat x, vfloat t, vfloat a, vfloat b)
+{
+    const vfloat mask = _mm_cmpgt_ps(x, t);
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+inline vfloat vmaskGreater(vfloat x, vfloat t, vfloat v)
+{ return _mm_and_ps(v, _mm_cmpgt_ps(x, t)); }
+
+inline double vdotProduct(const float* v1, const float* v2, size_t size, size_t& done)
+{
+    __m128d acc0 = _mm_setzero_pd();
+    __m128d acc1 = _mm_setzero_pd();
+    size_t idx = 0;
+    for (; idx + 4 <= size; idx += 4)
+    {
+        const __m128 a = _mm_loadu_ps(v1 + idx);
+        const __m128 b = _mm_loadu_ps(v2 + idx);
+        acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_cvtps_pd(a), _mm_cvtps_pd(b)));
+        acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(a, a)),
+                                           _mm_cvtps_pd(_mm_movehl_ps(b, b))));
+    }
+    done = idx;
+
+    double partial[2];
+    _mm_storeu_pd(partial, _mm_add_pd(acc0, acc1));
+    return partial[0] + partial[1];
+}
+
+// no half conversions before F16C: the scalar ones do all the work
+inline void vfloatToHalf(const float*, uint16_t*, size_t, size_t& done)
+{ done = 0; }
+
+inline void vhalfToFloat(const uint16_t*, float*, size_t, size_t& done)
+{ done = 0; }
+
+#endif
+
+// the polynomials are the same of fastmath.hxx, so a vector lane and the
+// scalar function give the same result
+inline vfloat vlnSeries(vfloat m)
+{
+    const vfloat one = vset(1.f);
+    const vfloat s = vdiv(vsub(m, one), vadd(m, one));
+    const vfloat s2 = vmul(s, s);
+    vfloat p = vset(1.f/9.f);
+    p = vadd(vmul(p, s2), vset(1.f/7.f));
+    p = vadd(vmul(p, s2), vset(1.f/5.f));
+    p = vadd(vmul(p, s2), vset(1.f/3.f));
+    p = vadd(vmul(p, s2), one);
+    return vmul(vmul(vset(2.f), s), p);
+}
+
+inline vfloat vexp2Poly(vfloat f)
+{
+    vfloat p = vset(1.8775767e-3f);
+    p = vadd(vmul(p, f), vset(8.9893397e-3f));
+    p = vadd(vmul(p, f), vset(5.5826318e-2f));
+    p = vadd(vmul(p, f), vset(2.4015361e-1f));
+    p = vadd(vmul(p, f), vset(6.9315308e-1f));
+    return vadd(vmul(p, f), vset(9.9999994e-1f));
+}
+
+inline vfloat vlog2(vfloat x)
+{
+    const vint i = vbits(x);
+    vfloat e = vitof(visub(vexponentBits(viand(i, viset(0x7F800000))), viset(127)));
+    vfloat m = vfromBits(vior(viand(i, viset(0x007FFFFF)), viset(0x3F800000)));
+
+    // mantissa in [sqrt(1/2), sqrt(2))
+    const vfloat sqrt2 = vset(1.41421356f);
+    e = vadd(e, vmaskGreater(m, sqrt2, vset(1.f)));
+    m = vselectGreater(m, sqrt2, vmul(m, vset(0.5f)), m);
+
+    return vadd(vmul(vlnSeries(m), vset(LOG2_E)), e);
+}
+
+inline vfloat vexp2(vfloat x)
+{
+    x = vmax(vmin(x, vset(128.f)), vset(-126.99999f));
+    const vfloat fl = vfloor(x);
+    const vfloat expipart = vfromBits(vtoExponent(viadd(vftoi(fl), viset(127))));
+    return vmul(expipart, vexp2Poly(vsub(x, fl)));
+}
+
+//! \brief run \a op on \a size samples: the last partial vector goes
+//! through a padded buffer, so every sample takes the same code path
+template <typename Op>
+inline void transform(const float* in, float* out, size_t size, const Op& op)
+{
+    size_t idx = 0;
+    for (; idx + VSIZE <= size; idx += VSIZE)
+    {
+        vstore(out + idx, op(vload(in + idx)));
+    }
+    if ( idx < size )
+    {
+        float buffer[VSIZE];
+        for (int k = 0; k < VSIZE; ++k)
+        {
+            buffer[k] = (idx + k < size) ? in[idx + k] : 1.f;
+        }
+        vstore(buffer, op(vload(buffer)));
+        for (size_t k = 0; idx + k < size; ++k)
+        {
+            out[idx + k] = buffer[k];
+        }
+    }
+}
+
+struct Log2Op
+{
+    explicit Log2Op(float scale) : m_scale(vset(scale)) {}
+    vfloat operator()(vfloat x) const { return vmul(vlog2(x), m_scale); }
+    vfloat m_scale;
+};
+
+struct Exp2Op
+{
+    explicit Exp2Op(float scale) : m_scale(vset(scale)) {}
+    vfloat operator()(vfloat x) const { return vexp2(vmul(x, m_scale)); }
+    vfloat m_scale;
+};
+
+struct PowOp
+{
+    explicit PowOp(float exponent) : m_exponent(vset(exponent)) {}
+    vfloat operator()(vfloat x) const
+    { return vmaskGreater(x, vset(0.f), vexp2(vmul(vlog2(x), m_exponent))); }
+    vfloat m_exponent;
+};
+
+double kernelDotProduct(const float* v1, const float* v2, size_t size)
+{
+    size_t idx = 0;
+    double dotProd = vdotProduct(v1, v2, size, idx);
+    for (; idx < size; ++idx)
+    {
+        dotProd += static_cast<double>(v1[idx])*v2[idx];
+    }
+    return dotProd;
+}
+
+double kernelSumOfSquares(const float* v, size_t size)
+{
+    return kernelDotProduct(v, v, size);
+}
+
+void kernelVadds(const float* A, float s, const float* B, float* C, size_t size)
+{
+    const vfloat vs = vset(s);
+    size_t idx = 0;
+    for (; idx + VSIZE <= size; idx += VSIZE)
+    {
+        vstore(C + idx, vadd(vload(A + idx), vmul(vs, vload(B + idx))));
+    }
+    for (; idx < size; ++idx)
+    {
+        C[idx] = A[idx] + s*B[idx];
+    }
+}
+
+void kernelMatrix3(const float* m,
+                   const float* in1, const float* in2, const float* in3,
+                   float* out1, float* out2, float* out3, size_t size)
+{
+    const vfloat m00 = vset(m[0]);
+    const vfloat m01 = vset(m[1]);
+    const vfloat m02 = vset(m[2]);
+    const vfloat m10 = vset(m[3]);
+    const vfloat m11 = vset(m[4]);
+    const vfloat m12 = vset(m[5]);
+    const vfloat m20 = vset(m[6]);
+    const vfloat m21 = vset(m[7]);
+    const vfloat m22 = vset(m[8]);
+
+    // the three inputs are loaded before the outputs are stored, so the
+    // conversion can run in place
+    size_t idx = 0;
+    for (; idx + VSIZE <= size; idx += VSIZE)
+    {
+        const vfloat i1 = vload(in1 + idx);
+        const vfloat i2 = vload(in2 + idx);
+        const vfloat i3 = vload(in3 + idx);
+
+        vstore(out1 + idx, vadd(vadd(vmul(m00, i1), vmul(m01, i2)), vmul(m02, i3)));
+        vstore(out2 + idx, vadd(vadd(vmul(m10, i1), vmul(m11, i2)), vmul(m12, i3)));
+        vstore(out3 + idx, vadd(vadd(vmul(m20, i1), vmul(m21, i2)), vmul(m22, i3)));
+    }
+    for (; idx < size; ++idx)
+    {
+        const float i1 = in1[idx];
+        const float i2 = in2[idx];
+        const float i3 = in3[idx];
+
+        out1[idx] = m[0]*i1 + m[1]*i2 + m[2]*i3;
+        out2[idx] = m[3]*i1 + m[4]*i2 + m[5]*i3;
+        out3[idx] = m[6]*i1 + m[7]*i2 + m[8]*i3;
+    }
+}
+
+void kernelLog2(const float* in, float* out, size_t size, float scale)
+{
+    transform(in, out, size, Log2Op(scale));
+}
+
+void kernelExp2(const float* in, float* out, size_t size, float scale)
+{
+    transform(in, out, size, Exp2Op(scale));
+}
+
+void kernelPow(const float* in, float* out, size_t size, float exponent)
+{
+    transform(in, out, size, PowOp(exponent));
+}
+
+void kernelFloatToHalf(const float* in, uint16_t* out, size_t size)
+{
+    size_t idx = 0;
+    vfloatToHalf(in, out, size, idx);
+    for (; idx < size; ++idx)
+    {
+        out[idx] = floatToHalfSaturate(in[idx]);
+    }
+}
+
+void kernelHalfToFloat(const uint16_t* in, float* out, size_t size)
+{
+    size_t idx = 0;
+    vhalfToFloat(in, out, size, idx);
+    for (; idx < size; ++idx)
+    {
+        out[idx] = halfToFloat(in[idx]);
+    }
+}
+
+Kernels makeKernels(CpuLevel level)
+{
+    Kernels k;
+    k.level = level;
+    k.dotProduct = &kernelDotProduct;
+    k.sumOfSquares = &kernelSumOfSquares;
+    k.vadds = &kernelVadds;
+    k.matrix3 = &kernelMatrix3;
+    k.log2 = &kernelLog2;
+    k.exp2 = &kernelExp2;
+    k.pow = &kernelPow;
+    k.floatToHalf = &kernelFloatToHalf;
+    k.halfToFloat = &kernelHalfToFloat;
+    return k;
+}
+
+}   // anonymous
+}   // utils
+}   // pfs
+
+#endif // PFS_UTILS_KERNELS_HXX
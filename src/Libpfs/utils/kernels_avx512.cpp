@@ -0,0 +1,47 @@
+/*
+* This file is a part of Luminance HDR package.
+* ----------------------------------------------------------------------
+*
+*  This library is free software; you can redistribute it and/or
+*  modify it under the terms of the GNU Lesser General Public
+*  License as published by the Free Software Foundation; either
+*  version 2.1 of the License, or (at your option) any later version.
+*
+*  This library is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*  Lesser General Public License for more details.
+*
+*  You should have received a copy of the GNU Lesser General Public
+*  License along with this library; if not, write to the Free Software
+*  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+* ----------------------------------------------------------------------
+*/
+
+
+//! \brief AVX-512 build of the dispatched kernels
+
+#include <Libpfs/utils/kernels.h>
+
+#if defined(__AVX512F__)
+#include <Libpfs/utils/kernels.hxx>
+#endif
+
+namespace pfs {
+namespace utils {
+namespace detail {
+
+const Kernels* avx512Kernels()
+{
+#if defined(__AVX512F__)
+    static const Kernels s_kernels = makeKernels(CPU_AVX512);
+    return &s_kernels;
+#else
+    // the compiler has not been asked for this instruction set
+    return NULL;
+#endif
+}
+
+}   // detail
+}   // utils
+}   // pfs
@@ -0,0 +1,463 @@
+/*
+* This file is a part of Luminance HDR package.
+* ----------------------------------------------------------------------
+*
+*  This library is free software; you can redistribute it and/or
+*  modify it under the terms of the GNU Lesser General Public
+*  License as published by the Free Software Foundation; either
+*  version 2.1 of the License, or (at your option) any later version.
+*
+*  This library is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*  Lesser General Public License for more details.
+*
+*  You should have received a copy of the GNU Lesser General Public
+*  License along with this library; if not, write to the Free Software
+*  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+* ----------------------------------------------------------------------
+*/
+
+//! \brief Accounting of the memory of the frames and admission of the jobs
+
+#include <Libpfs/utils/memorybudget.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace pfs {
+namespace utils {
+
+namespace
+{
+std::atomic<size_t> s_used(0);
+std::atomic<size_t> s_peak(0);
+
+size_t budgetFromEnvironment()
+{
+    const char* value = std::getenv("LUMINANCE_MEMORY_BUDGET");
+    if ( value == NULL ) return 0;
+
+    const long megabytes = std::atol(value);
+    return (megabytes > 0) ? static_cast<size_t>(megabytes)*1024*1024 : 0;
+}
+
+std::atomic<size_t> s_budget(budgetFromEnvironment());
+
+//! \brief frames freed outside of a reservation do not wake up the waiting
+//! jobs: they check again at this interval
+const std::chrono::milliseconds ADMISSION_POLL(50);
+
+//! \brief frames allocated by the thread of a reservation while it is alive
+struct Binding
+{
+    const MemoryReservation* m_owner;
+    std::thread::id m_thread;
+    size_t m_bytes;
+    size_t m_allocated;
+
+    //! \brief part of the reservation already in frameMemoryUsage()
+    size_t covered() const  { return std::min(m_allocated, m_bytes); }
+};
+
+struct Admission
+{
+    Admission()
+        : m_reserved(0)
+        , m_covered(0)
+        , m_numReservations(0)
+        , m_waiting(0)
+        , m_numBindings(0)
+    {}
+
+    //! \brief frames alive plus the part of the reservations not allocated
+    //! yet: the frames of a running job are not counted twice
+    //! \pre m_mutex is held
+    size_t projected() const
+    {
+        return s_used.load() + (m_reserved - m_covered);
+    }
+
+    //! \pre m_mutex is held
+    bool exceeds(size_t bytes) const
+    {
+        const size_t budget = s_budget.load();
+        return budget != 0 && projected() + bytes > budget;
+    }
+
+    //! \pre m_mutex is held
+    bool fits(size_t bytes) const
+    {
+        return m_numReservations == 0 || !exceeds(bytes);
+    }
+
+    //! \brief ask the handlers for the memory missing to \a bytes, also
+    //! when a reservation alone is admitted anyway
+    //! \pre \a lock holds m_mutex
+    void relieve(std::unique_lock<std::mutex>& lock, size_t bytes)
+    {
+        if ( !exceeds(bytes) ) return;
+
+        const size_t bytesMissing = missing(bytes);
+        lock.unlock();
+        relieveMemoryPressure(bytesMissing);
+        lock.lock();
+    }
+
+    //! \pre m_mutex is held
+    size_t missing(size_t bytes) const
+    {
+        const size_t needed = projected() + bytes;
+        const size_t budget = s_budget.load();
+        return (needed > budget) ? needed - budget : 0;
+    }
+
+    //! \pre m_mutex is held
+    void bind(const MemoryReservation* owner, size_t bytes)
+    {
+        Binding binding = { owner, std::this_thread::get_id(), bytes, 0 };
+        m_bindings.push_back(binding);
+        ++m_numBindings;
+    }
+
+    //! \pre m_mutex is held
+    Binding* binding(const MemoryReservation* owner)
+    {
+        for (size_t idx = 0; idx < m_bindings.size(); ++idx)
+        {
+            if ( m_bindings[idx].m_owner == owner ) return &m_bindings[idx];
+        }
+        return NULL;
+    }
+
+    //! \pre m_mutex is held
+    void unbind(const MemoryReservation* owner)
+    {
+        Binding* b = binding(owner);
+        if ( b == NULL ) return;
+
+        m_covered -= b->covered();
+        m_bindings.erase(m_bindings.begin() + (b - m_bindings.data()));
+        --m_numBindings;
+    }
+
+    //! \brief frames allocated (\a bytes > 0) or freed by the calling thread
+    //! go to its most recent reservation
+    void account(size_t bytes, bool allocated)
+    {
+        if ( m_numBindings.load() == 0 ) return;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const std::thread::id thread = std::this_thread::get_id();
+        for (size_t idx = m_bindings.size(); idx > 0; --idx)
+        {
+            Binding& binding = m_bindings[idx - 1];
+            if ( binding.m_thread != thread ) continue;
+
+            m_covered -= binding.covered();
+            if ( allocated )
+                binding.m_allocated += bytes;
+            else
+                binding.m_allocated -= std::min(binding.m_allocated, bytes);
+            m_covered += binding.covered();
+            return;
+        }
+    }
+
+    std::mutex m_mutex;
+    std::condition_variable m_released;
+    size_t m_reserved;
+    size_t m_covered;
+    size_t m_numReservations;
+    size_t m_waiting;
+    std::vector<Binding> m_bindings;
+    std::atomic<size_t> m_numBindings;
+};
+
+Admission& admission()
+{
+    static Admission s_admission;
+    return s_admission;
+}
+
+struct PressureHandlers
+{
+    PressureHandlers()
+        : m_nextId(1)
+    {}
+
+    std::mutex m_mutex;
+    std::vector< std::pair<int, MemoryPressureHandler> > m_handlers;
+    int m_nextId;
+};
+
+PressureHandlers& pressureHandlers()
+{
+    static PressureHandlers s_handlers;
+    return s_handlers;
+}
+}
+
+size_t frameMemoryUsage()
+{
+    return s_used.load();
+}
+
+size_t frameMemoryPeak()
+{
+    return s_peak.load();
+}
+
+size_t physicalMemory()
+{
+#if defined(_WIN32)
+    MEMORYSTATUSEX status;
+    status.dwLength = sizeof(status);
+    if ( !GlobalMemoryStatusEx(&status) ) return 0;
+    return static_cast<size_t>(status.ullTotalPhys);
+#else
+    const long pages = sysconf(_SC_PHYS_PAGES);
+    const long pageSize = sysconf(_SC_PAGESIZE);
+    if ( pages <= 0 || pageSize <= 0 ) return 0;
+    return static_cast<size_t>(pages)*static_cast<size_t>(pageSize);
+#endif
+}
+
+size_t memoryBudget()
+{
+    return s_budget.load();
+}
+
+void setMemoryBudget(size_t bytes)
+{
+    Admission& adm = admission();
+    {
+        std::lock_guard<std::mutex> lock(adm.m_mutex);
+        s_budget = bytes;
+    }
+    // a larger budget can admit the jobs waiting
+    adm.m_released.notify_all();
+}
+
+int addMemoryPressureHandler(const MemoryPressureHandler& handler)
+{
+    PressureHandlers& handlers = pressureHandlers();
+    std::lock_guard<std::mutex> lock(handlers.m_mutex);
+
+    const int id = handlers.m_nextId++;
+    handlers.m_handlers.push_back(std::make_pair(id, handler));
+    return id;
+}
+
+void removeMemoryPressureHandler(int id)
+{
+    PressureHandlers& handlers = pressureHandlers();
+    std::lock_guard<std::mutex> lock(handlers.m_mutex);
+
+    for (size_t idx = 0; idx < handlers.m_handlers.size(); ++idx)
+    {
+        if ( handlers.m_handlers[idx].first == id )
+        {
+            handlers.m_handlers.erase(handlers.m_handlers.begin() + idx);
+            return;
+        }
+    }
+}
+
+size_t relieveMemoryPressure(size_t bytes)
+{
+    // held while the handlers run: a handler is never called after its
+    // removal has returned
+    PressureHandlers& handlers = pressureHandlers();
+    std::lock_guard<std::mutex> lock(handlers.m_mutex);
+
+    size_t released = 0;
+    for (size_t idx = 0; idx < handlers.m_handlers.size() && released < bytes; ++idx)
+    {
+        released += handlers.m_handlers[idx].second(bytes - released);
+    }
+
+    if ( released > 0 ) admission().m_released.notify_all();
+    return released;
+}
+
+MemoryReservation::MemoryReservation()
+    : m_bytes(0)
+    , m_detached(false)
+{}
+
+MemoryReservation::MemoryReservation(size_t bytes)
+    : m_bytes(0)
+    , m_detached(false)
+{
+    reserve(bytes);
+}
+
+MemoryReservation::~MemoryReservation()
+{
+    release();
+}
+
+bool MemoryReservation::tryReserve(size_t bytes)
+{
+    release();
+    if ( bytes == 0 ) return true;
+
+    Admission& adm = admission();
+    std::unique_lock<std::mutex> lock(adm.m_mutex);
+    adm.relieve(lock, bytes);
+    if ( !adm.fits(bytes) ) return false;
+
+    adm.m_reserved += bytes;
+    ++adm.m_numReservations;
+    adm.bind(this, bytes);
+    m_bytes = bytes;
+    return true;
+}
+
+void MemoryReservation::reserve(size_t bytes)
+{
+    release();
+    if ( bytes == 0 ) return;
+
+    Admission& adm = admission();
+    std::unique_lock<std::mutex> lock(adm.m_mutex);
+    adm.relieve(lock, bytes);
+    if ( !adm.fits(bytes) )
+    {
+        ++adm.m_waiting;
+        while ( !adm.fits(bytes) )
+        {
+            adm.m_released.wait_for(lock, ADMISSION_POLL);
+        }
+        --adm.m_waiting;
+    }
+
+    adm.m_reserved += bytes;
+    ++adm.m_numReservations;
+    adm.bind(this, bytes);
+    m_bytes = bytes;
+}
+
+void MemoryReservation::shrink(size_t bytes)
+{
+    if ( bytes >= m_bytes ) return;
+    if ( bytes == 0 )
+    {
+        release();
+        return;
+    }
+
+    Admission& adm = admission();
+    {
+        std::lock_guard<std::mutex> lock(adm.m_mutex);
+        Binding* binding = adm.binding(this);
+        adm.m_covered -= binding->covered();
+        binding->m_bytes = bytes;
+        adm.m_covered += binding->covered();
+        adm.m_reserved -= m_bytes - bytes;
+    }
+    m_bytes = bytes;
+    adm.m_released.notify_all();
+}
+
+void MemoryReservation::detach()
+{
+    if ( m_bytes == 0 || m_detached ) return;
+
+    Admission& adm = admission();
+    {
+        std::lock_guard<std::mutex> lock(adm.m_mutex);
+        // no thread matches a default id: what it covers stays as it is
+        adm.binding(this)->m_thread = std::thread::id();
+        --adm.m_numReservations;
+    }
+    m_detached = true;
+    adm.m_released.notify_all();
+}
+
+void MemoryReservation::adopt()
+{
+    if ( m_bytes == 0 || m_detached ) return;
+
+    Admission& adm = admission();
+    std::lock_guard<std::mutex> lock(adm.m_mutex);
+    // the frames of the scheduler allocated meanwhile are not part of the job
+    Binding* binding = adm.binding(this);
+    adm.m_covered -= binding->covered();
+    binding->m_allocated = 0;
+    binding->m_thread = std::this_thread::get_id();
+}
+
+void MemoryReservation::release()
+{
+    if ( m_bytes == 0 ) return;
+
+    Admission& adm = admission();
+    {
+        std::lock_guard<std::mutex> lock(adm.m_mutex);
+        adm.unbind(this);
+        adm.m_reserved -= m_bytes;
+        if ( !m_detached ) --adm.m_numReservations;
+    }
+    m_bytes = 0;
+    m_detached = false;
+    adm.m_released.notify_all();
+}
+
+bool isMemoryAvailable(size_t bytes)
+{
+    Admission& adm = admission();
+    std::lock_guard<std::mutex> lock(adm.m_mutex);
+    return adm.fits(bytes);
+}
+
+MemoryStatus memoryStatus()
+{
+    Admission& adm = admission();
+    std::lock_guard<std::mutex> lock(adm.m_mutex);
+
+    MemoryStatus status;
+    status.used = s_used.load();
+    status.peak = s_peak.load();
+    status.reserved = adm.m_reserved;
+    status.budget = s_budget.load();
+    status.waiting = adm.m_waiting;
+    return status;
+}
+
+namespace detail
+{
+void addFrameMemory(size_t bytes)
+{
+    const size_t used = s_used.fetch_add(bytes) + bytes;
+
+    size_t peak = s_peak.load();
+    while ( used > peak && !s_peak.compare_exchange_weak(peak, used) )
+    {}
+
+    admission().account(bytes, true);
+}
+
+void removeFrameMemory(size_t bytes)
+{
+    s_used.fetch_sub(bytes);
+    admission().account(bytes, false);
+}
+}
+
+}   // utils
+}   // pfs
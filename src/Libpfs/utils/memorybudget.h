@@ -0,0 +1,149 @@
+/*
+* This file is a part of Luminance HDR package.
+* ----------------------------------------------------------------------
+*
+*  This library is free software; you can redistribute it and/or
+*  modify it under the terms of the GNU Lesser General Public
+*  License as published by the Free Software Foundation; either
+*  version 2.1 of the License, or (at your option) any later version.
+*
+*  This library is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*  Lesser General Public License for more details.
+*
+*  You should have received a copy of the GNU Lesser General Public
+*  License along with this library; if not, write to the Free Software
+*  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+* ----------------------------------------------------------------------
+*/
+
+#ifndef PFS_UTILS_MEMORYBUDGET_H
+#define PFS_UTILS_MEMORYBUDGET_H
+
+//! \brief Accounting of the memory of the frames and admission of the jobs
+//! under a budget
+//!
+//! Every buffer of an Array2D (and so every channel of a Frame) is counted
+//! when it is allocated and when it is freed. A job declares the memory it
+//! is about to need with a MemoryReservation, that waits while the frames
+//! alive plus the reservations of the running jobs would exceed the budget.
+//! The frames a thread allocates while its reservation is alive are part of
+//! that reservation: they are counted once, not in both.
+//! Before waiting, the handlers of memory pressure are asked to release
+//! memory (spilling inactive frames to disk, for example).
+//! A reservation is always admitted when no other one is alive: a job larger
+//! than the budget runs alone rather than never (the handlers of memory
+//! pressure are still asked first).
+//! A reservation can outlive its job, to keep the data the job has loaded in
+//! the budget (see MemoryReservation::detach())
+
+#include <cstddef>
+#include <functional>
+
+namespace pfs {
+namespace utils {
+
+//! \brief bytes held by the frame buffers of the process
+size_t frameMemoryUsage();
+//! \brief largest value of frameMemoryUsage() so far
+size_t frameMemoryPeak();
+//! \brief physical memory of the machine, 0 if unknown
+size_t physicalMemory();
+
+//! \brief bytes of a frame of \a width x \a height with \a channels float
+//! channels
+inline
+size_t frameMemorySize(size_t width, size_t height, size_t channels = 3)
+{
+    return width*height*channels*sizeof(float);
+}
+
+//! \brief budget of the frames, in bytes: 0 (the default) means no limit.
+//! The environment variable LUMINANCE_MEMORY_BUDGET sets the initial value,
+//! in megabytes
+size_t memoryBudget();
+void setMemoryBudget(size_t bytes);
+
+//! \brief called with the amount of bytes missing to admit a reservation
+//! \return bytes released
+//! \note the handlers run on the thread that asks for the memory: they must
+//! not add or remove handlers
+typedef std::function<size_t (size_t)> MemoryPressureHandler;
+
+//! \return identifier for removeMemoryPressureHandler()
+int addMemoryPressureHandler(const MemoryPressureHandler& handler);
+void removeMemoryPressureHandler(int id);
+//! \brief ask the handlers, in order of registration, until \a bytes have
+//! been released
+//! \return bytes released
+size_t relieveMemoryPressure(size_t bytes);
+
+//! \brief memory declared by a job before it allocates its frames, held for
+//! the lifetime of the object
+//! \note the frames are matched with the reservation through the thread that
+//! reserved it: reserve on the thread that runs the job
+class MemoryReservation
+{
+public:
+    MemoryReservation();
+    //! \brief wait until \a bytes are admitted
+    explicit MemoryReservation(size_t bytes);
+    ~MemoryReservation();
+
+    //! \brief release the current reservation, then reserve \a bytes if
+    //! they fit in the budget now
+    //! \return false, without waiting for other reservations, otherwise
+    bool tryReserve(size_t bytes);
+    //! \brief release the current reservation, then reserve \a bytes,
+    //! waiting for them to fit in the budget
+    void reserve(size_t bytes);
+    //! \brief lower the reservation to \a bytes, when the job finds out it
+    //! needs less than reserved
+    void shrink(size_t bytes);
+    //! \brief keep the reservation for the data of the job that outlives it:
+    //! the reservation stops following the frames of its thread and no
+    //! longer counts as a running job (a reservation alone is still
+    //! admitted), but its bytes stay in the budget until release()
+    void detach();
+    //! \brief follow the frames of the calling thread instead of the ones of
+    //! the thread that reserved: for a job admitted by a scheduler and run
+    //! on another thread
+    void adopt();
+    void release();
+
+    size_t bytes() const    { return m_bytes; }
+
+private:
+    MemoryReservation(const MemoryReservation&);
+    MemoryReservation& operator=(const MemoryReservation&);
+
+    size_t m_bytes;
+    bool m_detached;
+};
+
+//! \brief true if a reservation of \a bytes would be admitted now
+bool isMemoryAvailable(size_t bytes);
+
+struct MemoryStatus
+{
+    size_t used;        //!< frameMemoryUsage()
+    size_t peak;        //!< frameMemoryPeak()
+    size_t reserved;    //!< reservations alive
+    size_t budget;      //!< memoryBudget(), 0 if there is no limit
+    size_t waiting;     //!< reservations waiting to be admitted
+};
+
+MemoryStatus memoryStatus();
+
+namespace detail
+{
+//! \brief called by allocateFrameMemory/freeFrameMemory
+void addFrameMemory(size_t bytes);
+void removeFrameMemory(size_t bytes);
+}
+
+}   // utils
+}   // pfs
+
+#endif // PFS_UTILS_MEMORYBUDGET_H
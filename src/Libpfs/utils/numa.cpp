@@ -0,0 +1,257 @@
+/*
+* This file is a part of Luminance HDR package.
+* ----------------------------------------------------------------------
+*
+*  This library is free software; you can redistribute it and/or
+*  modify it under the terms of the GNU Lesser General Public
+*  License as published by the Free Software Foundation; either
+*  version 2.1 of the License, or (at your option) any later version.
+*
+*  This library is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*  Lesser General Public License for more details.
+*
+*  You should have received a copy of the GNU Lesser General Public
+*  License along with this library; if not, write to the Free Software
+*  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+* ----------------------------------------------------------------------
+*/
+
+//! \brief NUMA topology, thread binding and placement of the frame buffers
+
+#include <Libpfs/utils/numa.h>
+#include <Libpfs/utils/memorybudget.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <string>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace pfs {
+namespace utils {
+
+namespace
+{
+struct NumaTopology
+{
+    NumaTopology();
+
+    // CPUs of every node, in the order of the node ids
+    std::vector<std::vector<int> > m_cpus;
+    std::vector<int> m_ids;
+};
+
+#ifdef __linux__
+//! \brief parse a list like "0-7,16-23"
+std::vector<int> parseCpuList(const std::string& list)
+{
+    std::vector<int> cpus;
+    std::stringstream ss(list);
+    std::string range;
+    while ( std::getline(ss, range, ',') )
+    {
+        int first = 0;
+        int last = 0;
+        const int numFields = std::sscanf(range.c_str(), "%d-%d", &first, &last);
+        if ( numFields < 1 ) continue;
+        if ( numFields == 1 ) last = first;
+        for (int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+    }
+    return cpus;
+}
+#endif
+
+NumaTopology::NumaTopology()
+{
+#ifdef __linux__
+    const char* root = "/sys/devices/system/node";
+    DIR* dir = opendir(root);
+    if ( dir != NULL )
+    {
+        std::vector<int> ids;
+        while ( dirent* entry = readdir(dir) )
+        {
+            int id = 0;
+            if ( std::strncmp(entry->d_name, "node", 4) == 0 &&
+                 std::sscanf(entry->d_name + 4, "%d", &id) == 1 )
+            {
+                ids.push_back(id);
+            }
+        }
+        closedir(dir);
+        std::sort(ids.begin(), ids.end());
+
+        // CPUs the process may use (taskset, cpusets): binding never moves a
+        // thread out of them
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        if ( sched_getaffinity(0, sizeof(allowed), &allowed) != 0 )
+        {
+            for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) CPU_SET(cpu, &allowed);
+        }
+
+        for (size_t idx = 0; idx < ids.size(); ++idx)
+        {
+            std::ostringstream path;
+            path << root << "/node" << ids[idx] << "/cpulist";
+            std::ifstream file(path.str().c_str());
+            std::string list;
+            std::getline(file, list);
+
+            std::vector<int> cpus;
+            const std::vector<int> nodeCpus = parseCpuList(list);
+            for (size_t cpu = 0; cpu < nodeCpus.size(); ++cpu)
+            {
+                if ( nodeCpus[cpu] < CPU_SETSIZE && CPU_ISSET(nodeCpus[cpu], &allowed) )
+                {
+                    cpus.push_back(nodeCpus[cpu]);
+                }
+            }
+            // memory-only nodes, or nodes out of reach, do not run threads
+            if ( cpus.empty() ) continue;
+
+            m_ids.push_back(ids[idx]);
+            m_cpus.push_back(cpus);
+        }
+    }
+#endif
+    if ( m_cpus.empty() )
+    {
+        m_ids.push_back(0);
+        m_cpus.push_back(std::vector<int>());
+    }
+}
+
+const NumaTopology& topology()
+{
+    static const NumaTopology s_topology;
+    return s_topology;
+}
+
+MemoryPlacement defaultPlacement()
+{
+    const char* value = std::getenv("LUMINANCE_NUMA");
+    if ( value != NULL && std::strcmp(value, "interleave") == 0 )
+    {
+        return MEMORY_INTERLEAVED;
+    }
+    return MEMORY_FIRST_TOUCH;
+}
+
+std::atomic<int> s_placement(defaultPlacement());
+
+#ifdef __linux__
+// from <numaif.h>, so libnuma is not needed
+const int NUMA_MPOL_INTERLEAVE = 3;
+
+void interleave(void* ptr, size_t bytes)
+{
+    const NumaTopology& t = topology();
+    if ( t.m_ids.size() < 2 ) return;
+
+    const size_t bitsPerWord = 8*sizeof(unsigned long);
+    std::vector<unsigned long> mask(t.m_ids.back()/bitsPerWord + 1, 0);
+    for (size_t idx = 0; idx < t.m_ids.size(); ++idx)
+    {
+        mask[t.m_ids[idx]/bitsPerWord] |= 1UL << (t.m_ids[idx] % bitsPerWord);
+    }
+    // a failure leaves the default placement, which is still correct
+    syscall(SYS_mbind, ptr, bytes, NUMA_MPOL_INTERLEAVE,
+            mask.data(), mask.size()*bitsPerWord + 1, 0);
+}
+#endif
+}
+
+size_t numaNodeCount()
+{
+    return topology().m_cpus.size();
+}
+
+std::vector<int> numaNodeCpus(size_t node)
+{
+    const NumaTopology& t = topology();
+    return (node < t.m_cpus.size()) ? t.m_cpus[node] : std::vector<int>();
+}
+
+bool bindThreadToNumaNode(size_t node)
+{
+#ifdef __linux__
+    const std::vector<int> cpus = numaNodeCpus(node);
+    if ( cpus.empty() ) return false;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (size_t idx = 0; idx < cpus.size(); ++idx)
+    {
+        if ( cpus[idx] < CPU_SETSIZE ) CPU_SET(cpus[idx], &set);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)node;
+    return false;
+#endif
+}
+
+MemoryPlacement memoryPlacement()
+{
+    return static_cast<MemoryPlacement>(s_placement.load());
+}
+
+void setMemoryPlacement(MemoryPlacement placement)
+{
+    s_placement = placement;
+}
+
+void* allocateFrameMemory(size_t bytes)
+{
+#ifdef __linux__
+    if ( bytes >= FRAME_LARGE_BLOCK )
+    {
+        void* ptr = mmap(NULL, bytes, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if ( ptr == MAP_FAILED ) throw std::bad_alloc();
+
+        // the pages are not allocated yet: the policy applies when they are
+        // first written
+        if ( memoryPlacement() == MEMORY_INTERLEAVED ) interleave(ptr, bytes);
+        detail::addFrameMemory(bytes);
+        return ptr;
+    }
+#endif
+    void* ptr = ::operator new(bytes);
+    detail::addFrameMemory(bytes);
+    return ptr;
+}
+
+void freeFrameMemory(void* ptr, size_t bytes)
+{
+    if ( ptr == NULL ) return;
+
+    detail::removeFrameMemory(bytes);
+#ifdef __linux__
+    if ( bytes >= FRAME_LARGE_BLOCK )
+    {
+        munmap(ptr, bytes);
+        return;
+    }
+#endif
+    ::operator delete(ptr);
+}
+
+}   // utils
+}   // pfs
@@ -0,0 +1,77 @@
+/*
+* This file is a part of Luminance HDR package.
+* ----------------------------------------------------------------------
+*
+*  This library is free software; you can redistribute it and/or
+*  modify it under the terms of the GNU Lesser General Public
+*  License as published by the Free Software Foundation; either
+*  version 2.1 of the License, or (at your option) any later version.
+*
+*  This library is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*  Lesser General Public License for more details.
+*
+*  You should have received a copy of the GNU Lesser General Public
+*  License along with this library; if not, write to the Free Software
+*  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+* ----------------------------------------------------------------------
+*/
+
+#ifndef PFS_UTILS_NUMA_H
+#define PFS_UTILS_NUMA_H
+
+//! \brief NUMA topology, thread binding and placement of the frame buffers
+//!
+//! On a multi-socket machine a page lives on the node of the thread that
+//! writes it first. Frame buffers are therefore initialised by the same
+//! parallel split of the loops that process them (see Array2D), and the
+//! threads of the executor are spread over the nodes accordingly.
+//! Interleaved placement spreads the pages of large buffers over all the
+//! nodes instead, for the jobs whose access pattern does not follow the
+//! split. Everything degrades to a single node on systems other than Linux
+
+#include <cstddef>
+#include <vector>
+
+namespace pfs {
+namespace utils {
+
+//! \brief number of NUMA nodes with CPUs available to the process (1 when
+//! unknown)
+size_t numaNodeCount();
+//! \brief CPUs of the node \a node, in [0, numaNodeCount()), among the ones
+//! the process is allowed to run on
+std::vector<int> numaNodeCpus(size_t node);
+//! \brief restrict the calling thread (and the threads it creates from now
+//! on, OpenMP teams included) to the CPUs of \a node
+//! \return false if the binding is not supported
+bool bindThreadToNumaNode(size_t node);
+
+enum MemoryPlacement
+{
+    //! \brief pages on the node of the thread that writes them first
+    MEMORY_FIRST_TOUCH = 0,
+    //! \brief pages of the large buffers spread over all the nodes
+    MEMORY_INTERLEAVED = 1
+};
+
+//! \brief placement of the frame buffers allocated from now on: the default
+//! is MEMORY_FIRST_TOUCH, or MEMORY_INTERLEAVED when the environment variable
+//! LUMINANCE_NUMA is "interleave"
+MemoryPlacement memoryPlacement();
+void setMemoryPlacement(MemoryPlacement placement);
+
+//! \brief blocks of this size or larger are mapped straight from the system,
+//! so their placement can be chosen
+const size_t FRAME_LARGE_BLOCK = 1 << 20;
+
+//! \brief memory for the frame buffers (see FrameAllocator)
+//! \throws std::bad_alloc
+void* allocateFrameMemory(size_t bytes);
+void freeFrameMemory(void* ptr, size_t bytes);
+
+}   // utils
+}   // pfs
+
+#endif // PFS_UTILS_NUMA_H
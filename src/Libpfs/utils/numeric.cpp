@@ -0,0 +1,65 @@
+/*
+* This file is a part of Luminance HDR package.
+* ----------------------------------------------------------------------
+*
+*  This library is free software; you can redistribute it and/or
+*  modify it under the terms of the GNU Lesser General Public
+*  License as published by the Free Software Foundation; either
+*  version 2.1 of the License, or (at your option) any later version.
+*
+*  This library is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*  Lesser General Public License for more details.
+*
+*  You should have received a copy of the GNU Lesser General Public
+*  License along with this library; if not, write to the Free Software
+*  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+* ----------------------------------------------------------------------
+*/
+
+
+#include <Libpfs/utils/numeric.h>
+
+#include <algorithm>
+
+#include <Libpfs/utils/kernels.h>
+#include <Libpfs/utils/parallel.h>
+
+namespace pfs {
+namespace utils {
+
+namespace
+{
+void dispatchVadds(const float* A, float s, const float* B, float* C, size_t size)
+{
+    const Kernels& k = kernels();
+    const size_t numBlocks = (size + KERNELS_BLOCK_SIZE - 1)/KERNELS_BLOCK_SIZE;
+
+    parallelFor(0, numBlocks, 1,
+                [&](size_t first, size_t last)
+    {
+        for (size_t block = first; block < last; ++block)
+        {
+            const size_t offset = block*KERNELS_BLOCK_SIZE;
+            k.vadds(A + offset, s, B + offset, C + offset,
+                    std::min(KERNELS_BLOCK_SIZE, size - offset));
+        }
+    });
+}
+}
+
+template <>
+void vadds<float>(const float* A, const float& s, const float* B, float* C, size_t size)
+{
+    dispatchVadds(A, s, B, C, size);
+}
+
+template <>
+void vsubs<float>(const float* A, const float& s, const float* B, float* C, size_t size)
+{
+    dispatchVadds(A, -s, B, C, size);
+}
+
+}   // utils
+}   // pfs
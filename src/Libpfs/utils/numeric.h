@@ -101,6 +101,13 @@ void vsub(const _Type* A, const _Type* B, _Type* C, size_t size);
 template <typename _Type>
 void vsubs(const _Type* A, const _Type& s, const _Type* B, _Type* C, size_t size);
 
+//! \brief float versions of \c vadds and \c vsubs run the vector kernel of
+//! the processor
+template <>
+void vadds<float>(const float* A, const float& s, const float* B, float* C, size_t size);
+template <>
+void vsubs<float>(const float* A, const float& s, const float* B, float* C, size_t size);
+
 //! // O[i] = c * I[i]
 template <typename _Type>
 void vsmul(const _Type* I, const float c, _Type* O, size_t size);
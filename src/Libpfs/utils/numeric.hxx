@@ -28,6 +28,8 @@
 #include <numeric>
 #include <functional>
 
+#include <Libpfs/utils/parallel.h>
+
 namespace pfs {
 namespace utils {
 
@@ -37,11 +39,14 @@ template<typename _Type, typename _Op>
 inline
 void op(const _Type* A, const _Type* B, _Type* C, size_t size, const _Op& currOp)
 {
-#pragma omp parallel for
-    for (int idx = 0; idx < static_cast<int>(size); idx++)
+    parallelFor(0, size, PARALLEL_SAMPLES_GRAIN,
+                [&](size_t first, size_t last)
     {
-        C[idx] = currOp(A[idx], B[idx]);
-    }
+        for (size_t idx = first; idx < last; idx++)
+        {
+            C[idx] = currOp(A[idx], B[idx]);
+        }
+    });
 }
 
 } // detail
@@ -50,11 +55,14 @@ template <typename _Type>
 void vmul(const _Type* A, const _Type* B, _Type* C, size_t size)
 {
     //detail::op(A, B, C, size, std::multiplies<_Type>());
-#pragma omp parallel for
-    for (int idx = 0; idx < static_cast<int>(size); idx++)
+    parallelFor(0, size, PARALLEL_SAMPLES_GRAIN,
+                [&](size_t first, size_t last)
     {
-        (*C)(idx) = (*A)(idx) * (*B)(idx);
-    }
+        for (size_t idx = first; idx < last; idx++)
+        {
+            (*C)(idx) = (*A)(idx) * (*B)(idx);
+        }
+    });
 }
 
 template <typename _Type>
@@ -67,21 +75,27 @@ template <typename _Type>
 void vadd(const _Type* A, const _Type* B, _Type* C, size_t size)
 {
     //detail::op(A, B, C, size, std::plus<_Type>());
-#pragma omp parallel for
-    for (int idx = 0; idx < static_cast<int>(size); idx++)
+    parallelFor(0, size, PARALLEL_SAMPLES_GRAIN,
+                [&](size_t first, size_t last)
     {
-        (*C)(idx) = (*A)(idx) + (*B)(idx);
-    }
+        for (size_t idx = first; idx < last; idx++)
+        {
+            (*C)(idx) = (*A)(idx) + (*B)(idx);
+        }
+    });
 }
 
 template <typename _Type>
 void vsadd(const _Type* A, const float s, _Type* B, size_t size)
 {
-#pragma omp parallel for
-    for (int idx = 0; idx < static_cast<int>(size); idx++)
+    parallelFor(0, size, PARALLEL_SAMPLES_GRAIN,
+                [&](size_t first, size_t last)
     {
-        B[idx] = A[idx] + s;
-    }
+        for (size_t idx = first; idx < last; idx++)
+        {
+            B[idx] = A[idx] + s;
+        }
+    });
 }
 
 template <typename _Type>
@@ -106,41 +120,53 @@ void vsubs(const _Type* A, const _Type& s, const _Type* B, _Type* C, size_t size
 template <typename _Type>
 void vsmul(const _Type* I, const float c, _Type* O, size_t size)
 {
-#pragma omp parallel for
-    for (int idx = 0; idx < static_cast<int>(size); idx++)
+    parallelFor(0, size, PARALLEL_SAMPLES_GRAIN,
+                [&](size_t first, size_t last)
     {
-        O[idx] = c*I[idx];
-    }
+        for (size_t idx = first; idx < last; idx++)
+        {
+            O[idx] = c*I[idx];
+        }
+    });
 }
 
 template <typename _Type>
 void vsum_scalar(const _Type* I, const float c, _Type* O, size_t size)
 {
-#pragma omp parallel for
-    for (int idx = 0; idx < static_cast<int>(size); idx++)
+    parallelFor(0, size, PARALLEL_SAMPLES_GRAIN,
+                [&](size_t first, size_t last)
     {
-        (*O)(idx) = c+(*I)(idx);
-    }
+        for (size_t idx = first; idx < last; idx++)
+        {
+            (*O)(idx) = c+(*I)(idx);
+        }
+    });
 }
 
 template <typename _Type>
 void vmul_scalar(const _Type* I, const float c, _Type* O, size_t size)
 {
-#pragma omp parallel for
-    for (int idx = 0; idx < static_cast<int>(size); idx++)
+    parallelFor(0, size, PARALLEL_SAMPLES_GRAIN,
+                [&](size_t first, size_t last)
     {
-        (*O)(idx) = c*(*I)(idx);
-    }
+        for (size_t idx = first; idx < last; idx++)
+        {
+            (*O)(idx) = c*(*I)(idx);
+        }
+    });
 }
 
 template <typename _Type>
 void vdiv_scalar(const _Type* I, const float c, _Type* O, size_t size)
 {
-#pragma omp parallel for
-    for (int idx = 0; idx < static_cast<int>(size); idx++)
+    parallelFor(0, size, PARALLEL_SAMPLES_GRAIN,
+                [&](size_t first, size_t last)
     {
-        (*O)(idx) = c/(*I)(idx);
-    }
+        for (size_t idx = first; idx < last; idx++)
+        {
+            (*O)(idx) = c/(*I)(idx);
+        }
+    });
 }
 
 }   // utils
@@ -0,0 +1,513 @@
+/*
+* This file is a part of Luminance HDR package.
+* ----------------------------------------------------------------------
+*
+*  This library is free software; you can redistribute it and/or
+*  modify it under the terms of the GNU Lesser General Public
+*  License as published by the Free Software Foundation; either
+*  version 2.1 of the License, or (at your option) any later version.
+*
+*  This library is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*  Lesser General Public License for more details.
+*
+*  You should have received a copy of the GNU Lesser General Public
+*  License along with this library; if not, write to the Free Software
+*  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+* ----------------------------------------------------------------------
+*/
+
+//! \brief Work-stealing executor and global executor of the library
+
+#include <Libpfs/utils/parallel.h>
+#include <Libpfs/utils/numa.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <iterator>
+#include <mutex>
+#include <thread>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace pfs {
+namespace utils {
+
+namespace detail {
+bool insideOpenMP()
+{
+#ifdef _OPENMP
+    return omp_in_parallel() != 0;
+#else
+    return false;
+#endif
+}
+}
+
+namespace
+{
+size_t hardwareConcurrency()
+{
+    const unsigned int numThreads = std::thread::hardware_concurrency();
+    return (numThreads > 0) ? numThreads : 1;
+}
+
+size_t nodeConcurrency(int numaNode)
+{
+    if ( numaNode >= 0 )
+    {
+        const size_t numCpus = numaNodeCpus(numaNode).size();
+        if ( numCpus > 0 ) return numCpus;
+    }
+    return hardwareConcurrency();
+}
+
+//! \brief tasks of one call to run(): the caller waits for pending to reach
+//! zero
+struct Batch
+{
+    explicit Batch(size_t size)
+        : pending(size)
+    {}
+
+    size_t pending;
+    std::exception_ptr error;
+    std::mutex mutex;
+    std::condition_variable done;
+};
+
+struct WorkItem
+{
+    Executor::Task* task;
+    Batch* batch;
+    Executor* owner;
+};
+
+//! \brief executor of the task running on the calling thread: its run() is
+//! still waiting, so it is alive
+thread_local Executor* s_taskExecutor = NULL;
+//! \brief executor installed by ScopedExecutor
+thread_local ExecutorPtr s_scopedExecutor;
+
+void execute(const WorkItem& item)
+{
+    std::exception_ptr error;
+    Executor* previous = s_taskExecutor;
+    s_taskExecutor = item.owner;
+    try
+    {
+        (*item.task)();
+    }
+    catch (...)
+    {
+        error = std::current_exception();
+    }
+    s_taskExecutor = previous;
+
+    std::lock_guard<std::mutex> lock(item.batch->mutex);
+    if ( error && !item.batch->error )
+    {
+        item.batch->error = error;
+    }
+    if ( --item.batch->pending == 0 )
+    {
+        item.batch->done.notify_all();
+    }
+}
+}
+
+struct WorkStealingExecutor::Impl
+{
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<WorkItem> items;
+    };
+
+    Impl(size_t concurrency, int numaNode);
+
+    void push(const std::vector<WorkItem>& items);
+    bool pop(WorkItem& item);
+    //! \brief like pop(), but only the tasks of \a batch: a thread waiting
+    //! for its batch may hold a lock or a reservation, and must not start
+    //! unrelated work that could wait for them
+    bool pop(const Batch* batch, WorkItem& item);
+    //! \brief loop of the worker \a index: it owns a reference, so a worker
+    //! that outlives the executor (see the destructor) still finds its queues
+    static void work(std::shared_ptr<Impl> pool, size_t index);
+
+    const size_t m_concurrency;
+    const int m_numaNode;
+    // one queue for each worker: the threads outside the pool push on them
+    // in turn
+    std::vector<std::unique_ptr<Queue> > m_queues;
+    std::vector<std::thread> m_threads;
+    std::atomic<size_t> m_queued;
+
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wakeUp;
+    bool m_stop;
+};
+
+namespace
+{
+//! \brief pool and queue of the calling thread, if it is a worker
+thread_local const void* s_pool = NULL;
+thread_local size_t s_queue = 0;
+}
+
+WorkStealingExecutor::Impl::Impl(size_t concurrency, int numaNode)
+    : m_concurrency(concurrency > 0 ? concurrency : nodeConcurrency(numaNode))
+    , m_numaNode(numaNode)
+    , m_queued(0)
+    , m_stop(false)
+{
+    for (size_t idx = 1; idx < m_concurrency; ++idx)
+    {
+        m_queues.push_back(std::unique_ptr<Queue>(new Queue));
+    }
+}
+
+void WorkStealingExecutor::Impl::push(const std::vector<WorkItem>& items)
+{
+    // counted before they are visible, so the counter never goes below zero
+    m_queued += items.size();
+
+    if ( s_pool == this )
+    {
+        // nested call: the tasks stay on this thread, unless stolen
+        Queue& queue = *m_queues[s_queue];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.items.insert(queue.items.end(), items.begin(), items.end());
+    }
+    else
+    {
+        // contiguous runs: the split of a range always lands on the same
+        // queues, and so on the same NUMA nodes
+        const size_t numQueues = m_queues.size();
+        for (size_t idx = 0; idx < items.size(); ++idx)
+        {
+            Queue& queue = *m_queues[idx*numQueues/items.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.items.push_back(items[idx]);
+        }
+    }
+
+    // taking the mutex orders the notification after the check of the
+    // sleeping threads: no wake-up is lost
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+    }
+    m_wakeUp.notify_all();
+}
+
+bool WorkStealingExecutor::Impl::pop(WorkItem& item)
+{
+    if ( m_queued == 0 ) return false;
+
+    const size_t numQueues = m_queues.size();
+    const size_t first = (s_pool == this) ? s_queue : 0;
+
+    // newest task of the own queue first...
+    if ( s_pool == this )
+    {
+        Queue& queue = *m_queues[first];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if ( !queue.items.empty() )
+        {
+            item = queue.items.back();
+            queue.items.pop_back();
+            --m_queued;
+            return true;
+        }
+    }
+    // ... then the oldest of the others
+    for (size_t offset = 0; offset < numQueues; ++offset)
+    {
+        Queue& queue = *m_queues[(first + offset) % numQueues];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if ( !queue.items.empty() )
+        {
+            item = queue.items.front();
+            queue.items.pop_front();
+            --m_queued;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool WorkStealingExecutor::Impl::pop(const Batch* batch, WorkItem& item)
+{
+    if ( m_queued == 0 ) return false;
+
+    const size_t numQueues = m_queues.size();
+    const size_t first = (s_pool == this) ? s_queue : 0;
+
+    // same order as pop(): newest of the own queue, then oldest of the others
+    if ( s_pool == this )
+    {
+        Queue& queue = *m_queues[first];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        for (std::deque<WorkItem>::reverse_iterator it = queue.items.rbegin();
+             it != queue.items.rend(); ++it)
+        {
+            if ( it->batch == batch )
+            {
+                item = *it;
+                queue.items.erase(std::next(it).base());
+                --m_queued;
+                return true;
+            }
+        }
+    }
+    for (size_t offset = 0; offset < numQueues; ++offset)
+    {
+        Queue& queue = *m_queues[(first + offset) % numQueues];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        for (std::deque<WorkItem>::iterator it = queue.items.begin();
+             it != queue.items.end(); ++it)
+        {
+            if ( it->batch == batch )
+            {
+                item = *it;
+                queue.items.erase(it);
+                --m_queued;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void WorkStealingExecutor::Impl::work(std::shared_ptr<Impl> pool, size_t index)
+{
+    s_pool = pool.get();
+    s_queue = index;
+    if ( pool->m_numaNode >= 0 )
+    {
+        bindThreadToNumaNode(pool->m_numaNode);
+    }
+    else if ( numaNodeCount() > 1 )
+    {
+        // the queues of a node hold contiguous runs of the frames
+        bindThreadToNumaNode(index*numaNodeCount()/pool->m_queues.size());
+    }
+#ifdef _OPENMP
+    omp_set_num_threads(1);
+#endif
+
+    for (;;)
+    {
+        WorkItem item;
+        if ( pool->pop(item) )
+        {
+            execute(item);
+            continue;
+        }
+
+        // the queues are drained before leaving
+        std::unique_lock<std::mutex> lock(pool->m_sleepMutex);
+        if ( pool->m_stop ) return;
+        pool->m_wakeUp.wait(lock, [&pool]() { return pool->m_stop || pool->m_queued > 0; });
+    }
+}
+
+WorkStealingExecutor::WorkStealingExecutor(size_t concurrency, int numaNode)
+    : m_impl(std::make_shared<Impl>(concurrency, numaNode))
+{
+    for (size_t idx = 0; idx < m_impl->m_queues.size(); ++idx)
+    {
+        m_impl->m_threads.push_back(std::thread(&Impl::work, m_impl, idx));
+    }
+}
+
+WorkStealingExecutor::~WorkStealingExecutor()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_impl->m_sleepMutex);
+        m_impl->m_stop = true;
+    }
+    m_impl->m_wakeUp.notify_all();
+
+    for (size_t idx = 0; idx < m_impl->m_threads.size(); ++idx)
+    {
+        // the last reference to the executor can be dropped by one of its
+        // own tasks: that worker cannot be joined, it leaves on its own
+        if ( m_impl->m_threads[idx].get_id() == std::this_thread::get_id() )
+        {
+            m_impl->m_threads[idx].detach();
+        }
+        else
+        {
+            m_impl->m_threads[idx].join();
+        }
+    }
+}
+
+size_t WorkStealingExecutor::concurrency() const
+{
+    return m_impl->m_concurrency;
+}
+
+void WorkStealingExecutor::run(std::vector<Task>& tasks)
+{
+    if ( tasks.empty() ) return;
+
+    Batch batch(tasks.size());
+
+    if ( m_impl->m_queues.empty() )
+    {
+        for (size_t idx = 0; idx < tasks.size(); ++idx)
+        {
+            WorkItem item = { &tasks[idx], &batch, this };
+            execute(item);
+        }
+    }
+    else
+    {
+        std::vector<WorkItem> items(tasks.size());
+        for (size_t idx = 0; idx < tasks.size(); ++idx)
+        {
+            items[idx].task = &tasks[idx];
+            items[idx].batch = &batch;
+            items[idx].owner = this;
+        }
+        m_impl->push(items);
+
+        // help until the batch is done, with its own tasks only: the caller
+        // may be inside a task holding a lock (an operator, a memory
+        // reservation), and another batch could be waiting for it
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(batch.mutex);
+                if ( batch.pending == 0 ) break;
+            }
+
+            WorkItem item;
+            if ( m_impl->pop(&batch, item) )
+            {
+                execute(item);
+                continue;
+            }
+
+            // all the tasks of the batch were pushed at once: the last ones
+            // are running on other threads, wait for them
+            std::unique_lock<std::mutex> lock(batch.mutex);
+            batch.done.wait(lock, [&batch]() { return batch.pending == 0; });
+        }
+    }
+
+    if ( batch.error )
+    {
+        std::rethrow_exception(batch.error);
+    }
+}
+
+namespace
+{
+size_t defaultConcurrency()
+{
+    const char* value = std::getenv("LUMINANCE_THREADS");
+    if ( value != NULL )
+    {
+        const int numThreads = std::atoi(value);
+        if ( numThreads > 0 ) return static_cast<size_t>(numThreads);
+    }
+    return 0;
+}
+
+std::mutex s_executorMutex;
+ExecutorPtr s_executor;
+}
+
+ExecutorPtr executor()
+{
+    if ( s_scopedExecutor ) return s_scopedExecutor;
+
+    std::lock_guard<std::mutex> lock(s_executorMutex);
+    if ( !s_executor )
+    {
+        s_executor = std::make_shared<WorkStealingExecutor>(defaultConcurrency());
+    }
+    return s_executor;
+}
+
+void setExecutor(const ExecutorPtr& executor)
+{
+    ExecutorPtr previous;
+    {
+        std::lock_guard<std::mutex> lock(s_executorMutex);
+        previous = s_executor;
+        s_executor = executor;
+    }
+    // previous is released here, outside the lock: the destructor of a
+    // pool joins its threads
+}
+
+void setConcurrency(size_t concurrency)
+{
+    ExecutorPtr pool = std::make_shared<WorkStealingExecutor>(concurrency);
+#ifdef _OPENMP
+    omp_set_num_threads(static_cast<int>(pool->concurrency()));
+#endif
+    setExecutor(pool);
+}
+
+size_t concurrency()
+{
+    return executor()->concurrency();
+}
+
+ScopedExecutor::ScopedExecutor(const ExecutorPtr& executor)
+    : m_previous(s_scopedExecutor)
+    , m_previousTeamSize(0)
+{
+    s_scopedExecutor = executor;
+#ifdef _OPENMP
+    m_previousTeamSize = omp_get_max_threads();
+    omp_set_num_threads(static_cast<int>(executor->concurrency()));
+#endif
+}
+
+ScopedExecutor::~ScopedExecutor()
+{
+#ifdef _OPENMP
+    omp_set_num_threads(m_previousTeamSize);
+#endif
+    s_scopedExecutor = m_previous;
+}
+
+ExecutorPtr numaNodeExecutor(size_t node)
+{
+    static std::mutex s_mutex;
+    static std::vector<ExecutorPtr> s_executors(numaNodeCount());
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if ( node >= s_executors.size() ) node = 0;
+    if ( !s_executors[node] )
+    {
+        s_executors[node] = std::make_shared<WorkStealingExecutor>(0, static_cast<int>(node));
+    }
+    return s_executors[node];
+}
+
+namespace detail {
+Executor& loopExecutor(ExecutorPtr& holder)
+{
+    if ( s_taskExecutor != NULL ) return *s_taskExecutor;
+
+    holder = executor();
+    return *holder;
+}
+}
+
+}   // utils
+}   // pfs
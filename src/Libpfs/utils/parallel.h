@@ -0,0 +1,169 @@
+/*
+* This file is a part of Luminance HDR package.
+* ----------------------------------------------------------------------
+*
+*  This library is free software; you can redistribute it and/or
+*  modify it under the terms of the GNU Lesser General Public
+*  License as published by the Free Software Foundation; either
+*  version 2.1 of the License, or (at your option) any later version.
+*
+*  This library is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*  Lesser General Public License for more details.
+*
+*  You should have received a copy of the GNU Lesser General Public
+*  License along with this library; if not, write to the Free Software
+*  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+* ----------------------------------------------------------------------
+*/
+
+#ifndef PFS_UTILS_PARALLEL_H
+#define PFS_UTILS_PARALLEL_H
+
+//! \brief Task and parallel-for interface shared by the library: all the
+//! parallel loops go through one executor, so nested calls (an operator
+//! running inside a batch job, a resize inside an operator) share the same
+//! threads instead of multiplying them
+//!
+//! The default executor is a WorkStealingExecutor sized on the number of
+//! hardware threads, or on the environment variable LUMINANCE_THREADS.
+//! Applications that embed the library and own their threads can install
+//! their own executor with setExecutor().
+//! Not ported yet: the OpenMP loops of the operators (run on one thread
+//! from the pool threads, see WorkStealingExecutor), QtConcurrent in the
+//! HDR creation and alignment, and the threads of the batch tone mapper
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace pfs {
+namespace utils {
+
+//! \brief grain of the loops over the samples of a frame: shorter loops
+//! cost more to split than to run
+const size_t PARALLEL_SAMPLES_GRAIN = 16384;
+
+class Executor
+{
+public:
+    typedef std::function<void ()> Task;
+
+    virtual ~Executor() {}
+
+    //! \brief number of threads that can run tasks at the same time,
+    //! the calling thread included
+    virtual size_t concurrency() const = 0;
+
+    //! \brief run all the \a tasks and return when they are done. The
+    //! calling thread takes part in the work, with these tasks only, and a
+    //! task can call run() again (nested parallelism) without deadlocks,
+    //! even while it holds a lock. The first exception thrown by a task is
+    //! rethrown once all the tasks are done
+    virtual void run(std::vector<Task>& tasks) = 0;
+};
+
+typedef std::shared_ptr<Executor> ExecutorPtr;
+
+//! \brief pool of concurrency() - 1 threads, each with its own queue: a
+//! thread takes the newest task of its queue (the one whose data is still
+//! in cache) and, when the queue is empty, steals the oldest task of the
+//! others. Tasks spawned by a task go in the queue of its thread, so nested
+//! loops stay on the same core unless another one is idle.
+//! Tasks from outside the pool are dealt in contiguous runs, one run per
+//! queue, so the same split of a frame goes to the same threads at every
+//! loop; on a NUMA machine the threads are spread over the nodes in the
+//! same order, and a frame initialised by the pool stays local to them.
+//! OpenMP regions reached from the pool threads run on one thread, so the
+//! code not ported to the executor yet does not oversubscribe the machine
+class WorkStealingExecutor : public Executor
+{
+public:
+    //! \param concurrency total number of threads, 0 for the number of
+    //! hardware threads (of \a numaNode, if given)
+    //! \param numaNode bind all the threads to this NUMA node; by default
+    //! they are spread over all the nodes
+    explicit WorkStealingExecutor(size_t concurrency = 0, int numaNode = -1);
+    ~WorkStealingExecutor();
+
+    size_t concurrency() const;
+    void run(std::vector<Task>& tasks);
+
+private:
+    WorkStealingExecutor(const WorkStealingExecutor&);
+    WorkStealingExecutor& operator=(const WorkStealingExecutor&);
+
+    struct Impl;
+    std::shared_ptr<Impl> m_impl;
+};
+
+//! \brief executor of the loops started by the calling thread: the one of a
+//! ScopedExecutor, or the one of the library, created on first use
+ExecutorPtr executor();
+//! \brief install \a executor for all the following calls (the running ones
+//! finish on the previous executor); NULL restores the default one
+void setExecutor(const ExecutorPtr& executor);
+
+//! \brief replace the executor with a WorkStealingExecutor of \a concurrency
+//! threads (0 for the number of hardware threads). The size of the OpenMP
+//! teams of the calling thread is set to the same value, for the loops that
+//! still use OpenMP and for FFTW
+void setConcurrency(size_t concurrency);
+//! \brief concurrency of the current executor
+size_t concurrency();
+
+//! \brief run the loops started by the calling thread (and by the tasks
+//! they spawn) on \a executor for the lifetime of the object, for example
+//! the loops of a job bound to one NUMA node. The OpenMP teams of the
+//! thread are sized on the executor too
+class ScopedExecutor
+{
+public:
+    explicit ScopedExecutor(const ExecutorPtr& executor);
+    ~ScopedExecutor();
+
+private:
+    ScopedExecutor(const ScopedExecutor&);
+    ScopedExecutor& operator=(const ScopedExecutor&);
+
+    ExecutorPtr m_previous;
+    int m_previousTeamSize;
+};
+
+//! \brief executor bound to the NUMA node \a node, with a thread for each of
+//! its CPUs: created on first use, and shared by all the jobs on the node
+ExecutorPtr numaNodeExecutor(size_t node);
+
+//! \brief call \a body(b, e) on consecutive sub-ranges covering
+//! [\a begin, \a end), in parallel on the executor. Ranges are never
+//! shorter than \a grain, so loops shorter than twice \a grain run inline.
+//! The split only depends on the range, the grain and the concurrency of
+//! the executor, never on the timing
+template <typename Body>
+void parallelFor(size_t begin, size_t end, size_t grain, const Body& body);
+
+//! \brief sum of \a blockSum(b) for the blocks b in [0, \a numBlocks),
+//! computed in parallel and added up in order: unlike an OpenMP reduction,
+//! the result does not change with the number of threads
+template <typename Type, typename BlockSum>
+Type parallelSum(size_t numBlocks, const BlockSum& blockSum);
+
+namespace detail {
+//! \brief true inside an OpenMP parallel region, where a nested loop must
+//! not spawn more work
+bool insideOpenMP();
+
+//! \brief executor for a loop of the calling thread: the one running the
+//! current task, so nested loops stay on the same pool, or executor().
+//! \a holder keeps the latter alive during the loop
+Executor& loopExecutor(ExecutorPtr& holder);
+}
+
+}   // utils
+}   // pfs
+
+#include <Libpfs/utils/parallel.hxx>
+
+#endif // PFS_UTILS_PARALLEL_H
@@ -0,0 +1,92 @@
+/*
+* This file is a part of Luminance HDR package.
+* ----------------------------------------------------------------------
+*
+*  This library is free software; you can redistribute it and/or
+*  modify it under the terms of the GNU Lesser General Public
+*  License as published by the Free Software Foundation; either
+*  version 2.1 of the License, or (at your option) any later version.
+*
+*  This library is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*  Lesser General Public License for more details.
+*
+*  You should have received a copy of the GNU Lesser General Public
+*  License along with this library; if not, write to the Free Software
+*  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+* ----------------------------------------------------------------------
+*/
+
+#ifndef PFS_UTILS_PARALLEL_HXX
+#define PFS_UTILS_PARALLEL_HXX
+
+#include <Libpfs/utils/parallel.h>
+
+#include <algorithm>
+
+namespace pfs {
+namespace utils {
+
+namespace detail {
+//! \brief a few chunks per thread, so an idle thread always finds something
+//! to steal
+const size_t PARALLEL_CHUNKS_PER_THREAD = 4;
+}
+
+template <typename Body>
+void parallelFor(size_t begin, size_t end, size_t grain, const Body& body)
+{
+    if ( end <= begin ) return;
+
+    const size_t size = end - begin;
+    grain = std::max<size_t>(grain, 1);
+
+    ExecutorPtr holder;
+    Executor& exec = detail::loopExecutor(holder);
+    const size_t numChunks = std::min(size/grain,
+                                      detail::PARALLEL_CHUNKS_PER_THREAD*exec.concurrency());
+
+    if ( numChunks <= 1 || detail::insideOpenMP() )
+    {
+        body(begin, end);
+        return;
+    }
+
+    std::vector<Executor::Task> tasks;
+    tasks.reserve(numChunks);
+    for (size_t chunk = 0; chunk < numChunks; ++chunk)
+    {
+        // sizes differ by one element at most
+        const size_t first = begin + size*chunk/numChunks;
+        const size_t last = begin + size*(chunk + 1)/numChunks;
+        tasks.push_back([&body, first, last]() { body(first, last); });
+    }
+    exec.run(tasks);
+}
+
+template <typename Type, typename BlockSum>
+Type parallelSum(size_t numBlocks, const BlockSum& blockSum)
+{
+    std::vector<Type> partials(numBlocks, Type());
+    parallelFor(0, numBlocks, 1,
+                [&](size_t first, size_t last)
+    {
+        for (size_t block = first; block < last; ++block)
+        {
+            partials[block] = blockSum(block);
+        }
+    });
+
+    Type sum = Type();
+    for (size_t block = 0; block < numBlocks; ++block)
+    {
+        sum += partials[block];
+    }
+    return sum;
+}
+
+}   // utils
+}   // pfs
+
+#endif // PFS_UTILS_PARALLEL_HXX
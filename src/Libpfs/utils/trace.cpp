@@ -0,0 +1,408 @@
+/*
+* This file is a part of Luminance HDR package.
+* ----------------------------------------------------------------------
+*
+*  This library is free software; you can redistribute it and/or
+*  modify it under the terms of the GNU Lesser General Public
+*  License as published by the Free Software Foundation; either
+*  version 2.1 of the License, or (at your option) any later version.
+*
+*  This library is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*  Lesser General Public License for more details.
+*
+*  You should have received a copy of the GNU Lesser General Public
+*  License along with this library; if not, write to the Free Software
+*  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+* ----------------------------------------------------------------------
+*/
+
+//! \brief Instrumentation of the pipeline
+
+#include <Libpfs/utils/trace.h>
+#include <Libpfs/utils/memorybudget.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <ostream>
+
+#ifdef __linux__
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+namespace pfs {
+namespace utils {
+
+namespace
+{
+const char* MEMORY_COUNTER = "resident memory";
+
+//! \brief events kept for the Chrome trace: past this, only the totals of
+//! the stages and of the counters are updated
+const size_t TRACE_MAX_EVENTS = 1 << 20;
+
+struct TraceEvent
+{
+    char phase;         // 'X' span, 'C' counter
+    std::string name;
+    std::string detail;
+    int64_t timestamp;  // usec
+    int64_t duration;   // usec, spans
+    int64_t value;      // counters
+    int thread;
+};
+
+struct TraceLog
+{
+    TraceLog()
+        : m_peakMemory(0)
+    {}
+
+    std::mutex m_mutex;
+    std::vector<TraceEvent> m_events;
+    std::vector<TraceStage> m_stages;
+    std::map<std::string, size_t> m_stageIndex;
+    std::vector<TraceCounter> m_counters;
+    std::map<std::string, size_t> m_counterIndex;
+    size_t m_peakMemory;
+};
+
+TraceLog& traceLog()
+{
+    static TraceLog s_log;
+    return s_log;
+}
+
+bool tracingFromEnvironment()
+{
+    const char* value = std::getenv("LUMINANCE_TRACE");
+    return value != NULL && std::string(value) != "0";
+}
+
+std::atomic<bool> s_tracing(tracingFromEnvironment());
+
+int64_t now()
+{
+    typedef std::chrono::steady_clock Clock;
+    static const Clock::time_point s_origin = Clock::now();
+
+    return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - s_origin).count();
+}
+
+int threadIndex()
+{
+    static std::atomic<int> s_nextIndex(0);
+    thread_local int s_index = s_nextIndex++;
+    return s_index;
+}
+
+size_t residentMemory()
+{
+#ifdef __linux__
+    FILE* statm = std::fopen("/proc/self/statm", "r");
+    if ( statm == NULL ) return 0;
+
+    unsigned long size = 0;
+    unsigned long resident = 0;
+    const int numFields = std::fscanf(statm, "%lu %lu", &size, &resident);
+    std::fclose(statm);
+
+    if ( numFields != 2 ) return 0;
+    return static_cast<size_t>(resident)*static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#else
+    return 0;
+#endif
+}
+
+int64_t& counterTotal(TraceLog& log, const std::string& name)
+{
+    std::map<std::string, size_t>::iterator it = log.m_counterIndex.find(name);
+    if ( it == log.m_counterIndex.end() )
+    {
+        TraceCounter counter = { name, 0 };
+        it = log.m_counterIndex.insert(std::make_pair(name, log.m_counters.size())).first;
+        log.m_counters.push_back(counter);
+    }
+    return log.m_counters[it->second].total;
+}
+
+void pushEvent(TraceLog& log, const TraceEvent& event)
+{
+    if ( log.m_events.size() < TRACE_MAX_EVENTS )
+    {
+        log.m_events.push_back(event);
+    }
+}
+
+void writeJsonString(std::ostream& out, const std::string& str)
+{
+    out << '"';
+    for (size_t idx = 0; idx < str.size(); ++idx)
+    {
+        const unsigned char c = str[idx];
+        switch ( c )
+        {
+        case '"': out << "\\\""; break;
+        case '\\': out << "\\\\"; break;
+        case '\n': out << "\\n"; break;
+        case '\t': out << "\\t"; break;
+        default:
+            if ( c < 0x20 )
+            {
+                char code[8];
+                std::snprintf(code, sizeof(code), "\\u%04x", c);
+                out << code;
+            }
+            else
+            {
+                out << c;
+            }
+        }
+    }
+    out << '"';
+}
+}
+
+bool isTracing()
+{
+    return s_tracing.load(std::memory_order_relaxed);
+}
+
+void setTracing(bool enable)
+{
+    s_tracing = enable;
+}
+
+std::string traceFileFromEnvironment()
+{
+    const char* value = std::getenv("LUMINANCE_TRACE");
+    if ( value == NULL ) return std::string();
+
+    const std::string filename(value);
+    if ( filename == "0" || filename == "1" ) return std::string();
+    return filename;
+}
+
+TraceSpan::TraceSpan(const char* name, const std::string& detail)
+    : m_name(NULL)
+    , m_start(0)
+{
+    if ( !isTracing() ) return;
+
+    m_name = name;
+    m_detail = detail;
+    m_start = now();
+}
+
+TraceSpan::~TraceSpan()
+{
+    if ( m_name == NULL ) return;
+
+    const int64_t duration = now() - m_start;
+    const size_t memory = residentMemory();
+
+    TraceLog& log = traceLog();
+    std::lock_guard<std::mutex> lock(log.m_mutex);
+
+    std::map<std::string, size_t>::iterator it = log.m_stageIndex.find(m_name);
+    if ( it == log.m_stageIndex.end() )
+    {
+        TraceStage stage = { m_name, 0, 0., 0. };
+        it = log.m_stageIndex.insert(std::make_pair(std::string(m_name), log.m_stages.size())).first;
+        log.m_stages.push_back(stage);
+    }
+    TraceStage& stage = log.m_stages[it->second];
+    stage.calls++;
+    stage.totalMs += duration/1000.;
+    stage.maxMs = std::max(stage.maxMs, duration/1000.);
+
+    TraceEvent span = { 'X', m_name, m_detail, m_start, duration, 0, threadIndex() };
+    pushEvent(log, span);
+
+    if ( memory > 0 )
+    {
+        log.m_peakMemory = std::max(log.m_peakMemory, memory);
+        TraceEvent sample = { 'C', MEMORY_COUNTER, std::string(), m_start + duration, 0,
+                              static_cast<int64_t>(memory), threadIndex() };
+        pushEvent(log, sample);
+    }
+}
+
+void traceCount(const char* name, int64_t value)
+{
+    if ( !isTracing() ) return;
+
+    const int64_t timestamp = now();
+
+    TraceLog& log = traceLog();
+    std::lock_guard<std::mutex> lock(log.m_mutex);
+
+    int64_t& total = counterTotal(log, name);
+    total += value;
+
+    TraceEvent event = { 'C', name, std::string(), timestamp, 0, total, threadIndex() };
+    pushEvent(log, event);
+}
+
+void traceMemory()
+{
+    if ( !isTracing() ) return;
+
+    const int64_t timestamp = now();
+    const size_t memory = residentMemory();
+    if ( memory == 0 ) return;
+
+    TraceLog& log = traceLog();
+    std::lock_guard<std::mutex> lock(log.m_mutex);
+
+    log.m_peakMemory = std::max(log.m_peakMemory, memory);
+    TraceEvent sample = { 'C', MEMORY_COUNTER, std::string(), timestamp, 0,
+                          static_cast<int64_t>(memory), threadIndex() };
+    pushEvent(log, sample);
+}
+
+std::vector<TraceStage> traceStages()
+{
+    TraceLog& log = traceLog();
+    std::lock_guard<std::mutex> lock(log.m_mutex);
+    return log.m_stages;
+}
+
+std::vector<TraceCounter> traceCounters()
+{
+    TraceLog& log = traceLog();
+    std::lock_guard<std::mutex> lock(log.m_mutex);
+    return log.m_counters;
+}
+
+size_t tracePeakMemory()
+{
+    size_t peak = 0;
+    {
+        TraceLog& log = traceLog();
+        std::lock_guard<std::mutex> lock(log.m_mutex);
+        peak = log.m_peakMemory;
+    }
+#ifdef __linux__
+    // the samples can miss short peaks: the kernel keeps the high-water mark
+    struct rusage usage;
+    if ( getrusage(RUSAGE_SELF, &usage) == 0 )
+    {
+        peak = std::max(peak, static_cast<size_t>(usage.ru_maxrss)*1024);
+    }
+#endif
+    return peak;
+}
+
+void writeChromeTrace(std::ostream& out)
+{
+    TraceLog& log = traceLog();
+    std::lock_guard<std::mutex> lock(log.m_mutex);
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    for (size_t idx = 0; idx < log.m_events.size(); ++idx)
+    {
+        const TraceEvent& event = log.m_events[idx];
+
+        out << (idx ? ",\n" : "\n") << "{\"name\":";
+        writeJsonString(out, event.name);
+        out << ",\"cat\":\"luminance\",\"ph\":\"" << event.phase << "\""
+            << ",\"ts\":" << event.timestamp
+            << ",\"pid\":1,\"tid\":" << event.thread;
+        if ( event.phase == 'X' )
+        {
+            out << ",\"dur\":" << event.duration;
+            if ( !event.detail.empty() )
+            {
+                out << ",\"args\":{\"detail\":";
+                writeJsonString(out, event.detail);
+                out << "}";
+            }
+        }
+        else
+        {
+            out << ",\"args\":{";
+            writeJsonString(out, event.name);
+            out << ":" << event.value << "}";
+        }
+        out << "}";
+    }
+    out << "\n]}\n";
+}
+
+bool writeChromeTrace(const std::string& filename)
+{
+    std::ofstream file(filename.c_str());
+    if ( !file ) return false;
+
+    writeChromeTrace(file);
+    return static_cast<bool>(file);
+}
+
+void writeTraceSummary(std::ostream& out)
+{
+    const std::vector<TraceStage> stages = traceStages();
+    const std::vector<TraceCounter> counters = traceCounters();
+
+    const std::ios_base::fmtflags flags = out.flags();
+    const std::streamsize precision = out.precision();
+    out << std::fixed << std::setprecision(1);
+
+    out << std::left << std::setw(24) << "stage" << std::right
+        << std::setw(8) << "calls"
+        << std::setw(14) << "total ms"
+        << std::setw(12) << "mean ms"
+        << std::setw(12) << "max ms" << "\n";
+    for (size_t idx = 0; idx < stages.size(); ++idx)
+    {
+        const TraceStage& stage = stages[idx];
+        out << std::left << std::setw(24) << stage.name << std::right
+            << std::setw(8) << stage.calls
+            << std::setw(14) << stage.totalMs
+            << std::setw(12) << stage.totalMs/stage.calls
+            << std::setw(12) << stage.maxMs << "\n";
+    }
+
+    for (size_t idx = 0; idx < counters.size(); ++idx)
+    {
+        out << std::left << std::setw(24) << counters[idx].name << std::right
+            << std::setw(22) << counters[idx].total << "\n";
+    }
+
+    const size_t peak = tracePeakMemory();
+    if ( peak > 0 )
+    {
+        out << std::left << std::setw(24) << "peak memory" << std::right
+            << std::setw(19) << peak/(1024.*1024.) << " MB\n";
+    }
+    out << std::left << std::setw(24) << "peak frame memory" << std::right
+        << std::setw(19) << frameMemoryPeak()/(1024.*1024.) << " MB\n";
+
+    out.flags(flags);
+    out.precision(precision);
+}
+
+void resetTrace()
+{
+    TraceLog& log = traceLog();
+    std::lock_guard<std::mutex> lock(log.m_mutex);
+
+    log.m_events.clear();
+    log.m_stages.clear();
+    log.m_stageIndex.clear();
+    log.m_counters.clear();
+    log.m_counterIndex.clear();
+    log.m_peakMemory = 0;
+}
+
+}   // utils
+}   // pfs
@@ -0,0 +1,111 @@
+/*
+* This file is a part of Luminance HDR package.
+* ----------------------------------------------------------------------
+*
+*  This library is free software; you can redistribute it and/or
+*  modify it under the terms of the GNU Lesser General Public
+*  License as published by the Free Software Foundation; either
+*  version 2.1 of the License, or (at your option) any later version.
+*
+*  This library is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+*  Lesser General Public License for more details.
+*
+*  You should have received a copy of the GNU Lesser General Public
+*  License along with this library; if not, write to the Free Software
+*  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+* ----------------------------------------------------------------------
+*/
+
+#ifndef PFS_UTILS_TRACE_H
+#define PFS_UTILS_TRACE_H
+
+//! \brief Always compiled instrumentation of the pipeline: timed spans for
+//! the stages (read, align, fuse, tonemap, write...), counters of bytes and
+//! pixels, samples of the resident memory
+//!
+//! Tracing is off by default, and then a span costs a load of a flag. It is
+//! switched on by setTracing() or by the environment variable
+//! LUMINANCE_TRACE (any value but 0). The events can be written as a Chrome
+//! trace (to open in chrome://tracing or Perfetto) or as a summary table per
+//! stage
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+namespace pfs {
+namespace utils {
+
+bool isTracing();
+void setTracing(bool enable);
+//! \brief file named by LUMINANCE_TRACE, where the Chrome trace goes when
+//! the caller has no other name: empty if the variable is only a switch
+//! (0 or 1) or it is not set
+std::string traceFileFromEnvironment();
+
+//! \brief time spent between construction and destruction, recorded with
+//! the calling thread when tracing is on
+class TraceSpan
+{
+public:
+    //! \param name stage, a literal: spans with the same name are summed up
+    //! \param detail argument shown with the single event (a file name, an
+    //! operator...)
+    explicit TraceSpan(const char* name, const std::string& detail = std::string());
+    ~TraceSpan();
+
+private:
+    TraceSpan(const TraceSpan&);
+    TraceSpan& operator=(const TraceSpan&);
+
+    const char* m_name;
+    std::string m_detail;
+    int64_t m_start;
+};
+
+//! \brief add \a value to the counter \a name (bytes, pixels...)
+void traceCount(const char* name, int64_t value);
+//! \brief sample the resident memory of the process (spans do it when they
+//! end)
+void traceMemory();
+
+struct TraceStage
+{
+    std::string name;
+    size_t calls;
+    double totalMs;
+    double maxMs;
+};
+
+struct TraceCounter
+{
+    std::string name;
+    int64_t total;
+};
+
+//! \brief stages recorded so far, in order of first appearance
+std::vector<TraceStage> traceStages();
+std::vector<TraceCounter> traceCounters();
+//! \brief largest resident memory of the process, in bytes (0 if unknown)
+size_t tracePeakMemory();
+
+//! \brief Chrome trace of the events recorded so far
+void writeChromeTrace(std::ostream& out);
+//! \return false if \a filename cannot be written
+bool writeChromeTrace(const std::string& filename);
+//! \brief one line per stage (calls, total, mean, max), then the counters
+//! and the peak memory
+void writeTraceSummary(std::ostream& out);
+
+//! \brief drop the events recorded so far
+void resetTrace();
+
+}   // utils
+}   // pfs
+
+#endif // PFS_UTILS_TRACE_H
@@ -30,6 +30,8 @@
 #include <algorithm>
 #include <cassert>
 
+#include <Libpfs/utils/parallel.h>
+
 namespace pfs {
 namespace utils {
 
@@ -50,7 +52,7 @@ void transform(InputIterator in1, InputIterator in1End, InputIterator in2, Input
     }
 }
 
-// transform for random_access_iterator_tag, so we can use OpenMP (optimized)
+// transform for random_access_iterator_tag, so we can split the range (optimized)
 template <typename InputIterator, typename OutputIterator,
           typename ConversionOperator>
 void transform(InputIterator in1, InputIterator in1End, InputIterator in2, InputIterator in3,
@@ -60,11 +62,15 @@ void transform(InputIterator in1, InputIterator in1End, InputIterator in2, Input
 {
     typename std::iterator_traits<InputIterator>::difference_type
             numElem = (in1End - in1);
-#pragma omp parallel for
-    for ( int idx = 0; idx < numElem; ++idx) {
-        convOp(in1[idx], in2[idx], in3[idx],
-               out1[idx], out2[idx], out3[idx]);
-    }
+    parallelFor(0, numElem, PARALLEL_SAMPLES_GRAIN,
+                [&](size_t first, size_t last)
+    {
+        for (size_t idx = first; idx < last; ++idx)
+        {
+            convOp(in1[idx], in2[idx], in3[idx],
+                   out1[idx], out2[idx], out3[idx]);
+        }
+    });
 }
 
 }   // detail
@@ -98,7 +104,7 @@ void transform(InputIterator in1, InputIterator in1End, InputIterator in2, Input
     }
 }
 
-// transform for random_access_iterator_tag, so we can use OpenMP (optimized)
+// transform for random_access_iterator_tag, so we can split the range (optimized)
 template <typename InputIterator, typename OutputIterator,
           typename ConversionOperator>
 void transform(InputIterator in1, InputIterator in1End, InputIterator in2, InputIterator in3, InputIterator in4,
@@ -108,11 +114,15 @@ void transform(InputIterator in1, InputIterator in1End, InputIterator in2, Input
 {
     typename std::iterator_traits<InputIterator>::difference_type
             numElem = (in1End - in1);
-#pragma omp parallel for
-    for ( int idx = 0; idx < numElem; ++idx) {
-        convOp(in1[idx], in2[idx], in3[idx], in4[idx],
-               out1[idx], out2[idx], out3[idx]);
-    }
+    parallelFor(0, numElem, PARALLEL_SAMPLES_GRAIN,
+                [&](size_t first, size_t last)
+    {
+        for (size_t idx = first; idx < last; ++idx)
+        {
+            convOp(in1[idx], in2[idx], in3[idx], in4[idx],
+                   out1[idx], out2[idx], out3[idx]);
+        }
+    });
 }
 
 }   // detail
@@ -146,7 +156,7 @@ void transform(InputIterator in1, InputIterator in1End, InputIterator in2, Input
     }
 }
 
-// transform for random_access_iterator_tag, so we can use OpenMP (optimized)
+// transform for random_access_iterator_tag, so we can split the range (optimized)
 template <typename InputIterator, typename OutputIterator,
           typename ConversionOperator>
 void transform(InputIterator in1, InputIterator in1End, InputIterator in2, InputIterator in3,
@@ -155,10 +165,14 @@ void transform(InputIterator in1, InputIterator in1End, InputIterator in2, Input
 {
     typename std::iterator_traits<InputIterator>::difference_type
             numElem = (in1End - in1);
-#pragma omp parallel for
-    for ( int idx = 0; idx < numElem; ++idx) {
-        convOp(in1[idx], in2[idx], in3[idx], out[idx]);
-    }
+    parallelFor(0, numElem, PARALLEL_SAMPLES_GRAIN,
+                [&](size_t first, size_t last)
+    {
+        for (size_t idx = first; idx < last; ++idx)
+        {
+            convOp(in1[idx], in2[idx], in3[idx], out[idx]);
+        }
+    });
 }
 
 }   // detail
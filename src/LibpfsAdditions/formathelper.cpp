@@ -30,6 +30,7 @@
 #define KEY_EXPORT_FORMAT "FileFormats/Format"
 #define KEY_EXPORT_TIFF_MODE "FileFormats/TiffMode"
 #define KEY_EXPORT_QUALITY "FileFormats/Quality"
+#define KEY_EXPORT_TARGET_SIZE "FileFormats/TargetSize"
 
 namespace pfsadditions
 {
@@ -187,10 +188,14 @@ void FormatHelper::buttonPressed()
             qual = quality;
 
         ImageQualityDialog d(NULL, format == 21 ? "png" : "jpg", qual, m_settingsButton);
+        size_t targetSize = 0;
+        m_params.get("target_size", targetSize);
+        d.setTargetSize(targetSize);
         if (d.exec() == QDialog::Accepted)
         {
             size_t quality = d.getQuality();
             m_params.set("quality", quality);
+            m_params.set("target_size", d.getTargetSize());
         }
 
     }
@@ -239,6 +244,11 @@ void FormatHelper::writeSettings(LuminanceOptions& options, QString prefix)
         int qual = quality;
         options.setValue(prefix + "/" + KEY_EXPORT_QUALITY, qual);
     }
+    size_t targetSize;
+    if (m_params.get("target_size", targetSize))
+    {
+        options.setValue(prefix + "/" + KEY_EXPORT_TARGET_SIZE, qulonglong(targetSize));
+    }
 
 }
 
@@ -256,6 +266,11 @@ pfs::Params FormatHelper::getParamsFromSettings(const LuminanceOptions& options,
         size_t qual = quality;
         params.set("quality", qual);
     }
+    size_t targetSize = options.value(prefix + "/" + KEY_EXPORT_TARGET_SIZE, 0).toULongLong();
+    if (targetSize > 0)
+    {
+        params.set("target_size", targetSize);
+    }
     return params;
 }
 
@@ -25,6 +25,8 @@
  *
  */
 
+#include <QFile>
+#include <QFileInfo>
 #include <QTimer>
 #include <QDebug>
 #include <iostream>
@@ -44,6 +46,11 @@
 
 #include "Libpfs/tm/TonemapOperator.h"
 #include "Libpfs/manip/gamma_levels.h"
+#include "Libpfs/progress.h"
+#include "Libpfs/resultcache.h"
+#include "Libpfs/utils/memorybudget.h"
+#include "Libpfs/utils/parallel.h"
+#include "Libpfs/utils/trace.h"
 
 #include <boost/program_options.hpp>
 
@@ -92,6 +99,25 @@ float toFloatWithErrMsg(const QString &str)
     return ret;
 }
 
+//! OPTION:FIRST:LAST:STEPS of --sweep and --sweepRows
+pfs::SweepAxis toSweepAxisWithErrMsg(const std::string& value)
+{
+    const QStringList fields = QString::fromStdString(value).split(':');
+    if (fields.size() != 4 || fields[0].isEmpty())
+    {
+        printErrorAndExit(QObject::tr("Error: %1 is not OPTION:FIRST:LAST:STEPS").arg(QString::fromStdString(value)));
+    }
+    bool ok;
+    const int steps = fields[3].toInt(&ok);
+    if (!ok || steps < 1)
+    {
+        printErrorAndExit(QObject::tr("Error: the steps of a sweep must be at least 1."));
+    }
+    return pfs::SweepAxis(fields[0].toStdString(),
+                          toFloatWithErrMsg(fields[1]), toFloatWithErrMsg(fields[2]),
+                          static_cast<size_t>(steps));
+}
+
 }
 
 CommandLineInterfaceManager::CommandLineInterfaceManager(const int argc, char **argv):
@@ -112,7 +138,9 @@ CommandLineInterfaceManager::CommandLineInterfaceManager(const int argc, char **
     htmlQuality(2),
     pageName(),
     imagesDir(),
-    saveAlignedImagesPrefix("")
+    saveAlignedImagesPrefix(""),
+    isTraceSummary(false),
+    sweepCellWidth(256)
 {
 
     hdrcreationconfig.weightFunction = WEIGHT_TRIANGULAR;
@@ -140,6 +168,7 @@ int CommandLineInterfaceManager::execCommandLineParams()
         //
         ("load,l", po::value<std::string>(),       tr("HDR_FILE Load an HDR instead of creating a new one.").toUtf8().constData())
         ("save,s", po::value<std::string>(),       tr("HDR_FILE Save to a HDR file format. (default: don't save)").toUtf8().constData())
+        ("saveExrTiles", po::value<std::string>(),       tr("[one|mipmap|ripmap] Save OpenEXR files as tiles, with reduced levels that can be read without the full image (default: scanlines)").toUtf8().constData())
         ("gamma,g", po::value<float>(&tmopts->pregamma),       tr("VALUE        Gamma value to use during tone mapping. (default: 1) ").toUtf8().constData())
         ("resize,r", po::value<int>(&tmopts->xsize),       tr("VALUE       Width you want to resize your HDR to (resized before gamma and tone mapping)").toUtf8().constData())
 
@@ -147,6 +176,11 @@ int CommandLineInterfaceManager::execCommandLineParams()
         ("autoag,t", po::value<float>(&threshold),       tr("THRESHOLD   Enable auto anti-ghosting with given threshold. (0.0-1.0)").toUtf8().constData())
         ("autolevels,b", tr("Apply autolevels correction after tonemapping.").toUtf8().constData())
         ("createwebpage,w", tr("Enable generation of a webpage with embedded HDR viewer.").toUtf8().constData())
+        ("threads,j", po::value<int>(),       tr("NUM   Number of threads to use (default: all the cores, or LUMINANCE_THREADS).").toUtf8().constData())
+        ("memoryBudget", po::value<int>(),       tr("MB    Images loaded at the same time may use at most MB megabytes (default: no limit, or LUMINANCE_MEMORY_BUDGET).").toUtf8().constData())
+        ("resultCache", po::value<int>(),       tr("MB    Keep up to MB megabytes of tone mapped images in the temporary folder, and reuse them when the HDR and the options did not change (default: 0, disabled).").toUtf8().constData())
+        ("trace", po::value<std::string>(),       tr("FILE  Write the timings of the pipeline stages to FILE, as a Chrome trace (chrome://tracing).").toUtf8().constData())
+        ("traceSummary", tr("Print the time spent in each stage of the pipeline.").toUtf8().constData())
     ;
 
     po::options_description hdr_desc(tr("HDR creation parameters  - you must either load an existing HDR file (via the -l option) or specify INPUTFILES to create a new HDR").toUtf8().constData());
@@ -162,6 +196,7 @@ int CommandLineInterfaceManager::execCommandLineParams()
         ("ldrQuality,q", po::value<int>(), tr("VALUE      Quality of the saved tone mapped file (1-100).").toUtf8().constData())
         ("ldrTiff", po::value<std::string>(), tr("Tiff format. Legal values are [8b|16b|32b|logluv] (Default is 8b)").toUtf8().constData())
         ("ldrTiffDeflate", po::value<bool>(), tr("Tiff deflate compression. true|false (Default is true)").toUtf8().constData())
+        ("ldrTargetSize", po::value<int>(), tr("KB    Save JPEG and PNG files at the highest quality that fits in KB kilobytes (overrides ldrQuality).").toUtf8().constData())
         ;
 
     po::options_description html_desc(tr("HTML output parameters").toUtf8().constData());
@@ -186,6 +221,7 @@ directory must exist.  Useful to avoid clutter in the current directory. \
     tmo_desc.add_options()
         ("tmo", po::value<std::string>(),       tr("Tone mapping operator. Legal values are: [ashikhmin|drago|durand|fattal|ferradans|pattanaik|reinhard02|reinhard05|mai|mantiuk06|mantiuk08] (Default is mantiuk06)").toUtf8().constData())
         ("tmofile", po::value<std::string>(),   tr("SETTING_FILE Load an existing setting file containing pre-gamma and all TMO settings").toUtf8().constData())
+        ("tmoFastMath", po::value<bool>(&tmopts->fastMath), tr("BOOL Faster and less accurate log/exp/pow in the operator (default: false)").toUtf8().constData())
     ;
 
     po::options_description tmo_fattal(tr(" Fattal").toUtf8().constData());
@@ -266,6 +302,14 @@ directory must exist.  Useful to avoid clutter in the current directory. \
     tmo_desc.add(tmo_ash);
     tmo_desc.add(tmo_patt);
 
+    po::options_description tmo_sweep(tr("Parameter sweep  - every variant is saved next to the -o contact sheet, as NAME_OPTION-VALUE.EXT").toUtf8().constData());
+    tmo_sweep.add_options()
+        ("sweep", po::value<std::string>(), tr("OPTION:FIRST:LAST:STEPS Tone map with STEPS values of OPTION, from FIRST to LAST, one for each column of the contact sheet. OPTION is an option of the operator (e.g. contrastfactor for mantiuk06, bias for drago)").toUtf8().constData())
+        ("sweepRows", po::value<std::string>(), tr("OPTION:FIRST:LAST:STEPS Second option of the sweep, one value for each row of the contact sheet").toUtf8().constData())
+        ("sweepCellWidth", po::value<int>(&sweepCellWidth), tr("VALUE Width of the variants in the contact sheet (Default is 256)").toUtf8().constData())
+        ;
+    tmo_desc.add(tmo_sweep);
+
 
     po::options_description hidden("Hidden options");
     hidden.add_options()
@@ -307,6 +351,36 @@ directory must exist.  Useful to avoid clutter in the current directory. \
                 cout << *list++ << endl;
             return 1;
         }
+        if (vm.count("threads")) {
+            const int numThreads = vm["threads"].as<int>();
+            if (numThreads < 1)
+                printErrorAndExit(tr("Error: threads must be at least 1."));
+            pfs::utils::setConcurrency(numThreads);
+        }
+        if (vm.count("memoryBudget")) {
+            const int megabytes = vm["memoryBudget"].as<int>();
+            if (megabytes < 0)
+                printErrorAndExit(tr("Error: the memory budget cannot be negative."));
+            pfs::utils::setMemoryBudget(size_t(megabytes)*1024*1024);
+        }
+        if (vm.count("resultCache")) {
+            const int megabytes = vm["resultCache"].as<int>();
+            if (megabytes < 0)
+                printErrorAndExit(tr("Error: the size of the result cache cannot be negative."));
+            pfs::setSharedResultCache(QFile::encodeName(LuminanceOptions().getResultCacheDir()).constData(),
+                                      size_t(megabytes)*1024*1024);
+        }
+        if (vm.count("trace")) {
+            traceFilename = vm["trace"].as<std::string>();
+            pfs::utils::setTracing(true);
+        }
+        else {
+            traceFilename = pfs::utils::traceFileFromEnvironment();
+        }
+        if (vm.count("traceSummary")) {
+            isTraceSummary = true;
+            pfs::utils::setTracing(true);
+        }
         if (vm.count("autolevels")) {
             isAutolevels = true;
         }
@@ -378,7 +452,7 @@ directory must exist.  Useful to avoid clutter in the current directory. \
                 printErrorAndExit(tr("Error: Unknown HDR creation model specified."));
         }
         if (vm.count("hdrCurveFilename"))
-            hdrcreationconfig.inputResponseCurveFilename = QString::fromStdString(vm["hdrCurveFilename"].as<std::string>());
+            hdrcreationconfig.inputResponseCurveFilename = vm["hdrCurveFilename"].as<std::string>();
         if (vm.count("tmo")) {
             const char* value = vm["tmo"].as<std::string>().c_str();
             if (strcmp(value,"ashikhmin")==0)
@@ -427,6 +501,26 @@ directory must exist.  Useful to avoid clutter in the current directory. \
             }
         }
 
+        if (vm.count("sweep"))
+            sweepColumns = toSweepAxisWithErrMsg(vm["sweep"].as<std::string>());
+        if (vm.count("sweepRows")) {
+            if (!vm.count("sweep"))
+                printErrorAndExit(tr("Error: --sweepRows needs --sweep."));
+            sweepRows = toSweepAxisWithErrMsg(vm["sweepRows"].as<std::string>());
+        }
+        if (vm.count("sweep")) {
+            if (sweepCellWidth < 1)
+                printErrorAndExit(tr("Error: the width of the cells must be at least 1."));
+            try
+            {
+                pfs::TonemapSweep(*tmopts, sweepColumns, sweepRows);
+            }
+            catch (std::runtime_error& e)
+            {
+                printErrorAndExit(tr("Error: %1").arg(e.what()));
+            }
+        }
+
         if (vm.count("ldrQuality")) {
             int quality = vm["ldrQuality"].as<int>();
             if (quality < 1 || quality > 100)
@@ -449,11 +543,23 @@ directory must exist.  Useful to avoid clutter in the current directory. \
         }
         if (vm.count("ldrTiffDeflate"))
             tmofileparams->set("deflateCompression", vm["ldrTiffDeflate"].as<bool>());
+        if (vm.count("ldrTargetSize")) {
+            const int kilobytes = vm["ldrTargetSize"].as<int>();
+            if (kilobytes < 1)
+                printErrorAndExit(tr("Error: the target size must be at least 1 KB."));
+            tmofileparams->set("target_size", size_t(kilobytes)*1024);
+        }
 
         if (vm.count("load"))
             loadHdrFilename = QString::fromStdString(vm["load"].as<std::string>());
         if (vm.count("save"))
             saveHdrFilename = QString::fromStdString(vm["save"].as<std::string>());
+        if (vm.count("saveExrTiles")) {
+            const std::string value = vm["saveExrTiles"].as<std::string>();
+            if (value != "one" && value != "mipmap" && value != "ripmap")
+                printErrorAndExit(tr("Error: Unknown OpenEXR tiles mode."));
+            saveHdrParams.set("exr_tiles", value);
+        }
         if (vm.count("output"))
             saveLdrFilename = QString::fromStdString(vm["output"].as<std::string>());
         if (vm.count("savealigned"))
@@ -528,6 +634,7 @@ void CommandLineInterfaceManager::execCommandLineParamsSlot()
             printIfVerbose(QObject::tr("Using %n threads.", "", luminance_options.getNumThreads()), verbose);
         }
         hdrCreationManager.reset( new HdrCreationManager(true) );
+        connect(hdrCreationManager.data(), SIGNAL(duplicatesSkipped(QStringList)), this, SLOT(duplicatesSkipped(QStringList)));
         connect(hdrCreationManager.data(), SIGNAL(finishedLoadingFiles()), this, SLOT(finishedLoadingInputFiles()));
         connect(hdrCreationManager.data(), SIGNAL(finishedAligning(int)), this, SLOT(createHDR(int)));
         connect(hdrCreationManager.data(), SIGNAL(ais_failed(QProcess::ProcessError)), this, SLOT(ais_failed(QProcess::ProcessError)));
@@ -566,6 +673,16 @@ void CommandLineInterfaceManager::execCommandLineParamsSlot()
     }
 }
 
+void CommandLineInterfaceManager::duplicatesSkipped(const QStringList& files)
+{
+    // always printed: the EV values of the command line are assigned to
+    // the images left
+    foreach(const QString& file, files)
+    {
+        printIfVerbose(tr("Warning: skipped %1").arg(file), true);
+    }
+}
+
 void CommandLineInterfaceManager::finishedLoadingInputFiles()
 {
     QStringList filesLackingExif = hdrCreationManager->getFilesWithoutExif();
@@ -639,7 +756,7 @@ void CommandLineInterfaceManager::saveHDR()
         printIfVerbose( tr("Saving to file %1.").arg(saveHdrFilename) , verbose);
 
         // write_hdr_frame by default saves to EXR, if it doesn't find a supported file type
-        if ( IOWorker().write_hdr_frame(HDR.data(), saveHdrFilename) )
+        if ( IOWorker().write_hdr_frame(HDR.data(), saveHdrFilename, saveHdrParams) )
         {
             printIfVerbose( tr("Image %1 saved successfully").arg(saveHdrFilename) , verbose);
         }
@@ -700,8 +817,15 @@ void  CommandLineInterfaceManager::startTonemap()
         if(tmopts->pregamma != 1)
             printIfVerbose( tr("Applying gamma %1.").arg(tmopts->pregamma) , verbose);
 
+        if (!sweepColumns.option.empty())
+        {
+            startSweep();
+            return;
+        }
+
         // Build TMWorker
         TMWorker tm_worker;
+        tm_worker.setResultCacheEnabled(true);
         connect(&tm_worker, SIGNAL(tonemapSetMaximum(int)), this, SLOT(setProgressBar(int)));
         connect(&tm_worker, SIGNAL(tonemapSetValue(int)), this, SLOT(updateProgressBar(int)));
 
@@ -715,20 +839,21 @@ void  CommandLineInterfaceManager::startTonemap()
         else
             inputfname = inputFiles.first();
 
-        //Autolevels
+        //Autolevels: the writer applies them while it quantises the frame
+        pfs::Params ldrParams( *tmofileparams );
         if (isAutolevels)
         {
             float minL, maxL, gammaL;
             QScopedPointer<QImage> temp_qimage( fromLDRPFStoQImage(tm_frame.data()) );
             computeAutolevels(temp_qimage.data(), 0.985f, minL, maxL, gammaL);
-            pfs::gammaAndLevels(tm_frame.data(), minL, maxL, 0.f, 1.f, gammaL);
+            pfs::GammaLevels(minL, maxL, 0.f, 1.f, gammaL).toParams(ldrParams);
         }
         // Create an ad-hoc IOWorker to save the file
         if ( IOWorker().write_ldr_frame(tm_frame.data(), saveLdrFilename,
                                         inputfname,
                                         hdrCreationManager.data() ? hdrCreationManager->getExpotimes(): QVector<float>(),
                                         tmopts.data(),
-                                        *tmofileparams ) )
+                                        ldrParams ) )
         {
             // File save successful
             printIfVerbose( tr("\nImage %1 successfully saved").arg(saveLdrFilename) , verbose);
@@ -741,6 +866,7 @@ void  CommandLineInterfaceManager::startTonemap()
         if (isHtml && !isHtmlDone) {
             generateHTML();
         }
+        writeTrace();
         emit finishedParsing();
     }
     else
@@ -749,10 +875,107 @@ void  CommandLineInterfaceManager::startTonemap()
         if (isHtml && !isHtmlDone) {
             generateHTML();
         }
+        writeTrace();
         emit finishedParsing();
     }
 }
 
+void CommandLineInterfaceManager::startSweep()
+{
+    pfs::TonemapSweep sweep(*tmopts, sweepColumns, sweepRows);
+    sweep.setSheetCellWidth(sweepCellWidth);
+    printIfVerbose( tr("Sweeping %1 variants.").arg(sweep.getColumns()*sweep.getRows()) , verbose);
+
+    // NAME.EXT -> NAME_OPTION-VALUE[_OPTION-VALUE].EXT
+    const QFileInfo sheetInfo(saveLdrFilename);
+    const QString variantPrefix = QDir(sheetInfo.path()).filePath(sheetInfo.completeBaseName());
+
+    const QString inputfname = inputFiles.isEmpty() ? QString() : inputFiles.first();
+    const QVector<float> expotimes = hdrCreationManager.data() ? hdrCreationManager->getExpotimes() : QVector<float>();
+
+    QStringList failed;
+    int done = 0;
+    setProgressBar(static_cast<int>(sweep.getColumns()*sweep.getRows()));
+
+    // the variants are handed out one at a time: IOWorker and the progress
+    // bar are not shared between threads
+    pfs::Progress ph;
+    QScopedPointer<pfs::Frame> sheet( sweep.run(*HDR, [&](size_t column, size_t row,
+                                                          const TonemappingParameters& params,
+                                                          pfs::Frame& result)
+    {
+        QString filename = variantPrefix;
+        filename += QString("_%1-%2").arg(QString::fromStdString(sweepColumns.option))
+                                     .arg(sweepColumns.value(column));
+        if (!sweepRows.option.empty())
+        {
+            filename += QString("_%1-%2").arg(QString::fromStdString(sweepRows.option))
+                                         .arg(sweepRows.value(row));
+        }
+        filename += "." + sheetInfo.suffix();
+
+        TonemappingOptions options;
+        static_cast<TonemappingParameters&>(options) = params;
+
+        pfs::Params ldrParams( *tmofileparams );
+        if (isAutolevels)
+        {
+            float minL, maxL, gammaL;
+            QScopedPointer<QImage> temp_qimage( fromLDRPFStoQImage(&result) );
+            computeAutolevels(temp_qimage.data(), 0.985f, minL, maxL, gammaL);
+            pfs::GammaLevels(minL, maxL, 0.f, 1.f, gammaL).toParams(ldrParams);
+        }
+        if ( !IOWorker().write_ldr_frame(&result, filename, inputfname, expotimes,
+                                         &options, ldrParams) )
+        {
+            failed << filename;
+        }
+        updateProgressBar(++done);
+    }, ph) );
+
+    if (sheet.isNull())
+    {
+        printErrorAndExit( tr("\nERROR: The sweep has no contact sheet.") );
+    }
+    if (!failed.isEmpty())
+    {
+        printErrorAndExit( tr("\nERROR: Cannot save to file: %1").arg(failed.join(", ")) );
+    }
+    printIfVerbose( tr("\n%1 variants saved").arg(done) , verbose);
+
+    if ( IOWorker().write_ldr_frame(sheet.data(), saveLdrFilename,
+                                    inputfname, expotimes,
+                                    tmopts.data(), *tmofileparams ) )
+    {
+        printIfVerbose( tr("Contact sheet %1 successfully saved").arg(saveLdrFilename) , verbose);
+    }
+    else
+    {
+        printErrorAndExit( tr("\nERROR: Cannot save to file: %1").arg(saveLdrFilename) );
+    }
+    if (isHtml && !isHtmlDone) {
+        generateHTML();
+    }
+    writeTrace();
+    emit finishedParsing();
+}
+
+void CommandLineInterfaceManager::writeTrace()
+{
+    if (!traceFilename.empty())
+    {
+        if (pfs::utils::writeChromeTrace(traceFilename))
+            printIfVerbose( tr("Trace saved to %1.").arg(QString::fromStdString(traceFilename)) , verbose);
+        else
+            printIfVerbose( tr("Could not save the trace to %1.").arg(QString::fromStdString(traceFilename)) , true);
+    }
+    if (isTraceSummary)
+    {
+        std::cout << std::endl;
+        pfs::utils::writeTraceSummary(std::cout);
+    }
+}
+
 void CommandLineInterfaceManager::errorWhileLoading(QString errormessage) {
     printErrorAndExit( tr("Failed loading images"));
 }
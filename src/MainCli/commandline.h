@@ -37,6 +37,7 @@
 #include "HdrWizard/HdrCreationManager.h"
 #include "Libpfs/frame.h"
 #include "Libpfs/params.h"
+#include "Libpfs/tm/TonemapSweep.h"
 #include "ezETAProgressBar.hpp"
 
 class CommandLineInterfaceManager : public QObject
@@ -65,6 +66,7 @@ private:
     QList<float> ev;
     QScopedPointer<HdrCreationManager> hdrCreationManager;
     QString saveHdrFilename;
+    pfs::Params saveHdrParams;
     QString saveLdrFilename;
     QScopedPointer<pfs::Frame> HDR;
     void saveHDR();
@@ -87,12 +89,20 @@ private:
     std::string pageName;
     std::string imagesDir;
     QString saveAlignedImagesPrefix;
+    std::string traceFilename;
+    bool isTraceSummary;
+    pfs::SweepAxis sweepColumns;
+    pfs::SweepAxis sweepRows;
+    int sweepCellWidth;
 
     void generateHTML();
     void startTonemap();
+    void startSweep();
+    void writeTrace();
 
 private slots:
     void finishedLoadingInputFiles();
+    void duplicatesSkipped(const QStringList&);
     void ais_failed(QProcess::ProcessError);
     void errorWhileLoading(QString);
     void createHDR(int);
@@ -0,0 +1,327 @@
+/**
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include "MainWindow/ExportQueue.h"
+
+#ifdef QT_DEBUG
+#include <QDebug>
+#endif
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QStatusBar>
+#include <QThread>
+
+#include "Libpfs/frame.h"
+#include "Libpfs/utils/memorybudget.h"
+#include "Core/TMWorker.h"
+#include "Core/TonemappingOptions.h"
+#include "TonemappingPanel/TMOProgressIndicator.h"
+
+namespace
+{
+//! \brief rough peak memory of the export of \a frame with \a tm_options:
+//! the working copy (3 channels) plus the temporary buffers of the
+//! operators, that need a handful of full size float planes
+qint64 estimateExportMemory(const pfs::Frame& frame,
+                            const TonemappingOptions& tm_options)
+{
+    qint64 width = frame.getWidth();
+    qint64 height = frame.getHeight();
+
+    if ( tm_options.tonemapSelection )
+    {
+        width = tm_options.selection_x_bottom_right - tm_options.selection_x_up_left;
+        height = tm_options.selection_y_bottom_right - tm_options.selection_y_up_left;
+    }
+    else if ( tm_options.xsize > 0 && frame.getWidth() > 0 )
+    {
+        height = height*tm_options.xsize/frame.getWidth();
+        width = tm_options.xsize;
+    }
+
+    const qint64 numPlanes = 3 + 6;
+    return qMax<qint64>(width, 1)*qMax<qint64>(height, 1)*numPlanes*sizeof(float);
+}
+}
+
+ExportQueue::ExportQueue(QStatusBar* statusBar, QObject* parent)
+    : QObject(parent)
+    , m_statusBar(statusBar)
+    , m_maxThreads(1)
+    , m_running(0)
+    , m_interactiveBusy(false)
+{}
+
+ExportQueue::~ExportQueue()
+{
+    // the receivers may be already gone
+    blockSignals(true);
+    stop();
+
+    foreach (Worker* worker, m_workers)
+    {
+        worker->m_thread->quit();
+        worker->m_thread->wait();
+
+        delete worker->m_worker;
+        delete worker->m_thread;
+        delete worker;
+    }
+}
+
+void ExportQueue::setMaxThreads(int numThreads)
+{
+    m_maxThreads = qMax(1, numThreads);
+    schedule();
+}
+
+int ExportQueue::size() const
+{
+    return m_pending.size() + m_running;
+}
+
+void ExportQueue::enqueue(pfs::Frame* frame, TonemappingOptions* tm_options,
+                          const pfs::Params& params,
+                          const QString& exportDir, const QString& hdrName,
+                          const QString& inputfname,
+                          const QVector<float>& inputExpoTimes,
+                          InterpolationMethod m)
+{
+    Job job;
+    job.m_frame = frame;
+    job.m_options = tm_options;
+    job.m_params = params;
+    job.m_exportDir = exportDir;
+    job.m_hdrName = hdrName;
+    job.m_inputFileName = inputfname;
+    job.m_inputExpoTimes = inputExpoTimes;
+    job.m_interpolation = m;
+    job.m_memory = estimateExportMemory(*frame, *tm_options);
+
+    m_pending.append(job);
+    emit sizeChanged(size());
+
+    schedule();
+}
+
+void ExportQueue::stop()
+{
+    foreach (const Job& job, m_pending)
+    {
+        delete job.m_options;
+    }
+    m_pending.clear();
+
+    foreach (Worker* worker, m_workers)
+    {
+        if ( worker->m_busy )
+        {
+            worker->m_progress->requestTermination();
+        }
+    }
+    // the workers cannot deliver exportFinished() to this (blocked) thread:
+    // quit and wait them here, then account for the jobs they have dropped.
+    // A call still queued to a worker would run when its thread starts
+    // again, on a frame and options that are gone: it is canceled
+    foreach (Worker* worker, m_workers)
+    {
+        worker->m_thread->quit();
+        worker->m_thread->wait();
+        QCoreApplication::removePostedEvents(worker->m_worker, QEvent::MetaCall);
+        worker->m_worker->setExportReservation(NULL);
+
+        if ( worker->m_busy ) finish(worker);
+    }
+    // the results the workers have posted before stopping would be taken
+    // for the ones of the next exports
+    QCoreApplication::removePostedEvents(this, QEvent::MetaCall);
+
+    emit sizeChanged(0);
+}
+
+void ExportQueue::setInteractiveBusy(bool busy)
+{
+    m_interactiveBusy = busy;
+    if ( !busy ) schedule();
+}
+
+bool ExportQueue::admit(const Job& job, pfs::utils::MemoryReservation& reservation) const
+{
+    if ( m_running == 0 )
+    {
+        // nothing is running: the job starts even if it does not fit in the
+        // budget, otherwise it would never start at all
+        reservation.tryReserve(job.m_memory);
+        return true;
+    }
+    if ( m_running >= m_maxThreads ) return false;
+    if ( m_interactiveBusy ) return false;
+
+    return reservation.tryReserve(job.m_memory);
+}
+
+void ExportQueue::schedule()
+{
+    // first in, first out: a big export at the head of the queue is not
+    // overtaken by the smaller ones behind it
+    while ( !m_pending.isEmpty() )
+    {
+        std::unique_ptr<pfs::utils::MemoryReservation> reservation(new pfs::utils::MemoryReservation);
+        if ( !admit(m_pending.first(), *reservation) ) break;
+
+        Worker* idle_worker = NULL;
+        foreach (Worker* worker, m_workers)
+        {
+            if ( !worker->m_busy )
+            {
+                idle_worker = worker;
+                break;
+            }
+        }
+        if ( idle_worker == NULL )
+        {
+            idle_worker = createWorker();
+        }
+
+        start(idle_worker, m_pending.takeFirst(), std::move(reservation));
+    }
+}
+
+ExportQueue::Worker* ExportQueue::createWorker()
+{
+    Worker* worker = new Worker;
+    worker->m_busy = false;
+    worker->m_options = NULL;
+
+    worker->m_progress = new TMOProgressIndicator;
+    worker->m_progress->hide();
+    m_statusBar->addWidget(worker->m_progress);
+
+    worker->m_worker = new TMWorker;
+    worker->m_worker->setResultCacheEnabled(true);
+    worker->m_thread = new QThread;
+    worker->m_worker->moveToThread(worker->m_thread);
+
+    connect(worker->m_worker, SIGNAL(tonemapFailed(QString)),
+            this, SIGNAL(exportFailed(QString)));
+    connect(worker->m_worker, SIGNAL(exportFinished()),
+            this, SLOT(exportFinished()));
+
+    connect(worker->m_worker, SIGNAL(tonemapSetValue(int)), worker->m_progress, SLOT(setValue(int)));
+    connect(worker->m_worker, SIGNAL(tonemapSetMaximum(int)), worker->m_progress, SLOT(setMaximum(int)));
+    connect(worker->m_worker, SIGNAL(tonemapSetMinimum(int)), worker->m_progress, SLOT(setMinimum(int)));
+    connect(worker->m_progress, SIGNAL(terminate()), worker->m_worker, SIGNAL(tonemapRequestTermination()), Qt::DirectConnection);
+
+    m_workers.append(worker);
+    return worker;
+}
+
+QString ExportQueue::outputFileName(const Job& job) const
+{
+    QDir dir(job.m_exportDir);
+
+    const QString firstPart = job.m_hdrName + "_" + job.m_options->getPostfix();
+    QString extension;
+    if (!job.m_params.get("fileextension", extension))
+        extension = "tiff";
+    extension = "." + extension;
+
+    QString outputFilename;
+
+    int idx = 1;
+    do
+    {
+        outputFilename = dir.filePath(firstPart + (idx > 1 ? "-" + QString::number(idx) : QString()) + extension);
+        idx++;
+    } while ( QFile::exists(outputFilename) || m_reservedFileNames.contains(outputFilename) );
+
+    return outputFilename;
+}
+
+void ExportQueue::start(Worker* worker, const Job& job,
+                        std::unique_ptr<pfs::utils::MemoryReservation> reservation)
+{
+    worker->m_busy = true;
+    worker->m_options = job.m_options;
+    worker->m_outputFileName = outputFileName(job);
+    m_reservedFileNames.insert(worker->m_outputFileName);
+
+    ++m_running;
+    // adopted by the worker, that allocates the frames on its own thread
+    worker->m_reservation = std::move(reservation);
+    worker->m_worker->setExportReservation(worker->m_reservation.get());
+
+#ifdef QT_DEBUG
+    qDebug() << "ExportQueue::start()" << worker->m_outputFileName
+             << "estimated memory (MB):" << job.m_memory/(1024*1024);
+#endif
+
+    worker->m_progress->reset();
+    worker->m_progress->setMaximum(0);
+    worker->m_progress->setToolTip(QFileInfo(worker->m_outputFileName).fileName());
+    worker->m_progress->show();
+
+    if ( !worker->m_thread->isRunning() )
+    {
+        worker->m_thread->start(QThread::LowPriority);
+    }
+
+    QMetaObject::invokeMethod(worker->m_worker, "computeTonemapAndExport", Qt::QueuedConnection,
+                              Q_ARG(pfs::Frame*, job.m_frame),
+                              Q_ARG(TonemappingOptions*, job.m_options),
+                              Q_ARG(pfs::Params, job.m_params),
+                              Q_ARG(QString, worker->m_outputFileName),
+                              Q_ARG(QString, job.m_inputFileName),
+                              Q_ARG(QVector<float>, job.m_inputExpoTimes),
+                              Q_ARG(InterpolationMethod, job.m_interpolation));
+}
+
+void ExportQueue::exportFinished()
+{
+    TMWorker* tm_worker = qobject_cast<TMWorker*>(sender());
+
+    foreach (Worker* worker, m_workers)
+    {
+        if ( worker->m_worker != tm_worker || !worker->m_busy ) continue;
+
+        finish(worker);
+        break;
+    }
+
+    emit sizeChanged(size());
+
+    schedule();
+}
+
+void ExportQueue::finish(Worker* worker)
+{
+    worker->m_busy = false;
+    worker->m_progress->hide();
+    worker->m_progress->reset();
+
+    delete worker->m_options;
+    worker->m_options = NULL;
+    worker->m_reservation.reset();
+
+    m_reservedFileNames.remove(worker->m_outputFileName);
+    --m_running;
+}
@@ -0,0 +1,145 @@
+/**
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#ifndef EXPORTQUEUE_H
+#define EXPORTQUEUE_H
+
+#include <memory>
+
+#include <QObject>
+#include <QList>
+#include <QSet>
+#include <QString>
+#include <QVector>
+
+#include "Common/global.h"
+#include "Libpfs/params.h"
+
+namespace pfs {
+    class Frame;
+    namespace utils {
+        class MemoryReservation;
+    }
+}
+
+class QStatusBar;
+class QThread;
+class TMWorker;
+class TMOProgressIndicator;
+class TonemappingOptions;
+
+//!
+//! \brief Queue of the "tone map and export" requests of the main window
+//!
+//! Exports run on a small pool of TMWorker threads, each one with its own
+//! progress indicator in the status bar. A queued export only starts when
+//! its estimated memory is admitted in the memory budget of the program
+//! (pfs::utils::MemoryReservation), and only one export at a time runs
+//! while the interactive tone mapping is busy.
+//! Export threads run at low priority, so the GUI stays responsive.
+//!
+class ExportQueue : public QObject
+{
+    Q_OBJECT
+public:
+    ExportQueue(QStatusBar* statusBar, QObject* parent = 0);
+    ~ExportQueue();
+
+    //! \brief amount of workers: the workers already running are not stopped
+    void setMaxThreads(int numThreads);
+
+    //! \brief exports queued or running
+    int size() const;
+
+    //! \brief queue an export of \a frame: \a tm_options is owned by the queue
+    //! \note \a frame must stay alive until the export is over
+    void enqueue(pfs::Frame* frame, TonemappingOptions* tm_options,
+                 const pfs::Params& params,
+                 const QString& exportDir, const QString& hdrName,
+                 const QString& inputfname,
+                 const QVector<float>& inputExpoTimes,
+                 InterpolationMethod m);
+
+    //! \brief drop the queued exports, stop the running ones and wait for
+    //! them: the calls not yet picked up by the workers are canceled
+    void stop();
+
+public Q_SLOTS:
+    //! \brief the interactive tone mapping has priority over the exports
+    void setInteractiveBusy(bool busy);
+
+Q_SIGNALS:
+    void sizeChanged(int);
+    void exportFailed(QString);
+
+private Q_SLOTS:
+    void exportFinished();
+
+private:
+    struct Job
+    {
+        pfs::Frame* m_frame;
+        TonemappingOptions* m_options;
+        pfs::Params m_params;
+        QString m_exportDir;
+        QString m_hdrName;
+        QString m_inputFileName;
+        QVector<float> m_inputExpoTimes;
+        InterpolationMethod m_interpolation;
+        qint64 m_memory;
+    };
+
+    struct Worker
+    {
+        QThread* m_thread;
+        TMWorker* m_worker;
+        TMOProgressIndicator* m_progress;
+        bool m_busy;
+        // of the running export, released when it is over
+        TonemappingOptions* m_options;
+        std::unique_ptr<pfs::utils::MemoryReservation> m_reservation;
+        QString m_outputFileName;
+    };
+
+    //! \brief start as many queued exports as the limits allow
+    void schedule();
+    //! \brief reserve the memory of \a job in \a reservation
+    //! \return false if the job cannot start now
+    bool admit(const Job& job, pfs::utils::MemoryReservation& reservation) const;
+    void start(Worker* worker, const Job& job,
+               std::unique_ptr<pfs::utils::MemoryReservation> reservation);
+    //! \brief the export of \a worker is over (or canceled)
+    void finish(Worker* worker);
+    //! \brief first free name for the export, taking into account the files
+    //! that the running exports are about to write
+    QString outputFileName(const Job& job) const;
+    Worker* createWorker();
+
+    QStatusBar* m_statusBar;
+    QList<Job> m_pending;
+    QList<Worker*> m_workers;
+    QSet<QString> m_reservedFileNames;
+
+    int m_maxThreads;
+    int m_running;
+    bool m_interactiveBusy;
+};
+
+#endif // EXPORTQUEUE_H
@@ -34,10 +34,13 @@
 
 #include "MainWindow/MainWindow.h"
 
+#include <limits>
+
 #ifdef QT_DEBUG
 #include <QDebug>
 #endif
 
+#include <QFile>
 #include <QFileDialog>
 #include <QDir>
 #include <QFileInfo>
@@ -65,6 +68,8 @@
 #include "Libpfs/manip/copy.h"
 #include "Libpfs/manip/rotate.h"
 #include "Libpfs/manip/gamma_levels.h"
+#include "Libpfs/resultcache.h"
+#include "Libpfs/utils/memorybudget.h"
 #include "Fileformat/pfsoutldrimage.h"
 
 #include "Common/archs.h"
@@ -100,7 +105,7 @@
 #include "Preferences/PreferencesDialog.h"
 #include "Core/IOWorker.h"
 #include "Core/TMWorker.h"
-#include "TonemappingPanel/TMOProgressIndicator.h"
+#include "MainWindow/ExportQueue.h"
 #include "HdrWizard/AutoAntighosting.h"
 #include "HdrWizard/WhiteBalance.h"
 #include "LibpfsAdditions/formathelper.h"
@@ -194,7 +199,6 @@ QScopedPointer<UpdateChecker> MainWindow::sm_updateChecker;
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , m_Ui(new Ui::MainWindow)
-    , m_exportQueueSize(0)
     , m_interpolationMethod(BilinearInterp)
     , m_firstWindow(0)
     , m_winId(0)
@@ -207,7 +211,6 @@ MainWindow::MainWindow(pfs::Frame* curr_frame, const QString& new_file,
                        bool needSaving, QWidget *parent)
     : QMainWindow(parent)
     , m_Ui(new Ui::MainWindow)
-    , m_exportQueueSize(0)
     , m_interpolationMethod(BilinearInterp)
     , m_firstWindow(0)
     , m_winId(0)
@@ -257,8 +260,8 @@ MainWindow::~MainWindow()
     }
     m_TMThread->quit();
     m_TMThread->wait();
-    m_QueueThread->quit(); // should be idle, quit() ok
-    m_QueueThread->wait();
+    pfs::utils::removeMemoryPressureHandler(m_memoryPressureHandler);
+    delete m_exportQueue; // stops the running exports
 
     clearRecentFileActions();
     delete luminance_options;
@@ -279,6 +282,9 @@ void MainWindow::init()
     curr_num_ldr_open = 0;
     splash = 0;
     m_processingAWB = false;
+    m_pendingLdrWrites = 0;
+    m_pendingHdrWrites = 0;
+    m_tonemapRunning = false;
 
     if ( sm_NumMainWindows == 1 )
     {
@@ -389,9 +395,12 @@ void MainWindow::createCentralWidget()
     connect(m_tabwidget, SIGNAL(tabCloseRequested(int)), this, SLOT(removeTab(int)));
     connect(m_tabwidget, SIGNAL(currentChanged(int)), this, SLOT(updateActions(int)));
     connect(m_tabwidget, SIGNAL(currentChanged(int)), this, SLOT(updateSoftProofing(int)));
+    connect(m_tabwidget, SIGNAL(currentChanged(int)), this, SLOT(compactInactiveViewers(int)));
+    connect(m_tabwidget, SIGNAL(currentChanged(int)), this, SLOT(spillInactiveViewers(int)));
     connect(m_tonemapPanel, SIGNAL(startTonemapping(TonemappingOptions*)), this, SLOT(tonemapImage(TonemappingOptions*)));
     connect(m_tonemapPanel, SIGNAL(startExport(TonemappingOptions*)), this, SLOT(exportImage(TonemappingOptions*)));
     connect(this, SIGNAL(updatedHDR(pfs::Frame*)), m_tonemapPanel, SLOT(updatedHDR(pfs::Frame*)));
+    connect(m_tonemapPanel, SIGNAL(currentFrameNeeded()), this, SLOT(expandCurrentHdr()));
     connect(this, SIGNAL(destroyed()), m_PreviewPanel, SLOT(deleteLater()));
 
     m_centralwidget_splitter->restoreState(luminance_options->value("MainWindowSplitterState").toByteArray());
@@ -621,13 +630,8 @@ void MainWindow::on_fileSaveAllAction_triggered()
                 QString outfname = luminance_options->getDefaultPathLdrOut()
                         + "/" + ldr_name + "_" + l_v->getFileNamePostFix() + ".jpg";
 
-                QMetaObject::invokeMethod(m_IOWorker, "write_ldr_frame", Qt::QueuedConnection,
-                                          Q_ARG(GenericViewer*, l_v),
-                                          Q_ARG(QString, outfname),
-                                          Q_ARG(QString, QString()),
-                                          Q_ARG(QVector<float>, QVector<float>()),
-                                          Q_ARG(TonemappingOptions*, NULL),
-                                          Q_ARG(pfs::Params, pfs::Params("quality", 100u)));
+                writeLdrViewer(l_v, outfname, QString(), QVector<float>(), NULL,
+                               pfs::Params("quality", 100u));
             }
         }
     }
@@ -656,6 +660,11 @@ void MainWindow::on_fileSaveAsAction_triggered()
             p.set("tiff_mode", t.getTiffWriterMode());
         }
 
+        // the frame is expanded here, on the GUI thread, and the viewer is
+        // not compacted until the write is done
+        g_v->getFrame();
+        ++m_pendingHdrWrites;
+
         // CALL m_IOWorker->write_hdr_frame(dynamic_cast<HdrViewer*>(g_v), fname);
         QMetaObject::invokeMethod(m_IOWorker, "write_hdr_frame",
                                   Qt::QueuedConnection,
@@ -684,9 +693,13 @@ void MainWindow::on_fileSaveAsAction_triggered()
         }
 
         pfs::Params p;
+        // the viewer tells the user when its frame cannot be read back
+        pfs::Frame* frame = l_v->getFrame();
+        if ( frame == NULL ) return;
+
         if ( format == "png" || format == "jpg" )
         {
-            ImageQualityDialog savedFileQuality(l_v->getFrame(), format, -1, this);
+            ImageQualityDialog savedFileQuality(frame, format, -1, this);
             savedFileQuality.setWindowTitle( QObject::tr("Save as...") + format.toUpper() );
             if ( savedFileQuality.exec() == QDialog::Rejected ) return;
 
@@ -704,19 +717,16 @@ void MainWindow::on_fileSaveAsAction_triggered()
         QString inputfname;
         if ( ! m_inputFilesName.isEmpty() ) inputfname = m_inputFilesName.first();
 
-        QMetaObject::invokeMethod(m_IOWorker, "write_ldr_frame", Qt::QueuedConnection,
-                                  Q_ARG(GenericViewer*, l_v),
-                                  Q_ARG(QString, outputFilename),
-                                  Q_ARG(QString, inputfname),
-                                  Q_ARG(QVector<float>, m_inputExpoTimes),
-                                  Q_ARG(TonemappingOptions*, l_v->getTonemappingOptions()),
-                                  Q_ARG(pfs::Params, p));
+        writeLdrViewer(l_v, outputFilename, inputfname, m_inputExpoTimes,
+                       l_v->getTonemappingOptions(), p);
 
     }
 }
 
 void MainWindow::save_hdr_success(GenericViewer* saved_hdr, const QString& fname)
 {
+    m_pendingHdrWrites = qMax(0, m_pendingHdrWrites - 1);
+
     QFileInfo qfi(fname);
 
     setCurrentFile(qfi.absoluteFilePath());
@@ -728,20 +738,59 @@ void MainWindow::save_hdr_success(GenericViewer* saved_hdr, const QString& fname
 
 void MainWindow::save_hdr_failed(const QString &fname)
 {
+    m_pendingHdrWrites = qMax(0, m_pendingHdrWrites - 1);
     // TODO give some kind of feedback to the user!
     // TODO pass the name of the file, so the user know which file didn't save correctly
     // DONE!!! Once again, use unified style?
     QMessageBox::warning(0,"", tr("Failed to save %1").arg(fname), QMessageBox::Ok, QMessageBox::NoButton);
 }
 
-void MainWindow::save_ldr_success(GenericViewer* saved_ldr, const QString& fname)
+void MainWindow::writeLdrViewer(GenericViewer* g_v, const QString& filename,
+                                const QString& inputfname, const QVector<float>& expoTimes,
+                                TonemappingOptions* tmopts, const pfs::Params& params)
 {
-    if ( !saved_ldr->isHDR() )
+    // the frame is expanded here, on the GUI thread: the I/O thread only
+    // gets the pointer, and the viewer is neither compacted nor spilled
+    // until the write is done
+    pfs::Frame* frame = g_v->getFrame();
+    if ( frame == NULL )
+    {
+        save_ldr_failed(filename);
+        return;
+    }
+
+    pfs::Params p( params );
+    p.set( "min_luminance", g_v->getMinLuminanceValue() )
+            ( "max_luminance", g_v->getMaxLuminanceValue() )
+            ( "mapping_method", g_v->getLuminanceMappingMethod() );
+
+    ++m_pendingLdrWrites;
+    m_ldrWriteViewers.insert(filename, g_v);
+    QMetaObject::invokeMethod(m_IOWorker, "write_ldr_frame", Qt::QueuedConnection,
+                              Q_ARG(pfs::Frame*, frame),
+                              Q_ARG(QString, filename),
+                              Q_ARG(QString, inputfname),
+                              Q_ARG(QVector<float>, expoTimes),
+                              Q_ARG(TonemappingOptions*, tmopts),
+                              Q_ARG(pfs::Params, p));
+}
+
+void MainWindow::save_ldr_success(pfs::Frame*, const QString& fname)
+{
+    m_pendingLdrWrites = qMax(0, m_pendingLdrWrites - 1);
+
+    QPointer<GenericViewer> saved_ldr = m_ldrWriteViewers.take(fname);
+    if ( saved_ldr && !saved_ldr->isHDR() )
+    {
+        saved_ldr->setFileName(fname);
         m_tabwidget->setTabText(m_tabwidget->indexOf(saved_ldr), QFileInfo(fname).fileName());
+    }
 }
 
 void MainWindow::save_ldr_failed(const QString &fname)
 {
+    m_pendingLdrWrites = qMax(0, m_pendingLdrWrites - 1);
+    m_ldrWriteViewers.remove(fname);
     // TODO give some kind of feedback to the user!
     // TODO pass the name of the file, so the user know which file didn't save correctly
     // DONE!!! Once again, use unified style?
@@ -763,13 +812,8 @@ void MainWindow::on_actionSave_Hdr_Preview_triggered()
 
         if ( outfname.isEmpty() ) return;
 
-        QMetaObject::invokeMethod(m_IOWorker, "write_ldr_frame", Qt::QueuedConnection,
-                                  Q_ARG(GenericViewer*, g_v),
-                                  Q_ARG(QString, outfname),
-                                  Q_ARG(QString, QString()),
-                                  Q_ARG(QVector<float>, QVector<float>()),
-                                  Q_ARG(TonemappingOptions*, NULL),
-                                  Q_ARG(pfs::Params, pfs::Params("quality", 100u)) );
+        writeLdrViewer(g_v, outfname, QString(), QVector<float>(), NULL,
+                       pfs::Params("quality", 100u));
     }
     catch (...)
     {
@@ -839,12 +883,14 @@ void MainWindow::dispatchrotate(bool clockwise)
     if (m_tabwidget->count() <= 0) return;
 
     GenericViewer* curr_g_v = (GenericViewer*)m_tabwidget->currentWidget();
+    pfs::Frame* frame = curr_g_v->getFrame();
+    if ( frame == NULL ) return;
 
     m_Ui->rotateccw->setEnabled(false);
     m_Ui->rotatecw->setEnabled(false);
 
     QApplication::setOverrideCursor( QCursor(Qt::WaitCursor) );
-    pfs::Frame *rotated = pfs::rotate(curr_g_v->getFrame(), clockwise);
+    pfs::Frame *rotated = pfs::rotate(frame, clockwise);
 
     curr_g_v->setFrame(rotated);
     if ( !curr_g_v->needsSaving() )
@@ -870,7 +916,10 @@ void MainWindow::on_actionResizeHDR_triggered()
 
     GenericViewer* curr_g_v = (GenericViewer*)m_tabwidget->currentWidget();
 
-    ResizeDialog *resizedialog = new ResizeDialog(this, curr_g_v->getFrame());
+    pfs::Frame* frame = curr_g_v->getFrame();
+    if ( frame == NULL ) return;
+
+    ResizeDialog *resizedialog = new ResizeDialog(this, frame);
     if (resizedialog->exec() == QDialog::Accepted)
     {
         QApplication::setOverrideCursor( QCursor(Qt::WaitCursor) );
@@ -897,7 +946,10 @@ void MainWindow::on_actionExportToHTML_triggered()
     if (m_tabwidget->count() <= 0) return;
 
     GenericViewer* curr_g_v = (GenericViewer*)m_tabwidget->currentWidget();
-    ExportToHtmlDialog *exportDialog = new ExportToHtmlDialog(this, curr_g_v->getFrame());
+    pfs::Frame* frame = curr_g_v->getFrame();
+    if ( frame == NULL ) return;
+
+    ExportToHtmlDialog *exportDialog = new ExportToHtmlDialog(this, frame);
 
     exportDialog->exec();
     delete exportDialog;
@@ -917,7 +969,10 @@ void MainWindow::on_action_Projective_Transformation_triggered()
 
     GenericViewer* curr_g_v = (GenericViewer*)m_tabwidget->currentWidget();
 
-    ProjectionsDialog *projTranfsDialog = new ProjectionsDialog(this, curr_g_v->getFrame());
+    pfs::Frame* frame = curr_g_v->getFrame();
+    if ( frame == NULL ) return;
+
+    ProjectionsDialog *projTranfsDialog = new ProjectionsDialog(this, frame);
     if (projTranfsDialog->exec() == QDialog::Accepted)
     {
         QApplication::setOverrideCursor( QCursor(Qt::WaitCursor) );
@@ -1109,7 +1164,7 @@ void MainWindow::setupIO()
     connect(m_IOWorker, SIGNAL(write_hdr_failed(QString)), this, SLOT(save_hdr_failed(QString)));
     // Save LDR
     //connect(this, SIGNAL(save_ldr_frame(LdrViewer*, QString, int)), m_IOWorker, SLOT(write_ldr_frame(LdrViewer*, QString, int)));
-    connect(m_IOWorker, SIGNAL(write_ldr_success(GenericViewer*, QString)), this, SLOT(save_ldr_success(GenericViewer*, QString)));
+    connect(m_IOWorker, SIGNAL(write_ldr_success(pfs::Frame*, QString)), this, SLOT(save_ldr_success(pfs::Frame*, QString)));
     connect(m_IOWorker, SIGNAL(write_ldr_failed(QString)), this, SLOT(save_ldr_failed(QString)));
 
     // progress bar handling
@@ -1189,6 +1244,8 @@ void MainWindow::load_success(pfs::Frame* new_hdr_frame,
                 this, SLOT(showPreviousViewer(GenericViewer*)));
         connect(newhdr, SIGNAL(syncViewers(GenericViewer*)),
                 this, SLOT(setSyncViewers(GenericViewer*)));
+        connect(newhdr, SIGNAL(frameExpanded(pfs::Frame*)),
+                this, SLOT(hdrFrameExpanded(pfs::Frame*)));
 
         newhdr->setViewerMode( getCurrentViewerMode(*m_tabwidget) );
 
@@ -1239,6 +1296,11 @@ void MainWindow::on_OptionsAction_triggered()
     if (opts->exec() == QDialog::Accepted)
     {
         m_Ui->actionShowPreviewPanel->setChecked(luminance_options->isPreviewPanelActive());
+        // the queue admits its exports in the new budget
+        pfs::utils::setMemoryBudget(luminance_options->getMemoryBudgetBytes());
+        m_exportQueue->setMaxThreads(luminance_options->getExportNumThreads());
+        pfs::setSharedResultCache(QFile::encodeName(luminance_options->getResultCacheDir()).constData(),
+                                  size_t(luminance_options->getResultCacheSize())*1024*1024);
     }
 }
 
@@ -1539,6 +1601,7 @@ void MainWindow::setupTM()
     connect(this, SIGNAL(destroyed()), m_TMProgressBar, SLOT(deleteLater()));
 
     m_TMWorker = new TMWorker;
+    m_TMWorker->setResultCacheEnabled(true);
     m_TMThread = new QThread;
 
     m_TMWorker->moveToThread(m_TMThread);
@@ -1568,38 +1631,32 @@ void MainWindow::setupTM()
 
 void MainWindow::setupQueue()
 {
-    m_QueueProgressBar = new TMOProgressIndicator;
-    m_QueueProgressBar->hide();
-    statusBar()->addWidget(m_QueueProgressBar);
-
-    connect(this, SIGNAL(destroyed()), m_QueueProgressBar, SLOT(deleteLater()));
+    pfs::utils::setMemoryBudget(luminance_options->getMemoryBudgetBytes());
+    pfs::setSharedResultCache(QFile::encodeName(luminance_options->getResultCacheDir()).constData(),
+                              size_t(luminance_options->getResultCacheSize())*1024*1024);
 
-    m_QueueWorker = new TMWorker;
-    m_QueueThread = new QThread;
-
-    m_QueueWorker->moveToThread(m_QueueThread);
+    // jobs waiting for memory can have the background tabs moved to disk
+    m_memoryPressureHandler = pfs::utils::addMemoryPressureHandler(
+                [this](size_t bytes) -> size_t
+    {
+        if ( QThread::currentThread() != thread() )
+        {
+            // the viewers belong to the GUI thread: the job finds the memory
+            // released the next time it checks the budget
+            QMetaObject::invokeMethod(this, "spillViewersForMemory", Qt::QueuedConnection,
+                                      Q_ARG(qint64, qint64(bytes)));
+            return 0;
+        }
+        return spillViewersForMemory(qint64(bytes));
+    });
 
-    // Memory Management
-    connect(this, SIGNAL(destroyed()), m_QueueWorker, SLOT(deleteLater()));
-    connect(m_QueueWorker, SIGNAL(destroyed()), m_QueueThread, SLOT(deleteLater()));
+    m_exportQueue = new ExportQueue(statusBar());
+    m_exportQueue->setMaxThreads(luminance_options->getExportNumThreads());
 
-    // get back result!
-    //connect(m_QueueWorker, SIGNAL(tonemapSuccess(pfs::Frame*, TonemappingOptions*)),
-    //    this, SLOT(addLdrFrame(pfs::Frame*, TonemappingOptions*)));
-    connect(m_QueueWorker, SIGNAL(tonemapFailed(QString)),
+    connect(m_exportQueue, SIGNAL(exportFailed(QString)),
         this, SLOT(tonemapFailed(QString)));
-
-    // progress bar handling
-    connect(m_QueueWorker, SIGNAL(tonemapBegin()), this, SLOT(exportBegin()));
-    connect(m_QueueWorker, SIGNAL(tonemapEnd()), this, SLOT(exportEnd()));
-
-    connect(m_QueueWorker, SIGNAL(tonemapSetValue(int)), m_QueueProgressBar, SLOT(setValue(int)));
-    connect(m_QueueWorker, SIGNAL(tonemapSetMaximum(int)), m_QueueProgressBar, SLOT(setMaximum(int)));
-    connect(m_QueueWorker, SIGNAL(tonemapSetMinimum(int)), m_QueueProgressBar, SLOT(setMinimum(int)));
-    connect(m_QueueProgressBar, SIGNAL(terminate()), m_QueueWorker, SIGNAL(tonemapRequestTermination()), Qt::DirectConnection);
-
-    // start thread waiting for signals (I/O requests)
-    m_QueueThread->start();
+    connect(m_exportQueue, SIGNAL(sizeChanged(int)),
+        this, SLOT(exportQueueSizeChanged(int)));
 }
 
 void MainWindow::tonemapBegin()
@@ -1607,6 +1664,7 @@ void MainWindow::tonemapBegin()
     // statusBar()->addWidget(m_TMProgressBar);
     m_TMProgressBar->setMaximum(0);
     m_TMProgressBar->show();
+    m_exportQueue->setInteractiveBusy(true);
 }
 
 void MainWindow::tonemapEnd()
@@ -1614,19 +1672,12 @@ void MainWindow::tonemapEnd()
     // statusBar()->removeWidget(m_TMProgressBar);
     m_TMProgressBar->hide();
     m_TMProgressBar->reset();
+    m_exportQueue->setInteractiveBusy(false);
 }
 
-void MainWindow::exportBegin()
+void MainWindow::exportQueueSizeChanged(int size)
 {
-    m_QueueProgressBar->setMaximum(0);
-    m_QueueProgressBar->show();
-}
-
-void MainWindow::exportEnd()
-{
-    m_tonemapPanel->setExportQueueSize(--m_exportQueueSize);
-    m_QueueProgressBar->hide();
-    m_QueueProgressBar->reset();
+    m_tonemapPanel->setExportQueueSize(size);
 }
 
 
@@ -1693,6 +1744,7 @@ void MainWindow::tonemapImage(TonemappingOptions *opts)
         qDebug() << "MainWindow(): emit getTonemappedFrame()";
 #endif
         //CALL m_TMWorker->getTonemappedFrame(hdr_viewer->getHDRPfsFrame(), opts);
+        m_tonemapRunning = true;
         QMetaObject::invokeMethod(m_TMWorker, "computeTonemap", Qt::QueuedConnection,
                                   Q_ARG(pfs::Frame*, hdr_viewer->getFrame()), Q_ARG(TonemappingOptions*,opts),
                                   Q_ARG(InterpolationMethod, m_interpolationMethod));
@@ -1713,24 +1765,17 @@ void MainWindow::exportImage(TonemappingOptions *opts)
 
         QString exportDir = luminance_options->getExportDir();
 
-        m_tonemapPanel->setExportQueueSize(++m_exportQueueSize);
-
-        QMetaObject::invokeMethod(m_QueueWorker, "computeTonemapAndExport", Qt::QueuedConnection,
-                                  Q_ARG(pfs::Frame*, hdr_viewer->getFrame()),
-                                  Q_ARG(TonemappingOptions*,opts),
-                                  Q_ARG(pfs::Params,params),
-                                  Q_ARG(QString, exportDir),
-                                  Q_ARG(QString, hdrName),
-                                  Q_ARG(QString, inputfname),
-                                  Q_ARG(QVector<float>, m_inputExpoTimes),
-                                  Q_ARG(InterpolationMethod, m_interpolationMethod)
-                              );
+        m_exportQueue->enqueue(hdr_viewer->getFrame(), opts, params,
+                               exportDir, hdrName, inputfname,
+                               m_inputExpoTimes, m_interpolationMethod);
     }
 }
 
 
 void MainWindow::addLdrFrame(pfs::Frame *frame, TonemappingOptions* tm_options)
 {
+    m_tonemapRunning = false;
+
     if (m_tonemapPanel->doAutoLevels()) {
         float threshold, minL, maxL, gammaL;
         threshold = m_tonemapPanel->getAutoLevelsThreshold();
@@ -1782,6 +1827,8 @@ void MainWindow::addLdrFrame(pfs::Frame *frame, TonemappingOptions* tm_options)
 
 void MainWindow::tonemapFailed(const QString& error_msg)
 {
+    m_tonemapRunning = false;
+
     if (error_msg != "Canceled")
     {
         QMessageBox::critical(this, tr("Luminance HDR"),
@@ -2069,6 +2116,7 @@ void MainWindow::on_actionFix_Histogram_toggled(bool checked)
         GenericViewer* current = (GenericViewer*) m_tabwidget->currentWidget();
         if ( current==NULL ) return;
         if ( current->isHDR() ) return;
+        if ( current->getFrame() == NULL ) return;
 
         QScopedPointer<GammaAndLevels> g_n_l( new GammaAndLevels(this, current->getQImage()) );
 
@@ -2105,14 +2153,17 @@ void MainWindow::on_actionFix_Histogram_toggled(bool checked)
 
 void MainWindow::on_actionWhite_Balance_triggered()
 {
+    GenericViewer* current = (GenericViewer*) m_tabwidget->currentWidget();
+    if ( current == NULL ) return;
+    Frame *frame = current->getFrame();
+    if ( frame == NULL ) return;
+
     QApplication::setOverrideCursor( QCursor(Qt::WaitCursor) );
     m_Ui->actionWhite_Balance->setEnabled(false);
     m_processingAWB = true;
-    m_viewerToProcess = (GenericViewer*) m_tabwidget->currentWidget();
+    m_viewerToProcess = current;
     m_tabwidget->setTabEnabled(m_tabwidget->currentIndex(), false);
 
-    Frame *frame = m_viewerToProcess->getFrame();
-
     m_futureWatcher.setFuture(
                 QtConcurrent::run(
                         boost::bind(whiteBalance, boost::ref(*frame), WB_COLORBALANCE)
@@ -2204,6 +2255,110 @@ void MainWindow::updateSoftProofing(int i)
     }
 }
 
+void MainWindow::compactInactiveViewers(int i)
+{
+    if ( !luminance_options->isCompactInactiveViewers() ) return;
+    // viewers being saved are read by the I/O thread
+    if ( m_pendingLdrWrites > 0 ) return;
+
+    // the histogram of the HDR on screen reads its frame
+    GenericViewer* current = qobject_cast<GenericViewer*>(m_tabwidget->widget(i));
+    if ( current && current->isHDR() ) current->getFrame();
+
+    // the HDR frame is shared (by pointer) with the tone mapping, the export
+    // and the I/O threads: it is compacted only when none of them runs. The
+    // tone mapping panel gets the expanded frame through hdrFrameExpanded()
+    const bool hdrInUse = m_tonemapRunning || m_pendingHdrWrites > 0
+            || m_exportQueue->size() > 0;
+
+    for (int idx = 0; idx < m_tabwidget->count(); ++idx)
+    {
+        if ( idx == i ) continue;
+
+        GenericViewer *g_v = (GenericViewer *)m_tabwidget->widget(idx);
+        if ( g_v->isFrameCompacted() ) continue;
+        if ( g_v->isHDR() && hdrInUse ) continue;
+        // white balance works in place in background
+        if ( m_processingAWB && g_v == m_viewerToProcess ) continue;
+
+#ifdef QT_DEBUG
+        qDebug() << "MainWindow::compactInactiveViewers(): tab" << idx;
+#endif
+        g_v->compactFrame();
+    }
+}
+
+void MainWindow::hdrFrameExpanded(pfs::Frame* frame)
+{
+    m_tonemapPanel->setCurrentFrame(frame);
+}
+
+void MainWindow::expandCurrentHdr()
+{
+    if ( tm_status.is_hdr_ready ) tm_status.curr_tm_frame->getFrame();
+}
+
+void MainWindow::spillInactiveViewers(int i)
+{
+    GenericViewer* current = qobject_cast<GenericViewer*>(m_tabwidget->widget(i));
+    if ( current )
+    {
+        m_recentViewers.removeAll(current);
+        m_recentViewers.prepend(current);
+    }
+
+    const int resident = luminance_options->getResidentViewers();
+    if ( resident > 0 )
+    {
+        spillViewers(resident, std::numeric_limits<qint64>::max());
+    }
+}
+
+qint64 MainWindow::spillViewersForMemory(qint64 bytes)
+{
+    // only the tab on screen is left in memory
+    return spillViewers(1, bytes);
+}
+
+qint64 MainWindow::spillViewers(int resident, qint64 bytes)
+{
+    // viewers being saved are read by the I/O thread
+    if ( m_pendingLdrWrites > 0 ) return 0;
+
+    // tabs closed meanwhile leave a null pointer; tabs never shown are the
+    // least recently used
+    m_recentViewers.removeAll(QPointer<GenericViewer>());
+    for (int idx = 0; idx < m_tabwidget->count(); ++idx)
+    {
+        GenericViewer* g_v = qobject_cast<GenericViewer*>(m_tabwidget->widget(idx));
+        if ( g_v && !m_recentViewers.contains(g_v) ) m_recentViewers.append(g_v);
+    }
+
+    const QString tempDir = luminance_options->getTempDir();
+    qint64 released = 0;
+    int kept = 0;
+    for (int idx = 0; idx < m_recentViewers.size() && released < bytes; ++idx)
+    {
+        GenericViewer* g_v = m_recentViewers[idx];
+        // the HDR frame is shared (by pointer) with the tone mapping, the
+        // previews and the export threads
+        if ( g_v->isHDR() || m_tabwidget->indexOf(g_v) < 0 ) continue;
+        if ( ++kept <= resident ) continue;
+        if ( g_v == m_tabwidget->currentWidget() || g_v->isFrameSpilled() ) continue;
+        if ( m_processingAWB && g_v == m_viewerToProcess ) continue;
+
+        const qint64 size = pfs::utils::frameMemorySize(g_v->getWidth(), g_v->getHeight());
+        if ( g_v->spillFrame(tempDir) )
+        {
+#ifdef QT_DEBUG
+            qDebug() << "MainWindow::spillViewers(): tab" << m_tabwidget->indexOf(g_v);
+#endif
+            released += size;
+        }
+    }
+    return released;
+}
+
 void MainWindow::showPreviewsOnTheRight()
 {
     m_PreviewscrollArea->setParent(m_centralwidget_splitter);
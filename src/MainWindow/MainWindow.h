@@ -35,7 +35,10 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
+#include <QHash>
+#include <QList>
 #include <QMap>
+#include <QPointer>
 #include <QString>
 #include <QStringList>
 #include <QSignalMapper>
@@ -60,6 +63,7 @@ namespace Ui {
 
 namespace pfs {
     class Frame;            // #include "Libpfs/frame.h"
+    class Params;           // #include "Libpfs/params.h"
 }
 
 class IOWorker;             // #include "Core/IOWorker.h"
@@ -72,6 +76,7 @@ class TMOProgressIndicator; // #include "TonemappingPanel/TMOProgressIndicator.h
 class TonemappingPanel;     // #include "TonemappingPanel/TonemappingPanel.h"
 class TonemappingOptions;   // #include "Core/TonemappingOptions.h"
 class TMWorker;
+class ExportQueue;          // #include "MainWindow/ExportQueue.h"
 
 
 class UpdateChecker;        // #include "MainWindow/UpdateChecker.h"
@@ -92,7 +97,7 @@ public Q_SLOTS:
     // I/O
     void save_hdr_success(GenericViewer* saved_hdr, const QString& fname);
     void save_hdr_failed(const QString& fname);
-    void save_ldr_success(GenericViewer* saved_ldr, const QString& fname);
+    void save_ldr_success(pfs::Frame* saved_ldr, const QString& fname);
     void save_ldr_failed(const QString& fname);
 
     void load_failed(const QString&);
@@ -195,8 +200,7 @@ protected Q_SLOTS:
     void tonemapFailed(const QString&);
 
     // Export queue
-    void exportBegin();
-    void exportEnd();
+    void exportQueueSizeChanged(int);
 
     // lock functionalities
     void on_actionLock_toggled(bool);
@@ -211,6 +215,19 @@ protected Q_SLOTS:
     void on_actionSoft_Proofing_toggled(bool);
     void on_actionGamut_Check_toggled(bool);
     void updateSoftProofing(int);
+    void compactInactiveViewers(int);
+    //! \brief the HDR tab was compacted and is read again: hand the new
+    //! frame to the tone mapping panel
+    void hdrFrameExpanded(pfs::Frame* frame);
+    //! \brief expand the HDR tab, when it has been compacted
+    void expandCurrentHdr();
+    //! \brief move to disk the frames of the LDR tabs that have not been
+    //! used recently, beyond LuminanceOptions::getResidentViewers()
+    void spillInactiveViewers(int);
+    //! \brief move to disk the frames of all the tabs but the current one,
+    //! until \a bytes have been released
+    //! \return bytes released
+    qint64 spillViewersForMemory(qint64 bytes);
 
     void on_actionFits_Importer_triggered();
 
@@ -325,11 +342,7 @@ private:
     TMOProgressIndicator* m_TMProgressBar;
 
     // Export queue
-    QThread* m_QueueThread;
-    TMWorker* m_QueueWorker;
-    TMOProgressIndicator* m_QueueProgressBar;
-
-    int m_exportQueueSize;
+    ExportQueue* m_exportQueue;
 
     //
     InterpolationMethod m_interpolationMethod;
@@ -337,6 +350,23 @@ private:
     QFutureWatcher<void> m_futureWatcher;
     GenericViewer *m_viewerToProcess;
     bool m_processingAWB;
+
+    qint64 spillViewers(int resident, qint64 bytes);
+    // tabs in order of activation, the most recent first
+    QList< QPointer<GenericViewer> > m_recentViewers;
+    int m_memoryPressureHandler;
+    //! queue the write of the frame of \a g_v on the I/O thread
+    void writeLdrViewer(GenericViewer* g_v, const QString& filename,
+                        const QString& inputfname, const QVector<float>& expoTimes,
+                        TonemappingOptions* tmopts, const pfs::Params& params);
+    // LDR writes queued on the I/O thread
+    int m_pendingLdrWrites;
+    // HDR writes queued on the I/O thread
+    int m_pendingHdrWrites;
+    // tone mapping of the HDR running on the tone mapping thread
+    bool m_tonemapRunning;
+    // tabs renamed once their file is saved
+    QHash< QString, QPointer<GenericViewer> > m_ldrWriteViewers;
     int m_firstWindow;
     int m_winId; // unique MainWindow identifier
 
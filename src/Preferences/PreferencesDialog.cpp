@@ -220,6 +220,8 @@ void PreferencesDialog::on_okButton_clicked()
 
     luminance_options.setPreviewWidth( m_Ui->previewsWidthSpinBox->value() );
     luminance_options.setPreviewPanelActive( m_Ui->checkBoxTMOWindowsPreviewPanel->isChecked() );
+    luminance_options.setCompactInactiveViewers( m_Ui->chkCompactInactiveViewers->isChecked() );
+    luminance_options.setResidentViewers( m_Ui->residentViewersSpinBox->value() );
 
     if (m_Ui->chkPortableMode->isChecked() != LuminanceOptions::isCurrentPortableMode)
     {
@@ -229,6 +231,9 @@ void PreferencesDialog::on_okButton_clicked()
 
     // --- Batch TM
     luminance_options.setBatchTmNumThreads( m_Ui->numThreadspinBox->value() );
+    luminance_options.setBatchTmNumaAffinity( m_Ui->chkBatchTmNumaAffinity->isChecked() );
+    luminance_options.setMemoryBudget( m_Ui->memoryBudgetSpinBox->value() );
+    luminance_options.setResultCacheSize( m_Ui->resultCacheSpinBox->value() );
 
     // --- Other Parameters
 
@@ -297,6 +302,7 @@ void PreferencesDialog::on_okButton_clicked()
     luminance_options.setValue(KEY_GREEN_TOOLBUTTON, m_Ui->green_toolButton->isEnabled());
 
     luminance_options.setExportDir(m_Ui->exportDirectoryEdit->text());
+    luminance_options.setExportNumThreads(m_Ui->exportThreadsSpinBox->value());
     m_formatHelper.writeSettings(luminance_options, KEY_FILEFORMAT_QUEUE);
 
     if (restartNeeded)
@@ -608,12 +614,17 @@ void PreferencesDialog::from_options_to_gui()
 
 
     m_Ui->numThreadspinBox->setValue( luminance_options.getBatchTmNumThreads() );
+    m_Ui->chkBatchTmNumaAffinity->setChecked( luminance_options.isBatchTmNumaAffinity() );
+    m_Ui->memoryBudgetSpinBox->setValue( luminance_options.getMemoryBudget() );
+    m_Ui->resultCacheSpinBox->setValue( luminance_options.getResultCacheSize() );
 
     m_Ui->aisParamsLineEdit->setText( luminance_options.getAlignImageStackOptions().join(" ") );
 
     m_Ui->previewsWidthSpinBox->setValue( luminance_options.getPreviewWidth() );
 
     m_Ui->checkBoxTMOWindowsPreviewPanel->setChecked(luminance_options.isPreviewPanelActive());
+    m_Ui->chkCompactInactiveViewers->setChecked(luminance_options.isCompactInactiveViewers());
+    m_Ui->residentViewersSpinBox->setValue(luminance_options.getResidentViewers());
 
     m_Ui->chkPortableMode->setChecked(LuminanceOptions::isCurrentPortableMode);
 
@@ -713,6 +724,7 @@ void PreferencesDialog::from_options_to_gui()
     m_Ui->printer_lineEdit->setText( luminance_options.getPrinterProfileFileName() );
 
     m_Ui->exportDirectoryEdit->setText( luminance_options.getExportDir() );
+    m_Ui->exportThreadsSpinBox->setValue( luminance_options.getExportNumThreads() );
     m_formatHelper.loadFromSettings(luminance_options, KEY_FILEFORMAT_QUEUE);
 }
 
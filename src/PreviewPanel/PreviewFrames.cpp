@@ -0,0 +1,131 @@
+/**
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include "PreviewPanel/PreviewFrames.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <QMutexLocker>
+
+#include "Libpfs/frame.h"
+#include "Libpfs/manip/resize.h"
+
+namespace // anoymous namespace
+{
+const int PREVIEW_WIDTH = 120;
+const int PREVIEW_HEIGHT = 100;
+}
+
+PreviewReference::PreviewReference()
+    : m_frame(NULL)
+    , m_generation(0)
+{}
+
+QSharedPointer<pfs::Frame> PreviewReference::get(pfs::Frame* frame)
+{
+    // hashing the HDR would read all of it on the GUI thread: any change to
+    // the frame moves it to a new generation instead
+    const uint64_t generation = frame->getGeneration();
+    if ( !m_reference.isNull() && frame == m_frame && generation == m_generation )
+    {
+        return m_reference;
+    }
+
+    int frame_width = frame->getWidth();
+    int frame_height = frame->getHeight();
+
+    int resized_width = PREVIEW_WIDTH;
+    if (frame_height > frame_width)
+    {
+        float ratio = ((float)frame_width)/frame_height;
+        resized_width = PREVIEW_HEIGHT*ratio;
+    }
+
+    // the previews still running keep the previous reference alive
+    m_reference = QSharedPointer<pfs::Frame>( pfs::resize(frame, resized_width, AreaInterp) );
+    m_frame = frame;
+    m_generation = generation;
+    return m_reference;
+}
+
+PreviewFramePool::PreviewFramePool(int maxFree)
+    : m_maxFree(maxFree)
+{}
+
+PreviewFramePool::~PreviewFramePool()
+{
+    qDeleteAll(m_free);
+}
+
+pfs::Frame* PreviewFramePool::acquire(const pfs::Frame& reference)
+{
+    // freed if the copy throws (the allocation of a larger preview)
+    std::unique_ptr<pfs::Frame> frame;
+    {
+        QMutexLocker locker(&m_mutex);
+        if ( !m_free.isEmpty() ) frame.reset(m_free.takeLast());
+    }
+    if ( !frame ) frame.reset(new pfs::Frame);
+
+    // channels added by the operator that used the frame last
+    std::vector<std::string> extra;
+    const pfs::ChannelContainer& channels = frame->getChannels();
+    for (size_t c = 0; c < channels.size(); ++c)
+    {
+        if ( reference.getChannel(channels[c]->getName()) == NULL )
+        {
+            extra.push_back(channels[c]->getName());
+        }
+    }
+    for (size_t c = 0; c < extra.size(); ++c)
+    {
+        frame->removeChannel(extra[c]);
+    }
+
+    // the buffers of the channels keep their capacity across resizes
+    frame->resize(reference.getWidth(), reference.getHeight());
+
+    const pfs::ChannelContainer& source = reference.getChannels();
+    for (size_t c = 0; c < source.size(); ++c)
+    {
+        pfs::Channel* dst = frame->createChannel(source[c]->getName());
+        std::copy(source[c]->begin(), source[c]->end(), dst->begin());
+    }
+    pfs::copyTags(&reference, frame.get());
+
+    return frame.release();
+}
+
+void PreviewFramePool::release(pfs::Frame* frame)
+{
+    if ( frame == NULL ) return;
+
+    QMutexLocker locker(&m_mutex);
+    if ( m_free.size() < m_maxFree )
+    {
+        m_free.append(frame);
+        return;
+    }
+    locker.unlock();
+    delete frame;
+}
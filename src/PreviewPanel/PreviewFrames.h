@@ -0,0 +1,80 @@
+/**
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#ifndef PREVIEWFRAMES_H
+#define PREVIEWFRAMES_H
+
+#include <stdint.h>
+
+#include <QList>
+#include <QMutex>
+#include <QSharedPointer>
+
+// forward declaration
+namespace pfs {
+    class Frame;            // #include "Libpfs/frame.h"
+}
+
+//! \brief the HDR downscaled to the size of the preview labels, shared by
+//! all the previews of a panel. It is resized again only when another HDR
+//! is given or the HDR has been changed (see pfs::Frame::getGeneration()),
+//! not at every refresh of a label
+class PreviewReference
+{
+public:
+    PreviewReference();
+
+    //! \brief reference of \a frame: call it from the GUI thread
+    QSharedPointer<pfs::Frame> get(pfs::Frame* frame);
+
+private:
+    // only compared, never dereferenced
+    const pfs::Frame* m_frame;
+    uint64_t m_generation;
+    QSharedPointer<pfs::Frame> m_reference;
+};
+
+//! \brief working frames the previews are tone mapped in. The operators
+//! work in place, so every preview needs a copy of the reference: the
+//! copies are recycled across labels and refreshes instead of allocating
+//! (and freeing) a frame for each one
+class PreviewFramePool
+{
+public:
+    //! \param maxFree frames kept for reuse, usually the number of previews
+    //! rendered at the same time
+    explicit PreviewFramePool(int maxFree);
+    ~PreviewFramePool();
+
+    //! \brief frame with the channels and tags of \a reference, to give back
+    //! with release(). Thread safe
+    pfs::Frame* acquire(const pfs::Frame& reference);
+    void release(pfs::Frame* frame);
+
+private:
+    PreviewFramePool(const PreviewFramePool&);
+    PreviewFramePool& operator=(const PreviewFramePool&);
+
+    QMutex m_mutex;
+    QList<pfs::Frame*> m_free;
+    int m_maxFree;
+};
+
+#endif
@@ -22,20 +22,21 @@
  */
 
 #include <QDebug>
-#include <QtConcurrentMap>
+#include <QRunnable>
 #include <QSharedPointer>
 
 #include "PreviewPanel.h"
 
 #include "Libpfs/frame.h"
-#include "Libpfs/manip/copy.h"
-#include "Libpfs/manip/resize.h"
+#include "Libpfs/manip/gamma.h"
 #include "Libpfs/manip/gamma_levels.h"
+#include "Libpfs/progress.h"
+#include "Libpfs/utils/parallel.h"
 
-#include "Core/TMWorker.h"
 #include "Libpfs/tm/TonemapOperator.h"
 
 #include "Fileformat/pfsoutldrimage.h"
+#include "PreviewPanel/PreviewFrames.h"
 #include "PreviewPanel/PreviewLabel.h"
 
 #include "Common/LuminanceOptions.h"
@@ -57,93 +58,86 @@ void resetTonemappingOptions(TonemappingOptions* tm_options, const pfs::Frame* f
     tm_options->tonemapSelection   = false;
 }
 
-class PreviewLabelUpdater
+class PreviewLabelUpdater : public QRunnable
 {
 public:
-    explicit PreviewLabelUpdater(QSharedPointer<pfs::Frame> reference_frame):
+    //! \param tm_options copied: the label can replace its options while
+    //! the preview is running
+    PreviewLabelUpdater(QSharedPointer<pfs::Frame> reference_frame,
+                        QSharedPointer<PreviewFramePool> frame_pool,
+                        const TonemappingOptions& tm_options,
+                        PreviewPanel* panel, int index, int generation):
         m_doAutolevels(false),
         m_autolevelThreshold(0.985f),
-        m_ReferenceFrame(reference_frame)
-    {}
+        m_ReferenceFrame(reference_frame),
+        m_FramePool(frame_pool),
+        m_TMOptions(tm_options),
+        m_Panel(panel),
+        m_Index(index),
+        m_Generation(generation)
+    {
+        // thumbnails don't need the accurate log/exp/pow: the options of the
+        // label are left untouched, they can be picked for the full size image
+        m_TMOptions.fastMath = true;
+    }
 
     void setAutolevels(bool al, float th) { m_doAutolevels = al; m_autolevelThreshold = th; }
+
     //! \brief QRunnable::run() definition
-    //! \caption I use shared pointer in this function, so I don't have to worry about memory allocation
-    //! in case something wrong happens, it shouldn't leak
-    void operator()(PreviewLabel* to_update)
+    void run()
     {
-#ifdef QT_DEBUG
-        //qDebug() << QThread::currentThread() << "running...";
-#endif
-
-        // retrieve TM parameters
-        TonemappingOptions* tm_options = to_update->getTonemappingOptions();
-        resetTonemappingOptions(tm_options, m_ReferenceFrame.data());
-
-        if ( m_ReferenceFrame.isNull() )
+        QSharedPointer<QImage> qimage;
+        pfs::Frame* working_frame = NULL;
+        try
         {
-#ifdef QT_DEBUG
-            qDebug() << "operator()() for TM" << static_cast<int>(tm_options->tmoperator) << " received a NULL pointer";
-            return;
-#endif
-        }
-
-        // Copy Reference Frame
-        QSharedPointer<pfs::Frame> temp_frame( pfs::copy(m_ReferenceFrame.data()) );
+            // the operators work in place: tone map a recycled copy of the reference
+            working_frame = m_FramePool->acquire(*m_ReferenceFrame);
 
-        // Tone Mapping
-        //QScopedPointer<TonemapOperator> tm_operator( TonemapOperator::getTonemapOperator(tm_options->tmoperator));
-        //tm_operator->tonemapFrame(temp_frame.data(), tm_options, fake_progress_helper);
+            if ( m_TMOptions.pregamma != 1.0f )
+            {
+                pfs::applyGamma(working_frame, m_TMOptions.pregamma);
+            }
 
-        //try { //Since nothing here actually throws this isn't useful, i need to check if returned frame != NULL
-        QScopedPointer<TMWorker> tmWorker(new TMWorker);
-        QSharedPointer<pfs::Frame> frame (tmWorker->computeTonemap(temp_frame.data(), tm_options, BilinearInterp));
+            pfs::Progress fake_progress;
+            QScopedPointer<TonemapOperator> tm_operator( TonemapOperator::getTonemapOperator(m_TMOptions.tmoperator) );
+            tm_operator->tonemapFrame(*working_frame, &m_TMOptions, fake_progress);
 
-        if (!frame.isNull())
-        {
-            // Create QImage from pfs::Frame into QSharedPointer, and I give it to the preview panel
-            //QSharedPointer<QImage> qimage(fromLDRPFStoQImage(temp_frame.data()));
+            // levels are applied while building the final QImage
+            pfs::GammaLevels levels;
             if (m_doAutolevels) {
-                QSharedPointer<QImage> temp_qimage(fromLDRPFStoQImage(frame.data()));
+                QScopedPointer<QImage> temp_qimage(fromLDRPFStoQImage(working_frame));
                 float minL, maxL, gammaL;
                 computeAutolevels(temp_qimage.data(), m_autolevelThreshold, minL, maxL, gammaL);
-                pfs::gammaAndLevels(frame.data(), minL, maxL, 0.f, 1.f, gammaL);
+                levels = pfs::GammaLevels(minL, maxL, 0.f, 1.f, gammaL);
             }
 
-            QSharedPointer<QImage> qimage(fromLDRPFStoQImage(frame.data()));
-
-            //! \note I cannot use these 2 functions, because setPixmap must run in the GUI thread
-            //m_PreviewLabel->setPixmap( QPixmap::fromImage(*qimage) );
-            //m_PreviewLabel->adjustSize();
-            //! \note So I queue a SLOT request on the m_PreviewPanel
-            QMetaObject::invokeMethod(to_update, "assignNewQImage", Qt::QueuedConnection,
-                                      Q_ARG(QSharedPointer<QImage>, qimage));
+            qimage = QSharedPointer<QImage>(fromLDRPFStoQImage(working_frame, 0.f, 1.f,
+                                                               MAP_LINEAR, levels));
         }
-        else
+        catch (...)
         {
-            QSharedPointer<QImage> qimage(new QImage(PREVIEW_WIDTH, PREVIEW_HEIGHT, QImage::Format_ARGB32_Premultiplied));
+            qimage = QSharedPointer<QImage>(new QImage(PREVIEW_WIDTH, PREVIEW_HEIGHT, QImage::Format_ARGB32_Premultiplied));
             qimage->fill(QColor(255,0,0)); //TODO Tonemapping failed, let's show a RED preview...
-            QMetaObject::invokeMethod(to_update, "assignNewQImage", Qt::QueuedConnection,
-                                      Q_ARG(QSharedPointer<QImage>, qimage));
         }
-        /*
-        }
-        catch (...) {
-            qDebug() << "PreviewLabelUpdater: caught exception";
-            QSharedPointer<QImage> qimage(new QImage);
-            QMetaObject::invokeMethod(to_update, "assignNewQImage", Qt::QueuedConnection,
-                                      Q_ARG(QSharedPointer<QImage>, qimage));
-        }
-        */
-#ifdef QT_DEBUG
-        //qDebug() << QThread::currentThread() << "done!";
-#endif
+        m_FramePool->release(working_frame);
+
+        //! \note setPixmap must run in the GUI thread: the panel also drops
+        //! the previews overtaken by a newer request for the same label
+        QMetaObject::invokeMethod(m_Panel, "previewReady", Qt::QueuedConnection,
+                                  Q_ARG(int, m_Index),
+                                  Q_ARG(int, m_Generation),
+                                  Q_ARG(QSharedPointer<QImage>, qimage));
     }
 
 private:
     bool m_doAutolevels;
     float m_autolevelThreshold;
     QSharedPointer<pfs::Frame> m_ReferenceFrame;
+    QSharedPointer<PreviewFramePool> m_FramePool;
+    TonemappingOptions m_TMOptions;
+    PreviewPanel* m_Panel;
+    int m_Index;
+    int m_Generation;
 };
 
 }
@@ -151,7 +145,8 @@ private:
 PreviewPanel::PreviewPanel(QWidget *parent):
     QWidget(parent),
     m_original_width_frame(0),
-    m_doAutolevels(false)
+    m_doAutolevels(false),
+    m_reference(new PreviewReference)
 {
     //! \note I need to register the new object to pass this class as parameter inside invokeMethod()
     //! see run() inside PreviewLabelUpdater
@@ -249,6 +244,13 @@ PreviewPanel::PreviewPanel(QWidget *parent):
     flowLayout->addWidget(labelMai);
 
     setLayout(flowLayout);
+
+    // every preview is a whole tone mapping: never run more of them than
+    // the threads of the library, and keep one working frame for each
+    const int max_threads = static_cast<int>(pfs::utils::concurrency());
+    m_threadPool.setMaxThreadCount(max_threads);
+    m_framePool = QSharedPointer<PreviewFramePool>(new PreviewFramePool(max_threads));
+    m_generations.fill(0, m_ListPreviewLabel.size());
 }
 
 PreviewPanel::~PreviewPanel()
@@ -256,6 +258,8 @@ PreviewPanel::~PreviewPanel()
 #ifdef QT_DEBUG
     qDebug() << "PreviewPanel::~PreviewPanel()";
 #endif
+    m_threadPool.clear();
+    m_threadPool.waitForDone();
 }
 
 void PreviewPanel::updatePreviews(pfs::Frame* frame, int index)
@@ -264,34 +268,31 @@ void PreviewPanel::updatePreviews(pfs::Frame* frame, int index)
 
     m_original_width_frame = frame->getWidth();
 
-    int frame_width = frame->getWidth();
-    int frame_height = frame->getHeight();
+    // 1. the downscaled copy, shared by all the labels (and made once per HDR)
+    QSharedPointer<pfs::Frame> current_frame = m_reference->get(frame);
 
-    int resized_width = PREVIEW_WIDTH;
-    if (frame_height > frame_width)
+    // 2. (concurrent) for each PreviewLabel, run a PreviewLabelUpdater in the pool
+    for (int i = 0; i < m_ListPreviewLabel.size(); ++i)
     {
-        float ratio = ((float)frame_width)/frame_height;
-        resized_width = PREVIEW_HEIGHT*ratio;
-    }
-    // 1. make a resized copy
-    QSharedPointer<pfs::Frame> current_frame( pfs::resize(frame, resized_width, BilinearInterp));
+        if ( index != -1 && i != index ) continue;
 
-    // 2. (non concurrent) for each PreviewLabel, call PreviewLabelUpdater::operator()
-    if (index == -1) {
-        foreach(PreviewLabel* current_label, m_ListPreviewLabel)
-        {
-            PreviewLabelUpdater updater(current_frame);
-            updater.setAutolevels(m_doAutolevels, m_autolevelThreshold);
-            updater(current_label);
-        }
-    }
-    else {
-        PreviewLabelUpdater updater(current_frame);
-        updater.setAutolevels(m_doAutolevels, m_autolevelThreshold);
-        updater(m_ListPreviewLabel.at(index));
+        TonemappingOptions* tm_options = m_ListPreviewLabel.at(i)->getTonemappingOptions();
+        resetTonemappingOptions(tm_options, current_frame.data());
+
+        PreviewLabelUpdater* updater = new PreviewLabelUpdater(current_frame, m_framePool,
+                                                               *tm_options, this,
+                                                               i, ++m_generations[i]);
+        updater->setAutolevels(m_doAutolevels, m_autolevelThreshold);
+        m_threadPool.start(updater);
     }
-    // 2. (concurrent) for each PreviewLabel, call PreviewLabelUpdater::operator()
-    //QtConcurrent::map (m_ListPreviewLabel, PreviewLabelUpdater(current_frame) );
+}
+
+void PreviewPanel::previewReady(int index, int generation, QSharedPointer<QImage> qimage)
+{
+    // a newer preview of the label is on its way
+    if ( generation != m_generations.at(index) ) return;
+
+    m_ListPreviewLabel.at(index)->assignNewQImage(qimage);
 }
 
 void PreviewPanel::tonemapPreview(TonemappingOptions* opts)
@@ -24,6 +24,11 @@
 #ifndef PREVIEWPANEL_IMPL_H
 #define PREVIEWPANEL_IMPL_H
 
+#include <QImage>
+#include <QScopedPointer>
+#include <QSharedPointer>
+#include <QThreadPool>
+#include <QVector>
 #include <QWidget>
 
 // forward declaration
@@ -37,6 +42,8 @@ namespace Ui {
 
 class TonemappingOptions;   // #include "Core/TonemappingOptions.h"
 class PreviewLabel;         // #include "PreviewPanel/PreviewLabel.h"
+class PreviewReference;     // #include "PreviewPanel/PreviewFrames.h"
+class PreviewFramePool;     // #include "PreviewPanel/PreviewFrames.h"
 
 class PreviewPanel : public QWidget
 {
@@ -54,6 +61,9 @@ public Q_SLOTS:
 
 protected Q_SLOTS:
     void tonemapPreview(TonemappingOptions*);
+    //! \brief show the preview rendered by the pool, unless a newer one
+    //! of the same label was requested meanwhile
+    void previewReady(int index, int generation, QSharedPointer<QImage> qimage);
 
 Q_SIGNALS:
     void startTonemapping(TonemappingOptions*);
@@ -63,5 +73,10 @@ private:
     bool m_doAutolevels;
     float m_autolevelThreshold;
     QList<PreviewLabel*> m_ListPreviewLabel;
+    QScopedPointer<PreviewReference> m_reference;
+    QSharedPointer<PreviewFramePool> m_framePool;
+    //! \brief last preview requested for each label
+    QVector<int> m_generations;
+    QThreadPool m_threadPool;
 };
 #endif
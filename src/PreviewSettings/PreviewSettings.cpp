@@ -22,21 +22,26 @@
  */
 
 #include <QDebug>
-#include <QtConcurrentMap>
+#include <QCache>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPointer>
+#include <QRunnable>
 #include <QSharedPointer>
+#include <QThread>
 #include <QAction>
 
 #include "PreviewSettings.h"
 
 #include "Libpfs/frame.h"
 #include "Libpfs/manip/cut.h"
-#include "Libpfs/manip/copy.h"
-#include "Libpfs/manip/resize.h"
 #include "Libpfs/progress.h"
 #include "Libpfs/tm/TonemapOperator.h"
+#include "Libpfs/utils/parallel.h"
 
 #include "Core/TMWorker.h"
 #include "Fileformat/pfsoutldrimage.h"
+#include "PreviewPanel/PreviewFrames.h"
 #include "PreviewPanel/PreviewLabel.h"
 #include "Common/LuminanceOptions.h"
 
@@ -55,51 +60,112 @@ void resetTonemappingOptions(TonemappingOptions* tm_options, const pfs::Frame* f
     tm_options->tonemapSelection   = false;
 }
 
-class PreviewLabelUpdater
+//! \brief identifies the content of the (downscaled) reference frame: together
+//! with the parameters of a preset, it is the key of a rendered preview
+QString frameKey(const pfs::Frame& frame)
+{
+    return QString("%1_%2x%3_")
+            .arg(QString::fromStdString(frame.getContentHash().toString()))
+            .arg(frame.getWidth())
+            .arg(frame.getHeight());
+}
+
+//! \brief previews already rendered during this session, shared by all the
+//! PreviewSettings (the saved settings dialog can be opened many times on
+//! the same HDR)
+class PreviewCache
 {
 public:
-    explicit PreviewLabelUpdater(QSharedPointer<pfs::Frame> reference_frame):
-        m_ReferenceFrame(reference_frame)
+    PreviewCache()
+        : m_cache(16*1024)  // in KB
     {}
 
+    bool find(const QString& key, QImage& image)
+    {
+        QMutexLocker locker(&m_mutex);
+        QImage* cached = m_cache.object(key);
+        if ( !cached ) return false;
+
+        image = *cached;
+        return true;
+    }
+
+    void insert(const QString& key, const QImage& image)
+    {
+        QMutexLocker locker(&m_mutex);
+        m_cache.insert(key, new QImage(image), qMax(1, image.byteCount()/1024));
+    }
+
+private:
+    QMutex m_mutex;
+    QCache<QString, QImage> m_cache;
+};
+
+PreviewCache& previewCache()
+{
+    static PreviewCache cache;
+    return cache;
+}
+
+class PreviewLabelUpdater : public QRunnable
+{
+public:
+    PreviewLabelUpdater(QSharedPointer<pfs::Frame> reference_frame,
+                        QSharedPointer<PreviewFramePool> frame_pool,
+                        const TonemappingOptions& tm_options,
+                        const QString& key,
+                        PreviewSettings* settings,
+                        PreviewLabel* to_update, int generation):
+        m_ReferenceFrame(reference_frame),
+        m_FramePool(frame_pool),
+        m_TMOptions(tm_options),
+        m_Key(key),
+        m_Settings(settings),
+        m_PreviewLabel(to_update),
+        m_Generation(generation)
+    {
+        // thumbnails don't need the accurate log/exp/pow
+        m_TMOptions.fastMath = true;
+    }
+
     //! \brief QRunnable::run() definition
     //! \caption I use shared pointer in this function, so I don't have to worry about memory allocation
     //! in case something wrong happens, it shouldn't leak
-    void operator()(PreviewLabel* to_update)
+    void run()
     {
 #ifdef QT_DEBUG
         //qDebug() << QThread::currentThread() << "running...";
 #endif
-
-        // retrieve TM parameters
-        TonemappingOptions* tm_options = to_update->getTonemappingOptions();
-        resetTonemappingOptions(tm_options, m_ReferenceFrame.data());
-
-        if ( m_ReferenceFrame.isNull() )
-        {
-#ifdef QT_DEBUG
-            qDebug() << "operator()() for TM" << static_cast<int>(tm_options->tmoperator) << " received a NULL pointer";
-            return;
-#endif
-        }
-
         pfs::Progress fake_progress;
 
-        // Copy Reference Frame
-        QSharedPointer<pfs::Frame> temp_frame( pfs::copy(m_ReferenceFrame.data()) );
-
-        // Tone Mapping
-        QScopedPointer<TonemapOperator> tm_operator( TonemapOperator::getTonemapOperator(tm_options->tmoperator));
-        tm_operator->tonemapFrame(*temp_frame, tm_options, fake_progress);
+        QSharedPointer<QImage> qimage;
+        pfs::Frame* temp_frame = NULL;
+        try
+        {
+            // Copy Reference Frame (in a recycled one)
+            temp_frame = m_FramePool->acquire(*m_ReferenceFrame);
 
-        // Create QImage from pfs::Frame into QSharedPointer, and I give it to the preview panel
-        QSharedPointer<QImage> qimage(fromLDRPFStoQImage(temp_frame.data()));
+            // Tone Mapping
+            QScopedPointer<TonemapOperator> tm_operator( TonemapOperator::getTonemapOperator(m_TMOptions.tmoperator));
+            tm_operator->tonemapFrame(*temp_frame, &m_TMOptions, fake_progress);
 
-        //! \note I cannot use these 2 functions, because setPixmap must run in the GUI thread
-        //m_PreviewLabel->setPixmap( QPixmap::fromImage(*qimage) );
-        //m_PreviewLabel->adjustSize();
-        //! \note So I queue a SLOT request on the m_PreviewSettings
-        QMetaObject::invokeMethod(to_update, "assignNewQImage", Qt::QueuedConnection,
+            // Create QImage from pfs::Frame into QSharedPointer, and I give it to the preview panel
+            qimage = QSharedPointer<QImage>(fromLDRPFStoQImage(temp_frame));
+            previewCache().insert(m_Key, *qimage);
+        }
+        catch (...)
+        {
+            qimage = QSharedPointer<QImage>(new QImage(PREVIEW_WIDTH, PREVIEW_HEIGHT, QImage::Format_ARGB32_Premultiplied));
+            qimage->fill(QColor(255,0,0)); // Tonemapping failed, let's show a RED preview...
+        }
+        m_FramePool->release(temp_frame);
+
+        //! \note setPixmap must run in the GUI thread: the settings also drop
+        //! the previews overtaken by a newer request for the same label, and
+        //! the ones of labels deleted meanwhile
+        QMetaObject::invokeMethod(m_Settings, "previewReady", Qt::QueuedConnection,
+                                  Q_ARG(QPointer<PreviewLabel>, m_PreviewLabel),
+                                  Q_ARG(int, m_Generation),
                                   Q_ARG(QSharedPointer<QImage>, qimage));
 
 #ifdef QT_DEBUG
@@ -109,21 +175,35 @@ public:
 
 private:
     QSharedPointer<pfs::Frame> m_ReferenceFrame;
+    QSharedPointer<PreviewFramePool> m_FramePool;
+    TonemappingOptions m_TMOptions;
+    QString m_Key;
+    PreviewSettings* m_Settings;
+    QPointer<PreviewLabel> m_PreviewLabel;
+    int m_Generation;
 };
 
 }
 
 PreviewSettings::PreviewSettings(QWidget *parent):
     QWidget(parent),
-    m_original_width_frame(0)
+    m_original_width_frame(0),
+    m_reference(new PreviewReference)
 {
     //! \note I need to register the new object to pass this class as parameter inside invokeMethod()
     //! see run() inside PreviewLabelUpdater
     qRegisterMetaType< QSharedPointer<QImage> >("QSharedPointer<QImage>");
+    qRegisterMetaType< QPointer<PreviewLabel> >("QPointer<PreviewLabel>");
 
     m_flowLayout = new FlowLayout;
 
     setLayout(m_flowLayout);
+
+    // every preview is a whole tone mapping: never queue more of them than
+    // the threads of the library, even when the saved settings are dozens
+    const int max_threads = static_cast<int>(pfs::utils::concurrency());
+    m_threadPool.setMaxThreadCount(max_threads);
+    m_framePool = QSharedPointer<PreviewFramePool>(new PreviewFramePool(max_threads));
 }
 
 PreviewSettings::~PreviewSettings()
@@ -131,6 +211,13 @@ PreviewSettings::~PreviewSettings()
 #ifdef QT_DEBUG
     qDebug() << "PreviewSettings::~PreviewSettings()";
 #endif
+    stopPreviews();
+}
+
+void PreviewSettings::stopPreviews()
+{
+    m_threadPool.clear();
+    m_threadPool.waitForDone();
 }
 
 void PreviewSettings::changeEvent(QEvent *event)
@@ -148,26 +235,46 @@ void PreviewSettings::updatePreviews(pfs::Frame* frame)
 
     m_original_width_frame = frame->getWidth();
 
-    int frame_width = frame->getWidth();
-    int frame_height = frame->getHeight();
+    // 1. the resized copy, made again only when the HDR changes
+    QSharedPointer<pfs::Frame> current_frame = m_reference->get(frame);
 
-    int resized_width = PREVIEW_WIDTH;
-    if (frame_height > frame_width)
-    {
-        float ratio = ((float)frame_width)/frame_height;
-        resized_width = PREVIEW_HEIGHT*ratio;
-    }
-    // 1. make a resized copy
-    QSharedPointer<pfs::Frame> current_frame( pfs::resize(frame, resized_width, BilinearInterp) );
+    // 2. previews still queued for a previous frame are useless now
+    m_threadPool.clear();
+
+    const QString current_key = frameKey(*current_frame);
 
-    // 2. (non concurrent) for each PreviewLabel, call PreviewLabelUpdater::operator()
+    // 3. for each PreviewLabel, reuse the preview already rendered for this
+    // frame or render it in the pool: labels are updated as soon as their
+    // preview is ready
     foreach (PreviewLabel* current_label, m_ListPreviewLabel)
     {
-        PreviewLabelUpdater updater(current_frame);
-        updater(current_label);
+        TonemappingOptions* tm_options = current_label->getTonemappingOptions();
+        resetTonemappingOptions(tm_options, current_frame.data());
+
+        QString key = current_key + tm_options->getPostfix();
+        // a preview still running for the label is stale now
+        const int generation = ++m_generations[current_label];
+
+        QImage cached;
+        if ( previewCache().find(key, cached) )
+        {
+            current_label->assignNewQImage(QSharedPointer<QImage>(new QImage(cached)));
+            continue;
+        }
+
+        m_threadPool.start(new PreviewLabelUpdater(current_frame, m_framePool, *tm_options,
+                                                   key, this, current_label, generation));
     }
-    // 2. (concurrent) for each PreviewLabel, call PreviewLabelUpdater::operator()
-    //QtConcurrent::map (m_ListPreviewLabel, PreviewLabelUpdater(current_frame) );
+}
+
+void PreviewSettings::previewReady(QPointer<PreviewLabel> label, int generation,
+                                   QSharedPointer<QImage> qimage)
+{
+    if ( label.isNull() ) return;
+    // a newer preview of the label is on its way, or was taken from the cache
+    if ( generation != m_generations.value(label.data()) ) return;
+
+    label->assignNewQImage(qimage);
 }
 
 void PreviewSettings::tonemapPreview(TonemappingOptions* opts)
@@ -224,4 +331,5 @@ void PreviewSettings::clear() {
         m_flowLayout->takeAt(i);
     }
     m_ListPreviewLabel.clear();
+    m_generations.clear();
 }
@@ -25,7 +25,14 @@
 #define PREVIEWSETTINGS_IMPL_H
 
 #include <QWidget>
+#include <QHash>
+#include <QImage>
+#include <QPointer>
+#include <QScopedPointer>
+#include <QSharedPointer>
+#include <QThreadPool>
 
+#include "PreviewPanel/PreviewLabel.h"
 #include "UI/FlowLayout.h"
 
 // forward declaration
@@ -34,7 +41,8 @@ namespace pfs {
 }
 
 class TonemappingOptions;   // #include "Core/TonemappingOptions.h"
-class PreviewLabel;         // #include "PreviewSettings/PreviewLabel.h"
+class PreviewReference;     // #include "PreviewPanel/PreviewFrames.h"
+class PreviewFramePool;     // #include "PreviewPanel/PreviewFrames.h"
 
 class PreviewSettings : public QWidget
 {
@@ -48,12 +56,17 @@ public:
     QSize getLabelSize();
     int getSize() { return m_ListPreviewLabel.size(); }
     void clear();
+
+    //! \brief drop the previews not started yet and wait for the running ones:
+    //! call it before deleting the labels
+    void stopPreviews();
 protected:
     virtual void changeEvent(QEvent* event);
 
 public Q_SLOTS:
     void selectLabel(int index);
     void updatePreviews(pfs::Frame* frame);
+    void previewReady(QPointer<PreviewLabel> label, int generation, QSharedPointer<QImage> qimage);
 
 protected Q_SLOTS:
     void tonemapPreview(TonemappingOptions*);
@@ -66,5 +79,10 @@ private:
     int m_original_width_frame;
     QList<PreviewLabel*> m_ListPreviewLabel;
     FlowLayout *m_flowLayout;
+    QScopedPointer<PreviewReference> m_reference;
+    QSharedPointer<PreviewFramePool> m_framePool;
+    QThreadPool m_threadPool;
+    // bumped at every request for a label: older previews are dropped
+    QHash<PreviewLabel*, int> m_generations;
 };
 #endif
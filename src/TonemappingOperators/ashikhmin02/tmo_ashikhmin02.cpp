@@ -33,6 +33,7 @@
 #include "Libpfs/array2d.h"
 #include "Libpfs/frame.h"
 #include "Libpfs/progress.h"
+#include "Libpfs/utils/fastmath.h"
 #include "tmo_ashikhmin02.h"
 #include "pyramid.h"
 
@@ -114,7 +115,9 @@ float LAL(GaussianPyramid *myPyramid, int x, int y, float LOCAL_CONTRAST) {
 
 ////////////////////////////////////////////////////////
 
-float C(float lum_val) { // linearly approximated TVI function
+using pfs::utils::MathPrecision;
+
+float C(float lum_val, MathPrecision p) { // linearly approximated TVI function
   if(lum_val <= 1e-20)
     return 0.0;
 
@@ -122,20 +125,20 @@ float C(float lum_val) { // linearly approximated TVI function
     return lum_val/0.0014;
 
   if(lum_val < 1.0)
-    return 2.4483 + log(lum_val/0.0034)/0.4027;
+    return 2.4483 + pfs::utils::log(lum_val/0.0034f, p)/0.4027;
 
   if(lum_val < 7.2444)
     return 16.5630 + (lum_val-1.0)/0.4027;
 
-  return 32.0693 + log(lum_val/7.2444)/0.0556;
+  return 32.0693 + pfs::utils::log(lum_val/7.2444f, p)/0.0556;
 }
 
-inline float TM(float lum_val, float maxLum, float minLum) {
-  float div = C(maxLum)-C(minLum);
+inline float TM(float lum_val, float maxLum, float minLum, MathPrecision p) {
+  float div = C(maxLum, p)-C(minLum, p);
   if(div != 0.0)
-    return (LDMAX * (C(lum_val)-C(minLum)) / div);
+    return (LDMAX * (C(lum_val, p)-C(minLum, p)) / div);
   else
-    return (LDMAX * (C(lum_val)-C(minLum)) / EPSILON);
+    return (LDMAX * (C(lum_val, p)-C(minLum, p)) / EPSILON);
 }
 
 ////////////////////////////////////////////////////////
@@ -169,6 +172,8 @@ int tmo_ashikhmin02(pfs::Array2Df* Y, pfs::Array2Df* L, float maxLum, float minL
   unsigned int ncols = Y->getCols();
   assert(nrows==L->getRows() && ncols==L->getCols() );
 
+  const MathPrecision precision = pfs::utils::mathPrecision();
+
 //   int im_size = nrows * ncols;
 
   //  maxLum /= avLum;                            // normalize maximum luminance by average luminance
@@ -178,7 +183,7 @@ int tmo_ashikhmin02(pfs::Array2Df* Y, pfs::Array2Df* L, float maxLum, float minL
     for(unsigned int y=0; y<nrows; y++)
       for(unsigned int x=0; x<ncols; x++)
       {
-    (*L)(x,y) = TM((*Y)(x,y), maxLum, minLum);
+    (*L)(x,y) = TM((*Y)(x,y), maxLum, minLum, precision);
 
         //!! FIX:
         // to keep output values in range 0.01 - 1
@@ -213,7 +218,7 @@ int tmo_ashikhmin02(pfs::Array2Df* Y, pfs::Array2Df* L, float maxLum, float minL
     if (ph.canceled())
         break;
     for(unsigned int x=0; x<ncols; x++)
-      (*tm)(x,y) = TM((*la)(x,y), maxLum, minLum);
+      (*tm)(x,y) = TM((*la)(x,y), maxLum, minLum, precision);
   }
   // final computation for each pixel
   for(unsigned int y=0; y<nrows; y++) {
@@ -228,7 +233,7 @@ int tmo_ashikhmin02(pfs::Array2Df* Y, pfs::Array2Df* L, float maxLum, float minL
             (*L)(x,y) = (*Y)(x,y) * (*tm)(x,y) / (*la)(x,y);
             break;
         case 4:
-            (*L)(x,y) =  (*tm)(x,y) + C((*tm)(x,y))/C((*la)(x,y)) * ((*Y)(x,y)-(*la)(x,y));
+            (*L)(x,y) =  (*tm)(x,y) + C((*tm)(x,y), precision)/C((*la)(x,y), precision) * ((*Y)(x,y)-(*la)(x,y));
             break;
         default:
         {
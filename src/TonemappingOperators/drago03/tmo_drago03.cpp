@@ -38,13 +38,14 @@
 
 #include "Libpfs/frame.h"
 #include "Libpfs/progress.h"
+#include "Libpfs/utils/fastmath.h"
 #include "TonemappingOperators/pfstmo.h"
 
 namespace
 {
-inline float biasFunc(float b, float x)
+inline float biasFunc(float b, float x, pfs::utils::MathPrecision p)
 {
-    return std::pow(x, b);        // pow(x, log(bias)/log(0.5))
+    return pfs::utils::pow(x, b, p);        // pow(x, log(bias)/log(0.5))
 }
 
 const float LOG05 = -0.693147f; // log(0.5)
@@ -57,10 +58,11 @@ void calculateLuminance(unsigned int width, unsigned int height,
     maxLum = 0.0f;
 
     int size = width * height;
+    const pfs::utils::MathPrecision precision = pfs::utils::mathPrecision();
 
     for (int i = 0; i < size; i++)
     {
-        avLum += log( Y[i] + 1e-4 );
+        avLum += pfs::utils::log( Y[i] + 1e-4f, precision );
         maxLum = ( Y[i] > maxLum ) ? Y[i] : maxLum ;
     }
     avLum = exp( avLum/size );
@@ -79,6 +81,7 @@ void tmo_drago03(const pfs::Array2Df& Y, pfs::Array2Df& L,
 
     float divider = std::log10(maxLum + 1.0f);
     float biasP = log(bias)/LOG05;
+    const pfs::utils::MathPrecision precision = pfs::utils::mathPrecision();
 
     // Normal tone mapping of every pixel
     for (int y=0, yEnd = Y.getRows(); y < yEnd; y++)
@@ -90,9 +93,9 @@ void tmo_drago03(const pfs::Array2Df& Y, pfs::Array2Df& L,
         for (int x=0, xEnd = Y.getCols(); x < xEnd; x++)
         {
             float Yw = Y(x,y) / avLum;
-            float interpol = std::log (2.0f + biasFunc(biasP, Yw / maxLum) * 8.0f);
+            float interpol = pfs::utils::log(2.0f + biasFunc(biasP, Yw / maxLum, precision) * 8.0f, precision);
             //L(x,y) = ( std::log(Yw+1.0f)/interpol ) / divider;
-            L(x,y) = ( std::log1p(Yw)/interpol ) / divider; // avoid loss of precision
+            L(x,y) = ( pfs::utils::log1p(Yw, precision)/interpol ) / divider; // avoid loss of precision
 
             assert(!boost::math::isnan(L(x,y)));
         }
@@ -32,9 +32,10 @@
 #ifndef BILATERAL_H
 #define BILATERAL_H
 
+#include <Libpfs/array2d_fwd.h>
+
 namespace pfs
 {
-class Array2D;
 class Progress;
 }
 
@@ -48,7 +49,7 @@ class Progress;
 //! \param sigma_s sigma value for spatial kernel
 //! \param sigma_r sigma value for range kernel
 //!
-void bilateralFilter(const pfs::Array2D *I, pfs::Array2D *J,
+void bilateralFilter(const pfs::Array2Df *I, pfs::Array2Df *J,
                      float sigma_s, float sigma_r,
                      pfs::Progress& ph);
 
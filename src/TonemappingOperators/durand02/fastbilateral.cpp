@@ -33,6 +33,7 @@
 #include <fftw3.h>
 
 #include "Libpfs/array2d.h"
+#include "Libpfs/manip/transpose.h"
 #include "Libpfs/progress.h"
 #include "fastbilateral.h"
 
@@ -83,9 +84,8 @@ public:
     int ox = nx;
     int oy = ny/2 + 1;            // saves half of the data
 
-    for( y=0 ; y<ny ; y++ )
-      for( x=0 ; x<nx ; x++ )
-        source[x*ny+y] = I(x,y);
+    // FFTW works on the transposed image
+    pfs::transpose(I.data(), source, nx, ny);
 
     fftwf_execute(fplan_fw);
 
@@ -106,9 +106,9 @@ public:
 
     fftwf_execute(fplan_in);
 
-    for( x=0 ; x<nx ; x++ )
-      for( y=0 ; y<ny ; y++ )
-        J(x,y) = source[x*ny+y] / nsize;
+    pfs::transpose(source, J.data(), ny, nx);
+    for( x=0 ; x<nsize ; x++ )
+      J(x) /= nsize;
   }
 
   ~GaussianBlur()
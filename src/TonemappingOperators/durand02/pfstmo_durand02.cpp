@@ -58,7 +58,7 @@ const bool original_algorithm = false;
 
 void pfstmo_durand02(pfs::Frame& frame,
                      float sigma_s, float sigma_r, float baseContrast,
-                     pfs::Progress &ph)
+                     pfs::Progress &ph, const pfs::TonemapStages& stages)
 {
 #ifndef NDEBUG
     std::stringstream ss;
@@ -89,7 +89,7 @@ void pfstmo_durand02(pfs::Frame& frame,
 
   tmo_durand02(*X, *Y, *Z,
                sigma_s, sigma_r, baseContrast, downsample, !original_algorithm,
-               ph);
+               ph, stages);
 
   if ( !ph.canceled() )
       ph.setValue(100);
@@ -33,12 +33,16 @@
  */
 
 #include <iostream>
+#include <memory>
+#include <stdexcept>
 #include <vector>
 #include <algorithm>
 #include <cmath>
 
 #include "Libpfs/array2d.h"
 #include "Libpfs/progress.h"
+#include "Libpfs/tm/TonemapStageCache.h"
+#include "Libpfs/utils/fastmath.h"
 #include "TonemappingOperators/pfstmo.h"
 
 //#undef HAVE_FFTW3F
@@ -56,7 +60,7 @@ namespace
  *
  */
 inline
-void findMaxMinPercentile(pfs::Array2Df* I,
+void findMaxMinPercentile(const pfs::Array2Df* I,
                           float minPrct, float maxPrct,
                           float& minLum, float& maxLum)
 {
@@ -69,21 +73,29 @@ void findMaxMinPercentile(pfs::Array2Df* I,
             vI.push_back((*I)(i));
     }
 
-    std::sort(vI.begin(), vI.end());
+    // only two ranks are needed, not the whole order
+    const size_t minIdx = size_t(minPrct*vI.size());
+    const size_t maxIdx = size_t(maxPrct*vI.size());
+    if ( maxIdx >= vI.size() )
+    {
+        throw std::out_of_range("findMaxMinPercentile: empty base layer");
+    }
 
-    minLum = vI.at( int(minPrct*vI.size()) );
-    maxLum = vI.at( int(maxPrct*vI.size()) );
+    std::nth_element(vI.begin(), vI.begin() + maxIdx, vI.end());
+    maxLum = vI[maxIdx];
+    std::nth_element(vI.begin(), vI.begin() + minIdx, vI.begin() + maxIdx);
+    minLum = vI[minIdx];
 }
 
 template <typename T>
 inline
-T decode(const T& value)
+T decode(const T& value, pfs::utils::MathPrecision p)
 {
     if ( value <= 0.0031308f )
     {
         return (value * 12.92f);
     }
-    return (1.055f * std::pow( value, 1.f/2.4f ) - 0.055f);
+    return (1.055f * pfs::utils::pow( value, 1.f/2.4f, p ) - 0.055f);
 }
 }
 
@@ -107,15 +119,14 @@ R output = r*exp(log(output intensity)), etc.
 void tmo_durand02(pfs::Array2Df& R, pfs::Array2Df& G, pfs::Array2Df& B,
                   float sigma_s, float sigma_r, float baseContrast, int downsample,
                   bool color_correction,
-                  pfs::Progress &ph)
+                  pfs::Progress &ph, const pfs::TonemapStages& stages)
 {
     int w = R.getCols();
     int h = R.getRows();
     int size = w*h;
+    const pfs::utils::MathPrecision precision = pfs::utils::mathPrecision();
 
     pfs::Array2Df I(w,h); // intensities
-    pfs::Array2Df BASE(w,h); // base layer
-    pfs::Array2Df DETAIL(w,h); // detail layer
 
     float min_pos = 1e10f; // minimum positive value (to avoid log(0))
     for (int i = 0 ; i < size ; i++)
@@ -139,19 +150,37 @@ void tmo_durand02(pfs::Array2Df& R, pfs::Array2Df& G, pfs::Array2Df& B,
         G(i) /= L;
         B(i) /= L;
 
-        I(i) = std::log( L );
+        I(i) = pfs::utils::log( L, precision );
     }
 
+    // base layer and its range: the filter is most of the time of the
+    // operator, and it does not depend on baseContrast
+    pfs::TonemapStageCache::ResultPtr base =
+            stages.find("base", {sigma_s, sigma_r, float(downsample)});
+    pfs::TonemapStageCache::ResultPtr baseRange =
+            stages.find("base range", {sigma_s, sigma_r, float(downsample)});
+    if ( !base || !baseRange )
+    {
+        std::shared_ptr<pfs::Array2Df> computed(new pfs::Array2Df(w,h));
 #ifdef HAVE_FFTW3F
-    fastBilateralFilter( I, BASE, sigma_s, sigma_r, downsample, ph );
+        fastBilateralFilter( I, *computed, sigma_s, sigma_r, downsample, ph );
 #else
-    bilateralFilter( &I, &BASE, sigma_s, sigma_r, ph );
+        bilateralFilter( &I, computed.get(), sigma_s, sigma_r, ph );
 #endif
+        if ( ph.canceled() ) return;
 
-    //!! FIX: find minimum and maximum luminance, but skip 1% of outliers
-    float maxB;
-    float minB;
-    findMaxMinPercentile(&BASE, 0.01f, 0.99f, minB, maxB);
+        //!! FIX: find minimum and maximum luminance, but skip 1% of outliers
+        std::shared_ptr<pfs::Array2Df> range(new pfs::Array2Df(2,1));
+        findMaxMinPercentile(computed.get(), 0.01f, 0.99f, (*range)(0), (*range)(1));
+
+        base = computed;
+        baseRange = range;
+        stages.insert("base", {sigma_s, sigma_r, float(downsample)}, base);
+        stages.insert("base range", {sigma_s, sigma_r, float(downsample)}, baseRange);
+    }
+    const pfs::Array2Df& BASE = *base;
+    const float minB = (*baseRange)(0);
+    const float maxB = (*baseRange)(1);
 
     float compressionfactor = baseContrast / (maxB - minB);
 
@@ -160,10 +189,11 @@ void tmo_durand02(pfs::Array2Df& R, pfs::Array2Df& G, pfs::Array2Df& B,
     const float k2 = 0.82f;
     const float s = ( (1 + k1)*pow(compressionfactor,k2) )/( 1 + k1*pow(compressionfactor,k2) );
 
+#pragma omp parallel for
     for (int i = 0 ; i < size ; i++)
     {
-        DETAIL(i) = I(i) - BASE(i);
-        I(i) = BASE(i) * compressionfactor + DETAIL(i);
+        const float detail = I(i) - BASE(i);
+        I(i) = BASE(i) * compressionfactor + detail;
 
         //!! FIX: this to keep the output in normalized range 0.01 - 1.0
         //intensitites are related only to minimum luminance because I
@@ -172,17 +202,19 @@ void tmo_durand02(pfs::Array2Df& R, pfs::Array2Df& G, pfs::Array2Df& B,
         //luminance
         I(i) -=  4.3f+minB*compressionfactor;
 
+        const float intensity = pfs::utils::exp( I(i), precision );
         if ( color_correction )
         {
-            R(i) = decode( std::pow( R(i), s ) *  std::exp( I(i) ) );
-            G(i) = decode( std::pow( G(i), s ) *  std::exp( I(i) ) );
-            B(i) = decode( std::pow( B(i), s ) *  std::exp( I(i) ) );
+            R(i) = decode( pfs::utils::pow( R(i), s, precision ) * intensity, precision );
+            G(i) = decode( pfs::utils::pow( G(i), s, precision ) * intensity, precision );
+            B(i) = decode( pfs::utils::pow( B(i), s, precision ) * intensity, precision );
         }
         else
         {
-            R(i) *= decode( std::exp( I(i) ) );
-            G(i) *= decode( std::exp( I(i) ) );
-            B(i) *= decode( std::exp( I(i) ) );
+            const float decoded = decode( intensity, precision );
+            R(i) *= decoded;
+            G(i) *= decoded;
+            B(i) *= decoded;
         }
     }
 
@@ -40,6 +40,7 @@
 namespace pfs
 {
 class Progress;
+class TonemapStages;
 }
 
 //!
@@ -55,11 +56,13 @@ class Progress;
 //! \param baseContrast contrast of the base layer
 //! \param color_correction enable automatic color correction
 //! \param downsample down sampling factor for speeding up fast-bilateral (1..20)
+//! \param stages the base layer ("base") only depends on sigma_s, sigma_r and
+//! downsample: it is reused when only baseContrast changes
 //!
 void tmo_durand02(pfs::Array2Df& R, pfs::Array2Df& G, pfs::Array2Df& B,
                   float sigma_s, float sigma_r, float baseContrast, int downsample,
                   bool color_correction /*= true*/,
-                  pfs::Progress &ph);
+                  pfs::Progress &ph, const pfs::TonemapStages& stages);
 
 
 #endif // TMO_DURAND02_H
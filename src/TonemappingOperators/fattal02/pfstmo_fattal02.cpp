@@ -37,11 +37,13 @@
 #include <iostream>
 #include <sstream>
 #include <algorithm>
+#include <memory>
 
 #include "Libpfs/frame.h"
 #include "Libpfs/colorspace/colorspace.h"
 #include "Libpfs/exception.h"
 #include "Libpfs/progress.h"
+#include "Libpfs/tm/TonemapStageCache.h"
 
 namespace
 {
@@ -56,7 +58,8 @@ void pfstmo_fattal02(pfs::Frame& frame,
                      bool newfattal,
                      bool fftsolver,
                      int detail_level,
-                     pfs::Progress &ph)
+                     pfs::Progress &ph,
+                     const pfs::TonemapStages& stages)
 {
   if (fftsolver)
   {
@@ -95,14 +98,28 @@ void pfstmo_fattal02(pfs::Frame& frame,
   const int h = frame.getHeight();
 
   pfs::Array2Df Yr(w,h);
-  pfs::Array2Df L(w,h);
 
   pfs::transformRGB2Y(R, G, B, &Yr);
 
-  tmo_fattal02(w, h, Yr, L,
-               opt_alpha, opt_beta, opt_noise, newfattal,
-               fftsolver, detail_level,
-               ph);
+  // the solved luminance: only the saturation is applied after it
+  pfs::TonemapStageCache::ResultPtr luminance =
+          stages.find("luminance", {opt_alpha, opt_beta, opt_noise, float(newfattal),
+                                    float(fftsolver), float(detail_level)});
+  if ( !luminance )
+  {
+      std::shared_ptr<pfs::Array2Df> solved(new pfs::Array2Df(w,h));
+      tmo_fattal02(w, h, Yr, *solved,
+                   opt_alpha, opt_beta, opt_noise, newfattal,
+                   fftsolver, detail_level,
+                   ph);
+      luminance = solved;
+      if ( !ph.canceled() )
+      {
+          stages.insert("luminance", {opt_alpha, opt_beta, opt_noise, float(newfattal),
+                                      float(fftsolver), float(detail_level)}, luminance);
+      }
+  }
+  const pfs::Array2Df& L = *luminance;
 
   if ( !ph.canceled() )
   {
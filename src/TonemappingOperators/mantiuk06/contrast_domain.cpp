@@ -83,7 +83,9 @@
 #include "Libpfs/utils/minmax.h"
 #include "Libpfs/utils/dotproduct.h"
 #include "Libpfs/utils/msec_timer.h"
+#include "Libpfs/utils/fastmath.h"
 #include "Libpfs/progress.h"
+#include "Libpfs/tm/TonemapStageCache.h"
 
 using namespace pfs;
 
@@ -381,6 +383,7 @@ void normalizeLuminanceAndRGB(Array2Df& R, Array2Df& G, Array2Df& B,
 {
     const float Ymax = utils::maxElement(Y.data(), Y.size());
     const float clip_min = 1e-7f*Ymax;
+    const utils::MathPrecision precision = utils::mathPrecision();
 
     // std::cout << "clip_min = " << clip_min << std::endl;
     // std::cout << "Ymax = " << Ymax << std::endl;
@@ -397,7 +400,7 @@ void normalizeLuminanceAndRGB(Array2Df& R, Array2Df& G, Array2Df& B,
         R(idx) *= currY;
         G(idx) *= currY;
         B(idx) *= currY;
-        Y(idx) = std::log10( Y(idx) );
+        Y(idx) = utils::log10( Y(idx), precision );
     }
 }
 
@@ -434,28 +437,29 @@ void denormalizeLuminance(Array2Df& Y)
 
 template <typename T>
 inline
-T decode(const T& value)
+T decode(const T& value, utils::MathPrecision precision)
 {
     if ( value <= 0.0031308f )
     {
         return (value * 12.92f);
     }
-    return (1.055f * std::pow( value, 1.f/2.4f ) - 0.055f);
+    return (1.055f * utils::pow( value, 1.f/2.4f, precision ) - 0.055f);
 }
 
 void denormalizeRGB(Array2Df& R, Array2Df& G, Array2Df& B, const Array2Df& Y,
                     float saturationFactor)
 {
     const int size = static_cast<int>(Y.size());
+    const utils::MathPrecision precision = utils::mathPrecision();
 
     /* Transform to sRGB */
 #pragma omp parallel for
     for (int j = 0; j < size; j++)
     {
-        float myY = std::pow( 10.f, Y(j) );
-        R(j) = decode( std::pow( R(j), saturationFactor ) * myY );
-        G(j) = decode( std::pow( G(j), saturationFactor ) * myY );
-        B(j) = decode( std::pow( B(j), saturationFactor ) * myY );
+        float myY = utils::exp10( Y(j), precision );
+        R(j) = decode( utils::pow( R(j), saturationFactor, precision ) * myY, precision );
+        G(j) = decode( utils::pow( G(j), saturationFactor, precision ) * myY, precision );
+        B(j) = decode( utils::pow( B(j), saturationFactor, precision ) * myY, precision );
     }
 }
 }
@@ -468,7 +472,8 @@ int tmo_mantiuk06_contmap(Array2Df& R, Array2Df& G, Array2Df& B,
                           float detailfactor,
                           const int itmax,
                           const float tol,
-                          Progress &ph)
+                          Progress &ph,
+                          const TonemapStages& stages)
 {
     assert( R.getCols() == G.getCols() );
     assert( G.getCols() == B.getCols() );
@@ -483,6 +488,17 @@ int tmo_mantiuk06_contmap(Array2Df& R, Array2Df& G, Array2Df& B,
 
     normalizeLuminanceAndRGB(R, G, B, Y);
 
+    // the solver is most of the time of the operator: the saturation is
+    // only applied after it
+    TonemapStageCache::ResultPtr luminance =
+            stages.find("luminance", {contrastFactor, detailfactor, float(itmax), tol});
+    if ( luminance )
+    {
+        Y = *luminance;
+        denormalizeRGB(R, G, B, Y, saturationFactor);
+        return PFSTMO_OK;
+    }
+
     // create pyramid
     PyramidT pp(r, c);
     // calculate gradients for pyramid (Y won't be changed)
@@ -508,6 +524,11 @@ int tmo_mantiuk06_contmap(Array2Df& R, Array2Df& G, Array2Df& B,
     transformToLuminance(pp, Y, itmax, tol, ph);
 
     denormalizeLuminance(Y);
+    if ( !ph.canceled() )
+    {
+        stages.insert("luminance", {contrastFactor, detailfactor, float(itmax), tol},
+                      TonemapStageCache::ResultPtr(new Array2Df(Y)));
+    }
     denormalizeRGB(R, G, B, Y, saturationFactor);
 
     return PFSTMO_OK;
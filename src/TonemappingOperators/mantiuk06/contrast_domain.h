@@ -40,6 +40,11 @@
 #include "TonemappingOperators/pfstmo.h"
 #include <Libpfs/array2d_fwd.h>
 
+namespace pfs
+{
+class TonemapStages;
+}
+
 //! \brief: Tone mapping algorithm [Mantiuk2006]
 //!
 //! \param R red channel
@@ -51,6 +56,8 @@
 //! \param itmax maximum number of iterations for convergence (typically 50)
 //! \param tol tolerence to get within for convergence (typically 1e-3)
 //! \param ph callback class that reports progress
+//! \param stages the luminance after the solver ("luminance") does not
+//! depend on saturationFactor: it is reused when only the saturation changes
 //! \return PFSTMO_OK if tone-mapping was sucessful, PFSTMO_ABORTED if
 //! it was stopped from a callback function and PFSTMO_ERROR if an
 //! error was encountered.
@@ -59,6 +66,7 @@ int tmo_mantiuk06_contmap( pfs::Array2Df& R, pfs::Array2Df& G, pfs::Array2Df& B,
                            pfs::Array2Df& Y,
                            float contrastFactor, float saturationFactor, float detailFactor,
                            int itmax /*= 200*/, float tol /*= 1e-3*/,
-                           pfs::Progress &ph);
+                           pfs::Progress &ph,
+                           const pfs::TonemapStages& stages);
 
 #endif
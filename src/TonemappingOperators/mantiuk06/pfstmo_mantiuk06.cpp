@@ -62,7 +62,8 @@ const float tol = 5e-3f;
 
 void pfstmo_mantiuk06(pfs::Frame& frame, float scaleFactor,
                       float saturationFactor, float detailFactor,
-                      bool cont_eq, pfs::Progress &ph)
+                      bool cont_eq, pfs::Progress &ph,
+                      const pfs::TonemapStages& stages)
 {
 #ifndef NDEBUG
     std::stringstream ss;
@@ -105,7 +106,7 @@ void pfstmo_mantiuk06(pfs::Frame& frame, float scaleFactor,
 
     tmo_mantiuk06_contmap(*inRed, *inGreen, *inBlue, inY,
                           scaleFactor, saturationFactor, detailFactor, itmax, tol,
-                          ph);
+                          ph, stages);
 
     frame.getTags().setTag("LUMINANCE", "RELATIVE");
     if ( !ph.canceled() )
@@ -572,6 +572,7 @@ float lookup_table(size_t n, const float* in_tab, const float* out_tab, float va
 
 TransformToR::TransformToR(float detailFactor)
     : m_detailFactor(LOG10FACTOR*detailFactor)
+    , m_precision(pfs::utils::mathPrecision())
 {}
 
 // transform gradient G to R
@@ -580,14 +581,14 @@ float TransformToR::operator ()(float currG) const
     if (currG < 0.0f)
     {
         // G to W
-        currG = std::pow(10, (-currG) * m_detailFactor) - 1.0f;
+        currG = pfs::utils::exp10((-currG) * m_detailFactor, m_precision) - 1.0f;
         // W to RESP
         return -lookup_table(LOOKUP_W_TO_R, W_table, R_table, currG);
     }
     else
     {
         // G to W
-        currG = std::pow(10, currG * m_detailFactor) - 1.0f;
+        currG = pfs::utils::exp10(currG * m_detailFactor, m_precision) - 1.0f;
         // W to RESP
         return lookup_table(LOOKUP_W_TO_R, W_table, R_table, currG);
     }
@@ -596,6 +597,7 @@ float TransformToR::operator ()(float currG) const
 
 TransformToG::TransformToG(float detailFactor)
     : m_detailFactor(1.0f/(LOG10FACTOR*detailFactor))
+    , m_precision(pfs::utils::mathPrecision())
 {}
 
 // transform from R to G
@@ -607,7 +609,7 @@ float TransformToG::operator ()(float currR) const
         currR = lookup_table(LOOKUP_W_TO_R, R_table, W_table, -currR);
         // W to G
         //return -std::log(currR + 1.0f) * m_detailFactor;
-        return -std::log1p(currR) * m_detailFactor; // avoid loss of precision
+        return -pfs::utils::log1p(currR, m_precision) * m_detailFactor; // avoid loss of precision
     }
     else
     {
@@ -615,7 +617,7 @@ float TransformToG::operator ()(float currR) const
         currR = lookup_table(LOOKUP_W_TO_R, R_table, W_table, currR);
         // W to G
         //return std::log(currR + 1.0f) * m_detailFactor;
-        return std::log1p(currR) * m_detailFactor; // avoid loss of precision
+        return pfs::utils::log1p(currR, m_precision) * m_detailFactor; // avoid loss of precision
     }
 }
 
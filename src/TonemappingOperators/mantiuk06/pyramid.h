@@ -35,6 +35,7 @@
 #include <vector>
 
 #include "Libpfs/array2d.h"
+#include "Libpfs/utils/fastmath.h"
 
 class XYGradient
 {
@@ -165,21 +166,25 @@ void calculateAndAddDivergence(const PyramidS& G, float* divG);
 float calculateScaleFactor(float g);
 
 //! \brief transform gradient \a G to R
+//! \note the math precision of the calling thread is read by the constructor
 struct TransformToR
 {
     TransformToR(float detailFactor);
     float operator()(float currG) const;
 private:
     float m_detailFactor;
+    pfs::utils::MathPrecision m_precision;
 };
 
 //! \brief transform from \a R to G
+//! \note the math precision of the calling thread is read by the constructor
 struct TransformToG
 {
     TransformToG(float detailFactor);
     float operator()(float currR) const;
 private:
     float m_detailFactor;
+    pfs::utils::MathPrecision m_precision;
 };
 
 #endif // MANTIUK06_PYRAMID_H
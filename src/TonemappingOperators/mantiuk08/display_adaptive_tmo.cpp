@@ -53,6 +53,7 @@
 #include "Libpfs/progress.h"
 #include "Libpfs/array2d.h"
 #include "Libpfs/utils/sse.h"
+#include "Libpfs/utils/fastmath.h"
 
 #ifdef BRANCH_PREDICTION
 #define likely(x)       __builtin_expect((x),1)
@@ -145,28 +146,6 @@ void datmoToneCurve::free()
 #define round_int( x ) (int)((x) + 0.5)
 #define sign( x ) ( (x)<0 ? -1 : 1 )
 
-static inline float safe_log10( float x, const float min_x = MIN_PHVAL, const float max_x = MAX_PHVAL )
-{
-  if( x < min_x )
-    return log10(min_x);
-  else if( x > max_x )
-    return log10(max_x);
-  else return log10( x );
-}
-
-#ifdef LUMINANCE_USE_SSE
-
-#define LOG2_10 3.3219280948874f
-#define LOG2_10__1 (1.0f/LOG2_10)
-static inline v4sf safe_log10( v4sf x, const float min_x = MIN_PHVAL, const float max_x = MAX_PHVAL )
-{
-  x = _mm_max_ps(x, _mm_set1_ps(min_x));
-  x = _mm_min_ps(x, _mm_set1_ps(max_x));
-  return _mm_log2_ps(x) * _mm_set1_ps(LOG2_10__1);
-}
-
-#endif
-
 /**
  * Find the lowest non-zero value. Used to avoid log10(0).
  */
@@ -448,18 +427,11 @@ std::unique_ptr<datmoConditionalDensity> datmo_compute_conditional_density( int
 
   const float min_val = std::max( min_positive( L, pix_count ), MIN_PHVAL );
 
-  // Compute log10 of an image
-#pragma omp parallel for default(none) shared(LP_high_raw, L)
-#ifndef LUMINANCE_USE_SSE
+  // Compute log10 of an image: clamp, then the vector log10 of the processor
+#pragma omp parallel for
   for( int i=0; i < pix_count; i++ )
-    LP_high_raw[i] = safe_log10( L[i], min_val );
-#else
-  for( int i=0; i < pix_count-3; i+=4 )
-    _mm_store_ps(&LP_high_raw[i], safe_log10( _mm_load_ps(&L[i]), min_val ));
-  // In case pix_count%4 > 0
-  for( int i=pix_count-3; i < pix_count; i++ )
-    LP_high_raw[i] = safe_log10( L[i], min_val );
-#endif
+    LP_high_raw[i] = std::min( std::max( L[i], min_val ), MAX_PHVAL );
+  pfs::utils::vlog10( LP_high_raw, LP_high_raw, pix_count, pfs::utils::mathPrecision() );
 
   bool warn_out_of_range = false;
   C->total = 0;
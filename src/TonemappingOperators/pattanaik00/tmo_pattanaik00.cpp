@@ -39,6 +39,7 @@
 #include "Libpfs/pfs.h"
 #include "Libpfs/array2d.h"
 #include "Libpfs/progress.h"
+#include "Libpfs/utils/fastmath.h"
 
 /// sensitivity of human visual system
 float n = 0.73f;
@@ -47,6 +48,8 @@ float sigma_response_rod(float I);
 float sigma_response_cone(float I);
 float model_response(float I, float sigma);
 
+using pfs::utils::MathPrecision;
+
 namespace
 {
 const float LOG5 = std::log(5.f);
@@ -62,15 +65,17 @@ const float LOG5 = std::log(5.f);
  * @param y x-coordinate of pixel
  * @param Acone [out] calculated adaptation for cones
  * @param Arod [out] calculated adaptation for rods
+ * @param precision accuracy of the log/exp of the kernel weights
  */
-void calculateLocalAdaptation(const pfs::Array2Df& Y, int x, int y, float& Acone, float& Arod)
+void calculateLocalAdaptation(const pfs::Array2Df& Y, int x, int y, float& Acone, float& Arod,
+                              MathPrecision precision)
 {
     int width = Y.getCols();
     int height = Y.getRows();
 
     int kernel_size = 4;
 
-    float logLc = std::log(Y(x,y))/LOG5;
+    float logLc = pfs::utils::log(Y(x,y), precision)/LOG5;
 
     float pix_num = 0.0;
     float pix_sum = 0.0;
@@ -80,13 +85,10 @@ void calculateLocalAdaptation(const pfs::Array2Df& Y, int x, int y, float& Acone
                     x+kx>0 && x+kx<width && y+ky>0 && y+ky<height )
             {
                 float L = Y(x+kx,y+ky);
-                float w = std::exp(
-                            -std::pow(
-                                std::fabs(
-                                    std::log(L)/LOG5-logLc
-                                    ), 6.0f
-                                )
-                            );
+                // |d|^6 as a product: the integer power needs no pow()
+                float d = pfs::utils::log(L, precision)/LOG5-logLc;
+                float d2 = d*d;
+                float w = pfs::utils::exp(-d2*d2*d2, precision);
                 pix_sum +=  w*L;
                 pix_num +=  w;
             }
@@ -107,6 +109,8 @@ void tmo_pattanaik00(pfs::Array2Df& R, pfs::Array2Df& G, pfs::Array2Df& B,
                      const pfs::Array2Df& Y,
                      VisualAdaptationModel* am, bool local, pfs::Progress &ph)
 {
+    const MathPrecision precision = pfs::utils::mathPrecision();
+
     ///--- initialization of parameters
     /// cones level of adaptation
     float Acone = am->getAcone();
@@ -217,7 +221,7 @@ void tmo_pattanaik00(pfs::Array2Df& R, pfs::Array2Df& G, pfs::Array2Df& B,
 
             if ( local )
             {
-                calculateLocalAdaptation(Y,x,y,Acone,Arod);
+                calculateLocalAdaptation(Y,x,y,Acone,Arod,precision);
                 Bcone = 2e6/(2e6+Acone);
                 Brod = 0.04f/(0.04f+Arod);
 
@@ -235,8 +239,10 @@ void tmo_pattanaik00(pfs::Array2Df& R, pfs::Array2Df& G, pfs::Array2Df& B,
                 Rcone /= Rlum;
             }
 
-            float Scolor = (Bcone*pow(sigma_cone,n)*n*pow(l,n))
-                    / pow( pow(l,n)+pow(sigma_cone,n), 2 );
+            float sigma_cone_n = pfs::utils::pow(sigma_cone, n, precision);
+            float l_n = pfs::utils::pow(l, n, precision);
+            float Scolor = (Bcone*sigma_cone_n*n*l_n)
+                    / ((l_n+sigma_cone_n)*(l_n+sigma_cone_n));
             Scolor /= S_d;
 
             // appearance model
@@ -244,12 +250,13 @@ void tmo_pattanaik00(pfs::Array2Df& R, pfs::Array2Df& G, pfs::Array2Df& B,
             Ra = (Ra<1.0f) ? ((Ra>0.0f) ? Ra : 0.0f ) : 0.9999999f;
 
             // inverse display model
-            float I = display_sigma * pow(Ra/(1.0f-Ra), 1.0f/n) / display_white;
+            float I = display_sigma * pfs::utils::pow(Ra/(1.0f-Ra), 1.0f/n, precision)
+                    / display_white;
 
             // apply new luminance
-            r = pow( r, Scolor )*I*Rcone + I*Rrod;
-            g = pow( g, Scolor )*I*Rcone + I*Rrod;
-            b = pow( b, Scolor )*I*Rcone + I*Rrod;
+            r = pfs::utils::pow( r, Scolor, precision )*I*Rcone + I*Rrod;
+            g = pfs::utils::pow( g, Scolor, precision )*I*Rcone + I*Rrod;
+            b = pfs::utils::pow( b, Scolor, precision )*I*Rcone + I*Rrod;
 
             R(x,y) = (r<1.0f) ? ((r>0.0f) ? r : 0.0f) : 1.0f;
             G(x,y) = (g<1.0f) ? ((g>0.0f) ? g : 0.0f) : 1.0f;
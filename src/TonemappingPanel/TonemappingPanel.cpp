@@ -1127,6 +1127,17 @@ void TonemappingPanel::updatedHDR(pfs::Frame* f)
     m_currentFrame = f;
 }
 
+void TonemappingPanel::setCurrentFrame(pfs::Frame* f)
+{
+    m_currentFrame = f;
+}
+
+pfs::Frame* TonemappingPanel::currentFrame()
+{
+    emit currentFrameNeeded();
+    return m_currentFrame;
+}
+
 /*
  * This function should set the entire status.
  * Currently I'm only interested in changing the TM operator
@@ -1268,7 +1279,7 @@ void TonemappingPanel::saveParameters()
 
 void TonemappingPanel::loadParameters()
 {
-    TonemappingSettings dialog(this, m_currentFrame);
+    TonemappingSettings dialog(this, currentFrame());
 
     if (dialog.exec())
     {
@@ -1794,14 +1805,14 @@ void TonemappingPanel::updatePreviews(double v)
                 TonemappingOptions *tmopts = new TonemappingOptions(*toneMappingOptions); // make a copy
                 tmopts->pregamma = v;
                 m_previewPanel->getLabel(i)->setTonemappingOptions(tmopts);
-                m_previewPanel->updatePreviews(m_currentFrame, i);
+                m_previewPanel->updatePreviews(currentFrame(), i);
             }
             updateCurrentTmoOperator(index);
         }
         else
         {
             m_previewPanel->getLabel(index)->setTonemappingOptions(tmopts);
-            m_previewPanel->updatePreviews(m_currentFrame, index);
+            m_previewPanel->updatePreviews(currentFrame(), index);
         }
     }
     delete tmopts;
@@ -1837,7 +1848,7 @@ void TonemappingPanel::updatePreviewsCB(int state)
     if (index >= 0)
     {
         m_previewPanel->getLabel(index)->setTonemappingOptions(tmopts);
-        m_previewPanel->updatePreviews(m_currentFrame, index);
+        m_previewPanel->updatePreviews(currentFrame(), index);
     }
     delete tmopts;
 }
@@ -1854,7 +1865,7 @@ void TonemappingPanel::updatePreviewsRB(bool toggled)
     if (index >= 0)
     {
         m_previewPanel->getLabel(index)->setTonemappingOptions(tmopts);
-        m_previewPanel->updatePreviews(m_currentFrame, index);
+        m_previewPanel->updatePreviews(currentFrame(), index);
     }
     delete tmopts;
 }
@@ -172,6 +172,9 @@ public:
 public Q_SLOTS:
     void setEnabled(bool);
     void updatedHDR(pfs::Frame*);
+    //! \brief same HDR, expanded again after it was compacted: the sizes
+    //! chosen by the user are kept
+    void setCurrentFrame(pfs::Frame*);
     void updateTonemappingParams(TonemappingOptions *opts);
     void setRealtimePreviews(bool);
     void autoLevels(bool b);
@@ -180,9 +183,13 @@ signals:
     void startTonemapping(TonemappingOptions*);
     void startExport(TonemappingOptions*);
     void autoLevels(bool, float);
+    //! \brief emitted before the HDR is read: the tab holding it may have
+    //! been compacted, and setCurrentFrame() must be called back
+    void currentFrameNeeded();
 
 private:
     void onUndoRedo(bool undo);
+    pfs::Frame* currentFrame();
 
     QtWaitingSpinner* m_spinner;
 
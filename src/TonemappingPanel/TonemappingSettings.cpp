@@ -36,7 +36,7 @@
 
 namespace // anoymous namespace
 {
-const int PREVIEW_WIDTH = PREVIEW_WIDTH;
+const int PREVIEW_WIDTH = 120;
 const int PREVIEW_HEIGHT = 100;
 
 bool compareByComment(PreviewLabel *l1, PreviewLabel *l2)
@@ -100,6 +100,8 @@ TonemappingSettings::TonemappingSettings(QWidget *parent, pfs::Frame *frame) :
 
 TonemappingSettings::~TonemappingSettings()
 {
+    // previews still rendering hold pointers to the labels
+    m_previewSettings->stopPreviews();
     qDeleteAll(m_previewLabelList);
 }
 
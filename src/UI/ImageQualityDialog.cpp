@@ -30,8 +30,7 @@
 #include <QBuffer>
 #include <QDebug>
 
-#include <Libpfs/io/jpegwriter.h>
-#include <Libpfs/io/pngwriter.h>
+#include <Libpfs/io/encodedsize.h>
 
 namespace
 {
@@ -71,6 +70,7 @@ ImageQualityDialog::ImageQualityDialog(const pfs::Frame* frame,
     else
     {
         m_ui->fileSizePanel->setVisible(false);
+        m_ui->fitQualityButton->setVisible(false);
     }
 
 #ifdef Q_OS_MAC
@@ -91,43 +91,55 @@ int ImageQualityDialog::getQuality(void) const
     return m_ui->spinBox->value();
 }
 
+size_t ImageQualityDialog::getTargetSize() const
+{
+    return size_t(m_ui->targetSizeSpinBox->value())*1024;
+}
+
+void ImageQualityDialog::setTargetSize(size_t bytes)
+{
+    m_ui->targetSizeSpinBox->setValue(int(bytes/1024));
+}
+
+pfs::Params ImageQualityDialog::getParams() const
+{
+    return pfs::Params("format", std::string(m_format.startsWith("jp") ? "jpg" : "png"))
+            ("quality", (size_t)getQuality());
+}
+
 void ImageQualityDialog::on_getSizeButton_clicked()
 {
-    pfs::Params params( "quality", (size_t)getQuality() );
+    if (!m_format.startsWith("jp") && !m_format.startsWith("png")) { return; }
 
+    // predicted from a sample of the rows: close enough to pick a quality,
+    // at a fraction of the cost of encoding the whole frame
     setCursor(QCursor(Qt::WaitCursor));
-    int size = 0;
-    if (m_format.startsWith("jp"))
-    {
-        pfs::io::JpegWriter writer;
-        writer.write(*m_frame, params);
-        size = writer.getFileSize();
-    }
-    else if (m_format.startsWith("png"))
-    {
-        pfs::io::PngWriter writer;
-        writer.write(*m_frame, params);
-        size = writer.getFileSize();
-    }
-    else { return; }
-//    else
-//    {
-//        QByteArray ba;
-//        QBuffer buffer(&ba);
-//        buffer.open(QIODevice::WriteOnly);
-//        m_image->save(&buffer, m_format.toLatin1().constData(), quality);
-//        size = ba.size();
-//    }
+    size_t size = pfs::io::estimateEncodedSize(*m_frame, getParams());
 
     QLocale def;
-    QString s = def.toString(size);
-    // the JPG on disk differs by 374 more bytes
-    // label_filesize->setText(QString::number( ba.size() ));
-    // the JPG on disk differs by 374 more bytes
-    m_ui->label_filesize->setText(s);
+    m_ui->label_filesize->setText(tr("about %1").arg(def.toString(qulonglong(size))));
     setCursor(QCursor(Qt::ArrowCursor));
 }
 
+void ImageQualityDialog::on_fitQualityButton_clicked()
+{
+    if (!m_format.startsWith("jp") && !m_format.startsWith("png")) { return; }
+    if (getTargetSize() == 0) { return; }
+
+    setCursor(QCursor(Qt::WaitCursor));
+    size_t quality = pfs::io::findQualityForSize(*m_frame, getParams(), getTargetSize());
+    setCursor(QCursor(Qt::ArrowCursor));
+
+    if (quality == 0)
+    {
+        m_ui->spinBox->setValue(1);
+        m_ui->label_filesize->setText(tr("Larger than the target"));
+        return;
+    }
+    m_ui->spinBox->setValue(int(quality));
+    on_getSizeButton_clicked();
+}
+
 void ImageQualityDialog::reset(int)
 {
     m_ui->label_filesize->setText(tr("Unknown"));
@@ -28,6 +28,7 @@
 #include <QScopedPointer>
 
 #include "Common/LuminanceOptions.h"
+#include "Libpfs/params.h"
 
 namespace Ui {
 class ImgQualityDialog;
@@ -47,11 +48,19 @@ public:
 
     int getQuality(void) const;
 
+    //! \brief size in bytes that the file must fit in, 0 for none: without a
+    //! frame, the quality is searched when the file is written
+    size_t getTargetSize() const;
+    void setTargetSize(size_t bytes);
+
 protected slots:
     void on_getSizeButton_clicked();
+    void on_fitQualityButton_clicked();
     void reset(int);
 
 protected:
+    pfs::Params getParams() const;
+
     const pfs::Frame* m_frame;
     QString m_format;
 
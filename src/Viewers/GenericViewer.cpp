@@ -31,24 +31,33 @@
 #include <QDebug>
 #include <QDrag>
 #include <QMimeData>
+#include <QMessageBox>
+#include <QFile>
 
 #include "Viewers/GenericViewer.h"
 #include "Viewers/PanIconWidget.h"
 #include "Viewers/IGraphicsView.h"
 #include "Viewers/IGraphicsPixmapItem.h"
 #include "Libpfs/frame.h"
+#include "Libpfs/compactframe.h"
+#include "Libpfs/spilledframe.h"
+#include "Libpfs/exception.h"
 
 namespace
 {
 // define the number of pixels to count as border of the image, because of the shadow
 static const int BORDER_SIZE = 30;
+// longest side of the pixmap kept by a viewer whose frame is on disk
+static const int THUMBNAIL_SIZE = 256;
 }
 
 GenericViewer::GenericViewer(pfs::Frame* frame, QWidget *parent, bool ns):
     QWidget(parent),
     mViewerMode(FIT_WINDOW),
     mNeedsSaving(ns),
-    mFrame(frame)
+    mFrame(frame),
+    mShowsThumbnail(false),
+    mReloadFailureQueued(false)
 {
     mVBL = new QVBoxLayout(this);
     mVBL->setSpacing(0);
@@ -107,6 +116,13 @@ void GenericViewer::changeEvent(QEvent *event)
     QWidget::changeEvent(event);
 }
 
+void GenericViewer::showEvent(QShowEvent *event)
+{
+    if (mShowsThumbnail)
+        restorePixmap();
+    QWidget::showEvent(event);
+}
+
 void GenericViewer::fitToWindow(bool /* checked */)
 {
     // DO NOT de-comment: this line is not an optimization, it's a nice way to stop everything working correctly!
@@ -371,6 +387,10 @@ int GenericViewer::getWidth()
 {
     if (mFrame)
         return mFrame->getWidth();
+    else if (mCompactFrame)
+        return mCompactFrame->getWidth();
+    else if (mSpilledFrame)
+        return mSpilledFrame->getWidth();
     else
         return 0;
 }
@@ -379,6 +399,10 @@ int GenericViewer::getHeight()
 {
     if (mFrame)
         return mFrame->getHeight();
+    else if (mCompactFrame)
+        return mCompactFrame->getHeight();
+    else if (mSpilledFrame)
+        return mSpilledFrame->getHeight();
     else
         return 0;
 }
@@ -386,6 +410,9 @@ int GenericViewer::getHeight()
 void GenericViewer::setFrame(pfs::Frame *new_frame, TonemappingOptions* tmopts)
 {
     mFrame.reset(new_frame);
+    mCompactFrame.reset();
+    mSpilledFrame.reset();
+    mShowsThumbnail = false;
 
     // call virtual protected function
     updatePixmap();
@@ -401,9 +428,107 @@ void GenericViewer::setFrame(pfs::Frame *new_frame, TonemappingOptions* tmopts)
 
 pfs::Frame* GenericViewer::getFrame() const
 {
+    if (mCompactFrame)
+    {
+        mFrame.reset(mCompactFrame->expand());
+        mCompactFrame.reset();
+        emit const_cast<GenericViewer*>(this)->frameExpanded(mFrame.get());
+    }
+    else if (mSpilledFrame)
+    {
+        try
+        {
+            mFrame.reset(mSpilledFrame->expand());
+            mSpilledFrame.reset();
+            emit const_cast<GenericViewer*>(this)->frameExpanded(mFrame.get());
+        }
+        catch (const pfs::Exception& e)
+        {
+            // the scratch file is kept: the next call tries again
+            qCritical() << "GenericViewer::getFrame():" << e.what();
+            if (!mReloadFailureQueued)
+            {
+                mReloadFailureQueued = true;
+                QMetaObject::invokeMethod(const_cast<GenericViewer*>(this), "reportReloadFailure",
+                                          Qt::QueuedConnection,
+                                          Q_ARG(QString, QString::fromLocal8Bit(e.what())));
+            }
+        }
+    }
     return mFrame.get();
 }
 
+void GenericViewer::reportReloadFailure(const QString& error)
+{
+    QMessageBox::warning(this, tr("Luminance HDR"),
+                         tr("The image of %1 cannot be read back from the temporary directory:\n%2")
+                         .arg(mFileName, error));
+    mReloadFailureQueued = false;
+}
+
+void GenericViewer::compactFrame()
+{
+    if (!mFrame) return;
+
+    mCompactFrame.reset(new pfs::CompactFrame(*mFrame));
+    mFrame.reset();
+}
+
+bool GenericViewer::isFrameCompacted() const
+{
+    return static_cast<bool>(mCompactFrame);
+}
+
+bool GenericViewer::spillFrame(const QString& directory)
+{
+    if (mSpilledFrame) return true;
+
+    const pfs::Frame* frame = getFrame();
+    if (!frame) return false;
+
+    try
+    {
+        mSpilledFrame.reset(new pfs::SpilledFrame(*frame, QFile::encodeName(directory).constData()));
+    }
+    catch (const pfs::Exception& e)
+    {
+        qWarning() << "GenericViewer::spillFrame():" << e.what();
+        return false;
+    }
+    mFrame.reset();
+
+    const QPixmap& pixmap = mPixmap->pixmap();
+    if (pixmap.width() > THUMBNAIL_SIZE || pixmap.height() > THUMBNAIL_SIZE)
+    {
+        mPixmap->setPixmap(pixmap.scaled(THUMBNAIL_SIZE, THUMBNAIL_SIZE,
+                                         Qt::KeepAspectRatio, Qt::SmoothTransformation));
+        mShowsThumbnail = true;
+    }
+    return true;
+}
+
+bool GenericViewer::isFrameSpilled() const
+{
+    return static_cast<bool>(mSpilledFrame);
+}
+
+void GenericViewer::restorePixmap()
+{
+    // the thumbnail stays until the frame can be read again
+    if (getFrame() == NULL) return;
+
+    // the scene shrinks with the thumbnail: keep the position of the view
+    const int h_value = mView->horizontalScrollBar()->value();
+    const int v_value = mView->verticalScrollBar()->value();
+
+    mShowsThumbnail = false;
+    updatePixmap();
+    mScene->setSceneRect(mPixmap->boundingRect());
+
+    mView->horizontalScrollBar()->setValue(h_value);
+    mView->verticalScrollBar()->setValue(v_value);
+}
+
 void GenericViewer::startDragging()
 {
     QDrag *drag = new QDrag(this);
@@ -40,6 +40,8 @@
 // Forward declaration
 namespace pfs {
 class Frame;                // #include "Libpfs/frame.h"
+class CompactFrame;         // #include "Libpfs/compactframe.h"
+class SpilledFrame;         // #include "Libpfs/spilledframe.h"
 }
 
 class PanIconWidget;        // #include "Common/PanIconWidget.h"
@@ -161,12 +163,36 @@ public Q_SLOTS:
     //! it would be better if the return pointer is const
     //! It requires to many changes at this stage and it does not worth the effort
     //! it will be done during the integration of LibHDR
+    //! \return NULL if the frame was spilled and cannot be read back: the
+    //! user is told, and the next call tries again
+    //! \note a compacted or spilled frame comes back at a new address, and
+    //! frameExpanded() is emitted
     pfs::Frame* getFrame() const;
 
     //! set a new reference frame to be shown in the viewport
     //! previous frame gets DELETED!
     void setFrame(pfs::Frame* new_frame, TonemappingOptions* tmopts = NULL);
 
+    //! \brief store the frame in half precision until getFrame() is called
+    //! again: the pixmap on screen is left untouched, so the viewer can still
+    //! be shown, scrolled and zoomed
+    //! \note the conversion is lossy for frames that are not half to begin with
+    //! \note every pointer to the frame is dangling until getFrame() is
+    //! called again
+    virtual void compactFrame();
+
+    //! \return true if the frame is currently stored in half precision
+    bool isFrameCompacted() const;
+
+    //! \brief move the frame to a scratch file in \a directory until
+    //! getFrame() is called again. Only a thumbnail of the pixmap stays in
+    //! memory: the full one is rendered again when the viewer is shown
+    //! \return false if the file cannot be written (the frame stays in memory)
+    bool spillFrame(const QString& directory);
+
+    //! \return true if the frame is currently stored on disk
+    bool isFrameSpilled() const;
+
 protected Q_SLOTS:
     /*virtual*/  void slotPanIconSelectionMoved(QRect);
     /*virtual*/  void slotPanIconHidden();
@@ -175,10 +201,14 @@ protected Q_SLOTS:
 
     void startDragging();
 
+private Q_SLOTS:
+    void reportReloadFailure(const QString& error);
+
 protected:
 
     virtual void retranslateUi();
     virtual void changeEvent(QEvent* event);
+    virtual void showEvent(QShowEvent* event);
 
     QToolBar* mToolBar;
     QToolButton* mCornerButton;
@@ -205,8 +235,17 @@ private:
     //! \return current zoom factor
     float getScaleFactor();
 
+    //! \brief replace the thumbnail left by spillFrame() with the full pixmap
+    void restorePixmap();
+
     bool mNeedsSaving;
-    std::unique_ptr<pfs::Frame> mFrame;
+    // getFrame() expands mCompactFrame and reads mSpilledFrame on demand
+    mutable std::unique_ptr<pfs::Frame> mFrame;
+    mutable std::unique_ptr<pfs::CompactFrame> mCompactFrame;
+    mutable std::unique_ptr<pfs::SpilledFrame> mSpilledFrame;
+    bool mShowsThumbnail;
+    // a failed reload of mSpilledFrame is reported once until acknowledged
+    mutable bool mReloadFailureQueued;
 
     QAction* m_actionClose;
 
@@ -219,6 +258,7 @@ Q_SIGNALS:
     void goNext(GenericViewer *v);      // shows next image in fullscreen
     void goPrevious(GenericViewer *v);  // shows previous image in fullscreen
     void syncViewers(GenericViewer *v); // toggle viewers syncronization
+    void frameExpanded(pfs::Frame* frame); // frame rebuilt by getFrame()
 };
 
 inline
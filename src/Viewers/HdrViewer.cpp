@@ -82,6 +82,8 @@ HdrViewer::HdrViewer(pfs::Frame* frame, QWidget *parent, bool ns)
 
     updateView();
     m_lumRange->blockSignals(false);
+
+    connect(this, SIGNAL(frameExpanded(pfs::Frame*)), this, SLOT(restoreHistogramImage(pfs::Frame*)));
 }
 
 void HdrViewer::initUi()
@@ -156,6 +158,18 @@ void HdrViewer::updatePixmap()
     m_lumRange->blockSignals(false);
 }
 
+void HdrViewer::compactFrame()
+{
+    m_lumRange->setHistogramImage(NULL);
+    GenericViewer::compactFrame();
+}
+
+void HdrViewer::restoreHistogramImage(pfs::Frame* frame)
+{
+    // same content as before compactFrame(): the range window is kept
+    m_lumRange->setHistogramImage(getPrimaryChannel(*frame));
+}
+
 LuminanceRangeWidget* HdrViewer::lumRange()
 {
     return m_lumRange;
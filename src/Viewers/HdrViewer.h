@@ -73,6 +73,9 @@ public:
 
     RGBMappingType getLuminanceMappingMethod();
 
+    //! \brief the histogram, that reads the frame, is dropped as well
+    void compactFrame();
+
 public Q_SLOTS:
     void updateRangeWindow();
     int getLumMappingMethod();
@@ -81,6 +84,9 @@ public Q_SLOTS:
 protected Q_SLOTS:
     virtual void updatePixmap();
 
+private Q_SLOTS:
+    void restoreHistogramImage(pfs::Frame* frame);
+
 protected:
     // Methods
     virtual void retranslateUi();
@@ -219,10 +219,13 @@ void LdrViewer::updatePixmap()
     qDebug() << "void LdrViewer::updatePixmap()";
 #endif
 
-    QScopedPointer<QImage> temp_qimage( fromLDRPFStoQImage(getFrame()));
+    const pfs::Frame* frame = getFrame();
+    if ( frame == NULL ) return;
+
+    QScopedPointer<QImage> temp_qimage( fromLDRPFStoQImage(frame));
 
     doCMSTransform(*temp_qimage, false, false);
-    mPixmap->setPixmap(QPixmap::fromImage(*temp_qimage));
+    setQImage(*temp_qimage);
 
     parseOptions(mTonemappingOptions, caption);
     informativeLabel->setText( tr("LDR image [%1 x %2]: %3").arg(getWidth()).arg(getHeight()).arg( caption ));
@@ -257,7 +260,10 @@ float LdrViewer::getMinLuminanceValue()
 
 void LdrViewer::doSoftProofing(bool doGamutCheck)
 {
-    QScopedPointer<QImage> src_image( fromLDRPFStoQImage(getFrame()) );
+    const pfs::Frame* frame = getFrame();
+    if ( frame == NULL ) return;
+
+    QScopedPointer<QImage> src_image( fromLDRPFStoQImage(frame) );
     if ( doCMSTransform(*src_image, true, doGamutCheck) )
     {
         mPixmap->setPixmap(QPixmap::fromImage(*src_image));
@@ -266,7 +272,10 @@ void LdrViewer::doSoftProofing(bool doGamutCheck)
 
 void LdrViewer::undoSoftProofing()
 {
-    QScopedPointer<QImage> src_image( fromLDRPFStoQImage(getFrame()) );
+    const pfs::Frame* frame = getFrame();
+    if ( frame == NULL ) return;
+
+    QScopedPointer<QImage> src_image( fromLDRPFStoQImage(frame) );
     if ( doCMSTransform(*src_image, false, false) )
     {
         mPixmap->setPixmap(QPixmap::fromImage(*src_image));
@@ -0,0 +1,127 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+// Timing of the half float conversions behind CompactFrame: every level of
+// the dispatched kernels on one thread, then the multithreaded calls and a
+// whole frame. Not a test: run it by hand, optionally with the size of the
+// frame in megapixels (default 12)
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include <Libpfs/frame.h>
+#include <Libpfs/compactframe.h>
+#include <Libpfs/utils/half.h>
+#include <Libpfs/utils/kernels.h>
+#include <Libpfs/utils/msec_timer.h>
+
+using namespace pfs;
+using namespace pfs::utils;
+
+namespace
+{
+const int NUM_RUNS = 5;
+
+//! \brief best time of NUM_RUNS calls of \a op, in msec
+template <typename Op>
+double bestTime(const Op& op)
+{
+    double best = 0.;
+    for (int run = 0; run < NUM_RUNS; ++run)
+    {
+        msec_timer timer;
+        timer.start();
+        op();
+        timer.stop_and_update();
+        if ( run == 0 || timer.get_time() < best ) best = timer.get_time();
+    }
+    return best;
+}
+
+void report(const char* name, size_t samples, double msec)
+{
+    std::cout << std::setw(24) << std::left << name
+              << std::setw(10) << std::right << std::fixed << std::setprecision(2) << msec
+              << " msec " << std::setw(10) << samples/(msec*1e3) << " Msamples/s"
+              << std::endl;
+}
+}
+
+int main(int argc, char** argv)
+{
+    const double megapixels = (argc > 1) ? std::atof(argv[1]) : 12.;
+    const size_t width = static_cast<size_t>(std::sqrt(megapixels*1e6*1.5));
+    const size_t height = static_cast<size_t>(megapixels*1e6/width);
+    const size_t samples = width*height;
+
+    std::vector<float> in(samples);
+    for (size_t idx = 0; idx < samples; ++idx)
+    {
+        // a few decades of luminance, as in an HDR
+        in[idx] = std::pow(10.f, static_cast<float>(idx % 4093)/1023.f - 2.f);
+    }
+    std::vector<uint16_t> half(samples);
+    std::vector<float> out(samples);
+
+    std::cout << width << "x" << height << " samples, processor level "
+              << cpuLevelName(detectCpuLevel()) << std::endl;
+
+    const CpuLevel levels[] = { CPU_GENERIC, CPU_SSE2, CPU_AVX2, CPU_AVX512 };
+    for (size_t l = 0; l < sizeof(levels)/sizeof(levels[0]); ++l)
+    {
+        const Kernels* k = kernels(levels[l]);
+        if ( k == NULL ) continue;
+
+        std::cout << cpuLevelName(levels[l]) << ", one thread" << std::endl;
+        report("  floatToHalf", samples, bestTime([&]()
+        { k->floatToHalf(in.data(), half.data(), samples); }));
+        report("  halfToFloat", samples, bestTime([&]()
+        { k->halfToFloat(half.data(), out.data(), samples); }));
+    }
+
+    std::cout << "dispatched (" << cpuLevelName(kernels().level) << "), all threads" << std::endl;
+    report("  floatToHalf", samples, bestTime([&]()
+    { floatToHalf(in.data(), half.data(), samples); }));
+    report("  halfToFloat", samples, bestTime([&]()
+    { halfToFloat(half.data(), out.data(), samples); }));
+
+    Frame frame(width, height);
+    Channel* X;
+    Channel* Y;
+    Channel* Z;
+    frame.createXYZChannels(X, Y, Z);
+    std::copy(in.begin(), in.end(), X->begin());
+    std::copy(in.begin(), in.end(), Y->begin());
+    std::copy(in.begin(), in.end(), Z->begin());
+
+    std::unique_ptr<CompactFrame> compact;
+    std::cout << "frame, all threads" << std::endl;
+    report("  CompactFrame()", 3*samples, bestTime([&]()
+    { compact.reset(new CompactFrame(frame)); }));
+    report("  CompactFrame::expand()", 3*samples, bestTime([&]()
+    { std::unique_ptr<Frame> expanded(compact->expand()); }));
+
+    return 0;
+}
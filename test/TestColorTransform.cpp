@@ -0,0 +1,136 @@
+/*
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+#include <Libpfs/array2d.h>
+#include <Libpfs/exception.h>
+#include <Libpfs/colorspace/colorspace.h>
+#include <Libpfs/colorspace/colortransform.h>
+#include <Libpfs/colorspace/rgb.h>
+#include <Libpfs/colorspace/xyz.h>
+
+using namespace pfs;
+using namespace pfs::colorspace;
+
+namespace
+{
+void fillPlanes(Array2Df& C1, Array2Df& C2, Array2Df& C3)
+{
+    for (size_t idx = 0; idx < C1.size(); ++idx)
+    {
+        C1(idx) = 0.05f + static_cast<float>(idx % 97)/48.f;
+        C2(idx) = 0.05f + static_cast<float>(idx % 61)/60.f;
+        C3(idx) = 0.05f + static_cast<float>(idx % 13)/24.f;
+    }
+}
+}
+
+TEST(TestColorTransform, SRGBCurvesMatchPow)
+{
+    for (int idx = -1000; idx <= 3000; ++idx)
+    {
+        const float sample = static_cast<float>(idx)/2000.f;
+
+        EXPECT_NEAR(detail::srgb2rgb(sample), ConvertSRGB2RGB()(sample), 1e-6f);
+        EXPECT_NEAR(detail::rgb2srgb(sample), ConvertRGB2SRGB()(sample), 1e-6f);
+    }
+}
+
+TEST(TestColorTransform, MatrixMatchesFunctor)
+{
+    // odd size, so the vectorised kernel leaves a tail
+    Array2Df R(37, 3), G(37, 3), B(37, 3);
+    fillPlanes(R, G, B);
+    Array2Df X(37, 3), Y(37, 3), Z(37, 3);
+
+    ColorTransform::between(CS_RGB, CS_XYZ).apply(&R, &G, &B, &X, &Y, &Z);
+
+    for (size_t idx = 0; idx < R.size(); ++idx)
+    {
+        float x, y, z;
+        ConvertRGB2XYZ()(R(idx), G(idx), B(idx), x, y, z);
+        ASSERT_NEAR(x, X(idx), 1e-5f);
+        ASSERT_NEAR(y, Y(idx), 1e-5f);
+        ASSERT_NEAR(z, Z(idx), 1e-5f);
+    }
+
+    // in place, and back
+    ColorTransform::between(CS_XYZ, CS_RGB).apply(&X, &Y, &Z, &X, &Y, &Z);
+    for (size_t idx = 0; idx < R.size(); ++idx)
+    {
+        ASSERT_NEAR(R(idx), X(idx), 1e-5f);
+        ASSERT_NEAR(G(idx), Y(idx), 1e-5f);
+        ASSERT_NEAR(B(idx), Z(idx), 1e-5f);
+    }
+}
+
+TEST(TestColorTransform, FusedMatchesChained)
+{
+    Array2Df R(29, 5), G(29, 5), B(29, 5);
+    fillPlanes(R, G, B);
+
+    // RGB -> XYZ -> Yxy, in two passes
+    Array2Df C1(29, 5), C2(29, 5), C3(29, 5);
+    transformColorSpace(CS_RGB, &R, &G, &B, CS_XYZ, &C1, &C2, &C3);
+    transformColorSpace(CS_XYZ, &C1, &C2, &C3, CS_Yxy, &C1, &C2, &C3);
+
+    // ... and in one
+    Array2Df F1(29, 5), F2(29, 5), F3(29, 5);
+    ColorTransform fused = ColorTransform::between(CS_RGB, CS_XYZ)
+            .then(ColorTransform::between(CS_XYZ, CS_Yxy));
+    fused.apply(&R, &G, &B, &F1, &F2, &F3);
+
+    // sRGB -> Yxy -> RGB cancels the Yxy curves: one matrix and no encoding
+    ColorTransform roundTrip = ColorTransform::between(CS_SRGB, CS_Yxy)
+            .then(ColorTransform::between(CS_Yxy, CS_SRGB));
+    Array2Df S1(29, 5), S2(29, 5), S3(29, 5);
+    roundTrip.apply(&R, &G, &B, &S1, &S2, &S3);
+
+    for (size_t idx = 0; idx < R.size(); ++idx)
+    {
+        ASSERT_NEAR(C1(idx), F1(idx), 1e-5f);
+        ASSERT_NEAR(C2(idx), F2(idx), 1e-5f);
+        ASSERT_NEAR(C3(idx), F3(idx), 1e-5f);
+
+        ASSERT_NEAR(R(idx), S1(idx), 1e-4f);
+        ASSERT_NEAR(G(idx), S2(idx), 1e-4f);
+        ASSERT_NEAR(B(idx), S3(idx), 1e-4f);
+    }
+
+    // RGB -> Yxy is the same single pass
+    transformColorSpace(CS_RGB, &R, &G, &B, CS_Yxy, &C1, &C2, &C3);
+    for (size_t idx = 0; idx < R.size(); ++idx)
+    {
+        ASSERT_NEAR(C2(idx), F2(idx), 1e-5f);
+        ASSERT_NEAR(C3(idx), F3(idx), 1e-5f);
+    }
+}
+
+TEST(TestColorTransform, CurvesMustMatch)
+{
+    // the sRGB encoding is not undone by a conversion from XYZ
+    EXPECT_THROW(ColorTransform::between(CS_XYZ, CS_SRGB)
+                 .then(ColorTransform::between(CS_XYZ, CS_RGB)),
+                 pfs::Exception);
+}
@@ -0,0 +1,165 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <gtest/gtest.h>
+
+#include <QImage>
+#include <cstdlib>
+
+#include <Libpfs/array2d.h>
+#include <HdrWizard/AutoAntighosting.h>
+
+namespace
+{
+void fillRandom(Array2Df& plane, unsigned int seed)
+{
+    srand(seed);
+    for (size_t idx = 0; idx < plane.size(); ++idx)
+    {
+        // a few zeros exercise the floor of the log irradiance
+        plane(idx) = (rand() % 11 == 0) ? 0.f : static_cast<float>(rand())/RAND_MAX;
+    }
+}
+
+// the chain of full size planes used by HdrCreationManager so far
+template <typename Mask>
+void referenceDivergence(Array2Df& divergence,
+                         const Array2Df& good, const Array2Df& current,
+                         const Mask& blend)
+{
+    const int width = current.getCols();
+    const int height = current.getRows();
+
+    Array2Df logGood(width, height), logCurrent(width, height);
+    Array2Df gradientXGood(width, height), gradientYGood(width, height);
+    Array2Df gradientX(width, height), gradientY(width, height);
+    Array2Df gradientXBlended(width, height), gradientYBlended(width, height);
+
+    computeLogIrradiance(logGood, good);
+    computeLogIrradiance(logCurrent, current);
+    computeGradient(gradientXGood, gradientYGood, logGood);
+    computeGradient(gradientX, gradientY, logCurrent);
+    blend(gradientXBlended, gradientYBlended,
+          gradientX, gradientY, gradientXGood, gradientYGood);
+    computeDivergence(divergence, gradientXBlended, gradientYBlended);
+}
+
+struct PatchBlend
+{
+    bool (*patches)[agGridSize];
+    int gridX;
+    int gridY;
+
+    void operator()(Array2Df& bx, Array2Df& by,
+                    const Array2Df& gx, const Array2Df& gy,
+                    const Array2Df& gxGood, const Array2Df& gyGood) const
+    { blendGradients(bx, by, gx, gy, gxGood, gyGood, patches, gridX, gridY); }
+};
+
+struct MaskBlend
+{
+    const QImage* mask;
+
+    void operator()(Array2Df& bx, Array2Df& by,
+                    const Array2Df& gx, const Array2Df& gy,
+                    const Array2Df& gxGood, const Array2Df& gyGood) const
+    { blendGradients(bx, by, gx, gy, gxGood, gyGood, *mask); }
+};
+}
+
+TEST(TestDeghosting, FusedMatchesPatches)
+{
+    const int width = 6*agGridSize;
+    const int height = 4*agGridSize;
+
+    Array2Df good(width, height);
+    Array2Df current(width, height);
+    fillRandom(good, 1);
+    fillRandom(current, 2);
+
+    // the last row and column of patches stay off: the reference reads
+    // outside the image on their seams
+    bool patches[agGridSize][agGridSize];
+    srand(3);
+    for (int x = 0; x < agGridSize; ++x)
+        for (int y = 0; y < agGridSize; ++y)
+            patches[x][y] = (x < agGridSize - 1) && (y < agGridSize - 1) && (rand() % 2);
+
+    Array2Df reference(width, height);
+    PatchBlend blend = { patches, width/agGridSize, height/agGridSize };
+    referenceDivergence(reference, good, current, blend);
+
+    // in place, like HdrCreationManager::doAntiGhosting
+    Array2Df fused(current);
+    computeBlendedDivergence(fused, good, fused, patches,
+                             width/agGridSize, height/agGridSize);
+
+    for (size_t idx = 0; idx < fused.size(); ++idx)
+    {
+        ASSERT_FLOAT_EQ(reference(idx), fused(idx)) << "at " << idx;
+    }
+}
+
+TEST(TestDeghosting, FusedMatchesMask)
+{
+    const int width = 97;
+    const int height = 53;
+
+    Array2Df good(width, height);
+    Array2Df current(width, height);
+    fillRandom(good, 4);
+    fillRandom(current, 5);
+
+    QImage mask(width, height, QImage::Format_ARGB32);
+    srand(6);
+    for (int j = 0; j < height; ++j)
+        for (int i = 0; i < width; ++i)
+            mask.setPixel(i, j, (rand() % 2) ? qRgba(255, 0, 0, 255) : qRgba(0, 0, 0, 0));
+
+    Array2Df reference(width, height);
+    MaskBlend blend = { &mask };
+    referenceDivergence(reference, good, current, blend);
+
+    Array2Df fused(width, height);
+    computeBlendedDivergence(fused, good, current, mask);
+
+    for (size_t idx = 0; idx < fused.size(); ++idx)
+    {
+        ASSERT_FLOAT_EQ(reference(idx), fused(idx)) << "at " << idx;
+    }
+}
+
+TEST(TestDeghosting, SharedSpectrum)
+{
+    Array2Df divergence(64, 48);
+    fillRandom(divergence, 7);
+
+    Array2Df U1(64, 48);
+    solve_pde_dct(divergence, U1);
+
+    Array2Df U2(64, 48);
+    Array2Df spectrum(64, 48);
+    solve_pde_dct(divergence, U2, spectrum);
+
+    for (size_t idx = 0; idx < U1.size(); ++idx)
+    {
+        ASSERT_FLOAT_EQ(U1(idx), U2(idx));
+    }
+}
@@ -0,0 +1,185 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include <unistd.h>
+
+#include <Libpfs/frame.h>
+#include <Libpfs/io/exrreader.h>
+#include <Libpfs/io/exrwriter.h>
+
+using namespace pfs;
+using namespace pfs::io;
+
+namespace
+{
+class TestEXRLevels : public ::testing::Test
+{
+protected:
+    void SetUp()
+    {
+        const char* tmp = std::getenv("TMPDIR");
+        std::ostringstream name;
+        name << (tmp ? tmp : "/tmp") << "/luminance_exrlevels_XXXXXX";
+        std::string filename = name.str();
+        const int fd = mkstemp(&filename[0]);
+        ASSERT_NE(-1, fd);
+        close(fd);
+        m_filename = filename + ".exr";
+        std::rename(filename.c_str(), m_filename.c_str());
+    }
+
+    void TearDown()
+    {
+        std::remove(m_filename.c_str());
+    }
+
+    std::string m_filename;
+};
+
+//! \brief every 2x2 block has the average of its top left sample
+Frame* makeFrame(size_t width, size_t height)
+{
+    Frame* frame = new Frame(width, height);
+    Channel* X;
+    Channel* Y;
+    Channel* Z;
+    frame->createXYZChannels(X, Y, Z);
+    for (size_t y = 0; y < height; ++y)
+    {
+        for (size_t x = 0; x < width; ++x)
+        {
+            const float v = float(x/2 + 100*(y/2));
+            (*X)(x, y) = v;
+            (*Y)(x, y) = 2.f*v;
+            (*Z)(x, y) = 1.f;
+        }
+    }
+    return frame;
+}
+}
+
+TEST_F(TestEXRLevels, ScanlineRegion)
+{
+    std::unique_ptr<Frame> frame(makeFrame(100, 60));
+    EXRWriter(m_filename).write(*frame, Params());
+
+    EXRReader reader(m_filename);
+    Frame region;
+    reader.read(region, Params("exr_region_x", size_t(10))
+                              ("exr_region_y", size_t(20))
+                              ("exr_region_width", size_t(30))
+                              ("exr_region_height", size_t(7)));
+    ASSERT_EQ(30u, region.getWidth());
+    ASSERT_EQ(7u, region.getHeight());
+    for (size_t y = 0; y < region.getHeight(); ++y)
+    {
+        for (size_t x = 0; x < region.getWidth(); ++x)
+        {
+            ASSERT_EQ((*frame->getChannel("X"))(x + 10, y + 20),
+                      (*region.getChannel("X"))(x, y));
+        }
+    }
+}
+
+TEST_F(TestEXRLevels, MipmapLevels)
+{
+    std::unique_ptr<Frame> frame(makeFrame(256, 130));
+    EXRWriter(m_filename).write(*frame, Params("exr_tiles", std::string("mipmap"))
+                                                ("exr_tile_size", 32));
+
+    EXRReader reader(m_filename);
+    EXPECT_EQ(256u, reader.width());
+    EXPECT_EQ(130u, reader.height());
+
+    Frame full;
+    reader.read(full, Params());
+    ASSERT_EQ(256u, full.getWidth());
+    ASSERT_EQ(130u, full.getHeight());
+    for (size_t idx = 0; idx < full.size(); ++idx)
+    {
+        ASSERT_EQ((*frame->getChannel("Y"))(idx), (*full.getChannel("Y"))(idx));
+    }
+
+    Frame level;
+    reader.read(level, Params("exr_level", 1));
+    ASSERT_EQ(128u, level.getWidth());
+    ASSERT_EQ(65u, level.getHeight());
+    for (size_t y = 0; y < level.getHeight(); ++y)
+    {
+        for (size_t x = 0; x < level.getWidth(); ++x)
+        {
+            ASSERT_FLOAT_EQ((*frame->getChannel("Y"))(2*x, 2*y),
+                            (*level.getChannel("Y"))(x, y));
+        }
+    }
+
+    // the smallest level at least 60 pixels wide is 64 x 32
+    reader.read(level, Params("exr_min_width", size_t(60)));
+    EXPECT_EQ(64u, level.getWidth());
+    EXPECT_EQ(32u, level.getHeight());
+    EXPECT_FLOAT_EQ(1.f, (*level.getChannel("Z"))(10, 10));
+
+    // region of a level, across tiles
+    Frame region;
+    reader.read(region, Params("exr_level", 1)
+                              ("exr_region_x", size_t(20))
+                              ("exr_region_y", size_t(30))
+                              ("exr_region_width", size_t(40))
+                              ("exr_region_height", size_t(5)));
+    ASSERT_EQ(40u, region.getWidth());
+    ASSERT_EQ(5u, region.getHeight());
+    EXPECT_FLOAT_EQ((*frame->getChannel("X"))(40, 60), (*region.getChannel("X"))(0, 0));
+    EXPECT_FLOAT_EQ((*frame->getChannel("X"))(2*59, 2*34), (*region.getChannel("X"))(39, 4));
+}
+
+TEST_F(TestEXRLevels, RipmapLevels)
+{
+    std::unique_ptr<Frame> frame(makeFrame(64, 64));
+    EXRWriter(m_filename).write(*frame, Params("exr_tiles", std::string("ripmap")));
+
+    // a wide output needs a tall enough level too
+    EXRReader reader(m_filename);
+    Frame level;
+    reader.read(level, Params("exr_min_width", size_t(16)));
+    EXPECT_EQ(16u, level.getWidth());
+    EXPECT_EQ(16u, level.getHeight());
+    // average of the 4x4 block at (8, 12)
+    EXPECT_FLOAT_EQ(4.5f + 100.f*6.5f, (*level.getChannel("X"))(2, 3));
+}
+
+TEST_F(TestEXRLevels, InvalidParams)
+{
+    std::unique_ptr<Frame> frame(makeFrame(16, 16));
+    EXPECT_THROW(EXRWriter(m_filename).write(*frame, Params("exr_tiles", std::string("sometimes"))),
+                 pfs::io::WriteException);
+
+    EXRWriter(m_filename).write(*frame, Params());
+    Frame region;
+    EXPECT_THROW(EXRReader(m_filename).read(region, Params("exr_region_x", size_t(16))),
+                 pfs::io::ReadException);
+}
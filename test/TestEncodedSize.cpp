@@ -0,0 +1,116 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <memory>
+#include <string>
+
+#include <Libpfs/frame.h>
+#include <Libpfs/io/encodedsize.h>
+#include <Libpfs/io/jpegwriter.h>
+#include <Libpfs/io/pngwriter.h>
+
+using namespace pfs;
+
+namespace
+{
+//! \brief smooth gradients with some texture, like a photograph
+Frame* makeFrame(size_t width, size_t height)
+{
+    Frame* frame = new Frame(width, height);
+    Channel* X;
+    Channel* Y;
+    Channel* Z;
+    frame->createXYZChannels(X, Y, Z);
+
+    unsigned state = 12345;
+    for (size_t y = 0; y < height; ++y)
+    {
+        for (size_t x = 0; x < width; ++x)
+        {
+            state = state*1103515245u + 12345u;
+            const float noise = 0.05f*((state >> 16) & 0xff)/255.f;
+            const float v = 0.5f + 0.4f*std::sin(x*0.03f)*std::cos(y*0.011f);
+            (*X)(x, y) = v + noise;
+            (*Y)(x, y) = 0.9f*v + noise;
+            (*Z)(x, y) = float(y)/height;
+        }
+    }
+    return frame;
+}
+
+Params jpegParams(size_t quality)
+{
+    return Params("format", std::string("jpg"))("quality", quality);
+}
+}
+
+TEST(TestEncodedSize, MatchesWriter)
+{
+    std::unique_ptr<Frame> frame(makeFrame(64, 48));
+
+    io::JpegWriter writer;
+    writer.write(*frame, jpegParams(75));
+    EXPECT_EQ(writer.getFileSize(), io::encodedSize(*frame, jpegParams(75)));
+
+    // encoded whole
+    EXPECT_EQ(writer.getFileSize(), io::estimateEncodedSize(*frame, jpegParams(75)));
+
+    const Params pngParams("format", std::string("png"));
+    io::PngWriter pngWriter;
+    pngWriter.write(*frame, pngParams);
+    EXPECT_GT(pngWriter.getFileSize(), 0u);
+    EXPECT_EQ(pngWriter.getFileSize(), io::encodedSize(*frame, pngParams));
+
+    EXPECT_THROW(io::encodedSize(*frame, Params("format", std::string("tiff"))),
+                 io::UnsupportedFormat);
+}
+
+TEST(TestEncodedSize, Estimate)
+{
+    std::unique_ptr<Frame> frame(makeFrame(256, 1600));
+
+    for (size_t quality = 20; quality <= 100; quality += 40)
+    {
+        const double exact = io::encodedSize(*frame, jpegParams(quality));
+        const double estimated = io::estimateEncodedSize(*frame, jpegParams(quality));
+        EXPECT_NEAR(1.0, estimated/exact, 0.1) << "quality " << quality;
+    }
+}
+
+TEST(TestEncodedSize, FindQuality)
+{
+    std::unique_ptr<Frame> frame(makeFrame(256, 1200));
+    const Params params("format", std::string("jpg"));
+
+    const size_t target = io::encodedSize(*frame, jpegParams(80));
+    const size_t quality = io::findQualityForSize(*frame, params, target);
+    ASSERT_GE(quality, 80u);
+    EXPECT_LE(io::encodedSize(*frame, jpegParams(quality)), target);
+    if ( quality < 100 )
+    {
+        EXPECT_GT(io::encodedSize(*frame, jpegParams(quality + 1)), target);
+    }
+
+    EXPECT_EQ(100u, io::findQualityForSize(*frame, params, 1 << 30));
+    EXPECT_EQ(0u, io::findQualityForSize(*frame, params, 10));
+}
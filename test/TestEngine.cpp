@@ -0,0 +1,148 @@
+/*
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include <Libpfs/frame.h>
+#include <Libpfs/channel.h>
+#include <Libpfs/progress.h>
+#include <Libpfs/tm/TonemapOperator.h>
+#include <HdrCreation/fusionoperator.h>
+#include <Engine/engine.h>
+
+using namespace pfs;
+using namespace libhdr::fusion;
+
+namespace
+{
+// linear radiance of a smooth ramp, exposed at 2^ev
+FramePtr exposedFrame(size_t width, size_t height, float ev)
+{
+    FramePtr frame = std::make_shared<Frame>(width, height);
+    Channel* R;
+    Channel* G;
+    Channel* B;
+    frame->createXYZChannels(R, G, B);
+
+    const float scale = std::pow(2.f, ev);
+    for (size_t idx = 0; idx < frame->size(); ++idx)
+    {
+        const float radiance = 0.01f + 0.5f*static_cast<float>(idx)/frame->size();
+        (*R)(idx) = std::min(1.f, radiance*scale);
+        (*G)(idx) = std::min(1.f, 0.8f*radiance*scale);
+        (*B)(idx) = std::min(1.f, 0.6f*radiance*scale);
+    }
+    return frame;
+}
+
+void expectSameChannels(const Frame& expected, const Frame& actual)
+{
+    ASSERT_EQ(expected.getWidth(), actual.getWidth());
+    ASSERT_EQ(expected.getHeight(), actual.getHeight());
+
+    const Channel* eX;
+    const Channel* eY;
+    const Channel* eZ;
+    expected.getXYZChannels(eX, eY, eZ);
+    const Channel* aX;
+    const Channel* aY;
+    const Channel* aZ;
+    actual.getXYZChannels(aX, aY, aZ);
+
+    for (size_t idx = 0; idx < expected.size(); ++idx)
+    {
+        ASSERT_FLOAT_EQ((*eX)(idx), (*aX)(idx));
+        ASSERT_FLOAT_EQ((*eY)(idx), (*aY)(idx));
+        ASSERT_FLOAT_EQ((*eZ)(idx), (*aZ)(idx));
+    }
+}
+}
+
+TEST(TestEngine, PfsRoundTrip)
+{
+    FramePtr frame = exposedFrame(17, 9, 0.f);
+
+    luminance::writeFrame(*frame, "TestEngine.pfs");
+    FramePtr read = luminance::readFrame("TestEngine.pfs");
+
+    expectSameChannels(*frame, *read);
+}
+
+TEST(TestEngine, FuseMatchesFusionOperator)
+{
+    std::vector<luminance::Exposure> exposures;
+    exposures.push_back(luminance::Exposure(exposedFrame(32, 24, -1.f), 5.f));
+    exposures.push_back(luminance::Exposure(exposedFrame(32, 24, 0.f), 6.f));
+    exposures.push_back(luminance::Exposure(exposedFrame(32, 24, 1.f), 7.f));
+
+    FusionOperatorConfig config;
+    config.weightFunction = WEIGHT_TRIANGULAR;
+    config.responseCurve = RESPONSE_LINEAR;
+    config.fusionOperator = DEBEVEC;
+
+    FramePtr hdr = luminance::fuse(exposures, config);
+
+    // the reference exposure is the median one
+    std::vector<FrameEnhanced> frames;
+    frames.push_back(FrameEnhanced(exposures[0].frame, 0.5f));
+    frames.push_back(FrameEnhanced(exposures[1].frame, 1.f));
+    frames.push_back(FrameEnhanced(exposures[2].frame, 2.f));
+    ResponseCurve response(RESPONSE_LINEAR);
+    WeightFunction weight(WEIGHT_TRIANGULAR);
+    FramePtr reference(IFusionOperator::build(DEBEVEC)->computeFusion(response, weight, frames));
+
+    expectSameChannels(*reference, *hdr);
+}
+
+TEST(TestEngine, FuseNeedsFrames)
+{
+    FusionOperatorConfig config;
+    config.weightFunction = WEIGHT_TRIANGULAR;
+    config.responseCurve = RESPONSE_LINEAR;
+    config.fusionOperator = DEBEVEC;
+
+    EXPECT_THROW(luminance::fuse(std::vector<luminance::Exposure>(), config),
+                 std::runtime_error);
+}
+
+TEST(TestEngine, TonemapKeepsInput)
+{
+    FramePtr hdr = exposedFrame(40, 30, 2.f);
+    FramePtr original = exposedFrame(40, 30, 2.f);
+
+    TonemappingParameters params;
+    params.tmoperator = drago;
+
+    FramePtr ldr = luminance::tonemap(*hdr, params);
+    expectSameChannels(*original, *hdr);
+
+    // same result of the operator, working in place on a copy
+    Progress progress;
+    std::unique_ptr<TonemapOperator> tmo(TonemapOperator::getTonemapOperator(drago));
+    tmo->tonemapFrame(*original, &params, progress);
+
+    expectSameChannels(*original, *ldr);
+}
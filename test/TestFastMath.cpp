@@ -0,0 +1,124 @@
+/*
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+#include <Libpfs/utils/fastmath.h>
+
+using namespace pfs::utils;
+
+namespace
+{
+//! \brief positive samples over many octaves
+std::vector<float> samples()
+{
+    std::vector<float> values;
+    for (float v = 1e-6f; v < 1e6f; v *= 1.0137f)
+    {
+        values.push_back(v);
+    }
+    return values;
+}
+}
+
+TEST(TestFastMath, LogTier)
+{
+    const std::vector<float> values = samples();
+    for (size_t idx = 0; idx < values.size(); ++idx)
+    {
+        const float v = values[idx];
+        ASSERT_NEAR(std::log(v)/std::log(2.f), fastmath::log2(v), 2e-6f) << v;
+        ASSERT_NEAR(std::log(v), fastmath::log(v), 2e-6f) << v;
+        ASSERT_NEAR(std::log10(v), fastmath::log10(v), 2e-6f) << v;
+    }
+    EXPECT_EQ(0.f, fastmath::log2(1.f));
+}
+
+TEST(TestFastMath, ExpTier)
+{
+    for (float x = -80.f; x < 80.f; x += 0.0173f)
+    {
+        const float expected = std::exp(x);
+        ASSERT_NEAR(1.f, fastmath::exp(x)/expected, 1e-5f) << x;
+    }
+    for (float x = -30.f; x < 30.f; x += 0.0071f)
+    {
+        ASSERT_NEAR(1.f, fastmath::exp10(x)/std::pow(10.f, x), 2e-5f) << x;
+    }
+    for (float x = -20.f; x < 20.f; x += 0.0013f)
+    {
+        ASSERT_NEAR(1.f, fastmath::exp2(x)/std::pow(2.f, x), 3e-7f) << x;
+    }
+    EXPECT_FLOAT_EQ(1.f, fastmath::exp2(0.f));
+    EXPECT_FLOAT_EQ(0.25f, fastmath::exp2(-2.f));
+}
+
+TEST(TestFastMath, PowAndLog1p)
+{
+    const std::vector<float> values = samples();
+    for (size_t idx = 0; idx < values.size(); ++idx)
+    {
+        const float v = values[idx];
+        ASSERT_NEAR(1.f, fastmath::pow(v, 0.4167f)/std::pow(v, 0.4167f), 2e-5f) << v;
+        ASSERT_NEAR(1.f, fastmath::pow(v, -1.3f)/std::pow(v, -1.3f), 5e-5f) << v;
+        ASSERT_NEAR(1.f, fastmath::log1p(v)/std::log1p(v), 5e-7f) << v;
+        ASSERT_NEAR(1.f, fastmath::log1p(-v/(1.f + v))/std::log1p(-v/(1.f + v)), 5e-7f) << v;
+    }
+    EXPECT_EQ(0.f, fastmath::pow(0.f, 2.f));
+}
+
+TEST(TestFastMath, VectorMatchesScalar)
+{
+    // odd size, so the vector kernels leave a tail
+    const std::vector<float> values = samples();
+    std::vector<float> out(values.size());
+
+    vlog(values.data(), out.data(), values.size(), MATH_FAST);
+    for (size_t idx = 0; idx < values.size(); ++idx)
+        ASSERT_NEAR(fastmath::log(values[idx]), out[idx], 2e-6f);
+
+    vlog10(values.data(), out.data(), values.size(), MATH_ACCURATE);
+    for (size_t idx = 0; idx < values.size(); ++idx)
+        ASSERT_FLOAT_EQ(std::log10(values[idx]), out[idx]);
+
+    vpow(values.data(), 0.7f, out.data(), values.size(), MATH_FAST);
+    for (size_t idx = 0; idx < values.size(); ++idx)
+        ASSERT_NEAR(1.f, out[idx]/fastmath::pow(values[idx], 0.7f), 5e-6f);
+
+    // in place
+    std::vector<float> logs(values.size());
+    vlog10(values.data(), logs.data(), values.size(), MATH_FAST);
+    vexp10(logs.data(), logs.data(), logs.size(), MATH_FAST);
+    for (size_t idx = 0; idx < values.size(); ++idx)
+        ASSERT_NEAR(1.f, logs[idx]/values[idx], 5e-5f);
+}
+
+TEST(TestFastMath, ScopedPrecision)
+{
+    EXPECT_EQ(MATH_ACCURATE, mathPrecision());
+    {
+        ScopedMathPrecision fast(MATH_FAST);
+        EXPECT_EQ(MATH_FAST, mathPrecision());
+    }
+    EXPECT_EQ(MATH_ACCURATE, mathPrecision());
+}
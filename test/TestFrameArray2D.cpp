@@ -23,6 +23,7 @@
 
 #include <Libpfs/array2d.h>
 #include <Libpfs/frame.h>
+#include <Libpfs/utils/numa.h>
 
 #include "SeqInt.h"
 #include "CompareVector.h"
@@ -126,3 +127,46 @@ TEST(TestArray2D, Ctor)
         compareVectors(array2d_v2.data(), array2d_2.data(), array2d.size());
     }
 }
+
+TEST(TestArray2D, ZeroedInParallel)
+{
+    // large enough to be mapped from the system, and split among the threads
+    Array2Df array(1200, 900);
+    for (size_t idx = 0; idx < array.size(); ++idx)
+    {
+        ASSERT_EQ(0.f, array(idx));
+    }
+    array.fill(3.f);
+
+    // the samples added by resize() are zeroed too, the others are kept
+    array.resize(1200, 1000);
+    for (size_t idx = 0; idx < array.size(); ++idx)
+    {
+        ASSERT_EQ(idx < 1200*900 ? 3.f : 0.f, array(idx)) << idx;
+    }
+
+    Array2Df copy(array);
+    compareVectors(array.data(), copy.data(), array.size());
+}
+
+TEST(TestArray2D, InterleavedPlacement)
+{
+    utils::setMemoryPlacement(utils::MEMORY_INTERLEAVED);
+    Array2Df array(1024, 1024);
+    utils::setMemoryPlacement(utils::MEMORY_FIRST_TOUCH);
+
+    std::generate(array.begin(), array.end(), SeqInt());
+    Array2Df copy(array);
+    compareVectors(array.data(), copy.data(), array.size());
+}
+
+TEST(TestArray2D, BoolArray)
+{
+    // packed by std::vector, initialised by the container
+    pfs::Array2D<bool> mask(33, 7);
+    EXPECT_EQ(std::count(mask.begin(), mask.end(), true), 0);
+
+    mask.fill(true);
+    pfs::Array2D<bool> copy(mask);
+    EXPECT_EQ(std::count(copy.begin(), copy.end(), true), 33*7);
+}
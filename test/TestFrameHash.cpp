@@ -0,0 +1,181 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+#include <Libpfs/frame.h>
+#include <Libpfs/manip/gamma.h>
+#include <Libpfs/manip/gamma_levels.h>
+#include <Libpfs/utils/hash.h>
+#include <Libpfs/utils/parallel.h>
+
+using namespace pfs;
+using namespace pfs::utils;
+
+namespace
+{
+Frame* makeFrame(size_t width, size_t height)
+{
+    Frame* frame = new Frame(width, height);
+    Channel* X;
+    Channel* Y;
+    Channel* Z;
+    frame->createXYZChannels(X, Y, Z);
+    for (size_t idx = 0; idx < frame->size(); ++idx)
+    {
+        (*X)(idx) = static_cast<float>(idx % 1013)/1013.f;
+        (*Y)(idx) = static_cast<float>(idx);
+        (*Z)(idx) = -static_cast<float>(idx % 7);
+    }
+    frame->getTags().setTag("FILE_NAME", "test.exr");
+    return frame;
+}
+}
+
+TEST(TestFrameHash, Bytes)
+{
+    std::vector<unsigned char> data(1000);
+    for (size_t idx = 0; idx < data.size(); ++idx)
+    {
+        data[idx] = static_cast<unsigned char>(idx*31);
+    }
+
+    const Hash128 hash = hashBytes(data.data(), data.size());
+    EXPECT_EQ(hash, hashBytes(data.data(), data.size()));
+    EXPECT_EQ(32u, hash.toString().size());
+
+    // seed, size, every byte of the tail and of the stripes count
+    EXPECT_NE(hash, hashBytes(data.data(), data.size(), 1));
+    EXPECT_NE(hash, hashBytes(data.data(), data.size() - 1));
+    data[999] ^= 1;
+    EXPECT_NE(hash, hashBytes(data.data(), data.size()));
+    data[999] ^= 1;
+    data[3] ^= 0x80;
+    EXPECT_NE(hash, hashBytes(data.data(), data.size()));
+
+    // trailing zeros are not lost in the padding
+    std::vector<unsigned char> zeros(40, 0);
+    EXPECT_NE(hashBytes(zeros.data(), 33), hashBytes(zeros.data(), 34));
+}
+
+TEST(TestFrameHash, FrameContent)
+{
+    std::unique_ptr<Frame> a(makeFrame(211, 97));
+    std::unique_ptr<Frame> b(makeFrame(211, 97));
+    EXPECT_EQ(hashFrame(*a), hashFrame(*b));
+
+    (*b->getChannel("Z"))(b->size() - 1) = 1.f;
+    EXPECT_NE(hashFrame(*a), hashFrame(*b));
+
+    b.reset(makeFrame(211, 97));
+    b->getChannel("Y")->getTags().setTag("LUMINANCE", "ABSOLUTE");
+    EXPECT_NE(hashFrame(*a), hashFrame(*b));
+
+    b.reset(makeFrame(211, 97));
+    b->getTags().setTag("LUMINANCE", "RELATIVE");
+    EXPECT_NE(hashFrame(*a), hashFrame(*b));
+
+    // the same image read from another file
+    b.reset(makeFrame(211, 97));
+    b->getTags().setTag("FILE_NAME", "copy.exr");
+    EXPECT_EQ(hashFrame(*a), hashFrame(*b));
+
+    // same samples, different shape
+    b.reset(makeFrame(97, 211));
+    EXPECT_NE(hashFrame(*a), hashFrame(*b));
+}
+
+TEST(TestFrameHash, IndependentOfThreads)
+{
+    // several blocks per channel
+    std::unique_ptr<Frame> frame(makeFrame(1000, 300));
+    const Hash128 hash = hashFrame(*frame);
+
+    for (size_t threads = 1; threads <= 8; threads *= 2)
+    {
+        ScopedExecutor executor(ExecutorPtr(new WorkStealingExecutor(threads)));
+        EXPECT_EQ(hash, hashFrame(*frame)) << threads << " threads";
+    }
+}
+
+TEST(TestFrameHash, CachedOnFrame)
+{
+    std::unique_ptr<Frame> frame(makeFrame(64, 32));
+    const Frame& constFrame = *frame;
+
+    const Hash128 hash = constFrame.getContentHash();
+    EXPECT_EQ(hashFrame(constFrame), hash);
+
+    // const access keeps the hash, so a stale one is returned after a
+    // write through a pointer obtained earlier...
+    Channel* Y = frame->getChannel("Y");
+    EXPECT_EQ(hash, constFrame.getContentHash());
+    (*Y)(0) = 42.f;
+    EXPECT_EQ(hash, constFrame.getContentHash());
+
+    // ...until the hash is invalidated
+    frame->invalidateContentHash();
+    const Hash128 changed = constFrame.getContentHash();
+    EXPECT_NE(hash, changed);
+
+    // non-const accessors drop it
+    (*frame->getChannel("Y"))(0) = 0.f;
+    EXPECT_EQ(hash, constFrame.getContentHash());
+
+    frame->getTags().setTag("LUMINANCE", "RELATIVE");
+    EXPECT_NE(hash, constFrame.getContentHash());
+}
+
+TEST(TestFrameHash, InPlaceEditsDropTheHash)
+{
+    std::unique_ptr<Frame> frame(makeFrame(64, 32));
+    const Frame& constFrame = *frame;
+
+    const Hash128 hash = constFrame.getContentHash();
+    applyGamma(frame.get(), 2.2f);
+    const Hash128 gamma = constFrame.getContentHash();
+    EXPECT_NE(hash, gamma);
+    EXPECT_EQ(hashFrame(constFrame), gamma);
+
+    gammaAndLevels(frame.get(), 0.f, 1.f, 0.1f, 0.9f, 1.5f);
+    EXPECT_NE(gamma, constFrame.getContentHash());
+    EXPECT_EQ(hashFrame(constFrame), constFrame.getContentHash());
+}
+
+TEST(TestFrameHash, Generation)
+{
+    std::unique_ptr<Frame> frame(makeFrame(16, 8));
+    const Frame& constFrame = *frame;
+
+    const uint64_t generation = constFrame.getGeneration();
+    constFrame.getChannel("Y");
+    constFrame.getContentHash();
+    EXPECT_EQ(generation, constFrame.getGeneration());
+
+    frame->getChannel("Y");
+    EXPECT_NE(generation, constFrame.getGeneration());
+
+    // never shared by two frames
+    std::unique_ptr<Frame> other(makeFrame(16, 8));
+    EXPECT_NE(constFrame.getGeneration(), other->getGeneration());
+}
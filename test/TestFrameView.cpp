@@ -0,0 +1,118 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <cmath>
+
+#include <Libpfs/array2d.h>
+#include <Libpfs/array2d_view.h>
+#include <Libpfs/frame.h>
+#include <Libpfs/frame_view.h>
+#include <Libpfs/manip/copy.h>
+#include <Libpfs/manip/gamma.h>
+
+#include "SeqInt.h"
+
+using namespace pfs;
+
+TEST(TestArray2DView, Region)
+{
+    Array2Df input(6, 5);
+    std::generate(input.begin(), input.end(), SeqInt());
+
+    Array2DfConstView view(input, 1, 2, 4, 4);
+
+    EXPECT_EQ(view.getCols(), 3u);
+    EXPECT_EQ(view.getRows(), 2u);
+    EXPECT_EQ(view.getStride(), 6u);
+    EXPECT_FALSE(view.isContiguous());
+
+    // no copy: the view points inside the source buffer
+    EXPECT_EQ(view.data(), input.data() + 2*6 + 1);
+
+    EXPECT_EQ(view(0, 0), 13.f);
+    EXPECT_EQ(view(2, 1), 21.f);
+
+    Array2DfConstView sub = view.subView(1, 1, 3, 2);
+    EXPECT_EQ(sub.getCols(), 2u);
+    EXPECT_EQ(sub.getRows(), 1u);
+    EXPECT_EQ(sub(0, 0), 20.f);
+    EXPECT_EQ(sub(1, 0), 21.f);
+}
+
+TEST(TestArray2DView, CopyRegion)
+{
+    const float ref[] = { 13.f, 14.f, 15.f,
+                          19.f, 20.f, 21.f};
+
+    Array2Df input(6, 5);
+    std::generate(input.begin(), input.end(), SeqInt());
+
+    Array2Df output(3, 2);
+    pfs::copy(Array2DfConstView(input, 1, 2, 4, 4), &output);
+
+    for (size_t idx = 0; idx < output.size(); ++idx)
+    {
+        ASSERT_EQ(ref[idx], output(idx));
+    }
+}
+
+TEST(TestFrameView, CopyWithGamma)
+{
+    Frame frame(6, 5);
+
+    Channel *X, *Y, *Z;
+    frame.createXYZChannels(X, Y, Z);
+    std::generate(X->begin(), X->end(), SeqInt());
+    std::generate(Y->begin(), Y->end(), SeqInt());
+    std::generate(Z->begin(), Z->end(), SeqInt());
+    frame.getTags().setTag("TAG", "VALUE");
+
+    FrameView view(frame, 1, 1, 5, 4);
+    ASSERT_EQ(view.getWidth(), 4u);
+    ASSERT_EQ(view.getHeight(), 3u);
+    ASSERT_FALSE(view.isWholeFrame());
+
+    std::unique_ptr<Frame> copied(pfs::copy(view));
+    std::unique_ptr<Frame> gamma(pfs::copyWithGamma(view, 2.f));
+
+    // reference: copy, then gamma in place
+    pfs::applyGamma(copied.get(), 2.f);
+
+    ASSERT_EQ(gamma->getWidth(), 4u);
+    ASSERT_EQ(gamma->getHeight(), 3u);
+    EXPECT_EQ(gamma->getTags().getTag("TAG"), "VALUE");
+
+    Channel *Xc, *Yc, *Zc;
+    copied->getXYZChannels(Xc, Yc, Zc);
+    Channel *Xg, *Yg, *Zg;
+    gamma->getXYZChannels(Xg, Yg, Zg);
+
+    for (size_t idx = 0; idx < gamma->size(); ++idx)
+    {
+        ASSERT_EQ((*Xc)(idx), (*Xg)(idx));
+        ASSERT_EQ((*Yc)(idx), (*Yg)(idx));
+        ASSERT_EQ((*Zc)(idx), (*Zg)(idx));
+    }
+    EXPECT_FLOAT_EQ((*Xg)(0, 0), std::sqrt(7.f));
+}
@@ -0,0 +1,156 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <gtest/gtest.h>
+
+#include <stdint.h>
+#include <vector>
+
+#include <Libpfs/frame.h>
+#include <Libpfs/params.h>
+#include <Libpfs/manip/gamma_levels.h>
+#include <Libpfs/colorspace/convert.h>
+
+using namespace pfs;
+
+namespace
+{
+void fillFrame(Frame& frame)
+{
+    Channel* R;
+    Channel* G;
+    Channel* B;
+    frame.createXYZChannels(R, G, B);
+    for (size_t idx = 0; idx < frame.size(); ++idx)
+    {
+        (*R)(idx) = static_cast<float>(idx % 97)/96.f;
+        (*G)(idx) = static_cast<float>(idx % 61)/60.f;
+        (*B)(idx) = static_cast<float>(idx % 13)/12.f;
+    }
+}
+}
+
+TEST(TestGammaLevels, IdentityOnlyQuantises)
+{
+    Frame frame(41, 7);
+    fillFrame(frame);
+
+    const Channel* R;
+    const Channel* G;
+    const Channel* B;
+    frame.getXYZChannels(R, G, B);
+
+    const size_t width = frame.getWidth();
+    std::vector<uint16_t> line(3*width);
+    LevelsQuantizer<uint16_t> quantizer(0.f, 1.f);
+
+    for (size_t row = 0; row < frame.getHeight(); ++row)
+    {
+        quantizer(R->row_begin(row), G->row_begin(row), B->row_begin(row), width,
+                  line.data(), line.data() + 1, line.data() + 2, 3, row);
+
+        for (size_t col = 0; col < width; ++col)
+        {
+            ASSERT_EQ(colorspace::convertSample<uint16_t>((*R)(col, row)), line[3*col]);
+            ASSERT_EQ(colorspace::convertSample<uint16_t>((*G)(col, row)), line[3*col + 1]);
+            ASSERT_EQ(colorspace::convertSample<uint16_t>((*B)(col, row)), line[3*col + 2]);
+        }
+    }
+}
+
+TEST(TestGammaLevels, FusedMatchesInPlace)
+{
+    const float blackIn = 0.1f;
+    const float whiteIn = 0.8f;
+    const float blackOut = 0.05f;
+    const float whiteOut = 0.95f;
+    const float gamma = 1.4f;
+
+    Frame reference(53, 11);
+    fillFrame(reference);
+    Frame fused(53, 11);
+    fillFrame(fused);
+
+    gammaAndLevels(&reference, blackIn, whiteIn, blackOut, whiteOut, gamma);
+
+    // the same levels travel through the writer parameters
+    Params params;
+    GammaLevels(blackIn, whiteIn, blackOut, whiteOut, gamma).toParams(params);
+    LevelsQuantizer<uint8_t> quantizer(0.f, 1.f, GammaLevels::fromParams(params));
+
+    const Channel* R;
+    const Channel* G;
+    const Channel* B;
+    fused.getXYZChannels(R, G, B);
+    const Channel* rR;
+    const Channel* rG;
+    const Channel* rB;
+    reference.getXYZChannels(rR, rG, rB);
+
+    const size_t width = fused.getWidth();
+    // BGRx, like a QImage on little endian machines
+    std::vector<uint8_t> line(4*width);
+    for (size_t row = 0; row < fused.getHeight(); ++row)
+    {
+        quantizer(R->row_begin(row), G->row_begin(row), B->row_begin(row), width,
+                  line.data() + 2, line.data() + 1, line.data(), 4, row);
+
+        for (size_t col = 0; col < width; ++col)
+        {
+            ASSERT_EQ(colorspace::convertSample<uint8_t>((*rR)(col, row)), line[4*col + 2]);
+            ASSERT_EQ(colorspace::convertSample<uint8_t>((*rG)(col, row)), line[4*col + 1]);
+            ASSERT_EQ(colorspace::convertSample<uint8_t>((*rB)(col, row)), line[4*col]);
+        }
+    }
+}
+
+TEST(TestGammaLevels, DitherKeepsMean)
+{
+    // a flat area halfway between two codes
+    const size_t width = 64;
+    const size_t height = 16;
+    const float value = 100.5f/255.f;
+    std::vector<float> plane(width, value);
+
+    LevelsQuantizer<uint8_t> rounding(0.f, 1.f, GammaLevels(), MAP_LINEAR, false);
+    LevelsQuantizer<uint8_t> dithered(0.f, 1.f, GammaLevels(), MAP_LINEAR, true);
+
+    std::vector<uint8_t> line(3*width);
+    double sumRounded = 0.;
+    double sumDithered = 0.;
+    for (size_t row = 0; row < height; ++row)
+    {
+        rounding(plane.data(), plane.data(), plane.data(), width,
+                 line.data(), line.data() + 1, line.data() + 2, 3, row);
+        for (size_t col = 0; col < width; ++col) sumRounded += line[3*col];
+
+        dithered(plane.data(), plane.data(), plane.data(), width,
+                 line.data(), line.data() + 1, line.data() + 2, 3, row);
+        for (size_t col = 0; col < width; ++col)
+        {
+            EXPECT_GE(line[3*col], 100);
+            EXPECT_LE(line[3*col], 101);
+            sumDithered += line[3*col];
+        }
+    }
+
+    EXPECT_DOUBLE_EQ(101., sumRounded/(width*height));
+    EXPECT_NEAR(100.5, sumDithered/(width*height), 0.05);
+}
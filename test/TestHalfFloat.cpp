@@ -0,0 +1,156 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include <Libpfs/frame.h>
+#include <Libpfs/compactframe.h>
+#include <Libpfs/utils/half.h>
+
+using namespace pfs;
+using namespace pfs::utils;
+
+TEST(TestHalfFloat, SpecialValues)
+{
+    EXPECT_EQ(0x0000, floatToHalf(0.f));
+    EXPECT_EQ(0x8000, floatToHalf(-0.f));
+    EXPECT_EQ(0x3c00, floatToHalf(1.f));
+    EXPECT_EQ(0xc000, floatToHalf(-2.f));
+    EXPECT_EQ(0x7bff, floatToHalf(HALF_MAX));
+    EXPECT_EQ(0x7c00, floatToHalf(65520.f));
+    EXPECT_EQ(0x7c00, floatToHalf(std::numeric_limits<float>::infinity()));
+    EXPECT_EQ(0x0001, floatToHalf(std::ldexp(1.f, -24)));   // smallest subnormal
+    EXPECT_EQ(0x0000, floatToHalf(std::ldexp(1.f, -25)));   // tie to even
+    EXPECT_EQ(0x0400, floatToHalf(std::ldexp(1.f, -14)));   // smallest normal
+
+    // -ffast-math folds std::isnan() to false: look at the bits
+    const uint16_t nan = floatToHalf(std::numeric_limits<float>::quiet_NaN());
+    EXPECT_EQ(0x7c00, nan & 0x7c00);
+    EXPECT_NE(0, nan & 0x3ff);
+    EXPECT_EQ(0x7c00, floatToHalf(halfToFloat(0x7c00)));
+}
+
+TEST(TestHalfFloat, RoundToNearestEven)
+{
+    // 1 + 2^-11 is halfway between 1 and the next half: goes to 1 (even)
+    EXPECT_EQ(0x3c00, floatToHalf(1.f + std::ldexp(1.f, -11)));
+    // 1 + 3*2^-11 is halfway between two halves: goes to the even one
+    EXPECT_EQ(0x3c02, floatToHalf(1.f + 3.f*std::ldexp(1.f, -11)));
+    // just above halfway rounds up
+    EXPECT_EQ(0x3c01, floatToHalf(1.f + std::ldexp(1.f, -11) + std::ldexp(1.f, -20)));
+}
+
+TEST(TestHalfFloat, RoundTripAllHalves)
+{
+    for (uint32_t h = 0; h < 0x10000; ++h)
+    {
+        const uint16_t value = static_cast<uint16_t>(h);
+        // skip NaNs, their payload is not guaranteed
+        if ( (value & 0x7c00) == 0x7c00 && (value & 0x3ff) ) continue;
+
+        ASSERT_EQ(value, floatToHalf(halfToFloat(value))) << h;
+    }
+}
+
+TEST(TestHalfFloat, BulkMatchesScalar)
+{
+    const size_t size = 1031;
+    std::vector<float> in(size);
+    for (size_t idx = 0; idx < size; ++idx)
+    {
+        in[idx] = std::pow(1.013f, static_cast<float>(idx)) - 2.f;
+    }
+    in[5] = 1e6f;       // saturated, not turned into infinity
+    in[6] = -1e6f;
+    in[7] = std::numeric_limits<float>::quiet_NaN();
+
+    std::vector<uint16_t> half(size);
+    std::vector<float> out(size);
+    floatToHalf(in.data(), half.data(), size);
+    halfToFloat(half.data(), out.data(), size);
+
+    EXPECT_EQ(0x7bff, half[5]);
+    EXPECT_EQ(0xfbff, half[6]);
+    // NaN stays NaN
+    EXPECT_EQ(0x7c00, half[7] & 0x7c00);
+    EXPECT_NE(0, half[7] & 0x3ff);
+    for (size_t idx = 0; idx < size; ++idx)
+    {
+        if ( idx == 7 || std::fabs(in[idx]) > HALF_MAX ) continue;
+
+        ASSERT_EQ(floatToHalf(in[idx]), half[idx]) << idx;
+        ASSERT_NEAR(in[idx], out[idx], std::fabs(in[idx])*1e-3f + 1e-7f);
+    }
+}
+
+TEST(TestCompactFrame, Expand)
+{
+    const size_t width = 37;
+    const size_t height = 23;
+
+    Frame frame(width, height);
+    Channel* X;
+    Channel* Y;
+    Channel* Z;
+    frame.createXYZChannels(X, Y, Z);
+    for (size_t idx = 0; idx < frame.size(); ++idx)
+    {
+        (*X)(idx) = static_cast<float>(idx)*0.25f;
+        (*Y)(idx) = static_cast<float>(idx)*0.5f;
+        (*Z)(idx) = static_cast<float>(idx);
+    }
+    frame.getTags().setTag("LUMINANCE", "RELATIVE");
+
+    CompactFrame compact(frame);
+    EXPECT_EQ(width, compact.getWidth());
+    EXPECT_EQ(height, compact.getHeight());
+    EXPECT_EQ(3*width*height*sizeof(uint16_t), compact.getByteSize());
+
+    std::unique_ptr<Frame> expanded(compact.expand());
+    ASSERT_EQ(width, expanded->getWidth());
+    ASSERT_EQ(height, expanded->getHeight());
+    EXPECT_EQ("RELATIVE", expanded->getTags().getTag("LUMINANCE"));
+
+    Channel* eX;
+    Channel* eY;
+    Channel* eZ;
+    expanded->getXYZChannels(eX, eY, eZ);
+    ASSERT_TRUE(eX && eY && eZ);
+    // all values are exactly representable in half
+    for (size_t idx = 0; idx < frame.size(); ++idx)
+    {
+        ASSERT_EQ((*X)(idx), (*eX)(idx));
+        ASSERT_EQ((*Y)(idx), (*eY)(idx));
+        ASSERT_EQ((*Z)(idx), (*eZ)(idx));
+    }
+
+    Array2Df tile(10, 5);
+    ASSERT_TRUE(compact.expandTile("Y", 3, 4, 13, 9, tile));
+    for (size_t r = 0; r < 5; ++r)
+        for (size_t c = 0; c < 10; ++c)
+            ASSERT_EQ((*Y)(3 + c, 4 + r), tile(c, r));
+
+    EXPECT_FALSE(compact.expandTile("ALPHA", 0, 0, 10, 5, tile));
+}
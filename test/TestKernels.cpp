@@ -0,0 +1,216 @@
+/*
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <Libpfs/utils/cpu.h>
+#include <Libpfs/utils/kernels.h>
+#include <Libpfs/utils/dotproduct.h>
+#include <Libpfs/utils/numeric.h>
+
+using namespace pfs::utils;
+
+namespace
+{
+// not a multiple of any vector size, so the tails are exercised
+const size_t SIZE = 1031;
+
+std::vector<float> makeValues(float offset, float scale)
+{
+    std::vector<float> values(SIZE);
+    for (size_t idx = 0; idx < SIZE; ++idx)
+    {
+        values[idx] = offset + scale*static_cast<float>((idx*37) % 101)/100.f;
+    }
+    return values;
+}
+
+std::vector<const Kernels*> availableKernels()
+{
+    std::vector<const Kernels*> result;
+    const CpuLevel levels[] = { CPU_SSE2, CPU_AVX2, CPU_AVX512 };
+    for (size_t idx = 0; idx < sizeof(levels)/sizeof(levels[0]); ++idx)
+    {
+        const Kernels* k = kernels(levels[idx]);
+        if ( k != NULL ) result.push_back(k);
+    }
+    return result;
+}
+}
+
+TEST(TestKernels, CpuLevelNames)
+{
+    CpuLevel level;
+    EXPECT_TRUE(parseCpuLevel("AVX2", level));
+    EXPECT_EQ(CPU_AVX2, level);
+    EXPECT_TRUE(parseCpuLevel(cpuLevelName(CPU_AVX512), level));
+    EXPECT_EQ(CPU_AVX512, level);
+    EXPECT_FALSE(parseCpuLevel("neon", level));
+
+    EXPECT_LE(cpuLevel(), detectCpuLevel());
+    EXPECT_LE(kernels().level, cpuLevel());
+    // the processor never gets the code of a level above its own
+    for (int level = detectCpuLevel() + 1; level <= CPU_AVX512; ++level)
+    {
+        EXPECT_TRUE(kernels(static_cast<CpuLevel>(level)) == NULL);
+    }
+}
+
+TEST(TestKernels, LevelsMatchGeneric)
+{
+    const Kernels& generic = *kernels(CPU_GENERIC);
+    const std::vector<float> a = makeValues(-0.5f, 2.f);
+    const std::vector<float> b = makeValues(0.01f, 30.f);
+
+    std::vector<float> expected(SIZE);
+    std::vector<float> out(SIZE);
+    std::vector<float> expected3(3*SIZE);
+    std::vector<float> out3(3*SIZE);
+    const float m[9] = { 0.4124f, 0.3576f, 0.1805f,
+                         0.2126f, 0.7152f, 0.0722f,
+                         0.0193f, 0.1192f, 0.9505f };
+
+    const std::vector<const Kernels*> levels = availableKernels();
+    for (size_t l = 0; l < levels.size(); ++l)
+    {
+        const Kernels& k = *levels[l];
+        SCOPED_TRACE(cpuLevelName(k.level));
+
+        const double dot = generic.dotProduct(a.data(), b.data(), SIZE);
+        EXPECT_NEAR(dot, k.dotProduct(a.data(), b.data(), SIZE), std::fabs(dot)*1e-12);
+        const double squares = generic.sumOfSquares(b.data(), SIZE);
+        EXPECT_NEAR(squares, k.sumOfSquares(b.data(), SIZE), squares*1e-12);
+
+        generic.vadds(a.data(), 0.3f, b.data(), expected.data(), SIZE);
+        k.vadds(a.data(), 0.3f, b.data(), out.data(), SIZE);
+        for (size_t idx = 0; idx < SIZE; ++idx)
+        {
+            ASSERT_NEAR(expected[idx], out[idx], 1e-5f) << idx;
+        }
+
+        generic.matrix3(m, a.data(), b.data(), a.data(),
+                        &expected3[0], &expected3[SIZE], &expected3[2*SIZE], SIZE);
+        k.matrix3(m, a.data(), b.data(), a.data(),
+                  &out3[0], &out3[SIZE], &out3[2*SIZE], SIZE);
+        for (size_t idx = 0; idx < 3*SIZE; ++idx)
+        {
+            ASSERT_NEAR(expected3[idx], out3[idx], 1e-5f) << idx;
+        }
+
+        generic.log2(b.data(), expected.data(), SIZE, 0.5f);
+        k.log2(b.data(), out.data(), SIZE, 0.5f);
+        for (size_t idx = 0; idx < SIZE; ++idx)
+        {
+            ASSERT_NEAR(expected[idx], out[idx], 1e-6f) << idx;
+        }
+
+        generic.exp2(a.data(), expected.data(), SIZE, 3.f);
+        k.exp2(a.data(), out.data(), SIZE, 3.f);
+        for (size_t idx = 0; idx < SIZE; ++idx)
+        {
+            ASSERT_NEAR(1.f, out[idx]/expected[idx], 1e-6f) << idx;
+        }
+
+        generic.pow(a.data(), expected.data(), SIZE, 0.45f);
+        k.pow(a.data(), out.data(), SIZE, 0.45f);
+        for (size_t idx = 0; idx < SIZE; ++idx)
+        {
+            ASSERT_NEAR(expected[idx], out[idx], 1e-6f) << idx;
+        }
+    }
+}
+
+TEST(TestKernels, HalfConversionsMatchGeneric)
+{
+    const Kernels& generic = *kernels(CPU_GENERIC);
+    std::vector<float> in = makeValues(-2.f, 4.f);
+    for (size_t idx = 0; idx + 1 < SIZE; idx += 10)
+    {
+        in[idx] *= 1e5f;                        // saturated
+        in[idx + 1] = std::ldexp(in[idx + 1], -20);    // subnormal
+    }
+    in[3] = std::numeric_limits<float>::infinity();
+    in[4] = -std::numeric_limits<float>::infinity();
+    in[5] = std::numeric_limits<float>::quiet_NaN();
+    in[SIZE - 1] = -std::numeric_limits<float>::quiet_NaN();
+
+    std::vector<uint16_t> expected(SIZE);
+    std::vector<uint16_t> half(SIZE);
+    std::vector<float> expectedOut(SIZE);
+    std::vector<float> out(SIZE);
+    generic.floatToHalf(in.data(), expected.data(), SIZE);
+    generic.halfToFloat(expected.data(), expectedOut.data(), SIZE);
+    EXPECT_EQ(0x7bff, expected[3]);
+    EXPECT_EQ(0xfbff, expected[4]);
+
+    const std::vector<const Kernels*> levels = availableKernels();
+    for (size_t l = 0; l < levels.size(); ++l)
+    {
+        const Kernels& k = *levels[l];
+        SCOPED_TRACE(cpuLevelName(k.level));
+
+        k.floatToHalf(in.data(), half.data(), SIZE);
+        for (size_t idx = 0; idx < SIZE; ++idx)
+        {
+            // -ffast-math folds std::isnan() to false: look at the bits
+            if ( idx == 5 || idx == SIZE - 1 )
+            {
+                ASSERT_EQ(0x7c00, half[idx] & 0x7c00) << idx;
+                ASSERT_NE(0, half[idx] & 0x3ff) << idx;
+                continue;
+            }
+            ASSERT_EQ(expected[idx], half[idx]) << idx;
+        }
+
+        k.halfToFloat(expected.data(), out.data(), SIZE);
+        for (size_t idx = 0; idx < SIZE; ++idx)
+        {
+            if ( idx == 5 || idx == SIZE - 1 ) continue;
+            ASSERT_EQ(expectedOut[idx], out[idx]) << idx;
+        }
+    }
+}
+
+TEST(TestKernels, DispatchedNumeric)
+{
+    // bigger than a block, so the work is split among the threads
+    const size_t size = 3*KERNELS_BLOCK_SIZE + 5;
+    std::vector<float> a(size);
+    std::vector<float> b(size);
+    double expected = 0.;
+    for (size_t idx = 0; idx < size; ++idx)
+    {
+        a[idx] = static_cast<float>(idx % 7) - 3.f;
+        b[idx] = static_cast<float>(idx % 5)*0.25f;
+        expected += static_cast<double>(a[idx])*b[idx];
+    }
+    EXPECT_FLOAT_EQ(static_cast<float>(expected), dotProduct(a.data(), b.data(), size));
+
+    std::vector<float> c(size);
+    vsubs(a.data(), 2.f, b.data(), c.data(), size);
+    for (size_t idx = 0; idx < size; ++idx)
+    {
+        ASSERT_FLOAT_EQ(a[idx] - 2.f*b[idx], c[idx]) << idx;
+    }
+}
@@ -0,0 +1,271 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include <Libpfs/array2d.h>
+#include <Libpfs/frame.h>
+#include <Libpfs/utils/memorybudget.h>
+
+using namespace pfs;
+using namespace pfs::utils;
+
+namespace
+{
+const size_t MB = 1024*1024;
+
+//! \brief budget of \a bytes over the frames alive, for the lifetime of the
+//! object
+class ScopedBudget
+{
+public:
+    explicit ScopedBudget(size_t bytes)
+        : m_previous(memoryBudget())
+    {
+        setMemoryBudget(frameMemoryUsage() + bytes);
+    }
+
+    ~ScopedBudget()
+    {
+        setMemoryBudget(m_previous);
+    }
+
+private:
+    size_t m_previous;
+};
+}
+
+TEST(TestMemoryBudget, FramesAreCounted)
+{
+    const size_t before = frameMemoryUsage();
+    {
+        Frame frame(300, 200);
+        Channel* X;
+        Channel* Y;
+        Channel* Z;
+        frame.createXYZChannels(X, Y, Z);
+
+        EXPECT_EQ(before + frameMemorySize(300, 200), frameMemoryUsage());
+        EXPECT_GE(frameMemoryPeak(), frameMemoryUsage());
+    }
+    EXPECT_EQ(before, frameMemoryUsage());
+}
+
+TEST(TestMemoryBudget, NoBudgetAdmitsEverything)
+{
+    const size_t previous = memoryBudget();
+    setMemoryBudget(0);
+
+    MemoryReservation first(1000*MB);
+    MemoryReservation second;
+    EXPECT_TRUE(second.tryReserve(1000*MB));
+    EXPECT_EQ(2000*MB, memoryStatus().reserved);
+
+    setMemoryBudget(previous);
+}
+
+TEST(TestMemoryBudget, LoneReservationOverBudget)
+{
+    ScopedBudget budget(MB);
+
+    // nothing else is reserved: a job larger than the budget still runs
+    MemoryReservation reservation;
+    EXPECT_TRUE(reservation.tryReserve(10*MB));
+    EXPECT_EQ(10*MB, reservation.bytes());
+
+    reservation.release();
+    EXPECT_EQ(0u, memoryStatus().reserved);
+}
+
+TEST(TestMemoryBudget, FramesCountAgainstTheBudget)
+{
+    ScopedBudget budget(2*MB);
+
+    // allocated outside of the reservation: counted on top of it
+    std::unique_ptr<Array2Df> frame(new Array2Df(512, 256));   // half a megabyte
+    MemoryReservation first(MB);
+    EXPECT_FALSE(isMemoryAvailable(MB));
+
+    frame.reset();
+    EXPECT_TRUE(isMemoryAvailable(MB));
+}
+
+TEST(TestMemoryBudget, ReservedFramesAreCountedOnce)
+{
+    ScopedBudget budget(2*MB);
+
+    MemoryReservation running(MB);
+    {
+        Array2Df frame(512, 512);   // the whole reservation
+        EXPECT_TRUE(isMemoryAvailable(MB));
+
+        // past the reservation
+        Array2Df more(512, 256);
+        EXPECT_FALSE(isMemoryAvailable(MB));
+    }
+    EXPECT_TRUE(isMemoryAvailable(MB));
+
+    // the frames of other threads are not part of it
+    bool available = true;
+    std::thread other([&available]()
+    {
+        Array2Df frame(512, 512);
+        available = isMemoryAvailable(MB);
+    });
+    other.join();
+    EXPECT_FALSE(available);
+    EXPECT_TRUE(isMemoryAvailable(MB));
+}
+
+TEST(TestMemoryBudget, ReservationWaitsForRelease)
+{
+    ScopedBudget budget(3*MB);
+
+    std::unique_ptr<MemoryReservation> first(new MemoryReservation(2*MB));
+
+    MemoryReservation probe;
+    EXPECT_FALSE(probe.tryReserve(2*MB));
+
+    std::atomic<bool> admitted(false);
+    std::thread job([&admitted]()
+    {
+        MemoryReservation second(2*MB);
+        admitted = true;
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_FALSE(admitted);
+    EXPECT_EQ(1u, memoryStatus().waiting);
+
+    first.reset();
+    job.join();
+
+    EXPECT_TRUE(admitted);
+    EXPECT_EQ(0u, memoryStatus().waiting);
+    EXPECT_EQ(0u, memoryStatus().reserved);
+}
+
+TEST(TestMemoryBudget, PressureHandlersRelease)
+{
+    ScopedBudget budget(2*MB);
+    std::shared_ptr<Array2Df> inactive = std::make_shared<Array2Df>(1024, 1024);
+
+    size_t asked = 0;
+    const int id = addMemoryPressureHandler([&inactive, &asked](size_t bytes) -> size_t
+    {
+        asked = bytes;
+        if ( !inactive ) return 0;
+
+        const size_t released = inactive->size()*sizeof(float);
+        inactive.reset();
+        return released;
+    });
+
+    // alone, so admitted, but 4 MB of frames and 1 MB reserved are 3 MB
+    // over the budget: the handlers are asked all the same
+    MemoryReservation running(MB);
+    EXPECT_EQ(3*MB, asked);
+    MemoryReservation next(MB);
+
+    EXPECT_FALSE(inactive);
+    EXPECT_EQ(2*MB, next.bytes() + running.bytes());
+
+    removeMemoryPressureHandler(id);
+    EXPECT_EQ(0u, relieveMemoryPressure(MB));
+}
+
+TEST(TestMemoryBudget, LoneReservationRelievesPressure)
+{
+    ScopedBudget budget(MB);
+    std::shared_ptr<Array2Df> inactive = std::make_shared<Array2Df>(1024, 512);
+
+    size_t asked = 0;
+    const int id = addMemoryPressureHandler([&inactive, &asked](size_t bytes) -> size_t
+    {
+        asked = bytes;
+        if ( !inactive ) return 0;
+
+        const size_t released = inactive->size()*sizeof(float);
+        inactive.reset();
+        return released;
+    });
+
+    // admitted anyway, but the inactive frames make room first
+    MemoryReservation lone;
+    EXPECT_TRUE(lone.tryReserve(2*MB));
+    EXPECT_EQ(3*MB, asked);
+    EXPECT_FALSE(inactive);
+
+    removeMemoryPressureHandler(id);
+}
+
+TEST(TestMemoryBudget, DetachedReservationStaysInTheBudget)
+{
+    ScopedBudget budget(2*MB);
+
+    // a load reserves for a float frame, then keeps the smaller data it read
+    MemoryReservation loaded(2*MB);
+    loaded.shrink(MB);
+    EXPECT_EQ(MB, memoryStatus().reserved);
+    loaded.detach();
+
+    // the frames the thread allocates now are not part of it
+    Array2Df frame(512, 256);
+
+    // not a running job: a reservation alone is still admitted...
+    MemoryReservation running;
+    EXPECT_TRUE(running.tryReserve(MB/4));
+    // ...but the data kept counts against the others, and so does the frame
+    EXPECT_FALSE(isMemoryAvailable(MB/2));
+
+    loaded.release();
+    EXPECT_TRUE(isMemoryAvailable(MB/2));
+    EXPECT_EQ(MB/4, memoryStatus().reserved);
+}
+
+TEST(TestMemoryBudget, AdoptedReservationFollowsTheJobThread)
+{
+    ScopedBudget budget(2*MB);
+
+    // a scheduler admits the job, that runs on another thread
+    MemoryReservation job;
+    ASSERT_TRUE(job.tryReserve(MB));
+    Array2Df scheduler_frame(512, 256);
+
+    std::thread worker([&]()
+    {
+        job.adopt();
+        Array2Df frame(512, 512);
+
+        // the frame of the job is in its reservation, the one of the
+        // scheduler is not
+        EXPECT_TRUE(isMemoryAvailable(MB/4));
+        EXPECT_FALSE(isMemoryAvailable(MB/2 + MB/4));
+    });
+    worker.join();
+
+    job.release();
+    EXPECT_TRUE(isMemoryAvailable(MB + MB/2));
+}
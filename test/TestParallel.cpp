@@ -0,0 +1,276 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+#include <Libpfs/utils/parallel.h>
+#include <Libpfs/utils/numa.h>
+
+using namespace pfs::utils;
+
+namespace
+{
+//! \brief runs the tasks in order on the calling thread, and counts them
+class CountingExecutor : public Executor
+{
+public:
+    CountingExecutor()
+        : m_numTasks(0)
+    {}
+
+    size_t concurrency() const
+    { return 4; }
+
+    void run(std::vector<Task>& tasks)
+    {
+        for (size_t idx = 0; idx < tasks.size(); ++idx)
+        {
+            ++m_numTasks;
+            tasks[idx]();
+        }
+    }
+
+    size_t m_numTasks;
+};
+
+//! \brief restore the default executor at the end of a test
+struct ExecutorGuard
+{
+    ~ExecutorGuard()
+    { setExecutor(ExecutorPtr()); }
+};
+}
+
+TEST(TestParallel, CoversRangeOnce)
+{
+    ExecutorGuard guard;
+    setConcurrency(4);
+
+    const size_t begin = 7;
+    const size_t end = 100007;
+    std::vector<int> hits(end, 0);
+
+    parallelFor(begin, end, 64,
+                [&hits](size_t b, size_t e)
+    {
+        for (size_t idx = b; idx < e; ++idx) ++hits[idx];
+    });
+
+    for (size_t idx = 0; idx < end; ++idx)
+    {
+        ASSERT_EQ(idx < begin ? 0 : 1, hits[idx]) << idx;
+    }
+}
+
+TEST(TestParallel, RespectsGrain)
+{
+    ExecutorGuard guard;
+    setConcurrency(8);
+
+    std::atomic<size_t> minSize(1000);
+    std::atomic<size_t> numCalls(0);
+    parallelFor(0, 1000, 300,
+                [&](size_t b, size_t e)
+    {
+        ++numCalls;
+        size_t current = minSize;
+        while ( e - b < current && !minSize.compare_exchange_weak(current, e - b) ) {}
+    });
+
+    EXPECT_EQ(3u, numCalls.load());
+    EXPECT_LE(300u, minSize.load());
+
+    // short loops run inline
+    numCalls = 0;
+    parallelFor(0, 10, 6, [&](size_t, size_t) { ++numCalls; });
+    EXPECT_EQ(1u, numCalls.load());
+}
+
+TEST(TestParallel, NestedLoops)
+{
+    ExecutorGuard guard;
+    setConcurrency(3);
+
+    const size_t rows = 64;
+    const size_t cols = 1000;
+    std::vector<int> hits(rows*cols, 0);
+
+    parallelFor(0, rows, 1,
+                [&](size_t rb, size_t re)
+    {
+        for (size_t row = rb; row < re; ++row)
+        {
+            parallelFor(0, cols, 10,
+                        [&](size_t cb, size_t ce)
+            {
+                for (size_t col = cb; col < ce; ++col) ++hits[row*cols + col];
+            });
+        }
+    });
+
+    EXPECT_EQ(static_cast<int>(rows*cols), std::accumulate(hits.begin(), hits.end(), 0));
+}
+
+TEST(TestParallel, WaitingTaskOnlyHelpsItsOwnLoop)
+{
+    ExecutorGuard guard;
+    setConcurrency(3);
+
+    // an outer task is busy until its nested loop is done: while it waits,
+    // it must not start another outer task (which could need a lock it
+    // holds)
+    static thread_local int s_depth = 0;
+    std::atomic<int> maxDepth(0);
+    std::atomic<size_t> numInner(0);
+
+    parallelFor(0, 48, 1,
+                [&](size_t b, size_t e)
+    {
+        for (size_t outer = b; outer < e; ++outer)
+        {
+            ++s_depth;
+            int current = maxDepth;
+            while ( s_depth > current && !maxDepth.compare_exchange_weak(current, s_depth) ) {}
+
+            parallelFor(0, 64, 1, [&](size_t ib, size_t ie) { numInner += ie - ib; });
+            --s_depth;
+        }
+    });
+
+    EXPECT_EQ(1, maxDepth.load());
+    EXPECT_EQ(48u*64u, numInner.load());
+}
+
+TEST(TestParallel, InjectedExecutor)
+{
+    ExecutorGuard guard;
+    std::shared_ptr<CountingExecutor> counting = std::make_shared<CountingExecutor>();
+    setExecutor(counting);
+
+    EXPECT_EQ(4u, concurrency());
+
+    std::vector<int> hits(1000, 0);
+    parallelFor(0, hits.size(), 1,
+                [&hits](size_t b, size_t e)
+    {
+        for (size_t idx = b; idx < e; ++idx) ++hits[idx];
+    });
+
+    EXPECT_EQ(16u, counting->m_numTasks);
+    EXPECT_EQ(1000, std::accumulate(hits.begin(), hits.end(), 0));
+}
+
+TEST(TestParallel, PropagatesExceptions)
+{
+    ExecutorGuard guard;
+    setConcurrency(4);
+
+    std::atomic<size_t> done(0);
+    EXPECT_THROW(parallelFor(0, 1024, 1,
+                             [&done](size_t b, size_t e)
+    {
+        if ( b <= 500 && 500 < e ) throw std::runtime_error("failure");
+        done += e - b;
+    }), std::runtime_error);
+
+    // the other chunks are still completed
+    EXPECT_LT(0u, done.load());
+    EXPECT_GT(1024u, done.load());
+
+    // and the executor is still usable
+    std::atomic<size_t> total(0);
+    parallelFor(0, 1024, 1, [&total](size_t b, size_t e) { total += e - b; });
+    EXPECT_EQ(1024u, total.load());
+}
+
+TEST(TestParallel, SingleThread)
+{
+    WorkStealingExecutor serial(1);
+    EXPECT_EQ(1u, serial.concurrency());
+
+    std::vector<int> order;
+    std::vector<Executor::Task> tasks;
+    for (int idx = 0; idx < 5; ++idx)
+    {
+        tasks.push_back([&order, idx]() { order.push_back(idx); });
+    }
+    serial.run(tasks);
+
+    ASSERT_EQ(5u, order.size());
+    for (int idx = 0; idx < 5; ++idx) EXPECT_EQ(idx, order[idx]);
+}
+
+TEST(TestParallel, ScopedExecutor)
+{
+    std::shared_ptr<CountingExecutor> counting = std::make_shared<CountingExecutor>();
+    {
+        ScopedExecutor scope(counting);
+        EXPECT_EQ(counting, executor());
+
+        std::atomic<size_t> total(0);
+        parallelFor(0, 1000, 1, [&total](size_t b, size_t e) { total += e - b; });
+        EXPECT_EQ(1000u, total.load());
+        EXPECT_EQ(16u, counting->m_numTasks);
+    }
+    EXPECT_NE(counting, executor());
+}
+
+TEST(TestParallel, NestedLoopsStayOnTheirExecutor)
+{
+    ExecutorGuard guard;
+    setConcurrency(2);
+
+    std::shared_ptr<WorkStealingExecutor> pool = std::make_shared<WorkStealingExecutor>(3);
+    ScopedExecutor scope(pool);
+
+    // the inner loops see the concurrency of the scoped pool, also when they
+    // run on its threads
+    std::atomic<size_t> wrongExecutor(0);
+    parallelFor(0, 64, 1,
+                [&](size_t, size_t)
+    {
+        ExecutorPtr holder;
+        if ( &detail::loopExecutor(holder) != pool.get() ) ++wrongExecutor;
+    });
+    EXPECT_EQ(0u, wrongExecutor.load());
+}
+
+TEST(TestParallel, NumaNodeExecutor)
+{
+    ASSERT_LE(1u, numaNodeCount());
+
+    ExecutorPtr node = numaNodeExecutor(0);
+    EXPECT_EQ(node, numaNodeExecutor(0));
+    EXPECT_LE(1u, node->concurrency());
+
+    ScopedExecutor scope(node);
+    std::vector<int> hits(50000, 0);
+    parallelFor(0, hits.size(), 100,
+                [&hits](size_t b, size_t e)
+    {
+        for (size_t idx = b; idx < e; ++idx) ++hits[idx];
+    });
+    EXPECT_EQ(50000, std::accumulate(hits.begin(), hits.end(), 0));
+}
@@ -0,0 +1,115 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <gtest/gtest.h>
+
+#if GTEST_HAS_COMBINE
+
+#include <algorithm>
+#include <tuple>
+
+#include <Libpfs/array2d.h>
+#include <Libpfs/manip/transpose.h>
+
+#include "CompareVector.h"
+#include "SeqInt.h"
+
+using ::testing::TestWithParam;
+using ::testing::Values;
+using ::testing::Combine;
+
+template <typename InputType>
+void transpose_ref(const InputType* input,
+                   InputType* output,
+                   size_t width,
+                   size_t height)
+{
+    for (size_t j = 0; j < height; j++)
+    {
+        for (size_t i = 0; i < width; i++)
+        {
+            output[i*height + j] = input[j*width + i];
+        }
+    }
+}
+
+class TestPfsTranspose : public TestWithParam< ::std::tuple<size_t, size_t> >
+{
+protected:
+    size_t m_rows;
+    size_t m_cols;
+
+public:
+    TestPfsTranspose()
+        : m_rows( ::std::get<0>( GetParam() ))
+        , m_cols( ::std::get<1>( GetParam() ))
+    {}
+
+    size_t cols() const { return m_cols; }
+    size_t rows() const { return m_rows; }
+};
+
+TEST_P(TestPfsTranspose, Float)
+{
+    pfs::Array2Df inputVector(cols(), rows());
+    pfs::Array2Df referenceOutput(rows(), cols());
+    pfs::Array2Df computedOutput(rows(), cols());
+
+    std::generate(inputVector.begin(), inputVector.end(), SeqInt());
+
+    transpose_ref(inputVector.data(),
+                  referenceOutput.data(),
+                  cols(), rows());
+    pfs::transpose(&inputVector, &computedOutput);
+
+    compareVectors(referenceOutput.data(),
+                   computedOutput.data(),
+                   cols()*rows());
+}
+
+TEST_P(TestPfsTranspose, Int)
+{
+    pfs::Array2D<int> inputVector(cols(), rows());
+    pfs::Array2D<int> referenceOutput(rows(), cols());
+    pfs::Array2D<int> computedOutput(rows(), cols());
+
+    std::generate(inputVector.begin(), inputVector.end(), SeqInt());
+
+    transpose_ref(inputVector.data(),
+                  referenceOutput.data(),
+                  cols(), rows());
+    pfs::transpose(&inputVector, &computedOutput);
+
+    compareVectors(referenceOutput.data(),
+                   computedOutput.data(),
+                   cols()*rows());
+}
+
+INSTANTIATE_TEST_CASE_P(Test,
+                        TestPfsTranspose,
+                        Combine(Values(1, 3, 32, 91, 403),
+                                Values(1, 5, 64, 256, 511))
+                        );
+
+#else
+
+TEST(DummyTest, CombineIsNotSupportedOnThisPlatform) {}
+
+#endif
@@ -0,0 +1,160 @@
+/*
+ * This file is a part of Luminance HDR package.
+ * ----------------------------------------------------------------------
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <gtest/gtest.h>
+
+#include <stdint.h>
+#include <vector>
+
+#include <Libpfs/array2d.h>
+#include <Libpfs/frame.h>
+#include <Libpfs/manip/resize.h>
+
+using namespace pfs;
+
+namespace
+{
+void fillArray(Array2Df& array)
+{
+    for (size_t idx = 0; idx < array.size(); ++idx)
+    {
+        array(idx) = static_cast<float>((idx*7919) % 1000)/10.f;
+    }
+}
+}
+
+TEST(TestResize, BilinearMatchesReference)
+{
+    const size_t w = 67, h = 41, w2 = 23, h2 = 15;
+    Array2Df in(w, h);
+    fillArray(in);
+    Array2Df out(w2, h2);
+
+    resize(&in, &out, BilinearInterp);
+
+    const float x_ratio = static_cast<float>(w - 1)/w2;
+    const float y_ratio = static_cast<float>(h - 1)/h2;
+    for (size_t i = 0; i < h2; i++)
+    {
+        const size_t y = static_cast<size_t>(y_ratio * i);
+        const float y_diff = (y_ratio * i) - y;
+        for (size_t j = 0; j < w2; j++)
+        {
+            const size_t x = static_cast<size_t>(x_ratio * j);
+            const float x_diff = (x_ratio * j) - x;
+
+            const float expected =
+                    in(x, y)*(1 - x_diff)*(1 - y_diff) +
+                    in(x + 1, y)*x_diff*(1 - y_diff) +
+                    in(x, y + 1)*y_diff*(1 - x_diff) +
+                    in(x + 1, y + 1)*x_diff*y_diff;
+
+            ASSERT_NEAR(expected, out(j, i), 1e-3f);
+        }
+    }
+}
+
+TEST(TestResize, AreaAveragesBlocks)
+{
+    Array2Df in(64, 32);
+    fillArray(in);
+    Array2Df out(16, 8);
+
+    resize(&in, &out, AreaInterp);
+
+    for (size_t i = 0; i < out.getRows(); i++)
+    {
+        for (size_t j = 0; j < out.getCols(); j++)
+        {
+            float sum = 0.f;
+            for (size_t y = 4*i; y < 4*i + 4; y++)
+                for (size_t x = 4*j; x < 4*j + 4; x++)
+                    sum += in(x, y);
+
+            ASSERT_NEAR(sum/16.f, out(j, i), 1e-3f);
+        }
+    }
+}
+
+TEST(TestResize, FlatStaysFlat)
+{
+    const InterpolationMethod methods[] = { LanczosInterp, BilinearInterp, AreaInterp };
+    for (size_t m = 0; m < 3; ++m)
+    {
+        Array2Df in(101, 57);
+        std::fill(in.begin(), in.end(), 0.25f);
+        Array2Df small(13, 7);
+        Array2Df large(230, 130);
+
+        resize(&in, &small, methods[m]);
+        resize(&in, &large, methods[m]);
+
+        for (size_t idx = 0; idx < small.size(); ++idx)
+            ASSERT_NEAR(0.25f, small(idx), 1e-5f) << "method " << m;
+        for (size_t idx = 0; idx < large.size(); ++idx)
+            ASSERT_NEAR(0.25f, large(idx), 1e-5f) << "method " << m;
+    }
+}
+
+TEST(TestResize, FrameMatchesChannels)
+{
+    Frame frame(120, 80);
+    Channel* X;
+    Channel* Y;
+    Channel* Z;
+    frame.createXYZChannels(X, Y, Z);
+    fillArray(*X);
+    fillArray(*Y);
+    std::reverse(Y->begin(), Y->end());
+    fillArray(*Z);
+    std::fill(Z->begin(), Z->end() - 1000, 2.f);
+
+    std::unique_ptr<Frame> resized( pfs::resize(&frame, 50, LanczosInterp) );
+    ASSERT_EQ(50u, resized->getWidth());
+    ASSERT_EQ(33u, resized->getHeight());
+
+    Channel* rX;
+    Channel* rY;
+    Channel* rZ;
+    resized->getXYZChannels(rX, rY, rZ);
+
+    const Channel* channels[] = { X, Y, Z };
+    const Channel* resizedChannels[] = { rX, rY, rZ };
+    for (int c = 0; c < 3; ++c)
+    {
+        Array2Df single(50, 33);
+        resize(channels[c], &single, LanczosInterp);
+
+        for (size_t idx = 0; idx < single.size(); ++idx)
+        {
+            ASSERT_FLOAT_EQ(single(idx), (*resizedChannels[c])(idx));
+        }
+    }
+}
+
+TEST(TestResize, FilterBanksAreCached)
+{
+    detail::FilterBankPtr first = detail::getFilterBank(640, 120, AreaInterp);
+    detail::FilterBankPtr second = detail::getFilterBank(640, 120, AreaInterp);
+    detail::FilterBankPtr other = detail::getFilterBank(640, 120, LanczosInterp);
+
+    EXPECT_EQ(first.get(), second.get());
+    EXPECT_NE(first.get(), other.get());
+}
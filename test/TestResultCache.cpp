@@ -0,0 +1,280 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include <Libpfs/frame.h>
+#include <Libpfs/resultcache.h>
+
+using namespace pfs;
+
+namespace
+{
+//! \brief empty directory of its own for every test
+class TestResultCache : public ::testing::Test
+{
+protected:
+    void SetUp()
+    {
+        const char* tmp = std::getenv("TMPDIR");
+        std::ostringstream name;
+        name << (tmp ? tmp : "/tmp") << "/luminance_resultcache_XXXXXX";
+        std::string dir = name.str();
+        ASSERT_TRUE(mkdtemp(&dir[0]) != NULL);
+        m_directory = dir;
+    }
+
+    void TearDown()
+    {
+        ResultCache(m_directory, 0).clear();
+        std::remove((m_directory + "/index").c_str());
+        std::remove((m_directory + "/index.lock").c_str());
+        rmdir(m_directory.c_str());
+    }
+
+    std::string m_directory;
+};
+
+Frame* makeFrame(size_t width, size_t height, float seed)
+{
+    Frame* frame = new Frame(width, height);
+    Channel* X;
+    Channel* Y;
+    Channel* Z;
+    frame->createXYZChannels(X, Y, Z);
+    for (size_t idx = 0; idx < frame->size(); ++idx)
+    {
+        (*X)(idx) = seed + idx;
+        (*Y)(idx) = seed*idx;
+        (*Z)(idx) = -seed;
+    }
+    return frame;
+}
+}
+
+TEST_F(TestResultCache, KeyDependsOnContentAndOptions)
+{
+    std::unique_ptr<Frame> a(makeFrame(67, 131, 1.f));
+    std::unique_ptr<Frame> b(makeFrame(67, 131, 1.f));
+
+    const std::string key = ResultCache::makeKey(*a, "mantiuk06_contrast_0.1");
+    EXPECT_EQ(32u, key.size());
+    EXPECT_EQ(key, ResultCache::makeKey(*b, "mantiuk06_contrast_0.1"));
+    EXPECT_NE(key, ResultCache::makeKey(*a, "mantiuk06_contrast_0.2"));
+
+    // a single sample in the last row
+    (*b->getChannel("Z"))(b->size() - 1) = 0.f;
+    EXPECT_NE(key, ResultCache::makeKey(*b, "mantiuk06_contrast_0.1"));
+
+    b.reset(makeFrame(67, 131, 1.f));
+    b->getTags().setTag("LUMINANCE", "RELATIVE");
+    EXPECT_NE(key, ResultCache::makeKey(*b, "mantiuk06_contrast_0.1"));
+}
+
+TEST_F(TestResultCache, FindReturnsStoredResult)
+{
+    std::unique_ptr<Frame> result(makeFrame(32, 16, 2.f));
+    result->getTags().setTag("LUMINANCE", "DISPLAY");
+
+    ResultCache cache(m_directory, 16*1024*1024);
+    EXPECT_TRUE(cache.find("0123") == NULL);
+
+    cache.insert("0123", *result);
+    EXPECT_EQ(1u, cache.size());
+    EXPECT_GT(cache.getByteSize(), 0u);
+
+    std::unique_ptr<Frame> found(cache.find("0123"));
+    ASSERT_TRUE(found.get() != NULL);
+    EXPECT_EQ("DISPLAY", found->getTags().getTag("LUMINANCE"));
+    for (size_t idx = 0; idx < result->size(); ++idx)
+    {
+        ASSERT_EQ((*result->getChannel("Y"))(idx), (*found->getChannel("Y"))(idx));
+    }
+
+    // a new instance reads the index left by the first one
+    ResultCache reopened(m_directory, 16*1024*1024);
+    EXPECT_EQ(1u, reopened.size());
+    found.reset(reopened.find("0123"));
+    EXPECT_TRUE(found.get() != NULL);
+}
+
+TEST_F(TestResultCache, EvictsLeastRecentlyUsed)
+{
+    std::unique_ptr<Frame> result(makeFrame(64, 64, 3.f));
+
+    ResultCache cache(m_directory, 16*1024*1024);
+    cache.insert("a", *result);
+    const size_t entrySize = cache.getByteSize();
+    cache.setMaxByteSize(entrySize*3);
+
+    cache.insert("b", *result);
+    cache.insert("c", *result);
+    std::unique_ptr<Frame> found(cache.find("a"));
+    EXPECT_TRUE(found.get() != NULL);
+
+    // "b" is now the least recently used
+    cache.insert("d", *result);
+    EXPECT_EQ(3u, cache.size());
+    EXPECT_LE(cache.getByteSize(), entrySize*3);
+    EXPECT_TRUE(cache.find("b") == NULL);
+    found.reset(cache.find("a"));
+    EXPECT_TRUE(found.get() != NULL);
+    found.reset(cache.find("d"));
+    EXPECT_TRUE(found.get() != NULL);
+
+    // larger than the whole cache
+    cache.setMaxByteSize(entrySize/2);
+    EXPECT_EQ(0u, cache.size());
+    cache.insert("e", *result);
+    EXPECT_EQ(0u, cache.size());
+}
+
+TEST_F(TestResultCache, MissingFileIsAMiss)
+{
+    std::unique_ptr<Frame> result(makeFrame(8, 8, 4.f));
+
+    ResultCache cache(m_directory, 16*1024*1024);
+    cache.insert("gone", *result);
+    std::remove((m_directory + "/gone.lhc").c_str());
+
+    EXPECT_TRUE(cache.find("gone") == NULL);
+    EXPECT_EQ(0u, cache.size());
+    EXPECT_EQ(0u, cache.getByteSize());
+}
+
+TEST_F(TestResultCache, InstancesShareTheIndex)
+{
+    std::unique_ptr<Frame> result(makeFrame(16, 16, 5.f));
+
+    // two instances on the same directory behave as two processes
+    ResultCache first(m_directory, 16*1024*1024);
+    ResultCache second(m_directory, 16*1024*1024);
+    first.insert("a", *result);
+    second.insert("b", *result);
+    std::unique_ptr<Frame> found(first.find("b"));
+    EXPECT_TRUE(found.get() != NULL);
+
+    // an eviction by one is not undone by the other
+    second.clear();
+    first.insert("c", *result);
+    EXPECT_EQ(1u, first.size());
+    EXPECT_EQ(1u, ResultCache(m_directory, 16*1024*1024).size());
+}
+
+TEST_F(TestResultCache, ConcurrentInstancesKeepAllEntries)
+{
+    std::unique_ptr<Frame> result(makeFrame(16, 16, 6.f));
+
+    const size_t threads = 8;
+    const size_t entries = 32;
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t)
+    {
+        workers.push_back(std::thread([this, t, &result]()
+        {
+            ResultCache cache(m_directory, 16*1024*1024);
+            for (size_t idx = 0; idx < entries; ++idx)
+            {
+                std::ostringstream key;
+                key << t << '_' << idx;
+                cache.insert(key.str(), *result);
+            }
+        }));
+    }
+    for (size_t t = 0; t < threads; ++t)
+    {
+        workers[t].join();
+    }
+
+    ResultCache reopened(m_directory, 16*1024*1024);
+    EXPECT_EQ(threads*entries, reopened.size());
+}
+
+TEST_F(TestResultCache, OrphansAreRemoved)
+{
+    std::unique_ptr<Frame> result(makeFrame(8, 8, 7.f));
+    {
+        ResultCache cache(m_directory, 16*1024*1024);
+        cache.insert("orphan", *result);
+    }
+    // as left by a process that lost its index update
+    std::remove((m_directory + "/index").c_str());
+
+    ResultCache reopened(m_directory, 16*1024*1024);
+    EXPECT_EQ(0u, reopened.size());
+    std::FILE* f = std::fopen((m_directory + "/orphan.lhc").c_str(), "rb");
+    EXPECT_TRUE(f == NULL);
+    if ( f ) std::fclose(f);
+}
+
+TEST_F(TestResultCache, LookupsDoNotWriteTheIndex)
+{
+    std::unique_ptr<Frame> result(makeFrame(8, 8, 8.f));
+
+    ResultCache cache(m_directory, 16*1024*1024);
+    cache.insert("a", *result);
+    std::remove((m_directory + "/index").c_str());
+
+    std::unique_ptr<Frame> found(cache.find("a"));
+    EXPECT_TRUE(found.get() != NULL);
+    EXPECT_TRUE(cache.find("b") == NULL);
+    std::FILE* f = std::fopen((m_directory + "/index").c_str(), "rb");
+    EXPECT_TRUE(f == NULL);
+    if ( f ) std::fclose(f);
+}
+
+TEST_F(TestResultCache, MissingDirectoryDisablesTheCache)
+{
+    std::unique_ptr<Frame> result(makeFrame(8, 8, 9.f));
+
+    // returns at once, instead of waiting for a lock it cannot create
+    ResultCache cache(m_directory + "/missing", 16*1024*1024);
+    cache.insert("a", *result);
+    EXPECT_EQ(0u, cache.size());
+    EXPECT_TRUE(cache.find("a") == NULL);
+    cache.setMaxByteSize(1024);
+    cache.clear();
+}
+
+TEST_F(TestResultCache, SharedCache)
+{
+    EXPECT_TRUE(sharedResultCache() == NULL);
+
+    setSharedResultCache(m_directory, 1024*1024);
+    ResultCachePtr cache = sharedResultCache();
+    ASSERT_TRUE(cache != NULL);
+    EXPECT_EQ(m_directory, cache->getDirectory());
+
+    setSharedResultCache(m_directory, 2*1024*1024);
+    EXPECT_EQ(cache, sharedResultCache());
+    EXPECT_EQ(2u*1024*1024, cache->getMaxByteSize());
+
+    setSharedResultCache(m_directory, 0);
+    EXPECT_TRUE(sharedResultCache() == NULL);
+}
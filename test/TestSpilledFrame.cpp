@@ -0,0 +1,145 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <memory>
+
+#include <Libpfs/exception.h>
+#include <Libpfs/frame.h>
+#include <Libpfs/spilledframe.h>
+
+using namespace pfs;
+
+namespace
+{
+std::string scratchDirectory()
+{
+    const char* dir = std::getenv("TMPDIR");
+    return dir ? dir : "/tmp";
+}
+
+bool fileExists(const std::string& filename)
+{
+    std::FILE* f = std::fopen(filename.c_str(), "rb");
+    if ( f ) std::fclose(f);
+    return f != NULL;
+}
+}
+
+TEST(TestSpilledFrame, RoundTripIsExact)
+{
+    // height not multiple of the block, samples with every kind of exponent
+    Frame frame(37, 71);
+    Channel* X;
+    Channel* Y;
+    Channel* Z;
+    frame.createXYZChannels(X, Y, Z);
+    for (size_t idx = 0; idx < frame.size(); ++idx)
+    {
+        (*X)(idx) = std::ldexp(static_cast<float>(idx % 101)/100.f, static_cast<int>(idx % 40) - 20);
+        (*Y)(idx) = -static_cast<float>(idx)/7.f;
+        (*Z)(idx) = (idx % 3) ? 0.f : std::numeric_limits<float>::infinity();
+    }
+    frame.getTags().setTag("FILE_NAME", "test.exr");
+    Y->getTags().setTag("LUMINANCE", "ABSOLUTE");
+
+    SpilledFrame spilled(frame, scratchDirectory());
+    EXPECT_EQ(frame.getWidth(), spilled.getWidth());
+    EXPECT_EQ(frame.getHeight(), spilled.getHeight());
+    EXPECT_TRUE(fileExists(spilled.getFilename()));
+    EXPECT_GT(spilled.getByteSize(), 0u);
+
+    std::unique_ptr<Frame> expanded(spilled.expand());
+    ASSERT_EQ(frame.getWidth(), expanded->getWidth());
+    ASSERT_EQ(frame.getHeight(), expanded->getHeight());
+    EXPECT_EQ("test.exr", expanded->getTags().getTag("FILE_NAME"));
+
+    const ChannelContainer& channels = frame.getChannels();
+    ASSERT_EQ(channels.size(), expanded->getChannels().size());
+    for (size_t c = 0; c < channels.size(); ++c)
+    {
+        const Channel* ch = expanded->getChannel(channels[c]->getName());
+        ASSERT_TRUE(ch != NULL);
+        EXPECT_EQ(channels[c]->getTags().getTag("LUMINANCE"), ch->getTags().getTag("LUMINANCE"));
+        for (size_t idx = 0; idx < ch->size(); ++idx)
+        {
+            ASSERT_EQ((*channels[c])(idx), (*ch)(idx));
+        }
+    }
+
+    // a second reload works as well
+    std::unique_ptr<Frame> again(spilled.expand());
+    EXPECT_EQ((*Y)(100), (*again->getChannel("Y"))(100));
+}
+
+TEST(TestSpilledFrame, SmoothFrameIsCompressed)
+{
+    Frame frame(512, 256);
+    Channel* X;
+    Channel* Y;
+    Channel* Z;
+    frame.createXYZChannels(X, Y, Z);
+    for (size_t idx = 0; idx < frame.size(); ++idx)
+    {
+        (*X)(idx) = 0.5f;
+        (*Y)(idx) = static_cast<float>(idx % 512)/512.f;
+        (*Z)(idx) = 1.f;
+    }
+
+    SpilledFrame spilled(frame, scratchDirectory());
+    EXPECT_LT(spilled.getByteSize(), frame.size()*3*sizeof(float)/4);
+}
+
+TEST(TestSpilledFrame, DestructorRemovesFile)
+{
+    Frame frame(8, 8);
+    Channel* X;
+    Channel* Y;
+    Channel* Z;
+    frame.createXYZChannels(X, Y, Z);
+
+    std::string filename;
+    {
+        SpilledFrame spilled(frame, scratchDirectory());
+        filename = spilled.getFilename();
+        EXPECT_TRUE(fileExists(filename));
+    }
+    EXPECT_FALSE(fileExists(filename));
+}
+
+TEST(TestSpilledFrame, Errors)
+{
+    Frame frame(8, 8);
+    Channel* X;
+    Channel* Y;
+    Channel* Z;
+    frame.createXYZChannels(X, Y, Z);
+
+    EXPECT_THROW(SpilledFrame(frame, "/nonexistent/directory"), pfs::Exception);
+
+    SpilledFrame spilled(frame, scratchDirectory());
+    std::remove(spilled.getFilename().c_str());
+    EXPECT_THROW(spilled.expand(), pfs::Exception);
+}
@@ -0,0 +1,110 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <gtest/gtest.h>
+
+#include <Libpfs/array2d.h>
+#include <Libpfs/tm/TonemapStageCache.h>
+#include <Libpfs/utils/fastmath.h>
+#include <Libpfs/utils/memorybudget.h>
+
+using namespace pfs;
+
+namespace
+{
+TonemapStageCache::ResultPtr makeResult(size_t width, size_t height, float value)
+{
+    std::shared_ptr<Array2Df> result(new Array2Df(width, height));
+    std::fill(result->begin(), result->end(), value);
+    return result;
+}
+}
+
+TEST(TestTonemapStageCache, KeyDependsOnInputStageAndParameters)
+{
+    TonemapStageCache cache(16*1024*1024);
+    TonemapStages stages(&cache, utils::Hash128(1, 2));
+    stages.insert("base", {40.f, 0.4f}, makeResult(8, 8, 1.f));
+
+    TonemapStageCache::ResultPtr found = stages.find("base", {40.f, 0.4f});
+    ASSERT_TRUE(found != NULL);
+    EXPECT_EQ(1.f, (*found)(0));
+
+    EXPECT_TRUE(stages.find("base", {40.f, 0.5f}) == NULL);
+    EXPECT_TRUE(stages.find("luminance", {40.f, 0.4f}) == NULL);
+    EXPECT_TRUE(TonemapStages(&cache, utils::Hash128(1, 3)).find("base", {40.f, 0.4f}) == NULL);
+    {
+        utils::ScopedMathPrecision precision(utils::MATH_FAST);
+        EXPECT_TRUE(stages.find("base", {40.f, 0.4f}) == NULL);
+    }
+
+    // disabled: nothing is kept
+    TonemapStages none;
+    EXPECT_FALSE(none.isEnabled());
+    none.insert("base", {40.f, 0.4f}, makeResult(8, 8, 2.f));
+    EXPECT_TRUE(none.find("base", {40.f, 0.4f}) == NULL);
+    EXPECT_EQ(1u, cache.size());
+}
+
+TEST(TestTonemapStageCache, EvictsLeastRecentlyUsed)
+{
+    const size_t entrySize = 32*32*sizeof(float);
+    TonemapStageCache cache(entrySize*3);
+
+    cache.insert(utils::Hash128(0, 1), makeResult(32, 32, 1.f));
+    cache.insert(utils::Hash128(0, 2), makeResult(32, 32, 2.f));
+    cache.insert(utils::Hash128(0, 3), makeResult(32, 32, 3.f));
+    EXPECT_TRUE(cache.find(utils::Hash128(0, 1)) != NULL);
+
+    // 2 is now the least recently used
+    cache.insert(utils::Hash128(0, 4), makeResult(32, 32, 4.f));
+    EXPECT_EQ(3u, cache.size());
+    EXPECT_EQ(entrySize*3, cache.getByteSize());
+    EXPECT_TRUE(cache.find(utils::Hash128(0, 2)) == NULL);
+    EXPECT_TRUE(cache.find(utils::Hash128(0, 1)) != NULL);
+
+    // larger than the whole cache
+    cache.insert(utils::Hash128(0, 5), makeResult(64, 64, 5.f));
+    EXPECT_TRUE(cache.find(utils::Hash128(0, 5)) == NULL);
+
+    // the result in use survives its eviction
+    TonemapStageCache::ResultPtr kept = cache.find(utils::Hash128(0, 4));
+    cache.setMaxByteSize(0);
+    EXPECT_EQ(0u, cache.size());
+    EXPECT_EQ(0u, cache.getByteSize());
+    ASSERT_TRUE(kept != NULL);
+    EXPECT_EQ(4.f, (*kept)(0));
+}
+
+TEST(TestTonemapStageCache, ReleasedUnderMemoryPressure)
+{
+    const size_t entrySize = 32*32*sizeof(float);
+    TonemapStageCache cache(entrySize*4);
+    cache.insert(utils::Hash128(0, 1), makeResult(32, 32, 1.f));
+    cache.insert(utils::Hash128(0, 2), makeResult(32, 32, 2.f));
+    cache.insert(utils::Hash128(0, 3), makeResult(32, 32, 3.f));
+
+    EXPECT_EQ(entrySize*2, cache.release(entrySize + 1));
+    EXPECT_EQ(1u, cache.size());
+    EXPECT_TRUE(cache.find(utils::Hash128(0, 3)) != NULL);
+
+    EXPECT_GE(utils::relieveMemoryPressure(entrySize), entrySize);
+    EXPECT_EQ(0u, cache.size());
+}
@@ -0,0 +1,248 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include <Libpfs/frame.h>
+#include <Libpfs/progress.h>
+#include <Libpfs/manip/copy.h>
+#include <Libpfs/tm/TonemapOperator.h>
+#include <Libpfs/tm/TonemapStageCache.h>
+#include <Libpfs/tm/TonemapSweep.h>
+#include <Libpfs/utils/memorybudget.h>
+#include <Libpfs/utils/parallel.h>
+
+using namespace pfs;
+
+namespace
+{
+Frame* makeHdr(size_t width, size_t height)
+{
+    Frame* frame = new Frame(width, height);
+    Channel* R;
+    Channel* G;
+    Channel* B;
+    frame->createXYZChannels(R, G, B);
+    for (size_t y = 0; y < height; ++y)
+    {
+        for (size_t x = 0; x < width; ++x)
+        {
+            const float value = std::pow(10.f, 4.f*x/width - 2.f) * (1.f + 0.5f*y/height);
+            (*R)(x, y) = value;
+            (*G)(x, y) = 0.8f*value;
+            (*B)(x, y) = 0.6f*value;
+        }
+    }
+    return frame;
+}
+}
+
+TEST(TestTonemapSweep, Axes)
+{
+    SweepAxis axis("bias", 0.7f, 0.9f, 3);
+    EXPECT_FLOAT_EQ(0.7f, axis.value(0));
+    EXPECT_FLOAT_EQ(0.8f, axis.value(1));
+    EXPECT_FLOAT_EQ(0.9f, axis.value(2));
+    EXPECT_EQ(1u, SweepAxis().steps);
+
+    TonemappingParameters params;
+    params.tmoperator = drago;
+    EXPECT_TRUE(params.setOperatorOption("bias", 0.5f));
+    EXPECT_EQ(0.5f, params.operator_options.dragooptions.bias);
+    EXPECT_FALSE(params.setOperatorOption("contrastfactor", 0.5f));
+
+    EXPECT_THROW(TonemapSweep(params, SweepAxis("alpha", 0.f, 1.f, 2)), std::runtime_error);
+    EXPECT_THROW(TonemapSweep(params, SweepAxis("bias", 0.f, 1.f, 0)), std::runtime_error);
+
+    TonemapSweep sweep(params, axis);
+    EXPECT_EQ(3u, sweep.getColumns());
+    EXPECT_EQ(1u, sweep.getRows());
+    EXPECT_FLOAT_EQ(0.9f, sweep.getParameters(2, 0).operator_options.dragooptions.bias);
+}
+
+TEST(TestTonemapSweep, VariantsMatchSingleRuns)
+{
+    std::unique_ptr<Frame> hdr(makeHdr(64, 40));
+
+    TonemappingParameters params;
+    params.tmoperator = mantiuk06;
+    TonemapSweep sweep(params,
+                       SweepAxis("saturationfactor", 0.4f, 1.2f, 3),
+                       SweepAxis("contrastfactor", 0.1f, 0.3f, 2));
+    sweep.setSheetCellWidth(16);
+
+    // every variant on its own, computing all its stages
+    TonemapStageCache& cache = tonemapStageCache();
+    const size_t cache_size = cache.getMaxByteSize();
+    cache.setMaxByteSize(0);
+    std::vector< std::shared_ptr<Frame> > expected;
+    for (size_t row = 0; row < sweep.getRows(); ++row)
+    {
+        for (size_t column = 0; column < sweep.getColumns(); ++column)
+        {
+            std::shared_ptr<Frame> single(copy(hdr.get()));
+            TonemappingParameters single_params = sweep.getParameters(column, row);
+            Progress single_ph;
+            std::unique_ptr<TonemapOperator> tmo(TonemapOperator::getTonemapOperator(mantiuk06));
+            tmo->tonemapFrame(*single, &single_params, single_ph);
+            expected.push_back(single);
+        }
+    }
+    cache.setMaxByteSize(cache_size);
+
+    std::vector<int> calls(sweep.getColumns()*sweep.getRows(), 0);
+    Progress ph;
+    std::unique_ptr<Frame> sheet(sweep.run(*hdr,
+                                           [&](size_t column, size_t row,
+                                               const TonemappingParameters&,
+                                               const Frame& result)
+    {
+        const size_t idx = row*sweep.getColumns() + column;
+        ++calls[idx];
+
+        const Channel* single = expected[idx]->getChannel("X");
+        const Channel* actual = result.getChannel("X");
+        for (size_t i = 0; i < single->size(); ++i)
+        {
+            ASSERT_NEAR((*single)(i), (*actual)(i), 1e-5f);
+        }
+    }, ph));
+
+    for (size_t idx = 0; idx < calls.size(); ++idx)
+    {
+        EXPECT_EQ(1, calls[idx]);
+    }
+    EXPECT_EQ(6, ph.value());
+
+    // one solved luminance for each contrast
+    EXPECT_EQ(2u, cache.size());
+
+    ASSERT_TRUE(sheet.get() != NULL);
+    EXPECT_EQ(3u*16 + 4*4, sheet->getWidth());
+    EXPECT_EQ(2u*10 + 3*4, sheet->getHeight());
+}
+
+TEST(TestTonemapSweep, Canceled)
+{
+    std::unique_ptr<Frame> hdr(makeHdr(32, 32));
+
+    TonemappingParameters params;
+    params.tmoperator = drago;
+    TonemapSweep sweep(params, SweepAxis("bias", 0.7f, 0.9f, 4));
+    sweep.setSheetCellWidth(8);
+
+    int calls = 0;
+    Progress ph;
+    ph.cancel();
+    std::unique_ptr<Frame> sheet(sweep.run(*hdr,
+                                           [&](size_t, size_t, const TonemappingParameters&,
+                                               const Frame&) { ++calls; },
+                                           ph));
+    EXPECT_TRUE(sheet.get() == NULL);
+    EXPECT_EQ(0, calls);
+}
+
+TEST(TestTonemapSweep, DurandManyGroups)
+{
+    std::unique_ptr<Frame> hdr(makeHdr(512, 320));
+
+    // Durand holds a lock for the whole run, and its loops are split in
+    // tasks: with more groups than threads, and followers in every group,
+    // a thread holding the lock must never pick up another variant
+    utils::setConcurrency(2);
+
+    TonemappingParameters params;
+    params.tmoperator = durand;
+    TonemapSweep sweep(params,
+                       SweepAxis("spatial", 1.f, 4.f, 9),
+                       SweepAxis("base", 3.f, 6.f, 3));
+
+    TonemapStageCache& cache = tonemapStageCache();
+    const size_t cache_size = cache.getMaxByteSize();
+    cache.setMaxByteSize(0);
+    std::vector< std::shared_ptr<Frame> > expected;
+    for (size_t row = 0; row < sweep.getRows(); ++row)
+    {
+        for (size_t column = 0; column < sweep.getColumns(); ++column)
+        {
+            std::shared_ptr<Frame> single(copy(hdr.get()));
+            TonemappingParameters single_params = sweep.getParameters(column, row);
+            Progress single_ph;
+            std::unique_ptr<TonemapOperator> tmo(TonemapOperator::getTonemapOperator(durand));
+            tmo->tonemapFrame(*single, &single_params, single_ph);
+            expected.push_back(single);
+        }
+    }
+    cache.setMaxByteSize(cache_size);
+
+    std::vector<int> calls(sweep.getColumns()*sweep.getRows(), 0);
+    Progress ph;
+    sweep.run(*hdr, [&](size_t column, size_t row, const TonemappingParameters&,
+                        const Frame& result)
+    {
+        const size_t idx = row*sweep.getColumns() + column;
+        ++calls[idx];
+
+        const Channel* single = expected[idx]->getChannel("Y");
+        const Channel* actual = result.getChannel("Y");
+        for (size_t i = 0; i < single->size(); ++i)
+        {
+            ASSERT_NEAR((*single)(i), (*actual)(i), 1e-5f);
+        }
+    }, ph);
+
+    utils::setConcurrency(0);
+
+    for (size_t idx = 0; idx < calls.size(); ++idx)
+    {
+        EXPECT_EQ(1, calls[idx]);
+    }
+    EXPECT_EQ(27, ph.value());
+}
+
+TEST(TestTonemapSweep, CallerHoldsTheBudget)
+{
+    std::unique_ptr<Frame> hdr(makeHdr(32, 32));
+
+    // the job running the sweep has reserved all the budget: the variants
+    // cannot wait for it
+    const size_t bytes = utils::frameMemorySize(32, 32)*4;
+    utils::setMemoryBudget(bytes);
+    utils::MemoryReservation job(bytes);
+
+    TonemappingParameters params;
+    params.tmoperator = drago;
+    TonemapSweep sweep(params, SweepAxis("bias", 0.7f, 0.9f, 6));
+
+    int calls = 0;
+    Progress ph;
+    sweep.run(*hdr, [&](size_t, size_t, const TonemappingParameters&,
+                        const Frame&) { ++calls; }, ph);
+
+    job.release();
+    utils::setMemoryBudget(0);
+
+    EXPECT_EQ(6, calls);
+}
@@ -0,0 +1,172 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <Libpfs/utils/trace.h>
+
+using namespace pfs::utils;
+
+namespace
+{
+//! \brief tracing on (and empty) for the lifetime of the object
+class ScopedTracing
+{
+public:
+    ScopedTracing()
+        : m_previous(isTracing())
+    {
+        resetTrace();
+        setTracing(true);
+    }
+
+    ~ScopedTracing()
+    {
+        setTracing(m_previous);
+        resetTrace();
+    }
+
+private:
+    bool m_previous;
+};
+}
+
+TEST(TestTrace, DisabledRecordsNothing)
+{
+    const bool previous = isTracing();
+    resetTrace();
+    setTracing(false);
+    {
+        TraceSpan span("read");
+        traceCount("pixels read", 100);
+    }
+    setTracing(previous);
+
+    EXPECT_TRUE(traceStages().empty());
+    EXPECT_TRUE(traceCounters().empty());
+}
+
+TEST(TestTrace, StagesAreSummed)
+{
+    ScopedTracing tracing;
+
+    for (int idx = 0; idx < 3; ++idx)
+    {
+        TraceSpan span("fuse", "debevec");
+    }
+    {
+        TraceSpan span("write");
+    }
+
+    std::vector<TraceStage> stages = traceStages();
+    ASSERT_EQ(2u, stages.size());
+    EXPECT_EQ("fuse", stages[0].name);
+    EXPECT_EQ(3u, stages[0].calls);
+    EXPECT_GE(stages[0].totalMs, stages[0].maxMs);
+    EXPECT_EQ("write", stages[1].name);
+    EXPECT_EQ(1u, stages[1].calls);
+}
+
+TEST(TestTrace, CountersFromManyThreads)
+{
+    ScopedTracing tracing;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.push_back(std::thread([]()
+        {
+            for (int idx = 0; idx < 1000; ++idx)
+            {
+                TraceSpan span("tonemap");
+                traceCount("pixels tonemapped", 16);
+            }
+        }));
+    }
+    for (size_t t = 0; t < threads.size(); ++t) threads[t].join();
+
+    std::vector<TraceStage> stages = traceStages();
+    ASSERT_EQ(1u, stages.size());
+    EXPECT_EQ(4000u, stages[0].calls);
+
+    std::vector<TraceCounter> counters = traceCounters();
+    ASSERT_EQ(1u, counters.size());
+    EXPECT_EQ("pixels tonemapped", counters[0].name);
+    EXPECT_EQ(64000, counters[0].total);
+}
+
+TEST(TestTrace, ChromeTrace)
+{
+    ScopedTracing tracing;
+    {
+        TraceSpan span("read", "C:\\images\\\"quoted\".exr");
+        traceCount("bytes read", 1024);
+    }
+
+    std::ostringstream out;
+    writeChromeTrace(out);
+    const std::string json = out.str();
+
+    EXPECT_EQ(0u, json.find("{"));
+    EXPECT_NE(std::string::npos, json.find("\"traceEvents\":["));
+    EXPECT_NE(std::string::npos, json.find("\"name\":\"read\""));
+    EXPECT_NE(std::string::npos, json.find("\"ph\":\"X\""));
+    EXPECT_NE(std::string::npos, json.find("\"ph\":\"C\""));
+    EXPECT_NE(std::string::npos, json.find("\"bytes read\":1024"));
+    // backslashes and quotes of the detail are escaped
+    EXPECT_NE(std::string::npos, json.find("C:\\\\images\\\\\\\"quoted\\\".exr"));
+    EXPECT_EQ("]}\n", json.substr(json.size() - 3));
+}
+
+TEST(TestTrace, Summary)
+{
+    ScopedTracing tracing;
+    {
+        TraceSpan span("align");
+        traceCount("pixels read", 42);
+    }
+
+    std::ostringstream out;
+    writeTraceSummary(out);
+    const std::string summary = out.str();
+
+    EXPECT_NE(std::string::npos, summary.find("stage"));
+    EXPECT_NE(std::string::npos, summary.find("align"));
+    EXPECT_NE(std::string::npos, summary.find("pixels read"));
+    EXPECT_NE(std::string::npos, summary.find("42"));
+}
+
+TEST(TestTrace, ResetDropsEverything)
+{
+    ScopedTracing tracing;
+    {
+        TraceSpan span("read");
+        traceCount("pixels read", 1);
+    }
+    resetTrace();
+
+    EXPECT_TRUE(traceStages().empty());
+    EXPECT_TRUE(traceCounters().empty());
+}